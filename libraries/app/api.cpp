@@ -25,6 +25,7 @@
 
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_read_pool.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/impacted.hpp>
 #include <graphene/chain/database.hpp>
@@ -77,7 +78,8 @@ namespace graphene { namespace app {
     {
        if( api_name == "database_api" )
        {
-          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ) );
+          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), _app.get_market_depth(),
+                                                            _app.get_notification_hub(), _app.get_api_read_pool() );
        }
        else if( api_name == "network_broadcast_api" )
        {
@@ -331,15 +333,10 @@ namespace graphene { namespace app {
                   assert( aobj != nullptr );
                   result.push_back( aobj->owner );
                   break;
-               } case impl_transaction_object_type:{
-                  const auto& aobj = dynamic_cast<const transaction_object*>(obj);
-                  assert( aobj != nullptr );
-                  flat_set<account_id_type> impacted;
-                  transaction_get_impacted_accounts( aobj->trx, impacted );
-                  result.reserve( impacted.size() );
-                  for( auto& item : impacted ) result.emplace_back(item);
+               } case impl_transaction_object_type:
+                  // dedupe entries do not hold the transaction
                   break;
-               } case impl_blinded_balance_object_type:{
+                 case impl_blinded_balance_object_type:{
                   const auto& aobj = dynamic_cast<const blinded_balance_object*>(obj);
                   assert( aobj != nullptr );
                   result.reserve( aobj->owner.account_auths.size() );
@@ -369,27 +366,39 @@ namespace graphene { namespace app {
 
     vector<order_history_object> history_api::get_fill_order_history( asset_id_type a, asset_id_type b, uint32_t limit  )const
     {
-       FC_ASSERT(_app.chain_database());
-       const auto& db = *_app.chain_database();
-       if( a > b ) std::swap(a,b);
-       const auto& history_idx = db.get_index_type<graphene::market_history::history_index>().indices().get<by_key>();
-       history_key hkey;
-       hkey.base = a;
-       hkey.quote = b;
-       hkey.sequence = std::numeric_limits<int64_t>::min();
-
-       uint32_t count = 0;
-       auto itr = history_idx.lower_bound( hkey );
-       vector<order_history_object> result;
-       while( itr != history_idx.end() && count < limit)
-       {
-          if( itr->key.base != a || itr->key.quote != b ) break;
-          result.push_back( *itr );
-          ++itr;
-          ++count;
-       }
+       return get_fill_order_history_page( a, b, limit, optional<int64_t>() );
+    }
 
-       return result;
+    vector<order_history_object> history_api::get_fill_order_history_page( asset_id_type a, asset_id_type b, uint32_t limit,
+                                                                          optional<int64_t> start_sequence )const
+    {
+       return run_read( _app.get_api_read_pool(), "get_fill_order_history_page", [&]() -> vector<order_history_object> {
+          FC_ASSERT(_app.chain_database());
+          const auto& db = *_app.chain_database();
+          if( a > b ) std::swap(a,b);
+          const auto& history_idx = db.get_index_type<graphene::market_history::history_index>().indices().get<by_key>();
+          history_key hkey;
+          hkey.base = a;
+          hkey.quote = b;
+          hkey.sequence = std::numeric_limits<int64_t>::min();
+
+          auto itr = history_idx.lower_bound( hkey );
+          if( start_sequence )
+          {
+             hkey.sequence = *start_sequence;
+             itr = history_idx.upper_bound( hkey );
+          }
+
+          vector<order_history_object> result;
+          while( itr != history_idx.end() && result.size() < limit )
+          {
+             if( itr->key.base != a || itr->key.quote != b ) break;
+             result.push_back( *itr );
+             ++itr;
+          }
+
+          return result;
+       } );
     }
 
     vector<operation_history_object> history_api::get_account_history( account_id_type account, 
@@ -397,26 +406,28 @@ namespace graphene { namespace app {
                                                                        unsigned limit, 
                                                                        operation_history_id_type start ) const
     {
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();       
-       FC_ASSERT( limit <= 100 );
-       vector<operation_history_object> result;
-       const auto& stats = account(db).statistics(db);
-       if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
-       if( start == operation_history_id_type() )
-          start = node->operation_id;
-          
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-          if( node->operation_id.instance.value <= start.instance.value )
-             result.push_back( node->operation_id(db) );
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else node = &node->next(db);
-       }
+       return run_read( _app.get_api_read_pool(), "get_account_history", [&]() -> vector<operation_history_object> {
+          FC_ASSERT( _app.chain_database() );
+          const auto& db = *_app.chain_database();       
+          FC_ASSERT( limit <= 100 );
+          vector<operation_history_object> result;
+          // the walk below runs from start down to stop, so it would leave the account's range otherwise
+          if( start != operation_history_id_type() && start <= stop )
+             return result;
+          // seek straight to start instead of walking the account's history list from its most recent operation
+          const auto& by_op_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_op>();
+          auto itr_stop = by_op_idx.upper_bound( boost::make_tuple( account, stop ) );
+          auto itr = start == operation_history_id_type() ? by_op_idx.lower_bound( boost::make_tuple( account + 1 ) )
+                                                          : by_op_idx.upper_bound( boost::make_tuple( account, start ) );
+
+          while( itr != itr_stop && result.size() < limit )
+          {
+             --itr;
+             result.push_back( itr->operation_id(db) );
+          }
        
-       return result;
+          return result;
+       } );
     }
     
     vector<operation_history_object> history_api::get_relative_account_history( account_id_type account, 
@@ -424,27 +435,31 @@ namespace graphene { namespace app {
                                                                                 unsigned limit, 
                                                                                 uint32_t start) const
     {
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();
-       FC_ASSERT(limit <= 100);
-       vector<operation_history_object> result;
-       if( start == 0 )
-         start = account(db).statistics(db).total_ops;
-       else start = min( account(db).statistics(db).total_ops, start );
-       const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-       const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
+       return run_read( _app.get_api_read_pool(), "get_relative_account_history", [&]() -> vector<operation_history_object> {
+          FC_ASSERT( _app.chain_database() );
+          const auto& db = *_app.chain_database();
+          FC_ASSERT(limit <= 100);
+          vector<operation_history_object> result;
+          if( start == 0 )
+            start = account(db).statistics(db).total_ops;
+          else start = min( account(db).statistics(db).total_ops, start );
+          const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
+          const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
        
-       auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
-       auto itr_stop = by_seq_idx.lower_bound( boost::make_tuple( account, stop ) );
-       --itr;
-       
-       while ( itr != itr_stop && result.size() < limit )
-       {
-          result.push_back( itr->operation_id(db) );
+          if( start <= stop )
+             return result;
+          auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
+          auto itr_stop = by_seq_idx.lower_bound( boost::make_tuple( account, stop ) );
           --itr;
-       }
        
-       return result;
+          while ( itr != itr_stop && result.size() < limit )
+          {
+             result.push_back( itr->operation_id(db) );
+             --itr;
+          }
+       
+          return result;
+       } );
     }
 
     flat_set<uint32_t> history_api::get_market_history_buckets()const
@@ -457,27 +472,11 @@ namespace graphene { namespace app {
     vector<bucket_object> history_api::get_market_history( asset_id_type a, asset_id_type b,
                                                            uint32_t bucket_seconds, fc::time_point_sec start, fc::time_point_sec end )const
     { try {
-       FC_ASSERT(_app.chain_database());
-       const auto& db = *_app.chain_database();
-       vector<bucket_object> result;
-       result.reserve(200);
-
-       if( a > b ) std::swap(a,b);
-
-       const auto& bidx = db.get_index_type<bucket_index>();
-       const auto& by_key_idx = bidx.indices().get<by_key>();
-
-       auto itr = by_key_idx.lower_bound( bucket_key( a, b, bucket_seconds, start ) );
-       while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < 200 )
-       {
-          if( !(itr->key.base == a && itr->key.quote == b && itr->key.seconds == bucket_seconds) )
-          {
-            return result;
-          }
-          result.push_back(*itr);
-          ++itr;
-       }
-       return result;
+       auto hist = _app.get_plugin<market_history_plugin>( "market_history" );
+       FC_ASSERT( hist );
+       return run_read( _app.get_api_read_pool(), "get_market_history", [&]() {
+          return hist->get_market_history( a, b, bucket_seconds, start, end, 1000 );
+       } );
     } FC_CAPTURE_AND_RETHROW( (a)(b)(bucket_seconds)(start)(end) ) }
     
     crypto_api::crypto_api(){};
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_read_pool.hpp>
+
+namespace graphene { namespace app {
+
+api_read_pool::api_read_pool( database& db, uint32_t threads, uint32_t default_method_limit )
+   : _db( db ), _default_limit( default_method_limit )
+{
+   FC_ASSERT( threads > 0, "an API read pool needs at least one thread" );
+   _threads.reserve( threads );
+   for( uint32_t i = 0; i < threads; ++i )
+      _threads.emplace_back( new fc::thread( "api read " + fc::to_string( uint64_t(i) ) ) );
+   ilog( "Serving read-only API calls on ${n} threads", ("n", threads) );
+}
+
+api_read_pool::~api_read_pool()
+{
+   for( auto& t : _threads )
+      t->quit();
+}
+
+void api_read_pool::set_method_limit( const std::string& method, uint32_t limit )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _limits[method] = limit;
+}
+
+void api_read_pool::acquire( const std::string& method )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto itr = _limits.find( method );
+   uint32_t limit = itr != _limits.end() ? itr->second : _default_limit;
+   uint32_t& running = _running[method];
+   FC_ASSERT( limit == 0 || running < limit,
+              "Too many concurrent ${m} calls (limit ${l}), try again later", ("m", method)("l", limit) );
+   ++running;
+}
+
+void api_read_pool::release( const std::string& method )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   --_running[method];
+}
+
+fc::thread& api_read_pool::next_thread()
+{
+   return *_threads[ _next_thread++ % _threads.size() ];
+}
+
+} } // graphene::app
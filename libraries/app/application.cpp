@@ -24,6 +24,10 @@
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/app/market_depth.hpp>
+#include <graphene/app/notification_hub.hpp>
+#include <graphene/app/api_read_pool.hpp>
+#include <graphene/app/block_event_stream.hpp>
 #include <graphene/app/plugin.hpp>
 
 #include <graphene/chain/protocol/fee_schedule.hpp>
@@ -35,6 +39,8 @@
 #include <graphene/net/core_messages.hpp>
 #include <graphene/net/exceptions.hpp>
 
+#include <graphene/p2p/node.hpp>
+
 #include <graphene/time/time.hpp>
 
 #include <graphene/utilities/key_conversion.hpp>
@@ -43,6 +49,7 @@
 #include <fc/smart_ref_impl.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/rpc/api_connection.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/network/resolve.hpp>
@@ -115,10 +122,18 @@ namespace detail {
 
       void reset_p2p_node(const fc::path& data_dir)
       { try {
-         _p2p_network = std::make_shared<net::node>("Graphene Reference Implementation");
-
-         _p2p_network->load_configuration(data_dir / "p2p");
-         _p2p_network->set_node_delegate(this);
+         string engine = _options->count("p2p-engine") ? _options->at("p2p-engine").as<string>() : string("legacy");
+         if( engine == "push" )
+         {
+            _p2p_network = std::make_shared<p2p::node>("Graphene Reference Implementation", this);
+         }
+         else
+         {
+            FC_ASSERT( engine == "legacy", "Unknown p2p-engine ${e}, expected legacy or push", ("e",engine) );
+            _p2p_network = std::make_shared<net::node>("Graphene Reference Implementation");
+            _p2p_network->load_configuration(data_dir / "p2p");
+            _p2p_network->set_node_delegate(this);
+         }
 
          if( _options->count("seed-node") )
          {
@@ -187,7 +202,9 @@ namespace detail {
          _websocket_server->on_connection([&]( const fc::http::websocket_connection_ptr& c ){
             auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c);
             auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
-            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()) );
+            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()), _self->get_market_depth(),
+                                                                         _self->get_notification_hub(),
+                                                                         _self->get_api_read_pool() );
             wsc->register_api(fc::api<graphene::app::database_api>(db_api));
             wsc->register_api(fc::api<graphene::app::login_api>(login));
             c->set_session_data( wsc );
@@ -215,7 +232,9 @@ namespace detail {
          _websocket_tls_server->on_connection([&]( const fc::http::websocket_connection_ptr& c ){
             auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c);
             auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
-            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()) );
+            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()), _self->get_market_depth(),
+                                                                         _self->get_notification_hub(),
+                                                                         _self->get_api_read_pool() );
             wsc->register_api(fc::api<graphene::app::database_api>(db_api));
             wsc->register_api(fc::api<graphene::app::login_api>(login));
             c->set_session_data( wsc );
@@ -285,6 +304,18 @@ namespace detail {
             }
             else
             {
+               // a genesis embedded in packed form needs no JSON parsing
+               std::vector<char> egenesis_packed;
+               graphene::egenesis::compute_egenesis_packed( egenesis_packed );
+               if( !egenesis_packed.empty() )
+               {
+                  FC_ASSERT( graphene::egenesis::get_egenesis_packed_hash()
+                             == fc::sha256::hash( egenesis_packed.data(), egenesis_packed.size() ) );
+                  auto genesis = fc::raw::unpack<genesis_state_type>( egenesis_packed );
+                  genesis.initial_chain_id = graphene::egenesis::get_egenesis_chain_id();
+                  return genesis;
+               }
+
                std::string egenesis_json;
                graphene::egenesis::compute_egenesis_json( egenesis_json );
                FC_ASSERT( egenesis_json != "" );
@@ -392,6 +423,15 @@ namespace detail {
             _force_validate = true;
          }
 
+         if( _options->count("enable-apply-profiling") || _options->count("apply-profile-interval") )
+         {
+            auto& profiler = _chain_db->get_apply_profiler();
+            profiler.enable( true );
+            if( _options->count("apply-profile-interval") )
+               profiler.set_dump_interval( _options->at("apply-profile-interval").as<uint32_t>() );
+            ilog( "Evaluator and block apply profiling enabled" );
+         }
+
          graphene::time::now();
 
          if( _options->count("api-access") )
@@ -498,6 +538,10 @@ namespace detail {
                }
             }
 
+            // slow event subscribers hold up the next block rather than the one being applied
+            if( _block_events )
+               _block_events->wait_for_subscribers();
+
             return result;
          } catch ( const graphene::chain::unlinkable_block_exception& e ) {
             // translate to a graphene::net exception
@@ -866,6 +910,10 @@ namespace detail {
       api_access _apiaccess;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
+      std::shared_ptr<market_depth>                         _market_depth;
+      std::shared_ptr<notification_hub>                     _notification_hub;
+      std::shared_ptr<api_read_pool>                        _api_read_pool;
+      std::shared_ptr<block_event_stream>                   _block_events;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
@@ -900,6 +948,7 @@ void application::set_program_options(boost::program_options::options_descriptio
    configuration_file_options.add_options()
          ("p2p-endpoint", bpo::value<string>(), "Endpoint for P2P node to listen on")
          ("seed-node,s", bpo::value<vector<string>>()->composing(), "P2P nodes to connect to on startup (may specify multiple times)")
+         ("p2p-engine", bpo::value<string>()->default_value("legacy"), "Network protocol to run: legacy (announce/request/send) or push (low-latency push protocol)")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("rpc-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8090"), "Endpoint for websocket RPC to listen on")
          ("rpc-tls-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8089"), "Endpoint for TLS websocket RPC to listen on")
@@ -910,6 +959,11 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
          ("dbg-init-key", bpo::value<string>(), "Block signing key to use for init witnesses, overrides genesis file")
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
+         ("api-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads serving read-only database and history API calls, 0 serves them on the main thread")
+         ("api-method-limit", bpo::value<vector<string>>()->composing(), "Pairs of [METHOD,MAX_CALLS] limiting how many calls of a read-only API method may run at once on the API threads")
+         ("api-default-method-limit", bpo::value<uint32_t>()->default_value(0), "Limit of concurrent calls for methods without an api-method-limit, 0 for no limit")
+         ("enable-apply-profiling", "Collect per operation evaluator and per step block apply timings, see get_apply_profile")
+         ("apply-profile-interval", bpo::value<uint32_t>(), "Log and reset apply timings every N blocks (implies enable-apply-profiling)")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -985,6 +1039,48 @@ std::shared_ptr<chain::database> application::chain_database() const
    return my->_chain_db;
 }
 
+std::shared_ptr<market_depth> application::get_market_depth() const
+{
+   if( !my->_market_depth )
+      my->_market_depth = market_depth::create( *my->_chain_db );
+   return my->_market_depth;
+}
+
+std::shared_ptr<notification_hub> application::get_notification_hub() const
+{
+   if( !my->_notification_hub )
+      my->_notification_hub = notification_hub::create( *my->_chain_db );
+   return my->_notification_hub;
+}
+
+std::shared_ptr<api_read_pool> application::get_api_read_pool() const
+{
+   if( !my->_api_read_pool && my->_options && my->_options->count("api-threads")
+       && my->_options->at("api-threads").as<uint32_t>() > 0 )
+   {
+      const auto& options = *my->_options;
+      uint32_t default_limit = options.count("api-default-method-limit") ? options.at("api-default-method-limit").as<uint32_t>() : 0;
+      auto pool = std::make_shared<api_read_pool>( *my->_chain_db, options.at("api-threads").as<uint32_t>(), default_limit );
+      if( options.count("api-method-limit") )
+      {
+         for( const auto& l : options.at("api-method-limit").as<vector<string>>() )
+         {
+            auto item = fc::json::from_string(l).as<std::pair<string,uint32_t> >();
+            pool->set_method_limit( item.first, item.second );
+         }
+      }
+      my->_api_read_pool = pool;
+   }
+   return my->_api_read_pool;
+}
+
+std::shared_ptr<block_event_stream> application::get_block_events() const
+{
+   if( !my->_block_events )
+      my->_block_events = block_event_stream::create( *my->_chain_db );
+   return my->_block_events;
+}
+
 void application::set_block_production(bool producing_blocks)
 {
    my->_is_block_producer = producing_blocks;
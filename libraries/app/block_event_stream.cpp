@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/block_event_stream.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace app {
+
+event_subscription::~event_subscription()
+{
+   try
+   {
+      wait_idle();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Event subscriber ${name} did not shut down cleanly: ${e}", ("name", _name)("e", e.to_detail_string()) );
+   }
+   if( _thread )
+      _thread->quit();
+}
+
+event_stream_stats event_subscription::stats()const
+{
+   event_stream_stats result;
+   result.last_published_block = _last_published;
+   result.last_processed_block = _last_processed;
+   result.queued = std::count_if( _in_flight.begin(), _in_flight.end(),
+                                  []( const fc::future<void>& f ) { return !f.ready(); } );
+   result.processed = _processed;
+   result.stalls = _stalls;
+   result.last_delay = fc::microseconds( _last_delay_us );
+   result.max_delay = fc::microseconds( _max_delay_us );
+   return result;
+}
+
+void event_subscription::wait_idle()
+{
+   while( !_in_flight.empty() )
+   {
+      _in_flight.front().wait();
+      _in_flight.pop_front();
+   }
+}
+
+void event_subscription::post( const std::shared_ptr<const applied_block_event>& e )
+{
+   // called while the block is being applied, so never wait here; see wait_for_room()
+   while( !_in_flight.empty() && _in_flight.front().ready() )
+      _in_flight.pop_front();
+
+   _last_published = e->block_num();
+   // tasks posted to an fc::thread run in the order they were posted
+   _in_flight.push_back( _thread->async( [this, e]() { process( *e ); }, "block event" ) );
+}
+
+void event_subscription::wait_for_room()
+{
+   while( !_in_flight.empty() && _in_flight.front().ready() )
+      _in_flight.pop_front();
+   if( _in_flight.size() <= _max_queue )
+      return;
+
+   ++_stalls;
+   while( _in_flight.size() > _max_queue )
+   {
+      _in_flight.front().wait();
+      _in_flight.pop_front();
+   }
+}
+
+void event_subscription::process( const applied_block_event& e )
+{
+   try
+   {
+      _handler( e );
+   }
+   catch( const fc::exception& ex )
+   {
+      elog( "Event subscriber ${name} failed on block ${n}: ${e}",
+            ("name", _name)("n", e.block_num())("e", ex.to_detail_string()) );
+   }
+   catch( const std::exception& ex )
+   {
+      elog( "Event subscriber ${name} failed on block ${n}: ${e}", ("name", _name)("n", e.block_num())("e", ex.what()) );
+   }
+
+   const int64_t delay = ( fc::time_point::now() - e.applied_at ).count();
+   _last_delay_us = delay;
+   if( delay > _max_delay_us )
+      _max_delay_us = delay;
+   _last_processed = e.block_num();
+   ++_processed;
+}
+
+std::shared_ptr<block_event_stream> block_event_stream::create( database& db )
+{
+   std::shared_ptr<block_event_stream> result( new block_event_stream( db ) );
+   std::weak_ptr<block_event_stream> weak = result;
+   result->_applied_connection = db.applied_block.connect( [weak]( const signed_block& b ) {
+      if( auto stream = weak.lock() )
+         stream->on_applied_block( b );
+   });
+   result->_change_connection = db.changed_objects.connect( [weak]( const vector<object_id_type>& ids ) {
+      if( auto stream = weak.lock() )
+         stream->on_changed_objects( ids );
+   });
+   return result;
+}
+
+std::shared_ptr<event_subscription> block_event_stream::subscribe( const std::string& name,
+                                                                   event_subscription::handler_type handler,
+                                                                   delivery_mode mode,
+                                                                   uint32_t max_queue )
+{
+   FC_ASSERT( handler, "Event subscriber ${name} needs a handler", ("name", name) );
+   auto s = std::make_shared<event_subscription>();
+   s->_name = name;
+   s->_handler = handler;
+   s->_irreversible_only = ( mode == after_irreversible );
+   s->_max_queue = std::max<uint32_t>( max_queue, 1 );
+   s->_thread.reset( new fc::thread( name ) );
+   _subscribers.push_back( s );
+   return s;
+}
+
+vector< std::shared_ptr<event_subscription> > block_event_stream::live_subscribers()
+{
+   auto end = std::remove_if( _subscribers.begin(), _subscribers.end(),
+                              []( const std::weak_ptr<event_subscription>& w ) { return w.expired(); } );
+   _subscribers.erase( end, _subscribers.end() );
+
+   vector< std::shared_ptr<event_subscription> > live;
+   live.reserve( _subscribers.size() );
+   for( const auto& w : _subscribers )
+      if( auto s = w.lock() )
+         live.push_back( std::move(s) );
+   return live;
+}
+
+void block_event_stream::wait_for_subscribers()
+{
+   for( const auto& s : live_subscribers() )
+      s->wait_for_room();
+}
+
+void block_event_stream::on_applied_block( const signed_block& b )
+{
+   _current.reset();
+   if( live_subscribers().empty() )
+      return;
+
+   auto e = std::make_shared<applied_block_event>();
+   e->block = std::make_shared<const signed_block>( b );
+   e->applied_at = fc::time_point::now();
+   const auto& applied = _db.get_applied_operations();
+   e->operations.reserve( applied.size() );
+   for( const optional<operation_history_object>& op : applied )
+      if( op.valid() )
+         e->operations.push_back( *op );
+
+   // without undo tracking no change notification follows, so there is nothing to wait for
+   if( !_db._undo_db.enabled() )
+      publish( e );
+   else
+      _current = e;
+}
+
+void block_event_stream::on_changed_objects( const vector<object_id_type>& ids )
+{
+   // changes caused by pending transactions are reported without a block and are not part of the stream
+   if( !_current )
+      return;
+
+   std::shared_ptr<applied_block_event> e;
+   e.swap( _current );
+   e->changed_ids = ids;
+   publish( e );
+}
+
+void block_event_stream::publish( const std::shared_ptr<const applied_block_event>& e )
+{
+   auto live = live_subscribers();
+   bool any_irreversible = false;
+   for( const auto& s : live )
+   {
+      if( s->_irreversible_only )
+         any_irreversible = true;
+      else
+         s->post( e );
+   }
+
+   if( !any_irreversible )
+   {
+      _reversible.clear();
+      return;
+   }
+
+   // anything held for this height or above belongs to a fork we have just switched away from
+   const uint32_t block_num = e->block_num();
+   while( !_reversible.empty() && _reversible.back()->block_num() >= block_num )
+      _reversible.pop_back();
+   _reversible.push_back( e );
+
+   const uint32_t last_irreversible = _db.get_dynamic_global_properties().last_irreversible_block_num;
+   while( !_reversible.empty() && _reversible.front()->block_num() <= last_irreversible )
+   {
+      for( const auto& s : live )
+         if( s->_irreversible_only )
+            s->post( _reversible.front() );
+      _reversible.pop_front();
+   }
+}
+
+} } // graphene::app
@@ -25,7 +25,6 @@
 #include <graphene/app/database_api.hpp>
 #include <graphene/chain/get_config.hpp>
 
-#include <fc/bloom_filter.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <fc/crypto/hex.hpp>
@@ -49,11 +48,13 @@ class database_api_impl;
 class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 {
    public:
-      database_api_impl( graphene::chain::database& db );
+      database_api_impl( graphene::chain::database& db, std::shared_ptr<market_depth> depth,
+                         std::shared_ptr<notification_hub> hub, std::shared_ptr<api_read_pool> read_pool );
       ~database_api_impl();
 
       // Objects
       fc::variants get_objects(const vector<object_id_type>& ids)const;
+      conditional_objects get_objects_since(const vector<object_id_type>& ids, uint64_t known_revision)const;
 
       // Subscriptions
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool clear_filter );
@@ -64,6 +65,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       // Blocks and transactions
       optional<block_header> get_block_header(uint32_t block_num)const;
       optional<signed_block> get_block(uint32_t block_num)const;
+      vector<signed_block> get_blocks(uint32_t block_num_from, uint32_t count)const;
+      vector<raw_block> get_raw_blocks(uint32_t block_num_from, uint32_t count, bool include_ids)const;
       processed_transaction get_transaction( uint32_t block_num, uint32_t trx_in_block )const;
 
       // Globals
@@ -72,6 +75,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       fc::variant_object get_config()const;
       chain_id_type get_chain_id()const;
       dynamic_global_property_object get_dynamic_global_properties()const;
+      apply_profile get_apply_profile()const;
 
       // Keys
       vector<vector<account_id_type>> get_key_references( vector<public_key_type> key )const;
@@ -79,6 +83,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       // Accounts
       vector<optional<account_object>> get_accounts(const vector<account_id_type>& account_ids)const;
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids, bool subscribe );
+      conditional_full_accounts get_full_accounts_since( const vector<string>& names_or_ids, uint64_t known_revision, bool subscribe );
       optional<account_object> get_account_by_name( string name )const;
       vector<account_id_type> get_account_references( account_id_type account_id )const;
       vector<optional<account_object>> lookup_account_names(const vector<string>& account_names)const;
@@ -101,9 +106,19 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<limit_order_object>         get_limit_orders(asset_id_type a, asset_id_type b, uint32_t limit)const;
       vector<call_order_object>          get_call_orders(asset_id_type a, uint32_t limit)const;
       vector<force_settlement_object>    get_settle_orders(asset_id_type a, uint32_t limit)const;
+      vector<limit_order_object>         get_limit_orders_page(asset_id_type a, asset_id_type b, uint32_t limit,
+                                                               optional<price> start_price, optional<limit_order_id_type> start_id)const;
+      vector<call_order_object>          get_call_orders_page(asset_id_type a, uint32_t limit,
+                                                              optional<price> start_price, optional<call_order_id_type> start_id)const;
+      vector<force_settlement_object>    get_settle_orders_page(asset_id_type a, uint32_t limit,
+                                                                optional<time_point_sec> start_date, optional<force_settlement_id_type> start_id)const;
       vector<call_order_object>          get_margin_positions( const account_id_type& id )const;
       void subscribe_to_market(std::function<void(const variant&)> callback, asset_id_type a, asset_id_type b);
       void unsubscribe_from_market(asset_id_type a, asset_id_type b);
+      market_depth_snapshot get_market_depth( asset_id_type base, asset_id_type quote, uint32_t limit )const;
+      market_depth_snapshot subscribe_to_market_depth( std::function<void(const variant&)> callback,
+                                                       asset_id_type base, asset_id_type quote, uint32_t limit );
+      void unsubscribe_from_market_depth( asset_id_type a, asset_id_type b );
       market_ticker                      get_ticker( const string& base, const string& quote )const;
       market_volume                      get_24_volume( const string& base, const string& quote )const;
       order_book                         get_order_book( const string& base, const string& quote, unsigned limit = 50 )const;
@@ -140,38 +155,40 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<blinded_balance_object> get_blinded_balances( const flat_set<commitment_type>& commitments )const;
 
    //private:
-      template<typename T>
-      void subscribe_to_item( const T& i )const
+      const account_object* find_account( const std::string& name_or_id )const;
+      vector<object_id_type> lookup_vote_object_ids( const flat_set<vote_id_type>& votes )const;
+
+      bool changed_since( object_id_type id, uint64_t known_revision )const
       {
-         auto vec = fc::raw::pack(i);
-         if( !_subscribe_callback )
-            return;
+         return _db.get_object_revision( id ) > known_revision;
+      }
 
-         if( !is_subscribed_to_item(i) )
-         {
-            idump((i));
-            _subscribe_filter.insert( vec.data(), vec.size() );//(vecconst char*)&i, sizeof(i) );
-         }
+      /** true if an object in [begin,end) changed, or one of ObjectType may have been removed from the range */
+      template<typename ObjectType, typename Iterator>
+      bool range_changed_since( Iterator begin, Iterator end, uint64_t known_revision )const
+      {
+         if( _db.get_removal_revision( ObjectType::space_id, ObjectType::type_id ) > known_revision )
+            return true;
+         for( ; begin != end; ++begin )
+            if( changed_since( begin->id, known_revision ) )
+               return true;
+         return false;
       }
 
       template<typename T>
-      bool is_subscribed_to_item( const T& i )const
+      void subscribe_to_item( const T& i )const
       {
-         if( !_subscribe_callback )
-            return false;
-         return true;
-         return _subscribe_filter.contains( i );
+         _subscriber->subscribe( i );
       }
 
-      void broadcast_updates( const vector<variant>& updates );
-
       /** called every time a block is applied to report the objects that were changed */
       void on_objects_changed(const vector<object_id_type>& ids);
       void on_objects_removed(const vector<const object*>& objs);
       void on_applied_block();
+      void on_market_depth_changed( const map< pair<asset_id_type,asset_id_type>, fc::variant >& deltas );
+      market_depth& depth_tracker();
 
-      mutable fc::bloom_filter                               _subscribe_filter;
-      std::function<void(const fc::variant&)> _subscribe_callback;
+      std::shared_ptr<object_subscriber>                     _subscriber;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
@@ -180,6 +197,11 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       boost::signals2::scoped_connection                                                                                           _applied_block_connection;
       boost::signals2::scoped_connection                                                                                           _pending_trx_connection;
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> >      _market_subscriptions;
+      map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> >      _market_depth_subscriptions;
+      std::shared_ptr<market_depth>                                                      _market_depth;
+      std::shared_ptr<notification_hub>                                                  _notification_hub;
+      std::shared_ptr<api_read_pool>                                                     _read_pool;
+      boost::signals2::scoped_connection                                                 _market_depth_connection;
       graphene::chain::database&                                                                                                            _db;
 };
 
@@ -189,14 +211,20 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-database_api::database_api( graphene::chain::database& db )
-   : my( new database_api_impl( db ) ) {}
+database_api::database_api( graphene::chain::database& db, std::shared_ptr<market_depth> depth,
+                            std::shared_ptr<notification_hub> hub, std::shared_ptr<api_read_pool> read_pool )
+   : my( new database_api_impl( db, depth, hub, read_pool ) ) {}
 
 database_api::~database_api() {}
 
-database_api_impl::database_api_impl( graphene::chain::database& db ):_db(db)
+database_api_impl::database_api_impl( graphene::chain::database& db, std::shared_ptr<market_depth> depth,
+                                      std::shared_ptr<notification_hub> hub, std::shared_ptr<api_read_pool> read_pool )
+   :_market_depth(depth),_notification_hub(hub),_read_pool(read_pool),_db(db)
 {
    wlog("creating database api ${x}", ("x",int64_t(this)) );
+   if( !_notification_hub )
+      _notification_hub = notification_hub::create( _db );
+   _subscriber = _notification_hub->connect();
    _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids) {
                                 on_objects_changed(ids);
                                 });
@@ -213,6 +241,8 @@ database_api_impl::database_api_impl( graphene::chain::database& db ):_db(db)
 database_api_impl::~database_api_impl()
 {
    elog("freeing database api ${x}", ("x",int64_t(this)) );
+   for( const auto& item : _market_depth_subscriptions )
+      _market_depth->untrack( item.first.first, item.first.second );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -223,12 +253,12 @@ database_api_impl::~database_api_impl()
 
 fc::variants database_api::get_objects(const vector<object_id_type>& ids)const
 {
-   return my->get_objects( ids );
+   return run_read( my->_read_pool, "get_objects", [&]() { return my->get_objects( ids ); } );
 }
 
 fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)const
 {
-   if( _subscribe_callback )  {
+   if( _subscriber->has_callback() )  {
       for( auto id : ids )
       {
          if( id.type() == operation_history_object_type && id.space() == protocol_ids ) continue;
@@ -255,6 +285,28 @@ fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)co
    return result;
 }
 
+conditional_objects database_api::get_objects_since(const vector<object_id_type>& ids, uint64_t known_revision)const
+{
+   return run_read( my->_read_pool, "get_objects_since", [&]() { return my->get_objects_since( ids, known_revision ); } );
+}
+
+conditional_objects database_api_impl::get_objects_since(const vector<object_id_type>& ids, uint64_t known_revision)const
+{
+   conditional_objects result;
+   result.revision = _db.get_revision();
+   for( object_id_type id : ids )
+   {
+      if( const object* obj = _db.find_object(id) )
+      {
+         if( changed_since( id, known_revision ) )
+            result.changed[id] = obj->to_variant();
+      }
+      else if( _db.get_removal_revision( id.space(), id.type() ) > known_revision )
+         result.changed[id] = variant();
+   }
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Subscriptions                                                    //
@@ -269,16 +321,7 @@ void database_api::set_subscribe_callback( std::function<void(const variant&)> c
 void database_api_impl::set_subscribe_callback( std::function<void(const variant&)> cb, bool clear_filter )
 {
    edump((clear_filter));
-   _subscribe_callback = cb;
-   if( clear_filter || !cb )
-   {
-      static fc::bloom_parameters param;
-      param.projected_element_count    = 10000;
-      param.false_positive_probability = 1.0/10000;
-      param.maximum_size = 1024*8*8*2;
-      param.compute_optimal_parameters();
-      _subscribe_filter = fc::bloom_filter(param);
-   }
+   _subscriber->set_callback( cb, clear_filter );
 }
 
 void database_api::set_pending_transaction_callback( std::function<void(const variant&)> cb )
@@ -310,6 +353,9 @@ void database_api_impl::cancel_all_subscriptions()
 {
    set_subscribe_callback( std::function<void(const fc::variant&)>(), true);
    _market_subscriptions.clear();
+   for( const auto& item : _market_depth_subscriptions )
+      _market_depth->untrack( item.first.first, item.first.second );
+   _market_depth_subscriptions.clear();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -341,6 +387,39 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
    return _db.fetch_block_by_number(block_num);
 }
 
+vector<signed_block> database_api::get_blocks(uint32_t block_num_from, uint32_t count)const
+{
+   return my->get_blocks( block_num_from, count );
+}
+
+vector<signed_block> database_api_impl::get_blocks(uint32_t block_num_from, uint32_t count)const
+{
+   FC_ASSERT( count <= 100 );
+   vector<raw_block> raw = _db.fetch_raw_blocks_by_number( block_num_from, count );
+   vector<signed_block> result;
+   result.reserve( raw.size() );
+   for( const raw_block& b : raw )
+      result.emplace_back( fc::raw::unpack<signed_block>( b.data ) );
+   return result;
+}
+
+vector<raw_block> database_api::get_raw_blocks(uint32_t block_num_from, uint32_t count, bool include_ids)const
+{
+   return my->get_raw_blocks( block_num_from, count, include_ids );
+}
+
+vector<raw_block> database_api_impl::get_raw_blocks(uint32_t block_num_from, uint32_t count, bool include_ids)const
+{
+   FC_ASSERT( count <= 1000 );
+   // keeps a reply of large blocks within what a client will accept in one message
+   const uint64_t max_bytes = 4 * 1024 * 1024;
+   vector<raw_block> result = _db.fetch_raw_blocks_by_number( block_num_from, count, max_bytes );
+   if( !include_ids )
+      for( raw_block& b : result )
+         b.block_id.reset();
+   return result;
+}
+
 processed_transaction database_api::get_transaction( uint32_t block_num, uint32_t trx_in_block )const
 {
    return my->get_transaction( block_num, trx_in_block );
@@ -419,6 +498,16 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
    return _db.get(dynamic_global_property_id_type());
 }
 
+apply_profile database_api::get_apply_profile()const
+{
+   return my->get_apply_profile();
+}
+
+apply_profile database_api_impl::get_apply_profile()const
+{
+   return _db.get_apply_profiler().get_profile();
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Keys                                                             //
@@ -427,7 +516,7 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
 
 vector<vector<account_id_type>> database_api::get_key_references( vector<public_key_type> key )const
 {
-   return my->get_key_references( key );
+   return run_read( my->_read_pool, "get_key_references", [&]() { return my->get_key_references( key ); } );
 }
 
 /**
@@ -435,57 +524,36 @@ vector<vector<account_id_type>> database_api::get_key_references( vector<public_
  */
 vector<vector<account_id_type>> database_api_impl::get_key_references( vector<public_key_type> keys )const
 {
-   wdump( (keys) );
    vector< vector<account_id_type> > final_result;
    final_result.reserve(keys.size());
 
+   const auto& idx = _db.get_index_type<account_index>();
+   const auto& aidx = dynamic_cast<const primary_index<account_index>&>(idx);
+   const auto& refs = aidx.get_secondary_index<graphene::chain::account_member_index>();
+
+   // the legacy addresses are needed for the lookup if any account has an address authority, and for the
+   // subscription if the client has a callback; either way they are computed once per key
+   const bool subscribing = _subscriber->has_callback();
    for( auto& key : keys )
    {
-
-      address a1( pts_address(key, false, 56) );
-      address a2( pts_address(key, true, 56) );
-      address a3( pts_address(key, false, 0)  );
-      address a4( pts_address(key, true, 0)  );
-      address a5( key );
-
       subscribe_to_item( key );
-      subscribe_to_item( a1 );
-      subscribe_to_item( a2 );
-      subscribe_to_item( a3 );
-      subscribe_to_item( a4 );
-      subscribe_to_item( a5 );
-
-      const auto& idx = _db.get_index_type<account_index>();
-      const auto& aidx = dynamic_cast<const primary_index<account_index>&>(idx);
-      const auto& refs = aidx.get_secondary_index<graphene::chain::account_member_index>();
-      auto itr = refs.account_to_key_memberships.find(key);
-      vector<account_id_type> result;
-
-      for( auto& a : {a1,a2,a3,a4,a5} )
-      {
-          auto itr = refs.account_to_address_memberships.find(a);
-          if( itr != refs.account_to_address_memberships.end() )
-          {
-             result.reserve( itr->second.size() );
-             for( auto item : itr->second )
-             {
-                wdump((a)(item)(item(_db).name));
-                result.push_back(item);
-             }
-          }
-      }
 
-      if( itr != refs.account_to_key_memberships.end() )
+      vector<account_id_type> result;
+      if( subscribing || refs.has_address_members() )
       {
-         result.reserve( itr->second.size() );
-         for( auto item : itr->second ) result.push_back(item);
+         const auto legacy = graphene::chain::account_member_index::legacy_addresses( key );
+         if( subscribing )
+            for( const address& a : legacy )
+               subscribe_to_item( a );
+         refs.find_key_references( key, legacy, result );
       }
+      else
+         refs.find_key_references( key, result );
+      for( auto account : result )
+         subscribe_to_item( account );
       final_result.emplace_back( std::move(result) );
    }
 
-   for( auto i : final_result )
-      subscribe_to_item(i);
-
    return final_result;
 }
 
@@ -497,7 +565,7 @@ vector<vector<account_id_type>> database_api_impl::get_key_references( vector<pu
 
 vector<optional<account_object>> database_api::get_accounts(const vector<account_id_type>& account_ids)const
 {
-   return my->get_accounts( account_ids );
+   return run_read( my->_read_pool, "get_accounts", [&]() { return my->get_accounts( account_ids ); } );
 }
 
 vector<optional<account_object>> database_api_impl::get_accounts(const vector<account_id_type>& account_ids)const
@@ -517,7 +585,7 @@ vector<optional<account_object>> database_api_impl::get_accounts(const vector<ac
 
 std::map<string,full_account> database_api::get_full_accounts( const vector<string>& names_or_ids, bool subscribe )
 {
-   return my->get_full_accounts( names_or_ids, subscribe );
+   return run_read( my->_read_pool, "get_full_accounts", [&]() { return my->get_full_accounts( names_or_ids, subscribe ); } );
 }
 
 std::map<std::string, full_account> database_api_impl::get_full_accounts( const vector<std::string>& names_or_ids, bool subscribe)
@@ -527,16 +595,7 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
    for (const std::string& account_name_or_id : names_or_ids)
    {
-      const account_object* account = nullptr;
-      if (std::isdigit(account_name_or_id[0]))
-         account = _db.find(fc::variant(account_name_or_id).as<account_id_type>());
-      else
-      {
-         const auto& idx = _db.get_index_type<account_index>().indices().get<by_name>();
-         auto itr = idx.find(account_name_or_id);
-         if (itr != idx.end())
-            account = &*itr;
-      }
+      const account_object* account = find_account( account_name_or_id );
       if (account == nullptr)
          continue;
 
@@ -579,12 +638,8 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
 
       // Add the account's balances
-      auto balance_range = _db.get_index_type<account_balance_index>().indices().get<by_account_asset>().equal_range(boost::make_tuple(account->id));
-      //vector<account_balance_object> balances;
-      std::for_each(balance_range.first, balance_range.second,
-                    [&acnt](const account_balance_object& balance) {
-                       acnt.balances.emplace_back(balance);
-                    });
+      for( const auto& balance : _db.get_index_type<account_balance_index>().get_account_balances( account->id ) )
+         acnt.balances.emplace_back( *balance.second );
 
       // Add the account's vesting balances
       auto vesting_range = _db.get_index_type<vesting_balance_index>().indices().get<by_account>().equal_range(account->id);
@@ -609,9 +664,136 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
    return results;
 }
 
+conditional_full_accounts database_api::get_full_accounts_since( const vector<string>& names_or_ids, uint64_t known_revision, bool subscribe )
+{
+   return run_read( my->_read_pool, "get_full_accounts_since", [&]() { return my->get_full_accounts_since( names_or_ids, known_revision, subscribe ); } );
+}
+
+conditional_full_accounts database_api_impl::get_full_accounts_since( const vector<string>& names_or_ids, uint64_t known_revision, bool subscribe )
+{
+   conditional_full_accounts results;
+   results.revision = _db.get_revision();
+
+   for( const std::string& account_name_or_id : names_or_ids )
+   {
+      const account_object* account = find_account( account_name_or_id );
+      if( account == nullptr )
+         continue;
+
+      if( subscribe )
+         subscribe_to_item( account->id );
+
+      full_account_changes acnt;
+      bool any_change = false;
+
+      if( changed_since( account->id, known_revision ) )
+      {
+         acnt.account = *account;
+         acnt.registrar_name = account->registrar(_db).name;
+         acnt.referrer_name = account->referrer(_db).name;
+         acnt.lifetime_referrer_name = account->lifetime_referrer(_db).name;
+         any_change = true;
+      }
+      if( changed_since( account->statistics, known_revision ) )
+      {
+         acnt.statistics = account->statistics(_db);
+         any_change = true;
+      }
+
+      bool votes_changed = acnt.account.valid();
+      for( object_id_type id : lookup_vote_object_ids( account->options.votes ) )
+         votes_changed = votes_changed || changed_since( id, known_revision );
+      if( votes_changed )
+      {
+         acnt.votes = lookup_vote_ids( vector<vote_id_type>(account->options.votes.begin(),account->options.votes.end()) );
+         any_change = true;
+      }
+
+      if( account->cashback_vb && changed_since( *account->cashback_vb, known_revision ) )
+      {
+         acnt.cashback_balance = account->cashback_balance(_db);
+         any_change = true;
+      }
+
+      const auto& proposal_idx = _db.get_index_type<proposal_index>();
+      const auto& pidx = dynamic_cast<const primary_index<proposal_index>&>(proposal_idx);
+      const auto& proposals_by_account = pidx.get_secondary_index<graphene::chain::required_approval_index>();
+      auto required_approvals_itr = proposals_by_account._account_to_proposals.find( account->id );
+      if( required_approvals_itr != proposals_by_account._account_to_proposals.end() )
+      {
+         bool proposals_changed = _db.get_removal_revision( proposal_object::space_id, proposal_object::type_id ) > known_revision;
+         for( auto proposal_id : required_approvals_itr->second )
+            proposals_changed = proposals_changed || changed_since( proposal_id, known_revision );
+         if( proposals_changed )
+         {
+            acnt.proposals = vector<proposal_object>();
+            for( auto proposal_id : required_approvals_itr->second )
+               acnt.proposals->push_back( proposal_id(_db) );
+            any_change = true;
+         }
+      }
+      else if( _db.get_removal_revision( proposal_object::space_id, proposal_object::type_id ) > known_revision )
+      {
+         acnt.proposals = vector<proposal_object>();
+         any_change = true;
+      }
+
+      const auto& balances = _db.get_index_type<account_balance_index>().get_account_balances( account->id );
+      bool balances_changed = _db.get_removal_revision( account_balance_object::space_id, account_balance_object::type_id ) > known_revision;
+      for( auto itr = balances.begin(); !balances_changed && itr != balances.end(); ++itr )
+         balances_changed = changed_since( itr->second->id, known_revision );
+      if( balances_changed )
+      {
+         acnt.balances = vector<account_balance_object>();
+         for( const auto& balance : balances )
+            acnt.balances->push_back( *balance.second );
+         any_change = true;
+      }
+
+      auto vesting_range = _db.get_index_type<vesting_balance_index>().indices().get<by_account>().equal_range(account->id);
+      if( range_changed_since<vesting_balance_object>( vesting_range.first, vesting_range.second, known_revision ) )
+      {
+         acnt.vesting_balances = vector<vesting_balance_object>( vesting_range.first, vesting_range.second );
+         any_change = true;
+      }
+
+      auto order_range = _db.get_index_type<limit_order_index>().indices().get<by_account>().equal_range(account->id);
+      if( range_changed_since<limit_order_object>( order_range.first, order_range.second, known_revision ) )
+      {
+         acnt.limit_orders = vector<limit_order_object>( order_range.first, order_range.second );
+         any_change = true;
+      }
+
+      auto call_range = _db.get_index_type<call_order_index>().indices().get<by_account>().equal_range(account->id);
+      if( range_changed_since<call_order_object>( call_range.first, call_range.second, known_revision ) )
+      {
+         acnt.call_orders = vector<call_order_object>( call_range.first, call_range.second );
+         any_change = true;
+      }
+
+      if( any_change )
+         results.accounts[account_name_or_id] = std::move(acnt);
+   }
+   return results;
+}
+
+const account_object* database_api_impl::find_account( const std::string& name_or_id )const
+{
+   if( name_or_id.empty() )
+      return nullptr;
+   if( std::isdigit(name_or_id[0]) )
+      return _db.find(fc::variant(name_or_id).as<account_id_type>());
+
+   const auto& idx = _db.get_index_type<account_index>().indices().get<by_name>();
+   auto itr = idx.find(name_or_id);
+   if( itr != idx.end() )
+      return &*itr;
+   return nullptr;
+}
+
 optional<account_object> database_api::get_account_by_name( string name )const
 {
-   return my->get_account_by_name( name );
+   return run_read( my->_read_pool, "get_account_by_name", [&]() { return my->get_account_by_name( name ); } );
 }
 
 optional<account_object> database_api_impl::get_account_by_name( string name )const
@@ -625,7 +807,7 @@ optional<account_object> database_api_impl::get_account_by_name( string name )co
 
 vector<account_id_type> database_api::get_account_references( account_id_type account_id )const
 {
-   return my->get_account_references( account_id );
+   return run_read( my->_read_pool, "get_account_references", [&]() { return my->get_account_references( account_id ); } );
 }
 
 vector<account_id_type> database_api_impl::get_account_references( account_id_type account_id )const
@@ -646,7 +828,7 @@ vector<account_id_type> database_api_impl::get_account_references( account_id_ty
 
 vector<optional<account_object>> database_api::lookup_account_names(const vector<string>& account_names)const
 {
-   return my->lookup_account_names( account_names );
+   return run_read( my->_read_pool, "lookup_account_names", [&]() { return my->lookup_account_names( account_names ); } );
 }
 
 vector<optional<account_object>> database_api_impl::lookup_account_names(const vector<string>& account_names)const
@@ -664,7 +846,7 @@ vector<optional<account_object>> database_api_impl::lookup_account_names(const v
 
 map<string,account_id_type> database_api::lookup_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_accounts( lower_bound_name, limit );
+   return run_read( my->_read_pool, "lookup_accounts", [&]() { return my->lookup_accounts( lower_bound_name, limit ); } );
 }
 
 map<string,account_id_type> database_api_impl::lookup_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -703,7 +885,7 @@ uint64_t database_api_impl::get_account_count()const
 
 vector<asset> database_api::get_account_balances(account_id_type id, const flat_set<asset_id_type>& assets)const
 {
-   return my->get_account_balances( id, assets );
+   return run_read( my->_read_pool, "get_account_balances", [&]() { return my->get_account_balances( id, assets ); } );
 }
 
 vector<asset> database_api_impl::get_account_balances(account_id_type acnt, const flat_set<asset_id_type>& assets)const
@@ -713,9 +895,8 @@ vector<asset> database_api_impl::get_account_balances(account_id_type acnt, cons
    {
       // if the caller passes in an empty list of assets, return balances for all assets the account owns
       const account_balance_index& balance_index = _db.get_index_type<account_balance_index>();
-      auto range = balance_index.indices().get<by_account_asset>().equal_range(boost::make_tuple(acnt));
-      for (const account_balance_object& balance : boost::make_iterator_range(range.first, range.second))
-         result.push_back(asset(balance.get_balance()));
+      for( const auto& balance : balance_index.get_account_balances( acnt ) )
+         result.push_back( balance.second->get_balance() );
    }
    else
    {
@@ -730,7 +911,7 @@ vector<asset> database_api_impl::get_account_balances(account_id_type acnt, cons
 
 vector<asset> database_api::get_named_account_balances(const std::string& name, const flat_set<asset_id_type>& assets)const
 {
-   return my->get_named_account_balances( name, assets );
+   return run_read( my->_read_pool, "get_named_account_balances", [&]() { return my->get_named_account_balances( name, assets ); } );
 }
 
 vector<asset> database_api_impl::get_named_account_balances(const std::string& name, const flat_set<asset_id_type>& assets) const
@@ -743,7 +924,7 @@ vector<asset> database_api_impl::get_named_account_balances(const std::string& n
 
 vector<balance_object> database_api::get_balance_objects( const vector<address>& addrs )const
 {
-   return my->get_balance_objects( addrs );
+   return run_read( my->_read_pool, "get_balance_objects", [&]() { return my->get_balance_objects( addrs ); } );
 }
 
 vector<balance_object> database_api_impl::get_balance_objects( const vector<address>& addrs )const
@@ -772,7 +953,7 @@ vector<balance_object> database_api_impl::get_balance_objects( const vector<addr
 
 vector<asset> database_api::get_vested_balances( const vector<balance_id_type>& objs )const
 {
-   return my->get_vested_balances( objs );
+   return run_read( my->_read_pool, "get_vested_balances", [&]() { return my->get_vested_balances( objs ); } );
 }
 
 vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_type>& objs )const
@@ -790,7 +971,7 @@ vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_ty
 
 vector<vesting_balance_object> database_api::get_vesting_balances( account_id_type account_id )const
 {
-   return my->get_vesting_balances( account_id );
+   return run_read( my->_read_pool, "get_vesting_balances", [&]() { return my->get_vesting_balances( account_id ); } );
 }
 
 vector<vesting_balance_object> database_api_impl::get_vesting_balances( account_id_type account_id )const
@@ -816,7 +997,7 @@ vector<vesting_balance_object> database_api_impl::get_vesting_balances( account_
 
 vector<optional<asset_object>> database_api::get_assets(const vector<asset_id_type>& asset_ids)const
 {
-   return my->get_assets( asset_ids );
+   return run_read( my->_read_pool, "get_assets", [&]() { return my->get_assets( asset_ids ); } );
 }
 
 vector<optional<asset_object>> database_api_impl::get_assets(const vector<asset_id_type>& asset_ids)const
@@ -836,7 +1017,7 @@ vector<optional<asset_object>> database_api_impl::get_assets(const vector<asset_
 
 vector<asset_object> database_api::list_assets(const string& lower_bound_symbol, uint32_t limit)const
 {
-   return my->list_assets( lower_bound_symbol, limit );
+   return run_read( my->_read_pool, "list_assets", [&]() { return my->list_assets( lower_bound_symbol, limit ); } );
 }
 
 vector<asset_object> database_api_impl::list_assets(const string& lower_bound_symbol, uint32_t limit)const
@@ -859,7 +1040,7 @@ vector<asset_object> database_api_impl::list_assets(const string& lower_bound_sy
 
 vector<optional<asset_object>> database_api::lookup_asset_symbols(const vector<string>& symbols_or_ids)const
 {
-   return my->lookup_asset_symbols( symbols_or_ids );
+   return run_read( my->_read_pool, "lookup_asset_symbols", [&]() { return my->lookup_asset_symbols( symbols_or_ids ); } );
 }
 
 vector<optional<asset_object>> database_api_impl::lookup_asset_symbols(const vector<string>& symbols_or_ids)const
@@ -888,7 +1069,7 @@ vector<optional<asset_object>> database_api_impl::lookup_asset_symbols(const vec
 
 vector<limit_order_object> database_api::get_limit_orders(asset_id_type a, asset_id_type b, uint32_t limit)const
 {
-   return my->get_limit_orders( a, b, limit );
+   return run_read( my->_read_pool, "get_limit_orders", [&]() { return my->get_limit_orders( a, b, limit ); } );
 }
 
 /**
@@ -896,64 +1077,128 @@ vector<limit_order_object> database_api::get_limit_orders(asset_id_type a, asset
  */
 vector<limit_order_object> database_api_impl::get_limit_orders(asset_id_type a, asset_id_type b, uint32_t limit)const
 {
-   const auto& limit_order_idx = _db.get_index_type<limit_order_index>();
-   const auto& limit_price_idx = limit_order_idx.indices().get<by_price>();
+   limit = std::min<uint32_t>( limit, 300 );
+   vector<limit_order_object> result = get_limit_orders_page( a, b, limit, optional<price>(), optional<limit_order_id_type>() );
+   vector<limit_order_object> other_side = get_limit_orders_page( b, a, limit, optional<price>(), optional<limit_order_id_type>() );
+   result.insert( result.end(), other_side.begin(), other_side.end() );
+   return result;
+}
 
-   vector<limit_order_object> result;
+/**
+ *  Copies up to limit objects starting at itr.  Paginated queries resume strictly after the sort
+ *  key of the last object of the previous page, so a page costs one O(log n) seek no matter how
+ *  deep into the range it is and resuming still works when that object is gone by now.
+ */
+template<typename ObjectType, typename Iterator>
+static vector<ObjectType> copy_page( Iterator itr, Iterator end, uint32_t limit )
+{
+   vector<ObjectType> result;
+   for( ; itr != end && result.size() < limit; ++itr )
+      result.push_back( *itr );
+   return result;
+}
+
+vector<limit_order_object> database_api::get_limit_orders_page(asset_id_type a, asset_id_type b, uint32_t limit,
+                                                               optional<price> start_price, optional<limit_order_id_type> start_id)const
+{
+   return run_read( my->_read_pool, "get_limit_orders_page", [&]() { return my->get_limit_orders_page( a, b, limit, start_price, start_id ); } );
+}
+
+vector<limit_order_object> database_api_impl::get_limit_orders_page(asset_id_type a, asset_id_type b, uint32_t limit,
+                                                                    optional<price> start_price, optional<limit_order_id_type> start_id)const
+{
+   FC_ASSERT( limit <= 300 );
+   const auto& limit_price_idx = _db.get_index_type<limit_order_index>().indices().get<by_price>();
 
-   uint32_t count = 0;
    auto limit_itr = limit_price_idx.lower_bound(price::max(a,b));
    auto limit_end = limit_price_idx.upper_bound(price::min(a,b));
-   while(limit_itr != limit_end && count < limit)
-   {
-      result.push_back(*limit_itr);
-      ++limit_itr;
-      ++count;
-   }
-   count = 0;
-   limit_itr = limit_price_idx.lower_bound(price::max(b,a));
-   limit_end = limit_price_idx.upper_bound(price::min(b,a));
-   while(limit_itr != limit_end && count < limit)
+   if( start_price )
    {
-      result.push_back(*limit_itr);
-      ++limit_itr;
-      ++count;
+      FC_ASSERT( start_price->base.asset_id == a && start_price->quote.asset_id == b, "start_price must be a price of this market" );
+      if( start_id )
+         limit_itr = limit_price_idx.upper_bound( boost::make_tuple( *start_price, object_id_type(*start_id) ) );
+      else
+         limit_itr = limit_price_idx.lower_bound( boost::make_tuple( *start_price ) );
    }
-
-   return result;
+   return copy_page<limit_order_object>( limit_itr, limit_end, limit );
 }
 
 vector<call_order_object> database_api::get_call_orders(asset_id_type a, uint32_t limit)const
 {
-   return my->get_call_orders( a, limit );
+   return run_read( my->_read_pool, "get_call_orders", [&]() { return my->get_call_orders( a, limit ); } );
 }
 
 vector<call_order_object> database_api_impl::get_call_orders(asset_id_type a, uint32_t limit)const
 {
+   return get_call_orders_page( a, std::min<uint32_t>( limit, 300 ), optional<price>(), optional<call_order_id_type>() );
+}
+
+vector<call_order_object> database_api::get_call_orders_page(asset_id_type a, uint32_t limit,
+                                                             optional<price> start_price, optional<call_order_id_type> start_id)const
+{
+   return run_read( my->_read_pool, "get_call_orders_page", [&]() { return my->get_call_orders_page( a, limit, start_price, start_id ); } );
+}
+
+vector<call_order_object> database_api_impl::get_call_orders_page(asset_id_type a, uint32_t limit,
+                                                                  optional<price> start_price, optional<call_order_id_type> start_id)const
+{
+   FC_ASSERT( limit <= 300 );
    const auto& call_index = _db.get_index_type<call_order_index>().indices().get<by_price>();
    const asset_object& mia = _db.get(a);
    price index_price = price::min(mia.bitasset_data(_db).options.short_backing_asset, mia.get_id());
 
-   return vector<call_order_object>(call_index.lower_bound(index_price.min()),
-                                    call_index.lower_bound(index_price.max()));
+   auto call_itr = call_index.lower_bound(index_price.min());
+   auto call_end = call_index.lower_bound(index_price.max());
+   if( start_price )
+   {
+      FC_ASSERT( start_price->base.asset_id == index_price.base.asset_id && start_price->quote.asset_id == index_price.quote.asset_id,
+                 "start_price must be a call price of this asset" );
+      if( start_id )
+         call_itr = call_index.upper_bound( boost::make_tuple( *start_price, object_id_type(*start_id) ) );
+      else
+         call_itr = call_index.lower_bound( boost::make_tuple( *start_price ) );
+   }
+   return copy_page<call_order_object>( call_itr, call_end, limit );
 }
 
 vector<force_settlement_object> database_api::get_settle_orders(asset_id_type a, uint32_t limit)const
 {
-   return my->get_settle_orders( a, limit );
+   return run_read( my->_read_pool, "get_settle_orders", [&]() { return my->get_settle_orders( a, limit ); } );
 }
 
 vector<force_settlement_object> database_api_impl::get_settle_orders(asset_id_type a, uint32_t limit)const
 {
+   return get_settle_orders_page( a, std::min<uint32_t>( limit, 300 ), optional<time_point_sec>(), optional<force_settlement_id_type>() );
+}
+
+vector<force_settlement_object> database_api::get_settle_orders_page(asset_id_type a, uint32_t limit,
+                                                                     optional<time_point_sec> start_date, optional<force_settlement_id_type> start_id)const
+{
+   return run_read( my->_read_pool, "get_settle_orders_page", [&]() { return my->get_settle_orders_page( a, limit, start_date, start_id ); } );
+}
+
+vector<force_settlement_object> database_api_impl::get_settle_orders_page(asset_id_type a, uint32_t limit,
+                                                                          optional<time_point_sec> start_date, optional<force_settlement_id_type> start_id)const
+{
+   FC_ASSERT( limit <= 300 );
    const auto& settle_index = _db.get_index_type<force_settlement_index>().indices().get<by_expiration>();
    const asset_object& mia = _db.get(a);
-   return vector<force_settlement_object>(settle_index.lower_bound(mia.get_id()),
-                                          settle_index.upper_bound(mia.get_id()));
+
+   auto settle_itr = settle_index.lower_bound(mia.get_id());
+   auto settle_end = settle_index.upper_bound(mia.get_id());
+   if( start_date )
+   {
+      if( start_id )
+         settle_itr = settle_index.upper_bound( boost::make_tuple( mia.get_id(), *start_date, object_id_type(*start_id) ) );
+      else
+         settle_itr = settle_index.lower_bound( boost::make_tuple( mia.get_id(), *start_date ) );
+   }
+   return copy_page<force_settlement_object>( settle_itr, settle_end, limit );
 }
 
 vector<call_order_object> database_api::get_margin_positions( const account_id_type& id )const
 {
-   return my->get_margin_positions( id );
+   return run_read( my->_read_pool, "get_margin_positions", [&]() { return my->get_margin_positions( id ); } );
 }
 
 vector<call_order_object> database_api_impl::get_margin_positions( const account_id_type& id )const
@@ -998,6 +1243,52 @@ void database_api_impl::unsubscribe_from_market(asset_id_type a, asset_id_type b
    _market_subscriptions.erase(std::make_pair(a,b));
 }
 
+market_depth_snapshot database_api::get_market_depth( asset_id_type base, asset_id_type quote, uint32_t limit )const
+{
+   return my->get_market_depth( base, quote, limit );
+}
+
+market_depth_snapshot database_api_impl::get_market_depth( asset_id_type base, asset_id_type quote, uint32_t limit )const
+{
+   FC_ASSERT( limit <= 1000 );
+   FC_ASSERT( base != quote );
+   if( _market_depth )
+      return _market_depth->get_snapshot( base, quote, limit );
+   return market_depth::aggregate_orders( _db, base, quote, limit );
+}
+
+market_depth_snapshot database_api::subscribe_to_market_depth( std::function<void(const variant&)> callback,
+                                                               asset_id_type base, asset_id_type quote, uint32_t limit )
+{
+   return my->subscribe_to_market_depth( callback, base, quote, limit );
+}
+
+market_depth_snapshot database_api_impl::subscribe_to_market_depth( std::function<void(const variant&)> callback,
+                                                                    asset_id_type base, asset_id_type quote, uint32_t limit )
+{
+   FC_ASSERT( limit <= 1000 );
+   FC_ASSERT( base != quote );
+   auto market = base < quote ? std::make_pair( base, quote ) : std::make_pair( quote, base );
+   auto& depth = depth_tracker();
+   if( _market_depth_subscriptions.find( market ) == _market_depth_subscriptions.end() )
+      depth.track( base, quote );
+   _market_depth_subscriptions[market] = callback;
+   return depth.get_snapshot( base, quote, limit );
+}
+
+void database_api::unsubscribe_from_market_depth( asset_id_type a, asset_id_type b )
+{
+   my->unsubscribe_from_market_depth( a, b );
+}
+
+void database_api_impl::unsubscribe_from_market_depth( asset_id_type a, asset_id_type b )
+{
+   if( a > b ) std::swap( a, b );
+   FC_ASSERT( a != b );
+   if( _market_depth_subscriptions.erase( std::make_pair( a, b ) ) )
+      _market_depth->untrack( a, b );
+}
+
 market_ticker database_api::get_ticker( const string& base, const string& quote )const
 {
    return my->get_ticker( base, quote );
@@ -1115,7 +1406,7 @@ market_volume database_api_impl::get_24_volume( const string& base, const string
 
 order_book database_api::get_order_book( const string& base, const string& quote, unsigned limit )const
 {
-   return my->get_order_book( base, quote, limit);
+   return run_read( my->_read_pool, "get_order_book", [&]() { return my->get_order_book( base, quote, limit); } );
 }
 
 order_book database_api_impl::get_order_book( const string& base, const string& quote, unsigned limit )const
@@ -1174,7 +1465,7 @@ vector<market_trade> database_api::get_trade_history( const string& base,
                                                       fc::time_point_sec stop,
                                                       unsigned limit )const
 {
-   return my->get_trade_history( base, quote, start, stop, limit );
+   return run_read( my->_read_pool, "get_trade_history", [&]() { return my->get_trade_history( base, quote, start, stop, limit ); } );
 }
 
 vector<market_trade> database_api_impl::get_trade_history( const string& base,
@@ -1248,7 +1539,7 @@ vector<market_trade> database_api_impl::get_trade_history( const string& base,
 
 vector<optional<witness_object>> database_api::get_witnesses(const vector<witness_id_type>& witness_ids)const
 {
-   return my->get_witnesses( witness_ids );
+   return run_read( my->_read_pool, "get_witnesses", [&]() { return my->get_witnesses( witness_ids ); } );
 }
 
 vector<worker_object> database_api::get_workers_by_account(account_id_type account)const
@@ -1281,7 +1572,7 @@ vector<optional<witness_object>> database_api_impl::get_witnesses(const vector<w
 
 fc::optional<witness_object> database_api::get_witness_by_account(account_id_type account)const
 {
-   return my->get_witness_by_account( account );
+   return run_read( my->_read_pool, "get_witness_by_account", [&]() { return my->get_witness_by_account( account ); } );
 }
 
 fc::optional<witness_object> database_api_impl::get_witness_by_account(account_id_type account) const
@@ -1295,7 +1586,7 @@ fc::optional<witness_object> database_api_impl::get_witness_by_account(account_i
 
 map<string, witness_id_type> database_api::lookup_witness_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_witness_accounts( lower_bound_name, limit );
+   return run_read( my->_read_pool, "lookup_witness_accounts", [&]() { return my->lookup_witness_accounts( lower_bound_name, limit ); } );
 }
 
 map<string, witness_id_type> database_api_impl::lookup_witness_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -1339,7 +1630,7 @@ uint64_t database_api_impl::get_witness_count()const
 
 vector<optional<committee_member_object>> database_api::get_committee_members(const vector<committee_member_id_type>& committee_member_ids)const
 {
-   return my->get_committee_members( committee_member_ids );
+   return run_read( my->_read_pool, "get_committee_members", [&]() { return my->get_committee_members( committee_member_ids ); } );
 }
 
 vector<optional<committee_member_object>> database_api_impl::get_committee_members(const vector<committee_member_id_type>& committee_member_ids)const
@@ -1356,7 +1647,7 @@ vector<optional<committee_member_object>> database_api_impl::get_committee_membe
 
 fc::optional<committee_member_object> database_api::get_committee_member_by_account(account_id_type account)const
 {
-   return my->get_committee_member_by_account( account );
+   return run_read( my->_read_pool, "get_committee_member_by_account", [&]() { return my->get_committee_member_by_account( account ); } );
 }
 
 fc::optional<committee_member_object> database_api_impl::get_committee_member_by_account(account_id_type account) const
@@ -1370,7 +1661,7 @@ fc::optional<committee_member_object> database_api_impl::get_committee_member_by
 
 map<string, committee_member_id_type> database_api::lookup_committee_member_accounts(const string& lower_bound_name, uint32_t limit)const
 {
-   return my->lookup_committee_member_accounts( lower_bound_name, limit );
+   return run_read( my->_read_pool, "lookup_committee_member_accounts", [&]() { return my->lookup_committee_member_accounts( lower_bound_name, limit ); } );
 }
 
 map<string, committee_member_id_type> database_api_impl::lookup_committee_member_accounts(const string& lower_bound_name, uint32_t limit)const
@@ -1404,7 +1695,7 @@ map<string, committee_member_id_type> database_api_impl::lookup_committee_member
 
 vector<variant> database_api::lookup_vote_ids( const vector<vote_id_type>& votes )const
 {
-   return my->lookup_vote_ids( votes );
+   return run_read( my->_read_pool, "lookup_vote_ids", [&]() { return my->lookup_vote_ids( votes ); } );
 }
 
 vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>& votes )const
@@ -1463,6 +1754,52 @@ vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>&
    return result;
 }
 
+vector<object_id_type> database_api_impl::lookup_vote_object_ids( const flat_set<vote_id_type>& votes )const
+{
+   const auto& witness_idx = _db.get_index_type<witness_index>().indices().get<by_vote_id>();
+   const auto& committee_idx = _db.get_index_type<committee_member_index>().indices().get<by_vote_id>();
+   const auto& for_worker_idx = _db.get_index_type<worker_index>().indices().get<by_vote_for>();
+   const auto& against_worker_idx = _db.get_index_type<worker_index>().indices().get<by_vote_against>();
+
+   vector<object_id_type> result;
+   result.reserve( votes.size() );
+   for( auto id : votes )
+   {
+      switch( id.type() )
+      {
+         case vote_id_type::committee:
+         {
+            auto itr = committee_idx.find( id );
+            if( itr != committee_idx.end() )
+               result.push_back( itr->id );
+            break;
+         }
+         case vote_id_type::witness:
+         {
+            auto itr = witness_idx.find( id );
+            if( itr != witness_idx.end() )
+               result.push_back( itr->id );
+            break;
+         }
+         case vote_id_type::worker:
+         {
+            auto itr = for_worker_idx.find( id );
+            if( itr != for_worker_idx.end() )
+               result.push_back( itr->id );
+            else
+            {
+               auto against = against_worker_idx.find( id );
+               if( against != against_worker_idx.end() )
+                  result.push_back( against->id );
+            }
+            break;
+         }
+         case vote_id_type::VOTE_TYPE_COUNT: break; // supress unused enum value warnings
+      }
+   }
+   return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Authority / validation                                           //
@@ -1481,7 +1818,7 @@ std::string database_api_impl::get_transaction_hex(const signed_transaction& trx
 
 set<public_key_type> database_api::get_required_signatures( const signed_transaction& trx, const flat_set<public_key_type>& available_keys )const
 {
-   return my->get_required_signatures( trx, available_keys );
+   return run_read( my->_read_pool, "get_required_signatures", [&]() { return my->get_required_signatures( trx, available_keys ); } );
 }
 
 set<public_key_type> database_api_impl::get_required_signatures( const signed_transaction& trx, const flat_set<public_key_type>& available_keys )const
@@ -1498,11 +1835,11 @@ set<public_key_type> database_api_impl::get_required_signatures( const signed_tr
 
 set<public_key_type> database_api::get_potential_signatures( const signed_transaction& trx )const
 {
-   return my->get_potential_signatures( trx );
+   return run_read( my->_read_pool, "get_potential_signatures", [&]() { return my->get_potential_signatures( trx ); } );
 }
 set<address> database_api::get_potential_address_signatures( const signed_transaction& trx )const
 {
-   return my->get_potential_address_signatures( trx );
+   return run_read( my->_read_pool, "get_potential_address_signatures", [&]() { return my->get_potential_address_signatures( trx ); } );
 }
 
 set<public_key_type> database_api_impl::get_potential_signatures( const signed_transaction& trx )const
@@ -1560,7 +1897,7 @@ set<address> database_api_impl::get_potential_address_signatures( const signed_t
 
 bool database_api::verify_authority( const signed_transaction& trx )const
 {
-   return my->verify_authority( trx );
+   return run_read( my->_read_pool, "verify_authority", [&]() { return my->verify_authority( trx ); } );
 }
 
 bool database_api_impl::verify_authority( const signed_transaction& trx )const
@@ -1574,7 +1911,7 @@ bool database_api_impl::verify_authority( const signed_transaction& trx )const
 
 bool database_api::verify_account_authority( const string& name_or_id, const flat_set<public_key_type>& signers )const
 {
-   return my->verify_account_authority( name_or_id, signers );
+   return run_read( my->_read_pool, "verify_account_authority", [&]() { return my->verify_account_authority( name_or_id, signers ); } );
 }
 
 bool database_api_impl::verify_account_authority( const string& name_or_id, const flat_set<public_key_type>& keys )const
@@ -1614,7 +1951,7 @@ processed_transaction database_api_impl::validate_transaction( const signed_tran
 
 vector< fc::variant > database_api::get_required_fees( const vector<operation>& ops, asset_id_type id )const
 {
-   return my->get_required_fees( ops, id );
+   return run_read( my->_read_pool, "get_required_fees", [&]() { return my->get_required_fees( ops, id ); } );
 }
 
 /**
@@ -1703,7 +2040,7 @@ vector< fc::variant > database_api_impl::get_required_fees( const vector<operati
 
 vector<proposal_object> database_api::get_proposed_transactions( account_id_type id )const
 {
-   return my->get_proposed_transactions( id );
+   return run_read( my->_read_pool, "get_proposed_transactions", [&]() { return my->get_proposed_transactions( id ); } );
 }
 
 /** TODO: add secondary index that will accelerate this process */
@@ -1755,29 +2092,46 @@ vector<blinded_balance_object> database_api_impl::get_blinded_balances( const fl
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-void database_api_impl::broadcast_updates( const vector<variant>& updates )
+market_depth& database_api_impl::depth_tracker()
 {
-   if( updates.size() ) {
-      auto capture_this = shared_from_this();
-      fc::async([capture_this,updates](){
-          capture_this->_subscribe_callback( fc::variant(updates) );
-      });
-   }
+   if( !_market_depth )
+      _market_depth = market_depth::create( _db );
+   if( !_market_depth_connection.connected() )
+      _market_depth_connection = _market_depth->depth_changed.connect(
+         [this]( const map< pair<asset_id_type,asset_id_type>, fc::variant >& deltas ) {
+            on_market_depth_changed( deltas );
+         });
+   return *_market_depth;
 }
 
-void database_api_impl::on_objects_removed( const vector<const object*>& objs )
+void database_api_impl::on_market_depth_changed( const map< pair<asset_id_type,asset_id_type>, fc::variant >& deltas )
 {
-   /// we need to ensure the database_api is not deleted for the life of the async operation
-   if( _subscribe_callback )
-   {
-      vector<variant>    updates;
-      updates.reserve(objs.size());
+   vector<fc::variant> queue;
+   vector< pair<asset_id_type,asset_id_type> > markets;
+   for( const auto& item : deltas )
+      if( _market_depth_subscriptions.find( item.first ) != _market_depth_subscriptions.end() )
+      {
+         markets.push_back( item.first );
+         queue.push_back( item.second );
+      }
+   if( queue.empty() )
+      return;
 
-      for( auto obj : objs )
-         updates.emplace_back( obj->id );
-      broadcast_updates( updates );
-   }
+   /// we need to ensure the database_api is not deleted for the life of the async operation
+   auto capture_this = shared_from_this();
+   fc::async([capture_this,this,markets,queue](){
+      for( size_t i = 0; i < markets.size(); ++i )
+      {
+         auto sub = _market_depth_subscriptions.find( markets[i] );
+         if( sub != _market_depth_subscriptions.end() )
+            sub->second( queue[i] );
+      }
+   });
+}
 
+/** removals are reported to the subscribe callback by the notification hub */
+void database_api_impl::on_objects_removed( const vector<const object*>& objs )
+{
    if( _market_subscriptions.size() )
    {
       map< pair<asset_id_type, asset_id_type>, vector<variant> > broadcast_queue;
@@ -1806,52 +2160,34 @@ void database_api_impl::on_objects_removed( const vector<const object*>& objs )
    }
 }
 
+/** changed objects are reported to the subscribe callback by the notification hub */
 void database_api_impl::on_objects_changed(const vector<object_id_type>& ids)
 {
-   vector<variant>    updates;
-   map< pair<asset_id_type, asset_id_type>,  vector<variant> > market_broadcast_queue;
+   if( _market_subscriptions.empty() )
+      return;
 
+   map< pair<asset_id_type, asset_id_type>,  vector<variant> > market_broadcast_queue;
    for(auto id : ids)
    {
-      const object* obj = nullptr;
-      if( _subscribe_callback )
-      {
-         obj = _db.find_object( id );
-         if( obj )
-         {
-            updates.emplace_back( obj->to_variant() );
-         }
-         else
-         {
-            updates.emplace_back(id); // send just the id to indicate removal
-         }
-      }
-
-      if( _market_subscriptions.size() )
+      if( id.space() != limit_order_id_type::space_id || id.type() != limit_order_id_type::type_id )
+         continue;
+      const limit_order_object* order = static_cast<const limit_order_object*>( _db.find_object( id ) );
+      if( order )
       {
-         if( !_subscribe_callback )
-            obj = _db.find_object( id );
-         if( obj )
-         {
-            const limit_order_object* order = dynamic_cast<const limit_order_object*>(obj);
-            if( order )
-            {
-               auto sub = _market_subscriptions.find( order->get_market() );
-               if( sub != _market_subscriptions.end() )
-                  market_broadcast_queue[order->get_market()].emplace_back( order->id );
-            }
-         }
+         auto sub = _market_subscriptions.find( order->get_market() );
+         if( sub != _market_subscriptions.end() )
+            market_broadcast_queue[order->get_market()].emplace_back( order->id );
       }
    }
+   if( market_broadcast_queue.empty() )
+      return;
 
    auto capture_this = shared_from_this();
 
    /// pushing the future back / popping the prior future if it is complete.
    /// if a connection hangs then this could get backed up and result in
    /// a failure to exit cleanly.
-   fc::async([capture_this,this,updates,market_broadcast_queue](){
-      if( _subscribe_callback ) _subscribe_callback( updates );
-
+   fc::async([capture_this,this,market_broadcast_queue](){
       for( const auto& item : market_broadcast_queue )
       {
         auto sub = _market_subscriptions.find(item.first);
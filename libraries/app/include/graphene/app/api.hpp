@@ -111,6 +111,17 @@ namespace graphene { namespace app {
                                                                         uint32_t start = 0) const;
 
          vector<order_history_object> get_fill_order_history( asset_id_type a, asset_id_type b, uint32_t limit )const;
+         /**
+          * @brief Same as get_fill_order_history, but continues after start_sequence
+          * @param start_sequence key.sequence of the last fill of the previous page, null to start with the most recent fill
+          */
+         vector<order_history_object> get_fill_order_history_page( asset_id_type a, asset_id_type b, uint32_t limit,
+                                                                   optional<int64_t> start_sequence )const;
+         /**
+          * @brief Get the OHLCV buckets of a market opened between start and end, oldest first
+          * @return at most 1000 buckets; the node only keeps the buckets opened within history-per-size bucket
+          *         lengths of the newest bucket of the market
+          */
          vector<bucket_object> get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
                                                    fc::time_point_sec start, fc::time_point_sec end )const;
          flat_set<uint32_t> get_market_history_buckets()const;
@@ -314,6 +325,7 @@ FC_API(graphene::app::history_api,
        (get_account_history)
        (get_relative_account_history)
        (get_fill_order_history)
+       (get_fill_order_history_page)
        (get_market_history)
        (get_market_history_buckets)
      )
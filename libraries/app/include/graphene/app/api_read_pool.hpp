@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/database.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace graphene { namespace app {
+   using namespace graphene::chain;
+
+   /**
+    *  @class api_read_pool
+    *  @brief runs read-only API calls on a pool of threads next to block application
+    *
+    *  Each call runs on one of the pool's threads while holding database::read_lock(), so any number
+    *  of calls read the object graph at once and block application waits until they are done.  The
+    *  calling task waits for the result, which keeps the order of calls and replies of a connection.
+    *
+    *  A call must only read the database and state which is safe to share between threads; calls
+    *  which read the block log or touch per-session state other than object subscriptions have to
+    *  stay on the main thread.
+    *
+    *  The number of calls of one method running at once can be limited, calls above the limit are
+    *  rejected right away so that a flood of expensive queries cannot take all threads.
+    */
+   class api_read_pool
+   {
+      public:
+         /** @param default_method_limit limit of methods without one of their own, 0 for no limit */
+         api_read_pool( database& db, uint32_t threads, uint32_t default_method_limit = 0 );
+         ~api_read_pool();
+
+         /** at most limit calls of method run at once, 0 removes the limit */
+         void set_method_limit( const std::string& method, uint32_t limit );
+
+         size_t threads()const { return _threads.size(); }
+
+         template<typename Lambda>
+         auto run( const char* method, Lambda&& l ) -> decltype( l() )
+         {
+            method_slot slot( *this, method );
+            database& db = _db;
+            return next_thread().async( [&db, &l]() -> decltype( l() ) {
+               auto lock = db.read_lock();
+               return l();
+            }, method ).wait();
+         }
+
+      private:
+         /** counts a call of a method as running for the life of the slot */
+         struct method_slot
+         {
+            method_slot( api_read_pool& pool, const char* method ) : _pool( pool ), _method( method ) { _pool.acquire( _method ); }
+            ~method_slot() { _pool.release( _method ); }
+            api_read_pool&  _pool;
+            std::string     _method;
+         };
+
+         void        acquire( const std::string& method );
+         void        release( const std::string& method );
+         fc::thread& next_thread();
+
+         database&                                  _db;
+         vector< std::unique_ptr<fc::thread> >      _threads;
+         std::atomic<uint32_t>                      _next_thread{0};
+
+         std::mutex                                 _mutex;
+         uint32_t                                   _default_limit;
+         std::map<std::string, uint32_t>            _limits;
+         std::map<std::string, uint32_t>            _running;
+   };
+
+   /** runs l on the pool, or on the calling thread when there is none */
+   template<typename Lambda>
+   auto run_read( const std::shared_ptr<api_read_pool>& pool, const char* method, Lambda&& l ) -> decltype( l() )
+   {
+      if( !pool )
+         return l();
+      return pool->run( method, std::forward<Lambda>( l ) );
+   }
+
+} } // graphene::app
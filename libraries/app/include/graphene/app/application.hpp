@@ -34,6 +34,10 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class market_depth;
+   class notification_hub;
+   class api_read_pool;
+   class block_event_stream;
 
    class application
    {
@@ -79,6 +83,14 @@ namespace graphene { namespace app {
 
          net::node_ptr                    p2p_node();
          std::shared_ptr<chain::database> chain_database()const;
+         /** order book depth tracker shared by all API sessions, created on first use */
+         std::shared_ptr<market_depth>    get_market_depth()const;
+         /** object change notifications shared by all API sessions, created on first use */
+         std::shared_ptr<notification_hub> get_notification_hub()const;
+         /** threads serving read-only API calls, created on first use; null unless api-threads is set */
+         std::shared_ptr<api_read_pool> get_api_read_pool()const;
+         /** asynchronous stream of applied blocks for plugins which only observe them, created on first use */
+         std::shared_ptr<block_event_stream> get_block_events()const;
 
          void set_block_production(bool producing_blocks);
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
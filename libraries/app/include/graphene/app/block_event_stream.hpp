@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/thread/future.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace fc { class thread; }
+
+namespace graphene { namespace app {
+   using namespace graphene::chain;
+
+   /**
+    *  @brief everything a consumer of the event stream learns about one applied block
+    */
+   struct applied_block_event
+   {
+      std::shared_ptr<const signed_block>  block;
+      /** operations applied by the block, including virtual ones; operations which failed are left out */
+      vector<operation_history_object>     operations;
+      /** objects created, modified or removed by the block, empty while undo tracking is disabled (e.g. replay) */
+      vector<object_id_type>               changed_ids;
+      /** when the block finished applying on the chain thread */
+      fc::time_point                       applied_at;
+
+      uint32_t block_num()const { return block->block_num(); }
+   };
+
+   struct event_stream_stats
+   {
+      uint32_t         last_published_block = 0;
+      uint32_t         last_processed_block = 0;
+      /** events handed to the subscriber's thread but not processed yet */
+      uint32_t         queued = 0;
+      uint64_t         processed = 0;
+      /** number of times the block producer had to wait in wait_for_subscribers() because the queue was full */
+      uint64_t         stalls = 0;
+      /** time from the block being applied to its event being processed, for the last and the slowest event */
+      fc::microseconds last_delay;
+      fc::microseconds max_delay;
+   };
+
+   class block_event_stream;
+
+   /**
+    *  @class event_subscription
+    *  @brief one consumer of the event stream, with the thread its handler runs on
+    *
+    *  Releasing the subscription waits for the queued events to be processed and stops the thread.
+    */
+   class event_subscription
+   {
+      public:
+         typedef std::function<void(const applied_block_event&)> handler_type;
+
+         ~event_subscription();
+
+         const std::string& name()const { return _name; }
+         event_stream_stats stats()const;
+
+         /** waits until every event published so far has been processed */
+         void wait_idle();
+
+      private:
+         friend class block_event_stream;
+
+         void post( const std::shared_ptr<const applied_block_event>& e );
+         void wait_for_room();
+         void process( const applied_block_event& e );
+
+         std::string                     _name;
+         handler_type                    _handler;
+         bool                            _irreversible_only = false;
+         uint32_t                        _max_queue = 64;
+         std::unique_ptr<fc::thread>     _thread;
+
+         // touched on the chain thread only
+         std::deque< fc::future<void> >  _in_flight;
+         uint32_t                        _last_published = 0;
+         uint64_t                        _stalls = 0;
+
+         // written on the subscriber's thread
+         std::atomic<uint32_t>           _last_processed{0};
+         std::atomic<uint64_t>           _processed{0};
+         std::atomic<int64_t>            _last_delay_us{0};
+         std::atomic<int64_t>            _max_delay_us{0};
+   };
+
+   /**
+    *  @class block_event_stream
+    *  @brief ordered, asynchronous delivery of applied blocks to consumers which do not modify chain state
+    *
+    *  Consumers that only need to observe what a block did (exporters, indexers outside of the object database,
+    *  notification services) subscribe here instead of connecting to database::applied_block, so that their work
+    *  runs on a thread of their own rather than inside block application.  Handlers must not access the database;
+    *  the event carries the block, its operations and the ids of the objects it changed.
+    *
+    *  Each subscriber receives events strictly in the order blocks were applied.  An after_apply subscriber sees
+    *  every applied block, including blocks which are later undone by a fork switch; an after_irreversible
+    *  subscriber sees each block once, when it becomes irreversible.
+    *
+    *  Events are queued without waiting, since block application must not yield.  Whoever pushes blocks calls
+    *  wait_for_subscribers() once push_block() has returned, which waits until every queue is back to at most
+    *  max_queue events; a slow subscriber thereby slows the node down instead of losing events.  The number of
+    *  such stalls is reported in its stats.
+    */
+   class block_event_stream : public std::enable_shared_from_this<block_event_stream>
+   {
+      public:
+         enum delivery_mode
+         {
+            after_apply,
+            after_irreversible
+         };
+
+         /** creates a stream and connects it to the block notifications of db */
+         static std::shared_ptr<block_event_stream> create( database& db );
+
+         /** registers a consumer, it is dropped from the stream once the returned pointer is released */
+         std::shared_ptr<event_subscription> subscribe( const std::string& name,
+                                                        event_subscription::handler_type handler,
+                                                        delivery_mode mode = after_apply,
+                                                        uint32_t max_queue = 64 );
+
+         size_t subscribers()const { return _subscribers.size(); }
+
+         /**
+          *  Waits until no subscriber has more than its max_queue events outstanding.  Must be called outside of
+          *  block application, e.g. after database::push_block() returned.
+          */
+         void wait_for_subscribers();
+
+      private:
+         block_event_stream( database& db ):_db(db){}
+
+         void on_applied_block( const signed_block& b );
+         void on_changed_objects( const vector<object_id_type>& ids );
+         void publish( const std::shared_ptr<const applied_block_event>& e );
+         vector< std::shared_ptr<event_subscription> > live_subscribers();
+
+         database&                                             _db;
+         vector< std::weak_ptr<event_subscription> >           _subscribers;
+         /** the block applied last, waiting for the ids of the objects it changed */
+         std::shared_ptr<applied_block_event>                  _current;
+         /** applied blocks not yet irreversible, for after_irreversible subscribers */
+         std::deque< std::shared_ptr<const applied_block_event> > _reversible;
+         boost::signals2::scoped_connection                    _applied_connection;
+         boost::signals2::scoped_connection                    _change_connection;
+   };
+
+} } // graphene::app
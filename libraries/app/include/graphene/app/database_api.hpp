@@ -24,6 +24,9 @@
 #pragma once
 
 #include <graphene/app/full_account.hpp>
+#include <graphene/app/market_depth.hpp>
+#include <graphene/app/notification_hub.hpp>
+#include <graphene/app/api_read_pool.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 
@@ -107,6 +110,25 @@ struct market_trade
    double                     value;
 };
 
+/**
+ *  Result of the *_since calls: what changed after the revision the client passed in.
+ */
+struct conditional_objects
+{
+   /** pass back as known_revision to only receive later changes */
+   uint64_t                      revision = 0;
+   /** objects changed after the known revision, null for objects that were removed */
+   map<object_id_type, variant>  changed;
+};
+
+struct conditional_full_accounts
+{
+   /** pass back as known_revision to only receive later changes */
+   uint64_t                                revision = 0;
+   /** accounts with changes after the known revision, unchanged accounts are left out */
+   map<string, full_account_changes>       accounts;
+};
+
 /**
  * @brief The database_api class implements the RPC API for the chain database.
  *
@@ -117,7 +139,17 @@ struct market_trade
 class database_api
 {
    public:
-      database_api(graphene::chain::database& db);
+      /**
+       * @param depth order book depth tracker to share with other sessions, a private one is
+       * created on demand if none is given
+       * @param hub object change notifications shared with other sessions, a private one is
+       * created if none is given
+       * @param read_pool threads to serve the read-only queries on, they are served on the calling
+       * thread if none is given
+       */
+      database_api(graphene::chain::database& db, std::shared_ptr<market_depth> depth = std::shared_ptr<market_depth>(),
+                   std::shared_ptr<notification_hub> hub = std::shared_ptr<notification_hub>(),
+                   std::shared_ptr<api_read_pool> read_pool = std::shared_ptr<api_read_pool>());
       ~database_api();
 
       /////////////
@@ -133,6 +165,16 @@ class database_api
        */
       fc::variants get_objects(const vector<object_id_type>& ids)const;
 
+      /**
+       * @brief Get the objects that changed since a revision returned by an earlier call
+       * @param ids IDs of the objects to check
+       * @param known_revision revision from a previous result, or 0 to get every object
+       * @return the current revision and the objects among ids modified after known_revision
+       *
+       * Unlike @ref get_objects this does not subscribe to the objects, it is meant for polling clients.
+       */
+      conditional_objects get_objects_since(const vector<object_id_type>& ids, uint64_t known_revision)const;
+
       ///////////////////
       // Subscriptions //
       ///////////////////
@@ -165,6 +207,25 @@ class database_api
        */
       optional<signed_block> get_block(uint32_t block_num)const;
 
+      /**
+       * @brief Retrieve a contiguous range of full, signed blocks in a single call
+       * @param block_num_from Height of the first block to be returned
+       * @param count Maximum number of blocks to return, at most 100
+       * @return the blocks starting at block_num_from, in order; the result stops short at the first block
+       *         which has not been applied by this node
+       */
+      vector<signed_block> get_blocks(uint32_t block_num_from, uint32_t count)const;
+
+      /**
+       * @brief Retrieve a contiguous range of blocks as they are packed in the block log
+       * @param block_num_from Height of the first block to be returned
+       * @param count Maximum number of blocks to return, at most 1000
+       * @param include_ids Whether to return the id of each block along with its data
+       * @return the packed blocks starting at block_num_from, in order; the result stops short at the first block
+       *         which is not in the block log, or once the blocks add up to 4 MiB.  Only applied blocks are returned.
+       */
+      vector<raw_block> get_raw_blocks(uint32_t block_num_from, uint32_t count, bool include_ids)const;
+
       /**
        * @brief used to fetch an individual transaction.
        */
@@ -206,6 +267,13 @@ class database_api
        */
       dynamic_global_property_object get_dynamic_global_properties()const;
 
+      /**
+       * @brief Retrieve evaluator and block apply timings collected since the profiler was last reset
+       *
+       * Empty unless the node was started with profiling enabled.
+       */
+      apply_profile get_apply_profile()const;
+
       //////////
       // Keys //
       //////////
@@ -238,6 +306,17 @@ class database_api
        */
       std::map<string,full_account> get_full_accounts( const vector<string>& names_or_ids, bool subscribe );
 
+      /**
+       * @brief Same as @ref get_full_accounts, but only returns what changed after known_revision
+       * @param names_or_ids Each item must be the name or ID of an account to retrieve
+       * @param known_revision revision from a previous result, or 0 to get everything
+       * @param subscribe whether to subscribe to updates of the accounts
+       *
+       * Accounts that did not change are left out of the result, for the others only the members
+       * that changed are set.
+       */
+      conditional_full_accounts get_full_accounts_since( const vector<string>& names_or_ids, uint64_t known_revision, bool subscribe );
+
       optional<account_object> get_account_by_name( string name )const;
 
       /**
@@ -327,7 +406,7 @@ class database_api
        * @brief Get limit orders in a given market
        * @param a ID of asset being sold
        * @param b ID of asset being purchased
-       * @param limit Maximum number of orders to retrieve
+       * @param limit Maximum number of orders to retrieve on each side, values above 300 are treated as 300
        * @return The limit orders, ordered from least price to greatest
        */
       vector<limit_order_object> get_limit_orders(asset_id_type a, asset_id_type b, uint32_t limit)const;
@@ -335,7 +414,7 @@ class database_api
       /**
        * @brief Get call orders in a given asset
        * @param a ID of asset being called
-       * @param limit Maximum number of orders to retrieve
+       * @param limit Maximum number of orders to retrieve, values above 300 are treated as 300
        * @return The call orders, ordered from earliest to be called to latest
        */
       vector<call_order_object> get_call_orders(asset_id_type a, uint32_t limit)const;
@@ -343,11 +422,50 @@ class database_api
       /**
        * @brief Get forced settlement orders in a given asset
        * @param a ID of asset being settled
-       * @param limit Maximum number of orders to retrieve
+       * @param limit Maximum number of orders to retrieve, values above 300 are treated as 300
        * @return The settle orders, ordered from earliest settlement date to latest
        */
       vector<force_settlement_object> get_settle_orders(asset_id_type a, uint32_t limit)const;
 
+      /**
+       *  The *_page calls below return a result set in pages.  Each takes the sort key and the id of
+       *  the last object of the previous page and continues strictly after it, which costs the same
+       *  no matter how far into the set the page is and still works when that object has been filled
+       *  or cancelled in the meantime.  Pass null for both to start at the beginning.
+       */
+      /// @{
+
+      /**
+       * @brief Get one side of a market, orders selling a for b, in pages
+       * @param limit Maximum number of orders to retrieve, must not exceed 300
+       * @param start_price sell_price of the last order of the previous page
+       * @param start_id ID of the last order of the previous page, if null the page starts at start_price
+       * @return The limit orders, from best price to worst
+       */
+      vector<limit_order_object> get_limit_orders_page(asset_id_type a, asset_id_type b, uint32_t limit,
+                                                       optional<price> start_price, optional<limit_order_id_type> start_id)const;
+
+      /**
+       * @brief Get call orders in a given asset in pages
+       * @param limit Maximum number of orders to retrieve, must not exceed 300
+       * @param start_price call_price of the last order of the previous page
+       * @param start_id ID of the last order of the previous page, if null the page starts at start_price
+       * @return The call orders, ordered from earliest to be called to latest
+       */
+      vector<call_order_object> get_call_orders_page(asset_id_type a, uint32_t limit,
+                                                     optional<price> start_price, optional<call_order_id_type> start_id)const;
+
+      /**
+       * @brief Get forced settlement orders in a given asset in pages
+       * @param limit Maximum number of orders to retrieve, must not exceed 300
+       * @param start_date settlement_date of the last order of the previous page
+       * @param start_id ID of the last order of the previous page, if null the page starts at start_date
+       * @return The settle orders, ordered from earliest settlement date to latest
+       */
+      vector<force_settlement_object> get_settle_orders_page(asset_id_type a, uint32_t limit,
+                                                             optional<time_point_sec> start_date, optional<force_settlement_id_type> start_id)const;
+      /// @}
+
       /**
        *  @return all open margin positions for a given account id.
        */
@@ -372,6 +490,31 @@ class database_api
        */
       void unsubscribe_from_market( asset_id_type a, asset_id_type b );
 
+      /**
+       * @brief Returns the order book of the market between two assets aggregated by price
+       * @param base Asset ID of the asset sold by the bids
+       * @param quote Asset ID of the asset sold by the asks
+       * @param limit Maximum number of price levels on each side, capped at 1000
+       */
+      market_depth_snapshot get_market_depth( asset_id_type base, asset_id_type quote, uint32_t limit )const;
+
+      /**
+       * @brief Request level 2 updates of the order book of the market between two assets
+       * @param callback Callback method which is passed a market_depth_delta whenever levels change
+       * @param base Asset ID of the asset sold by the bids
+       * @param quote Asset ID of the asset sold by the asks
+       * @param limit Maximum number of price levels on each side of the returned snapshot, capped at 1000
+       * @return The current depth of the market.  Deltas with a higher sequence number replace
+       * the levels with the same price, a level with nothing for sale has been removed.
+       */
+      market_depth_snapshot subscribe_to_market_depth( std::function<void(const variant&)> callback,
+                                                       asset_id_type base, asset_id_type quote, uint32_t limit );
+
+      /**
+       * @brief Unsubscribe from depth updates of a given market
+       */
+      void unsubscribe_from_market_depth( asset_id_type a, asset_id_type b );
+
       /**
        * @brief Returns the ticker for the market assetA:assetB
        * @param a String name of the first asset
@@ -566,10 +709,13 @@ FC_REFLECT( graphene::app::order_book, (base)(quote)(bids)(asks) );
 FC_REFLECT( graphene::app::market_ticker, (base)(quote)(latest)(lowest_ask)(highest_bid)(percent_change)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_volume, (base)(quote)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_trade, (date)(price)(amount)(value) );
+FC_REFLECT( graphene::app::conditional_objects, (revision)(changed) );
+FC_REFLECT( graphene::app::conditional_full_accounts, (revision)(accounts) );
 
 FC_API(graphene::app::database_api,
    // Objects
    (get_objects)
+   (get_objects_since)
 
    // Subscriptions
    (set_subscribe_callback)
@@ -580,6 +726,8 @@ FC_API(graphene::app::database_api,
    // Blocks and transactions
    (get_block_header)
    (get_block)
+   (get_blocks)
+   (get_raw_blocks)
    (get_transaction)
    (get_recent_transaction_by_id)
 
@@ -589,6 +737,7 @@ FC_API(graphene::app::database_api,
    (get_config)
    (get_chain_id)
    (get_dynamic_global_properties)
+   (get_apply_profile)
 
    // Keys
    (get_key_references)
@@ -596,6 +745,7 @@ FC_API(graphene::app::database_api,
    // Accounts
    (get_accounts)
    (get_full_accounts)
+   (get_full_accounts_since)
    (get_account_by_name)
    (get_account_references)
    (lookup_account_names)
@@ -619,9 +769,15 @@ FC_API(graphene::app::database_api,
    (get_limit_orders)
    (get_call_orders)
    (get_settle_orders)
+   (get_limit_orders_page)
+   (get_call_orders_page)
+   (get_settle_orders_page)
    (get_margin_positions)
    (subscribe_to_market)
    (unsubscribe_from_market)
+   (get_market_depth)
+   (subscribe_to_market_depth)
+   (unsubscribe_from_market_depth)
    (get_ticker)
    (get_24_volume)
    (get_trade_history)
@@ -46,6 +46,27 @@ namespace graphene { namespace app {
       vector<proposal_object>          proposals;
    };
 
+   /**
+    *  The parts of a full_account that changed after a revision known to the client, see
+    *  database_api::get_full_accounts_since().  Members that are not set did not change; lists are
+    *  sent whole when any of their members was added, changed or may have been removed.
+    */
+   struct full_account_changes
+   {
+      optional<account_object>                   account;
+      optional<account_statistics_object>        statistics;
+      optional<string>                           registrar_name;
+      optional<string>                           referrer_name;
+      optional<string>                           lifetime_referrer_name;
+      optional<vector<variant>>                  votes;
+      optional<vesting_balance_object>           cashback_balance;
+      optional<vector<account_balance_object>>   balances;
+      optional<vector<vesting_balance_object>>   vesting_balances;
+      optional<vector<limit_order_object>>       limit_orders;
+      optional<vector<call_order_object>>        call_orders;
+      optional<vector<proposal_object>>          proposals;
+   };
+
 } }
 
 FC_REFLECT( graphene::app::full_account, 
@@ -62,3 +83,18 @@ FC_REFLECT( graphene::app::full_account,
             (call_orders)
             (proposals) 
           )
+
+FC_REFLECT( graphene::app::full_account_changes,
+            (account)
+            (statistics)
+            (registrar_name)
+            (referrer_name)
+            (lifetime_referrer_name)
+            (votes)
+            (cashback_balance)
+            (balances)
+            (vesting_balances)
+            (limit_orders)
+            (call_orders)
+            (proposals)
+          )
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/market_object.hpp>
+
+#include <fc/signals.hpp>
+
+#include <map>
+#include <unordered_map>
+
+namespace graphene { namespace app {
+   using namespace graphene::chain;
+   using std::map;
+   using std::pair;
+
+   /**
+    *  An aggregated price level of one side of a market.  In a delta a for_sale of 0 means
+    *  the level no longer exists.
+    */
+   struct depth_level
+   {
+      depth_level(){}
+      depth_level( const price& p, share_type amount, uint32_t count )
+      :sell_price(p),for_sale(amount),orders(count){}
+
+      price       sell_price; ///< price of the orders at this level, sell_price.base is the asset for sale
+      share_type  for_sale;   ///< total amount of sell_price.base for sale at this level
+      uint32_t    orders = 0;
+   };
+
+   struct market_depth_snapshot
+   {
+      asset_id_type        base;
+      asset_id_type        quote;
+      /** sequence number of the last delta included, deltas with a higher sequence apply on top */
+      uint64_t             sequence = 0;
+      vector<depth_level>  bids; ///< levels selling base, best first
+      vector<depth_level>  asks; ///< levels selling quote, best first
+   };
+
+   struct market_depth_delta
+   {
+      asset_id_type        base;  ///< the lower of the two asset ids
+      asset_id_type        quote;
+      uint64_t             sequence = 0;
+      vector<depth_level>  levels;
+   };
+
+   /**
+    *  @class market_depth
+    *  @brief level 2 order books of the markets API clients are subscribed to
+    *
+    *  Orders are aggregated by price as limit_order_objects are added, modified and removed,
+    *  observed through an index_observer on the limit order index, so that a snapshot never
+    *  needs to walk individual orders and subscribers only receive the levels that changed.
+    *  Markets are tracked for as long as they have at least one subscriber.
+    */
+   class market_depth : public std::enable_shared_from_this<market_depth>
+   {
+      public:
+         typedef pair<asset_id_type,asset_id_type> market_type;
+
+         /** creates a tracker and registers it with the limit order index of db */
+         static std::shared_ptr<market_depth> create( database& db );
+
+         void track( asset_id_type a, asset_id_type b );
+         void untrack( asset_id_type a, asset_id_type b );
+         bool is_tracked( asset_id_type a, asset_id_type b )const;
+
+         /**
+          *  Up to limit levels of each side of the market, best first.  Untracked markets are
+          *  aggregated from the limit order index on the fly.
+          */
+         market_depth_snapshot get_snapshot( asset_id_type base, asset_id_type quote, uint32_t limit );
+
+         /** aggregates up to limit levels of each side of the market from the limit order index */
+         static market_depth_snapshot aggregate_orders( const database& db, asset_id_type base, asset_id_type quote, uint32_t limit );
+
+         /**
+          *  Emitted whenever the database reports changed objects, with one delta per tracked
+          *  market that changed.  The deltas are converted to variants once for all subscribers.
+          */
+         fc::signal<void(const map<market_type, fc::variant>&)> depth_changed;
+
+      private:
+         friend class order_observer;
+
+         struct level_totals
+         {
+            share_type for_sale;
+            uint32_t   orders = 0;
+         };
+         typedef std::map< price, level_totals, std::greater<price> > side_type;
+
+         struct tracked_market
+         {
+            uint32_t         subscribers = 0;
+            uint64_t         sequence = 0;
+            side_type        sells_first;   ///< orders selling market.first
+            side_type        sells_second;  ///< orders selling market.second
+            flat_set<price>  changed;
+
+            side_type& side_of( const price& p ) { return p.base.asset_id < p.quote.asset_id ? sells_first : sells_second; }
+         };
+
+         struct order_contribution
+         {
+            price      sell_price;
+            share_type for_sale;
+         };
+
+         market_depth( database& db ):_db(db){}
+
+         static market_type make_market( asset_id_type a, asset_id_type b );
+
+         void on_order_added( const limit_order_object& o );
+         void on_order_modified( const limit_order_object& o );
+         void on_order_removed( const limit_order_object& o );
+         void add_to_level( tracked_market& m, const price& p, share_type amount, int32_t orders );
+         void on_objects_changed();
+         void restore_undone_removals();
+
+         database&                                                  _db;
+         map< market_type, tracked_market >                         _markets;
+         std::unordered_map< object_id_type, order_contribution >   _orders;
+         /// orders removed from tracked markets, undo puts objects back without notifying observers
+         flat_set< object_id_type >                                 _removed_orders;
+         boost::signals2::scoped_connection                         _change_connection;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::depth_level, (sell_price)(for_sale)(orders) )
+FC_REFLECT( graphene::app::market_depth_snapshot, (base)(quote)(sequence)(bids)(asks) )
+FC_REFLECT( graphene::app::market_depth_delta, (base)(quote)(sequence)(levels) )
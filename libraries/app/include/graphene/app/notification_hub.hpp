@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/database.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace graphene { namespace app {
+   using namespace graphene::chain;
+
+   class notification_hub;
+
+   /**
+    *  @class object_subscriber
+    *  @brief the objects one API client is subscribed to and its undelivered notifications
+    *
+    *  Items are kept in an exact set of their packed form.  A changed object matches if its id or
+    *  the account or address that owns it was subscribed to.  API calls served by the read pool
+    *  subscribe from their worker threads, so the callback and items are guarded by a mutex.
+    */
+   class object_subscriber
+   {
+      public:
+         typedef std::function<void(const fc::variant&)> callback_type;
+
+         /** replaces the callback, a null callback or clear_items also drops all subscribed items */
+         void set_callback( callback_type cb, bool clear_items );
+         bool has_callback()const;
+
+         void subscribe( const object_id_type& id ) { subscribe_key( pack_key( id ) ); }
+         template<uint8_t SpaceID, uint8_t TypeID, typename T>
+         void subscribe( const object_id<SpaceID,TypeID,T>& id ) { subscribe( object_id_type( id ) ); }
+         template<typename T>
+         void subscribe( const T& item ) { subscribe_key( pack_key( item ) ); }
+
+         bool is_subscribed( const object_id_type& id )const;
+         size_t subscribed_items()const;
+
+         /** number of notification batches waiting to be delivered */
+         size_t pending()const { return _queue.size(); }
+
+         template<typename T>
+         static std::string pack_key( const T& item )
+         {
+            auto vec = fc::raw::pack( item );
+            return std::string( vec.begin(), vec.end() );
+         }
+
+      private:
+         friend class notification_hub;
+         typedef vector< pair<object_id_type, fc::variant> > batch_type;
+
+         void subscribe_key( std::string key );
+
+         mutable std::mutex                 _mutex;
+         callback_type                      _callback;
+         std::unordered_set<std::string>    _items;
+         std::deque<batch_type>             _queue;
+         bool                               _delivering = false;
+   };
+
+   /**
+    *  @class notification_hub
+    *  @brief fans the object changes of each block out to all API clients
+    *
+    *  The database reports changed and removed objects once to the hub rather than once per client.
+    *  Each changed object is converted to a variant at most once, and only if some client is
+    *  subscribed to it; clients then receive references to the same payload.
+    *
+    *  Delivery to a client runs in its own task.  While a slow client still has max_pending batches
+    *  queued, further batches are merged into the queue keeping only the newest state of each
+    *  object, so a stalled connection costs memory proportional to what it subscribed to rather
+    *  than to the number of blocks it is behind.
+    */
+   class notification_hub : public std::enable_shared_from_this<notification_hub>
+   {
+      public:
+         /** creates a hub and connects it to the change notifications of db */
+         static std::shared_ptr<notification_hub> create( database& db );
+
+         /** registers a new client, it is dropped from the hub once the returned pointer is released */
+         std::shared_ptr<object_subscriber> connect();
+
+         void     set_max_pending( uint32_t batches ) { _max_pending = std::max<uint32_t>( batches, 1 ); }
+         uint32_t max_pending()const { return _max_pending; }
+
+         size_t   subscribers()const { return _subscribers.size(); }
+         /** number of objects converted to variants so far */
+         uint64_t objects_serialized()const { return _objects_serialized; }
+
+      private:
+         struct change
+         {
+            object_id_type       id;
+            const object*        obj = nullptr;
+            vector<std::string>  keys;
+            fc::variant          value;
+            bool                 serialized = false;
+         };
+
+         notification_hub( database& db ):_db(db){}
+
+         void on_objects_changed( const vector<object_id_type>& ids );
+         void on_objects_removed( const vector<const object*>& objs );
+         void dispatch( vector<change>& changes );
+         void enqueue( const std::shared_ptr<object_subscriber>& s, object_subscriber::batch_type&& batch );
+         void schedule( const std::shared_ptr<object_subscriber>& s );
+         static void owner_keys( const object& obj, vector<std::string>& keys );
+
+         database&                                         _db;
+         vector< std::weak_ptr<object_subscriber> >        _subscribers;
+         uint32_t                                          _max_pending = 32;
+         uint64_t                                          _objects_serialized = 0;
+         boost::signals2::scoped_connection                _change_connection;
+         boost::signals2::scoped_connection                _removed_connection;
+   };
+
+} } // graphene::app
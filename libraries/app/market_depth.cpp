@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/market_depth.hpp>
+
+namespace graphene { namespace app {
+
+class order_observer : public graphene::db::index_observer
+{
+   public:
+      order_observer( const std::shared_ptr<market_depth>& depth ):_depth(depth){}
+
+      virtual void on_add( const object& obj )override
+      {
+         if( auto depth = _depth.lock() )
+            depth->on_order_added( static_cast<const limit_order_object&>(obj) );
+      }
+      virtual void on_remove( const object& obj )override
+      {
+         if( auto depth = _depth.lock() )
+            depth->on_order_removed( static_cast<const limit_order_object&>(obj) );
+      }
+      virtual void on_modify( const object& obj )override
+      {
+         if( auto depth = _depth.lock() )
+            depth->on_order_modified( static_cast<const limit_order_object&>(obj) );
+      }
+
+   private:
+      std::weak_ptr<market_depth> _depth;
+};
+
+std::shared_ptr<market_depth> market_depth::create( database& db )
+{
+   std::shared_ptr<market_depth> result( new market_depth( db ) );
+   db.add_index_observer<limit_order_object>( std::make_shared<order_observer>( result ) );
+
+   std::weak_ptr<market_depth> weak = result;
+   result->_change_connection = db.changed_objects.connect( [weak]( const vector<object_id_type>& ) {
+      if( auto depth = weak.lock() )
+         depth->on_objects_changed();
+   });
+   return result;
+}
+
+market_depth::market_type market_depth::make_market( asset_id_type a, asset_id_type b )
+{
+   if( a > b ) std::swap( a, b );
+   FC_ASSERT( a != b );
+   return std::make_pair( a, b );
+}
+
+void market_depth::track( asset_id_type a, asset_id_type b )
+{
+   auto market = make_market( a, b );
+   auto& m = _markets[market];
+   if( m.subscribers++ > 0 )
+      return;
+
+   const auto& price_idx = _db.get_index_type<limit_order_index>().indices().get<by_price>();
+   for( const auto& sides : { market, std::make_pair( market.second, market.first ) } )
+   {
+      auto itr = price_idx.lower_bound( price::max( sides.first, sides.second ) );
+      auto end = price_idx.upper_bound( price::min( sides.first, sides.second ) );
+      for( ; itr != end; ++itr )
+      {
+         _orders[itr->id] = order_contribution{ itr->sell_price, itr->for_sale };
+         add_to_level( m, itr->sell_price, itr->for_sale, 1 );
+      }
+   }
+   m.changed.clear();
+}
+
+void market_depth::untrack( asset_id_type a, asset_id_type b )
+{
+   auto market = make_market( a, b );
+   auto itr = _markets.find( market );
+   if( itr == _markets.end() || --itr->second.subscribers > 0 )
+      return;
+
+   _markets.erase( itr );
+   for( auto oitr = _orders.begin(); oitr != _orders.end(); )
+   {
+      const auto& p = oitr->second.sell_price;
+      if( make_market( p.base.asset_id, p.quote.asset_id ) == market )
+         oitr = _orders.erase( oitr );
+      else
+         ++oitr;
+   }
+}
+
+bool market_depth::is_tracked( asset_id_type a, asset_id_type b )const
+{
+   return _markets.find( make_market( a, b ) ) != _markets.end();
+}
+
+void market_depth::add_to_level( tracked_market& m, const price& p, share_type amount, int32_t orders )
+{
+   auto& side = m.side_of( p );
+   auto& level = side[p];
+   level.for_sale += amount;
+   level.orders += orders;
+   if( level.orders == 0 )
+      side.erase( p );
+   m.changed.insert( p );
+}
+
+void market_depth::on_order_added( const limit_order_object& o )
+{
+   auto itr = _markets.find( o.get_market() );
+   if( itr == _markets.end() )
+      return;
+   _orders[o.id] = order_contribution{ o.sell_price, o.for_sale };
+   add_to_level( itr->second, o.sell_price, o.for_sale, 1 );
+}
+
+void market_depth::on_order_modified( const limit_order_object& o )
+{
+   auto itr = _markets.find( o.get_market() );
+   if( itr == _markets.end() )
+      return;
+   auto oitr = _orders.find( o.id );
+   if( oitr != _orders.end() )
+      add_to_level( itr->second, oitr->second.sell_price, -oitr->second.for_sale, -1 );
+   _orders[o.id] = order_contribution{ o.sell_price, o.for_sale };
+   add_to_level( itr->second, o.sell_price, o.for_sale, 1 );
+}
+
+void market_depth::on_order_removed( const limit_order_object& o )
+{
+   auto itr = _markets.find( o.get_market() );
+   if( itr == _markets.end() )
+      return;
+   auto oitr = _orders.find( o.id );
+   if( oitr == _orders.end() )
+      return;
+   add_to_level( itr->second, oitr->second.sell_price, -oitr->second.for_sale, -1 );
+   _orders.erase( oitr );
+   _removed_orders.insert( o.id );
+}
+
+void market_depth::restore_undone_removals()
+{
+   for( const auto& id : _removed_orders )
+   {
+      const limit_order_object* o = _db.find( limit_order_id_type( id ) );
+      if( o != nullptr && _orders.find( id ) == _orders.end() )
+         on_order_added( *o );
+   }
+   _removed_orders.clear();
+}
+
+void market_depth::on_objects_changed()
+{
+   restore_undone_removals();
+
+   map<market_type, fc::variant> deltas;
+   for( auto& item : _markets )
+   {
+      auto& m = item.second;
+      if( m.changed.empty() )
+         continue;
+
+      market_depth_delta delta;
+      delta.base     = item.first.first;
+      delta.quote    = item.first.second;
+      delta.sequence = ++m.sequence;
+      delta.levels.reserve( m.changed.size() );
+      for( const auto& p : m.changed )
+      {
+         depth_level level;
+         level.sell_price = p;
+         const auto& side = m.side_of( p );
+         auto litr = side.find( p );
+         if( litr != side.end() )
+         {
+            level.for_sale = litr->second.for_sale;
+            level.orders   = litr->second.orders;
+         }
+         delta.levels.push_back( level );
+      }
+      m.changed.clear();
+      deltas[item.first] = fc::variant( delta );
+   }
+   if( !deltas.empty() )
+      depth_changed( deltas );
+}
+
+market_depth_snapshot market_depth::get_snapshot( asset_id_type base, asset_id_type quote, uint32_t limit )
+{
+   restore_undone_removals();
+
+   market_depth_snapshot result;
+   result.base  = base;
+   result.quote = quote;
+
+   auto copy_levels = [limit]( const side_type& side, vector<depth_level>& out ) {
+      for( auto itr = side.begin(); itr != side.end() && out.size() < limit; ++itr )
+         out.push_back( depth_level( itr->first, itr->second.for_sale, itr->second.orders ) );
+   };
+
+   auto itr = _markets.find( make_market( base, quote ) );
+   if( itr != _markets.end() )
+   {
+      const auto& m = itr->second;
+      result.sequence = m.sequence;
+      copy_levels( base < quote ? m.sells_first : m.sells_second, result.bids );
+      copy_levels( base < quote ? m.sells_second : m.sells_first, result.asks );
+      return result;
+   }
+
+   return aggregate_orders( _db, base, quote, limit );
+}
+
+market_depth_snapshot market_depth::aggregate_orders( const database& db, asset_id_type base, asset_id_type quote, uint32_t limit )
+{
+   market_depth_snapshot result;
+   result.base  = base;
+   result.quote = quote;
+
+   const auto& price_idx = db.get_index_type<limit_order_index>().indices().get<by_price>();
+   auto aggregate = [&]( asset_id_type sold, asset_id_type received, vector<depth_level>& out ) {
+      auto itr = price_idx.lower_bound( price::max( sold, received ) );
+      auto end = price_idx.upper_bound( price::min( sold, received ) );
+      for( ; itr != end; ++itr )
+      {
+         if( out.empty() || out.back().sell_price != itr->sell_price )
+         {
+            if( out.size() == limit )
+               break;
+            out.push_back( depth_level( itr->sell_price, 0, 0 ) );
+         }
+         out.back().for_sale += itr->for_sale;
+         ++out.back().orders;
+      }
+   };
+   aggregate( base, quote, result.bids );
+   aggregate( quote, base, result.asks );
+   return result;
+}
+
+} } // graphene::app
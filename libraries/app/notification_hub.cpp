@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/notification_hub.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/balance_object.hpp>
+#include <graphene/chain/market_object.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace graphene { namespace app {
+
+namespace {
+   template<typename ObjectType>
+   const ObjectType* as( const object& obj )
+   {
+      if( obj.id.space() == ObjectType::space_id && obj.id.type() == ObjectType::type_id )
+         return static_cast<const ObjectType*>( &obj );
+      return nullptr;
+   }
+
+   object_id_type account_key( account_id_type a ) { return a; }
+}
+
+void object_subscriber::set_callback( callback_type cb, bool clear_items )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _callback = cb;
+   if( clear_items || !cb )
+   {
+      _items.clear();
+      _queue.clear();
+   }
+}
+
+bool object_subscriber::has_callback()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return bool(_callback);
+}
+
+bool object_subscriber::is_subscribed( const object_id_type& id )const
+{
+   auto key = pack_key( id );
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _items.count( key ) != 0;
+}
+
+size_t object_subscriber::subscribed_items()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _items.size();
+}
+
+void object_subscriber::subscribe_key( std::string key )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( !_callback )
+      return;
+   _items.insert( std::move(key) );
+}
+
+std::shared_ptr<notification_hub> notification_hub::create( database& db )
+{
+   std::shared_ptr<notification_hub> result( new notification_hub( db ) );
+   std::weak_ptr<notification_hub> weak = result;
+   result->_change_connection = db.changed_objects.connect( [weak]( const vector<object_id_type>& ids ) {
+      if( auto hub = weak.lock() )
+         hub->on_objects_changed( ids );
+   });
+   result->_removed_connection = db.removed_objects.connect( [weak]( const vector<const object*>& objs ) {
+      if( auto hub = weak.lock() )
+         hub->on_objects_removed( objs );
+   });
+   return result;
+}
+
+std::shared_ptr<object_subscriber> notification_hub::connect()
+{
+   auto s = std::make_shared<object_subscriber>();
+   _subscribers.push_back( s );
+   return s;
+}
+
+void notification_hub::owner_keys( const object& obj, vector<std::string>& keys )
+{
+   if( auto b = as<account_balance_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( account_key( b->owner ) ) );
+   else if( auto s = as<account_statistics_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( account_key( s->owner ) ) );
+   else if( auto o = as<limit_order_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( account_key( o->seller ) ) );
+   else if( auto c = as<call_order_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( account_key( c->borrower ) ) );
+   else if( auto f = as<force_settlement_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( account_key( f->owner ) ) );
+   else if( auto bal = as<balance_object>( obj ) )
+      keys.push_back( object_subscriber::pack_key( bal->owner ) );
+}
+
+void notification_hub::on_objects_changed( const vector<object_id_type>& ids )
+{
+   vector<change> changes( ids.size() );
+   for( size_t i = 0; i < ids.size(); ++i )
+   {
+      change& c = changes[i];
+      c.id = ids[i];
+      c.obj = _db.find_object( c.id );
+      if( !c.obj )
+      {
+         // send just the id to indicate removal
+         c.value = fc::variant( c.id );
+         c.serialized = true;
+      }
+   }
+   dispatch( changes );
+}
+
+void notification_hub::on_objects_removed( const vector<const object*>& objs )
+{
+   vector<change> changes( objs.size() );
+   for( size_t i = 0; i < objs.size(); ++i )
+   {
+      change& c = changes[i];
+      c.id = objs[i]->id;
+      c.obj = objs[i];
+      c.value = fc::variant( c.id );
+      c.serialized = true;
+   }
+   dispatch( changes );
+}
+
+void notification_hub::dispatch( vector<change>& changes )
+{
+   vector< std::shared_ptr<object_subscriber> > live;
+   live.reserve( _subscribers.size() );
+   auto end = std::remove_if( _subscribers.begin(), _subscribers.end(),
+                              []( const std::weak_ptr<object_subscriber>& w ) { return w.expired(); } );
+   _subscribers.erase( end, _subscribers.end() );
+   for( const auto& w : _subscribers )
+   {
+      auto s = w.lock();
+      if( !s )
+         continue;
+      std::lock_guard<std::mutex> lock( s->_mutex );
+      if( s->_callback && !s->_items.empty() )
+         live.push_back( std::move(s) );
+   }
+   if( live.empty() || changes.empty() )
+      return;
+
+   for( auto& c : changes )
+   {
+      c.keys.push_back( object_subscriber::pack_key( c.id ) );
+      if( c.obj )
+         owner_keys( *c.obj, c.keys );
+   }
+
+   for( const auto& s : live )
+   {
+      object_subscriber::batch_type batch;
+      for( auto& c : changes )
+      {
+         bool match = false;
+         {
+            std::lock_guard<std::mutex> lock( s->_mutex );
+            for( const auto& k : c.keys )
+               if( s->_items.count( k ) ) { match = true; break; }
+         }
+         if( !match )
+            continue;
+
+         if( !c.serialized )
+         {
+            c.value = c.obj->to_variant();
+            c.serialized = true;
+            ++_objects_serialized;
+         }
+         batch.emplace_back( c.id, c.value );
+      }
+      if( !batch.empty() )
+         enqueue( s, std::move(batch) );
+   }
+}
+
+void notification_hub::enqueue( const std::shared_ptr<object_subscriber>& s, object_subscriber::batch_type&& batch )
+{
+   s->_queue.push_back( std::move(batch) );
+   if( s->_queue.size() > _max_pending )
+   {
+      // the client is falling behind, only its newest view of each object is still worth sending
+      object_subscriber::batch_type merged;
+      std::unordered_map<object_id_type, size_t> position;
+      for( auto& queued : s->_queue )
+         for( auto& item : queued )
+         {
+            auto itr = position.find( item.first );
+            if( itr == position.end() )
+            {
+               position[item.first] = merged.size();
+               merged.push_back( std::move(item) );
+            }
+            else
+               merged[itr->second].second = std::move( item.second );
+         }
+      s->_queue.clear();
+      s->_queue.push_back( std::move(merged) );
+   }
+   schedule( s );
+}
+
+void notification_hub::schedule( const std::shared_ptr<object_subscriber>& s )
+{
+   if( s->_delivering )
+      return;
+   s->_delivering = true;
+
+   /// the subscriber is kept alive for the life of the async operation
+   fc::async( [s](){
+      while( !s->_queue.empty() )
+      {
+         object_subscriber::batch_type batch = std::move( s->_queue.front() );
+         s->_queue.pop_front();
+         if( !s->_callback )
+            continue;
+
+         vector<fc::variant> updates;
+         updates.reserve( batch.size() );
+         for( auto& item : batch )
+            updates.push_back( std::move(item.second) );
+         try
+         {
+            s->_callback( fc::variant( updates ) );
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "dropping notification: ${e}", ("e",e.to_detail_string()) );
+         }
+      }
+      s->_delivering = false;
+   });
+}
+
+} } // graphene::app
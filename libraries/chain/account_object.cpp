@@ -27,6 +27,8 @@
 #include <graphene/chain/hardfork.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace chain {
 
 share_type cut_fee(share_type a, uint16_t p)
@@ -48,6 +50,109 @@ void account_balance_object::adjust_balance(const asset& delta)
    balance += delta.amount;
 }
 
+const object& account_balance_index::create( const std::function<void(object&)>& constructor )
+{
+   account_balance_object item;
+   item.id = get_next_id();
+   constructor( item );
+   item.id = get_next_id();
+   FC_ASSERT( find( item.owner, item.asset_type ) == nullptr,
+              "Could not create object! Most likely a uniqueness constraint is violated." );
+   const auto& result = static_cast<const account_balance_object&>( simple_index::insert( std::move(item) ) );
+   use_next_id();
+   add_to_lookups( result );
+   return result;
+}
+
+const object& account_balance_index::insert( object&& obj )
+{
+   assert( nullptr != dynamic_cast<account_balance_object*>(&obj) );
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   FC_ASSERT( find( b.owner, b.asset_type ) == nullptr,
+              "Could not insert object, most likely a uniqueness constraint was violated" );
+   const auto& result = static_cast<const account_balance_object&>( simple_index::insert( std::move(obj) ) );
+   add_to_lookups( result );
+   return result;
+}
+
+void account_balance_index::modify( const object& obj, const std::function<void(object&)>& m )
+{
+   assert( nullptr != dynamic_cast<const account_balance_object*>(&obj) );
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   const account_id_type owner = b.owner;
+   const asset_id_type asset_type = b.asset_type;
+
+   // the ranking is ordered by balance, so the object has to leave it while the balance changes
+   auto ranking = _rankings.find( asset_type );
+   if( ranking != _rankings.end() )
+      ranking->second.erase( &b );
+   simple_index::modify( obj, m );
+   if( ranking != _rankings.end() )
+      ranking->second.insert( &b );
+
+   FC_ASSERT( b.owner == owner && b.asset_type == asset_type, "The owner and asset of a balance cannot be modified" );
+}
+
+void account_balance_index::remove( const object& obj )
+{
+   remove_from_lookups( static_cast<const account_balance_object&>(obj) );
+   simple_index::remove( obj );
+}
+
+const account_balance_object* account_balance_index::find( account_id_type owner, asset_id_type asset )const
+{
+   const account_balances& balances = get_account_balances( owner );
+   auto itr = balances.find( asset );
+   if( itr == balances.end() )
+      return nullptr;
+   return itr->second;
+}
+
+const account_balance_index::account_balances& account_balance_index::get_account_balances( account_id_type owner )const
+{
+   static const account_balances no_balances;
+   if( owner.instance.value >= _by_account.size() )
+      return no_balances;
+   return _by_account[owner.instance.value];
+}
+
+const account_balance_index::ranked_balances& account_balance_index::get_ranked_balances( asset_id_type asset )const
+{
+   auto itr = _rankings.find( asset );
+   if( itr != _rankings.end() )
+      return itr->second;
+
+   ranked_balances& ranking = _rankings[asset];
+   for( const account_balances& balances : _by_account )
+   {
+      auto b = balances.find( asset );
+      if( b != balances.end() )
+         ranking.insert( b->second );
+   }
+   return ranking;
+}
+
+void account_balance_index::add_to_lookups( const account_balance_object& b )
+{
+   if( b.owner.instance.value >= _by_account.size() )
+      _by_account.resize( b.owner.instance.value + 1 );
+   _by_account[b.owner.instance.value][b.asset_type] = &b;
+
+   auto ranking = _rankings.find( b.asset_type );
+   if( ranking != _rankings.end() )
+      ranking->second.insert( &b );
+}
+
+void account_balance_index::remove_from_lookups( const account_balance_object& b )
+{
+   auto ranking = _rankings.find( b.asset_type );
+   if( ranking != _rankings.end() )
+      ranking->second.erase( &b );
+
+   assert( b.owner.instance.value < _by_account.size() );
+   _by_account[b.owner.instance.value].erase( b.asset_type );
+}
+
 void account_statistics_object::process_fees(const account_object& a, database& d) const
 {
    if( pending_fees > 0 || pending_vested_fees > 0 )
@@ -110,34 +215,119 @@ void account_statistics_object::pay_fee( share_type core_fee, share_type cashbac
       pending_vested_fees += core_fee;
 }
 
-set<account_id_type> account_member_index::get_account_members(const account_object& a)const
+template<typename Key>
+void account_member_index::add_members( const flat_map<Key,weight_type>& auths, vector<Key>& result )
 {
-   set<account_id_type> result;
-   for( auto auth : a.owner.account_auths )
-      result.insert(auth.first);
-   for( auto auth : a.active.account_auths )
-      result.insert(auth.first);
-   return result;
+   for( const auto& auth : auths )
+      result.push_back( auth.first );
 }
-set<public_key_type> account_member_index::get_key_members(const account_object& a)const
+
+template<typename Key>
+void account_member_index::update_memberships( std::unordered_map<Key, account_set, account_member_hash>& memberships,
+                                               const vector<Key>& before, const vector<Key>& after, account_id_type account )
 {
-   set<public_key_type> result;
-   for( auto auth : a.owner.key_auths )
-      result.insert(auth.first);
-   for( auto auth : a.active.key_auths )
-      result.insert(auth.first);
-   result.insert( a.options.memo_key );
-   return result;
+   // both sides are sorted and unique, walk them together
+   auto b = before.begin();
+   auto a = after.begin();
+   while( b != before.end() || a != after.end() )
+   {
+      if( a == after.end() || (b != before.end() && *b < *a) )
+      {
+         auto itr = memberships.find( *b );
+         if( itr != memberships.end() )
+         {
+            itr->second.erase( account );
+            if( itr->second.empty() )
+               memberships.erase( itr );
+         }
+         ++b;
+      }
+      else if( b == before.end() || *a < *b )
+      {
+         memberships[*a].insert( account );
+         ++a;
+      }
+      else
+      {
+         ++a;
+         ++b;
+      }
+   }
+}
+
+namespace {
+   template<typename Key>
+   void sort_unique( vector<Key>& v )
+   {
+      std::sort( v.begin(), v.end() );
+      v.erase( std::unique( v.begin(), v.end() ), v.end() );
+   }
 }
-set<address> account_member_index::get_address_members(const account_object& a)const
+
+void account_member_index::get_account_members( const account_object& a, vector<account_id_type>& result )const
 {
-   set<address> result;
-   for( auto auth : a.owner.address_auths )
-      result.insert(auth.first);
-   for( auto auth : a.active.address_auths )
-      result.insert(auth.first);
-   result.insert( a.options.memo_key );
-   return result;
+   result.clear();
+   add_members( a.owner.account_auths, result );
+   add_members( a.active.account_auths, result );
+   sort_unique( result );
+}
+void account_member_index::get_key_members( const account_object& a, vector<public_key_type>& result )const
+{
+   result.clear();
+   add_members( a.owner.key_auths, result );
+   add_members( a.active.key_auths, result );
+   result.push_back( a.options.memo_key );
+   sort_unique( result );
+}
+/** the memo key is found through account_to_key_memberships, only real address authorities are indexed here */
+void account_member_index::get_address_members( const account_object& a, vector<address>& result )const
+{
+   result.clear();
+   add_members( a.owner.address_auths, result );
+   add_members( a.active.address_auths, result );
+   sort_unique( result );
+}
+
+account_member_index::legacy_address_array account_member_index::legacy_addresses( const public_key_type& key )
+{
+   return {{ address( pts_address( key, false, 56 ) ),
+             address( pts_address( key, true, 56 ) ),
+             address( pts_address( key, false, 0 ) ),
+             address( pts_address( key, true, 0 ) ),
+             address( key ) }};
+}
+
+void account_member_index::find_key_references( const public_key_type& key, vector<account_id_type>& result )const
+{
+   // deriving the addresses costs several hashes per key, only do it if any account still uses them
+   if( has_address_members() )
+      find_key_references( key, legacy_addresses( key ), result );
+   else
+      find_key_references( key, legacy_address_array(), result );
+}
+
+void account_member_index::find_key_references( const public_key_type& key, const legacy_address_array& legacy,
+                                                vector<account_id_type>& result )const
+{
+   const size_t first = result.size();
+   auto add = [&]( const account_set& accounts ) {
+      for( auto id : accounts )
+         if( std::find( result.begin() + first, result.end(), id ) == result.end() )
+            result.push_back( id );
+   };
+
+   auto itr = account_to_key_memberships.find( key );
+   if( itr != account_to_key_memberships.end() )
+      add( itr->second );
+
+   if( !has_address_members() )
+      return;
+   for( const auto& a : legacy )
+   {
+      auto aitr = account_to_address_memberships.find( a );
+      if( aitr != account_to_address_memberships.end() )
+         add( aitr->second );
+   }
 }
 
 void account_member_index::object_inserted(const object& obj)
@@ -145,17 +335,16 @@ void account_member_index::object_inserted(const object& obj)
     assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
     const account_object& a = static_cast<const account_object&>(obj);
 
-    auto account_members = get_account_members(a);
-    for( auto item : account_members )
-       account_to_account_memberships[item].insert(obj.id);
-
-    auto key_members = get_key_members(a);
-    for( auto item : key_members )
-       account_to_key_memberships[item].insert(obj.id);
+    before_account_members.clear();
+    before_key_members.clear();
+    before_address_members.clear();
 
-    auto address_members = get_address_members(a);
-    for( auto item : address_members )
-       account_to_address_memberships[item].insert(obj.id);
+    get_account_members( a, after_account_members );
+    update_memberships( account_to_account_memberships, before_account_members, after_account_members, a.id );
+    get_key_members( a, after_key_members );
+    update_memberships( account_to_key_memberships, before_key_members, after_key_members, a.id );
+    get_address_members( a, after_address_members );
+    update_memberships( account_to_address_memberships, before_address_members, after_address_members, a.id );
 }
 
 void account_member_index::object_removed(const object& obj)
@@ -163,28 +352,25 @@ void account_member_index::object_removed(const object& obj)
     assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
     const account_object& a = static_cast<const account_object&>(obj);
 
-    auto key_members = get_key_members(a);
-    for( auto item : key_members )
-       account_to_key_memberships[item].erase( obj.id );
-
-    auto address_members = get_address_members(a);
-    for( auto item : address_members )
-       account_to_address_memberships[item].erase( obj.id );
+    after_account_members.clear();
+    after_key_members.clear();
+    after_address_members.clear();
 
-    auto account_members = get_account_members(a);
-    for( auto item : account_members )
-       account_to_account_memberships[item].erase( obj.id );
+    get_account_members( a, before_account_members );
+    update_memberships( account_to_account_memberships, before_account_members, after_account_members, a.id );
+    get_key_members( a, before_key_members );
+    update_memberships( account_to_key_memberships, before_key_members, after_key_members, a.id );
+    get_address_members( a, before_address_members );
+    update_memberships( account_to_address_memberships, before_address_members, after_address_members, a.id );
 }
 
 void account_member_index::about_to_modify(const object& before)
 {
-   before_key_members.clear();
-   before_account_members.clear();
    assert( dynamic_cast<const account_object*>(&before) ); // for debug only
    const account_object& a = static_cast<const account_object&>(before);
-   before_key_members     = get_key_members(a);
-   before_address_members = get_address_members(a);
-   before_account_members = get_account_members(a);
+   get_account_members( a, before_account_members );
+   get_key_members( a, before_key_members );
+   get_address_members( a, before_address_members );
 }
 
 void account_member_index::object_modified(const object& after)
@@ -192,79 +378,84 @@ void account_member_index::object_modified(const object& after)
     assert( dynamic_cast<const account_object*>(&after) ); // for debug only
     const account_object& a = static_cast<const account_object&>(after);
 
-    {
-       set<account_id_type> after_account_members = get_account_members(a);
-       vector<account_id_type> removed; removed.reserve(before_account_members.size());
-       std::set_difference(before_account_members.begin(), before_account_members.end(),
-                           after_account_members.begin(), after_account_members.end(),
-                           std::inserter(removed, removed.end()));
-
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_account_memberships[*itr].erase(after.id);
-
-       vector<object_id_type> added; added.reserve(after_account_members.size());
-       std::set_difference(after_account_members.begin(), after_account_members.end(),
-                           before_account_members.begin(), before_account_members.end(),
-                           std::inserter(added, added.end()));
-
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_account_memberships[*itr].insert(after.id);
-    }
-
-
-    {
-       set<public_key_type> after_key_members = get_key_members(a);
-
-       vector<public_key_type> removed; removed.reserve(before_key_members.size());
-       std::set_difference(before_key_members.begin(), before_key_members.end(),
-                           after_key_members.begin(), after_key_members.end(),
-                           std::inserter(removed, removed.end()));
-
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_key_memberships[*itr].erase(after.id);
-
-       vector<public_key_type> added; added.reserve(after_key_members.size());
-       std::set_difference(after_key_members.begin(), after_key_members.end(),
-                           before_key_members.begin(), before_key_members.end(),
-                           std::inserter(added, added.end()));
-
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_key_memberships[*itr].insert(after.id);
-    }
+    get_account_members( a, after_account_members );
+    if( after_account_members != before_account_members )
+       update_memberships( account_to_account_memberships, before_account_members, after_account_members, a.id );
+    get_key_members( a, after_key_members );
+    if( after_key_members != before_key_members )
+       update_memberships( account_to_key_memberships, before_key_members, after_key_members, a.id );
+    get_address_members( a, after_address_members );
+    if( after_address_members != before_address_members )
+       update_memberships( account_to_address_memberships, before_address_members, after_address_members, a.id );
+}
 
-    {
-       set<address> after_address_members = get_address_members(a);
+void account_referrer_index::object_inserted( const object& obj )
+{
+}
+void account_referrer_index::object_removed( const object& obj )
+{
+}
+void account_referrer_index::about_to_modify( const object& before )
+{
+}
+void account_referrer_index::object_modified( const object& after  )
+{
+}
 
-       vector<address> removed; removed.reserve(before_address_members.size());
-       std::set_difference(before_address_members.begin(), before_address_members.end(),
-                           after_address_members.begin(), after_address_members.end(),
-                           std::inserter(removed, removed.end()));
+void account_pending_fee_index::object_inserted( const object& obj )
+{
+   object_modified( obj );
+}
 
-       for( auto itr = removed.begin(); itr != removed.end(); ++itr )
-          account_to_address_memberships[*itr].erase(after.id);
+void account_pending_fee_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_statistics_object*>(&obj) ); // for debug only
+   accounts_with_pending_fees.erase( static_cast<const account_statistics_object&>(obj).owner );
+}
 
-       vector<address> added; added.reserve(after_address_members.size());
-       std::set_difference(after_address_members.begin(), after_address_members.end(),
-                           before_address_members.begin(), before_address_members.end(),
-                           std::inserter(added, added.end()));
+void account_pending_fee_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const account_statistics_object*>(&after) ); // for debug only
+   const account_statistics_object& s = static_cast<const account_statistics_object&>(after);
+   if( s.pending_fees > 0 || s.pending_vested_fees > 0 )
+      accounts_with_pending_fees.insert( s.owner );
+   else
+      accounts_with_pending_fees.erase( s.owner );
+}
 
-       for( auto itr = added.begin(); itr != added.end(); ++itr )
-          account_to_address_memberships[*itr].insert(after.id);
-    }
+void top_holders_index::object_inserted( const object& obj )
+{
+   on_change( obj );
+}
 
+void top_holders_index::object_removed( const object& obj )
+{
+   on_change( obj );
 }
 
-void account_referrer_index::object_inserted( const object& obj )
+void top_holders_index::object_modified( const object& after )
 {
+   on_change( after );
 }
-void account_referrer_index::object_removed( const object& obj )
+
+void top_holders_index::on_change( const object& obj )
 {
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   auto itr = _change_counts.find( static_cast<const account_balance_object&>(obj).asset_type );
+   if( itr != _change_counts.end() )
+      ++itr->second;
 }
-void account_referrer_index::about_to_modify( const object& before )
+
+void top_holders_index::watch( asset_id_type asset )const
 {
+   _change_counts.insert( std::make_pair( asset, uint64_t(0) ) );
 }
-void account_referrer_index::object_modified( const object& after  )
+
+uint64_t top_holders_index::get_change_count( asset_id_type asset )const
 {
+   auto itr = _change_counts.find( asset );
+   FC_ASSERT( itr != _change_counts.end() );
+   return itr->second;
 }
 
 } } // graphene::chain
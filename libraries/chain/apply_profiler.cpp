@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/apply_profiler.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+   struct operation_name_visitor
+   {
+      typedef string result_type;
+      template<typename T>
+      string operator()( const T& )const
+      {
+         string name = fc::get_typename<T>::name();
+         auto pos = name.find_last_of( ':' );
+         return pos == string::npos ? name : name.substr( pos + 1 );
+      }
+   };
+}
+
+void latency_histogram::record( const fc::microseconds& elapsed )
+{
+   uint64_t us = std::max<int64_t>( elapsed.count(), 0 );
+   uint32_t bucket = 0;
+   while( (us >> bucket) != 0 && bucket < 31 )
+      ++bucket;
+   if( buckets.size() <= bucket )
+      buckets.resize( bucket + 1 );
+   ++buckets[bucket];
+   ++count;
+   total_us += us;
+   max_us = std::max( max_us, us );
+}
+
+apply_profiler::step_timer::step_timer( apply_profiler& p )
+:_profiler(p),_enabled(p.enabled())
+{
+   _profiler._in_block = true;
+   if( _enabled )
+      _start = _last = fc::time_point::now();
+}
+
+apply_profiler::step_timer::~step_timer()
+{
+   _profiler._in_block = false;
+}
+
+void apply_profiler::step_timer::step( const char* name )
+{
+   if( !_enabled ) return;
+   auto now = fc::time_point::now();
+   _profiler.record_step( name, now - _last );
+   _last = now;
+}
+
+void apply_profiler::step_timer::finish( uint32_t block_num )
+{
+   if( !_enabled ) return;
+   _profiler.record_block( block_num, fc::time_point::now() - _start );
+}
+
+void apply_profiler::enable( bool e )
+{
+   if( e && !_enabled )
+      reset();
+   _enabled = e;
+}
+
+void apply_profiler::reset()
+{
+   _profile = apply_profile();
+   _operations.clear();
+   _sessions_started = _undo.sessions_started();
+   _sessions_undone  = _undo.sessions_undone();
+   _sessions_merged  = _undo.sessions_merged();
+}
+
+void apply_profiler::record_operation( int which, const fc::microseconds& evaluate, const fc::microseconds& apply )
+{
+   if( which < 0 ) return;
+   if( _operations.size() <= size_t(which) )
+      _operations.resize( which + 1 );
+   auto& op = _operations[which];
+   op.evaluate.record( evaluate );
+   op.apply.record( apply );
+}
+
+void apply_profiler::record_step( const char* step, const fc::microseconds& elapsed )
+{
+   _profile.steps[step].record( elapsed );
+}
+
+void apply_profiler::record_block( uint32_t block_num, const fc::microseconds& elapsed )
+{
+   if( _profile.block.count == 0 )
+      _profile.first_block = block_num;
+   _profile.last_block = block_num;
+   _profile.block.record( elapsed );
+
+   if( _undo.enabled() && _undo.size() )
+   {
+      const auto& head = _undo.head();
+      _profile.objects_created  += head.new_ids.size();
+      _profile.objects_modified += head.old_values.size();
+      _profile.objects_removed  += head.removed.size();
+   }
+
+   if( _dump_interval && _profile.block.count >= _dump_interval )
+   {
+      dump();
+      reset();
+   }
+}
+
+apply_profile apply_profiler::get_profile()const
+{
+   apply_profile result = _profile;
+   result.undo_sessions_started = _undo.sessions_started() - _sessions_started;
+   result.undo_sessions_undone  = _undo.sessions_undone()  - _sessions_undone;
+   result.undo_sessions_merged  = _undo.sessions_merged()  - _sessions_merged;
+
+   operation op;
+   for( size_t i = 0; i < _operations.size(); ++i )
+   {
+      if( _operations[i].evaluate.count == 0 )
+         continue;
+      result.operations.push_back( _operations[i] );
+      op.set_which( i );
+      result.operations.back().which = i;
+      result.operations.back().name  = op.visit( operation_name_visitor() );
+   }
+   return result;
+}
+
+void apply_profiler::dump()const
+{
+   auto p = get_profile();
+   ilog( "Apply profile for blocks ${f}-${l}: ${n} blocks, mean ${mean}us, max ${max}us, ${s} undo sessions (${u} undone)",
+         ("f",p.first_block)("l",p.last_block)("n",p.block.count)("mean",p.block.mean_us())("max",p.block.max_us)
+         ("s",p.undo_sessions_started)("u",p.undo_sessions_undone) );
+   for( const auto& step : p.steps )
+      ilog( "   step ${name}: mean ${mean}us, max ${max}us",
+            ("name",step.first)("mean",step.second.mean_us())("max",step.second.max_us) );
+   for( const auto& op : p.operations )
+      ilog( "   ${name} x${n}: evaluate mean ${e}us max ${emax}us, apply mean ${a}us max ${amax}us",
+            ("name",op.name)("n",op.evaluate.count)
+            ("e",op.evaluate.mean_us())("emax",op.evaluate.max_us)
+            ("a",op.apply.mean_us())("amax",op.apply.max_us) );
+}
+
+} } // graphene::chain
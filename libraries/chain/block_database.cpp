@@ -206,6 +206,59 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+vector<raw_block> block_database::fetch_range_raw( uint32_t block_num_from, uint32_t count, uint64_t max_bytes )const
+{
+   vector<raw_block> result;
+   try
+   {
+      if( block_num_from == 0 || count == 0 )
+         return result;
+
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      uint64_t index_end = _block_num_to_pos.tellg();
+      uint64_t index_pos = uint64_t(sizeof(index_entry)) * block_num_from;
+      if( index_end <= index_pos )
+         return result;
+      count = std::min<uint64_t>( count, (index_end - index_pos) / sizeof(index_entry) );
+
+      vector<index_entry> entries( count );
+      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
+      _block_num_to_pos.read( (char*)entries.data(), sizeof(index_entry) * count );
+
+      // the first block is returned even if it alone exceeds max_bytes, so that a caller always makes progress
+      uint32_t found = 0;
+      uint64_t total_size = 0;
+      while( found < count && entries[found].block_size > 0 && entries[found].block_id != block_id_type() )
+      {
+         if( found > 0 && total_size + entries[found].block_size > max_bytes )
+            break;
+         total_size += entries[found].block_size;
+         ++found;
+      }
+      result.resize( found );
+
+      // blocks on the current chain are normally adjacent in the log, so a run of them needs a single seek
+      for( uint32_t i = 0; i < found; ++i )
+      {
+         if( i == 0 || entries[i].block_pos != entries[i-1].block_pos + entries[i-1].block_size )
+            _blocks.seekg( entries[i].block_pos );
+         result[i].block_num = block_num_from + i;
+         result[i].block_id  = entries[i].block_id;
+         result[i].data.resize( entries[i].block_size );
+         _blocks.read( result[i].data.data(), entries[i].block_size );
+      }
+   }
+   catch (const fc::exception&)
+   {
+      result.clear();
+   }
+   catch (const std::exception&)
+   {
+      result.clear();
+   }
+   return result;
+}
+
 optional<signed_block> block_database::last()const
 {
    try
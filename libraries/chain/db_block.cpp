@@ -51,8 +51,7 @@ bool database::is_known_block( const block_id_type& id )const
  */
 bool database::is_known_transaction( const transaction_id_type& id )const
 {
-   const auto& trx_idx = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   return trx_idx.find( id ) != trx_idx.end();
+   return get_index_type<transaction_index>().find_trx( id ) != nullptr;
 }
 
 block_id_type  database::get_block_id_for_num( uint32_t block_num )const
@@ -78,12 +77,32 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
    return optional<signed_block>();
 }
 
-const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
+vector<raw_block> database::fetch_raw_blocks_by_number( uint32_t first, uint32_t count, uint64_t max_bytes )const
 {
-   auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
-   return itr->trx;
+   return _block_id_to_block.fetch_range_raw( first, count, max_bytes );
+}
+
+signed_transaction database::get_recent_transaction(const transaction_id_type& trx_id) const
+{
+   const transaction_object* trx_obj = get_index_type<transaction_index>().find_trx( trx_id );
+   FC_ASSERT( trx_obj != nullptr, "Unknown transaction ${id}", ("id",trx_id) );
+
+   // the dedupe index only knows the block, the transaction itself comes from the block or the pending list
+   if( trx_obj->block_num == 0 )
+   {
+      for( const auto& trx : _pending_tx )
+         if( trx.id() == trx_id )
+            return trx;
+      FC_THROW( "Transaction ${id} is not pending anymore", ("id",trx_id) );
+   }
+   optional<signed_block> block = fetch_block_by_number( trx_obj->block_num );
+   if( block.valid() )
+   {
+      for( const auto& trx : block->transactions )
+         if( trx.id() == trx_id )
+            return trx;
+   }
+   FC_THROW( "Transaction ${id} is not in block ${n}", ("id",trx_id)("n",trx_obj->block_num) );
 }
 
 std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of_fork) const
@@ -113,6 +132,7 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
    //idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   write_guard guard( *this );
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -122,6 +142,7 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
          result = _push_block(new_block);
       });
    });
+   trim_caches();
    return result;
 }
 
@@ -217,6 +238,7 @@ bool database::_push_block(const signed_block& new_block)
  */
 processed_transaction database::push_transaction( const signed_transaction& trx, uint32_t skip )
 { try {
+   write_guard guard( *this );
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -240,6 +262,8 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
    auto temp_session = _undo_db.start_undo_session();
    auto processed_trx = _apply_transaction( trx );
    _pending_tx.push_back(processed_trx);
+   _pending_tx_digests.push_back( processed_trx.merkle_digest() );
+   _pending_tx_size += fc::raw::pack_size( processed_trx );
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -252,6 +276,7 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   write_guard guard( *this );
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
 }
@@ -300,6 +325,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 { try {
+   write_guard guard( *this );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -316,97 +342,133 @@ signed_block database::_generate_block(
 {
    try {
    uint32_t skip = get_node_properties().skip_flags;
-   uint32_t slot_num = get_slot_at_time( when );
-   FC_ASSERT( slot_num > 0 );
-   witness_id_type scheduled_witness = get_scheduled_witness( slot_num );
-   FC_ASSERT( scheduled_witness == witness_id );
-
    const auto& witness_obj = witness_id(*this);
 
    if( !(skip & skip_witness_signature) )
       FC_ASSERT( witness_obj.signing_key == block_signing_private_key.get_public_key() );
 
+   signed_block pending_block = _build_block( when, witness_id );
+
+   if( !(skip & skip_witness_signature) )
+      pending_block.sign( block_signing_private_key );
+
+   push_block( pending_block, skip );
+
+   return pending_block;
+} FC_CAPTURE_AND_RETHROW( (witness_id) ) }
+
+signed_block database::build_block(
+   fc::time_point_sec when,
+   witness_id_type witness_id,
+   uint32_t skip /* = 0 */
+   )
+{ try {
+   write_guard guard( *this );
+   signed_block result;
+   detail::with_skip_flags( *this, skip, [&]()
+   {
+      result = _build_block( when, witness_id );
+   } );
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
+signed_block database::_build_block(
+   fc::time_point_sec when,
+   witness_id_type witness_id
+   )
+{
+   try {
+   uint32_t skip = get_node_properties().skip_flags;
+   uint32_t slot_num = get_slot_at_time( when );
+   FC_ASSERT( slot_num > 0 );
+   witness_id_type scheduled_witness = get_scheduled_witness( slot_num );
+   FC_ASSERT( scheduled_witness == witness_id );
+
    static const size_t max_block_header_size = fc::raw::pack_size( signed_block_header() ) + 4;
    auto maximum_block_size = get_global_properties().parameters.maximum_block_size;
    size_t total_block_size = max_block_header_size;
 
    signed_block pending_block;
+   vector<digest_type> digests;
 
-   //
-   // The following code throws away existing pending_tx_session and
-   // rebuilds it by re-applying pending transactions.
-   //
-   // This rebuild is necessary because pending transactions' validity
-   // and semantics may have changed since they were received, because
-   // time-based semantics are evaluated based on the current block
-   // time.  These changes can only be reflected in the database when
-   // the value of the "when" variable is known, which means we need to
-   // re-apply pending transactions in this method.
-   //
-   _pending_tx_session.reset();
-   _pending_tx_session = _undo_db.start_undo_session();
-
-   uint64_t postponed_tx_count = 0;
-   // pop pending state (reset to head block state)
-   for( const processed_transaction& tx : _pending_tx )
+   if( total_block_size + _pending_tx_size < maximum_block_size )
+   {
+      //
+      // Pending transactions are applied on top of the head block state
+      // in the order they arrived, which is exactly what the block will
+      // do, so when all of them fit they can be taken as they are.
+      //
+      pending_block.transactions = _pending_tx;
+      digests = _pending_tx_digests;
+   }
+   else
    {
-      size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+      //
+      // The following code throws away existing pending_tx_session and
+      // rebuilds it by re-applying the pending transactions that fit
+      // into the block, the others are postponed.
+      //
+      _pending_tx_session.reset();
+      _pending_tx_session = _undo_db.start_undo_session();
 
-      // postpone transaction if it would make block too big
-      if( new_total_size >= maximum_block_size )
+      uint64_t postponed_tx_count = 0;
+      // pop pending state (reset to head block state)
+      for( const processed_transaction& tx : _pending_tx )
       {
-         postponed_tx_count++;
-         continue;
-      }
+         size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
 
-      try
-      {
-         auto temp_session = _undo_db.start_undo_session();
-         processed_transaction ptx = _apply_transaction( tx );
-         temp_session.merge();
-
-         // We have to recompute pack_size(ptx) because it may be different
-         // than pack_size(tx) (i.e. if one or more results increased
-         // their size)
-         total_block_size += fc::raw::pack_size( ptx );
-         pending_block.transactions.push_back( ptx );
+         // postpone transaction if it would make block too big
+         if( new_total_size >= maximum_block_size )
+         {
+            postponed_tx_count++;
+            continue;
+         }
+
+         try
+         {
+            auto temp_session = _undo_db.start_undo_session();
+            processed_transaction ptx = _apply_transaction( tx );
+            temp_session.merge();
+
+            // We have to recompute pack_size(ptx) because it may be different
+            // than pack_size(tx) (i.e. if one or more results increased
+            // their size)
+            total_block_size += fc::raw::pack_size( ptx );
+            digests.push_back( ptx.merkle_digest() );
+            pending_block.transactions.push_back( std::move(ptx) );
+         }
+         catch ( const fc::exception& e )
+         {
+            // Do nothing, transaction will not be re-applied
+            wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
+            wlog( "The transaction was ${t}", ("t", tx) );
+         }
       }
-      catch ( const fc::exception& e )
+      if( postponed_tx_count > 0 )
       {
-         // Do nothing, transaction will not be re-applied
-         wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
-         wlog( "The transaction was ${t}", ("t", tx) );
+         wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
       }
    }
-   if( postponed_tx_count > 0 )
-   {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
-   }
 
    _pending_tx_session.reset();
 
    // We have temporarily broken the invariant that
    // _pending_tx_session is the result of applying _pending_tx, as
    // _pending_tx now consists of the set of postponed transactions.
-   // However, the push_block() call below will re-create the
+   // However, the push_block() call that follows will re-create the
    // _pending_tx_session.
 
    pending_block.previous = head_block_id();
    pending_block.timestamp = when;
-   pending_block.transaction_merkle_root = pending_block.calculate_merkle_root();
+   pending_block.transaction_merkle_root = signed_block::merkle_root( std::move(digests) );
    pending_block.witness = witness_id;
 
-   if( !(skip & skip_witness_signature) )
-      pending_block.sign( block_signing_private_key );
-
-   // TODO:  Move this to _push_block() so session is restored.
+   // the signature has a fixed size, so the unsigned block can be checked already
    if( !(skip & skip_block_size_check) )
    {
       FC_ASSERT( fc::raw::pack_size(pending_block) <= get_global_properties().parameters.maximum_block_size );
    }
 
-   push_block( pending_block, skip );
-
    return pending_block;
 } FC_CAPTURE_AND_RETHROW( (witness_id) ) }
 
@@ -416,6 +478,7 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   write_guard guard( *this );
    _pending_tx_session.reset();
    auto head_id = head_block_id();
    optional<signed_block> head_block = fetch_block_by_id( head_id );
@@ -431,8 +494,11 @@ void database::pop_block()
 
 void database::clear_pending()
 { try {
+   write_guard guard( *this );
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
+   _pending_tx_digests.clear();
+   _pending_tx_size = 0;
    _pending_tx_session.reset();
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -489,6 +555,7 @@ void database::_apply_block( const signed_block& next_block )
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
+   apply_profiler::step_timer timer( _apply_profiler );
 
    FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
 
@@ -499,6 +566,7 @@ void database::_apply_block( const signed_block& next_block )
 
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
+   timer.step( "validate_block_header" );
 
    for( const auto& trx : next_block.transactions )
    {
@@ -511,21 +579,31 @@ void database::_apply_block( const signed_block& next_block )
       apply_transaction( trx, skip );
       ++_current_trx_in_block;
    }
+   timer.step( "apply_transactions" );
 
    update_global_dynamic_data(next_block);
    update_signing_witness(signing_witness, next_block);
    update_last_irreversible_block();
+   timer.step( "update_global_dynamic_data" );
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
       perform_chain_maintenance(next_block, global_props);
+      timer.step( "perform_chain_maintenance" );
+   }
 
    create_block_summary(next_block);
    clear_expired_transactions();
+   timer.step( "clear_expired_transactions" );
    clear_expired_proposals();
+   timer.step( "clear_expired_proposals" );
    clear_expired_orders();
+   timer.step( "clear_expired_orders" );
    update_expired_feeds();
+   timer.step( "update_expired_feeds" );
    update_withdraw_permissions();
+   timer.step( "update_withdraw_permissions" );
 
    // n.b., update_maintenance_flag() happens this late
    // because get_slot_time() / get_slot_at_time() is needed above
@@ -536,12 +614,17 @@ void database::_apply_block( const signed_block& next_block )
    update_witness_schedule();
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
+   timer.step( "update_witness_schedule" );
 
    // notify observers that the block has been applied
    applied_block( next_block ); //emit
    _applied_ops.clear();
+   timer.step( "applied_block" );
 
    notify_changed_objects();
+   timer.step( "notify_changed_objects" );
+   forget_irreversible_revisions( next_block_num );
+   timer.finish( next_block_num );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 void database::notify_changed_objects()
@@ -580,11 +663,10 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    if( true || !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
-   auto& trx_idx = get_mutable_index_type<transaction_index>();
+   const auto& trx_idx = get_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
    auto trx_id = trx.id();
-   FC_ASSERT( (skip & skip_transaction_dupe_check) ||
-              trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end() );
+   FC_ASSERT( (skip & skip_transaction_dupe_check) || trx_idx.find_trx( trx_id ) == nullptr );
    transaction_evaluation_state eval_state(this);
    const chain_parameters& chain_parameters = get_global_properties().parameters;
    eval_state._trx = &trx;
@@ -620,7 +702,9 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
-         transaction.trx = trx;
+         transaction.expiration = trx.expiration;
+         // pending transactions are applied on top of the pending session, only blocks are applied without one
+         transaction.block_num = _pending_tx_session.valid() ? 0 : _current_block_num;
       });
    }
 
@@ -637,9 +721,8 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    ptrx.operation_results = std::move(eval_state.operation_results);
 
    //Make sure the temp account has no non-zero balances
-   const auto& index = get_index_type<account_balance_index>().indices().get<by_account_asset>();
-   auto range = index.equal_range( boost::make_tuple( GRAPHENE_TEMP_ACCOUNT ) );
-   std::for_each(range.first, range.second, [](const account_balance_object& b) { FC_ASSERT(b.balance == 0); });
+   for( const auto& b : get_index_type<account_balance_index>().get_account_balances( GRAPHENE_TEMP_ACCOUNT ) )
+      FC_ASSERT( b.second->balance == 0 );
 
    return ptrx;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
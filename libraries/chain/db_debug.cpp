@@ -41,7 +41,7 @@ void database::debug_dump()
    const auto& db = *this;
    const asset_dynamic_data_object& core_asset_data = db.get_core_asset().dynamic_asset_data_id(db);
 
-   const auto& balance_index = db.get_index_type<account_balance_index>().indices();
+   const auto& balance_index = db.get_index_type<account_balance_index>();
    const simple_index<account_statistics_object>& statistics_index = db.get_index_type<simple_index<account_statistics_object>>();
    map<asset_id_type,share_type> total_balances;
    map<asset_id_type,share_type> total_debts;
@@ -184,6 +184,7 @@ void database::apply_debug_updates()
 
 void database::debug_update( const fc::variant_object& update )
 {
+   write_guard guard( *this );
    block_id_type head_id = head_block_id();
    auto it = _node_property_object.debug_updates.find( head_id );
    if( it == _node_property_object.debug_updates.end() )
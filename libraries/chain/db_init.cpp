@@ -193,6 +193,7 @@ void database::initialize_indexes()
 
    auto prop_index = add_index< primary_index<proposal_index > >();
    prop_index->add_secondary_index<required_approval_index>();
+   prop_index->add_secondary_index<proposal_authority_index>();
 
    add_index< primary_index<withdraw_permission_index > >();
    add_index< primary_index<vesting_balance_index> >();
@@ -202,11 +203,13 @@ void database::initialize_indexes()
 
    //Implementation object indexes
    add_index< primary_index<transaction_index                             > >();
-   add_index< primary_index<account_balance_index                         > >();
+   auto acct_balance_index = add_index< primary_index<account_balance_index > >();
+   acct_balance_index->add_secondary_index<top_holders_index>();
    add_index< primary_index<asset_bitasset_data_index                     > >();
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
-   add_index< primary_index<simple_index<account_statistics_object       >> >();
+   auto stats_index = add_index< primary_index<simple_index<account_statistics_object       >> >();
+   stats_index->add_secondary_index<account_pending_fee_index>();
    add_index< primary_index<simple_index<asset_dynamic_data_object       >> >();
    add_index< primary_index<flat_index<  block_summary_object            >> >();
    add_index< primary_index<simple_index<chain_property_object          > > >();
@@ -407,31 +410,119 @@ void database::init_genesis(const genesis_state_type& genesis_state)
    create<block_summary_object>([&](block_summary_object&) {});
 
    // Create initial accounts
-   for( const auto& account : genesis_state.initial_accounts )
+   //
+   // Genesis accounts are created directly rather than through account_create_evaluator:
+   // their authorities only reference keys and the registrar is the temp account, so the
+   // evaluator's chain state lookups reduce to the checks below.  Registration counting and
+   // the account fee scale follow the evaluator exactly, and the applied operations are
+   // still recorded so that history plugins see the same operations as before.
+   if( _genesis_accounts_through_evaluators )
    {
-      account_create_operation cop;
-      cop.name = account.name;
-      cop.registrar = GRAPHENE_TEMP_ACCOUNT;
-      cop.owner = authority(1, account.owner_key, 1);
-      if( account.active_key == public_key_type() )
+      for( const auto& account : genesis_state.initial_accounts )
       {
-         cop.active = cop.owner;
-         cop.options.memo_key = account.owner_key;
-      }
-      else
-      {
-         cop.active = authority(1, account.active_key, 1);
-         cop.options.memo_key = account.active_key;
+         account_create_operation cop;
+         cop.name = account.name;
+         cop.registrar = GRAPHENE_TEMP_ACCOUNT;
+         cop.owner = authority(1, account.owner_key, 1);
+         if( account.active_key == public_key_type() )
+         {
+            cop.active = cop.owner;
+            cop.options.memo_key = account.owner_key;
+         }
+         else
+         {
+            cop.active = authority(1, account.active_key, 1);
+            cop.options.memo_key = account.active_key;
+         }
+         account_id_type account_id(apply_operation(genesis_eval_state, cop).get<object_id_type>());
+
+         if( account.is_lifetime_member )
+         {
+             account_upgrade_operation op;
+             op.account_to_upgrade = account_id;
+             op.upgrade_to_lifetime_member = true;
+             apply_operation(genesis_eval_state, op);
+         }
       }
-      account_id_type account_id(apply_operation(genesis_eval_state, cop).get<object_id_type>());
+   }
+   else
+   {
+      const auto& accounts_by_name = get_index_type<account_index>().indices().get<by_name>();
+      const auto& params = get_global_properties().parameters;
+      uint32_t registered = get_dynamic_global_properties().accounts_registered_this_interval;
+
+      account_create_operation cop;
+      cop.registrar = GRAPHENE_TEMP_ACCOUNT;
+      const account_object& referrer = cop.referrer(*this);
+      FC_ASSERT( cop.registrar(*this).is_lifetime_member(), "Only Lifetime members may register an account." );
+      FC_ASSERT( referrer.is_member( head_block_time() ), "The referrer must be either a lifetime or annual subscriber." );
+      account_upgrade_operation uop;
+      uop.upgrade_to_lifetime_member = true;
 
-      if( account.is_lifetime_member )
+      for( const auto& account : genesis_state.initial_accounts )
       {
-          account_upgrade_operation op;
-          op.account_to_upgrade = account_id;
-          op.upgrade_to_lifetime_member = true;
-          apply_operation(genesis_eval_state, op);
+         FC_ASSERT( accounts_by_name.find( account.name ) == accounts_by_name.end(),
+                    "Duplicate genesis account ${n}", ("n", account.name) );
+
+         cop.name = account.name;
+         cop.owner = authority(1, account.owner_key, 1);
+         if( account.active_key == public_key_type() )
+         {
+            cop.active = cop.owner;
+            cop.options.memo_key = account.owner_key;
+         }
+         else
+         {
+            cop.active = authority(1, account.active_key, 1);
+            cop.options.memo_key = account.active_key;
+         }
+         cop.validate();
+         FC_ASSERT( cop.owner.num_auths() <= params.maximum_authority_membership &&
+                    cop.active.num_auths() <= params.maximum_authority_membership,
+                    "Maximum authority membership exceeded" );
+
+         uint32_t create_op_id = push_applied_operation( cop );
+         const account_object& new_account = create<account_object>( [&]( account_object& a ) {
+            a.name = cop.name;
+            a.owner = cop.owner;
+            a.active = cop.active;
+            a.options = cop.options;
+            a.statistics = create<account_statistics_object>([&](account_statistics_object& s){s.owner = a.id;}).id;
+            a.network_fee_percentage = params.network_percent_of_fee;
+            a.referrer_rewards_percentage = 0;
+            if( account.is_lifetime_member )
+            {
+               a.referrer = a.registrar = a.lifetime_referrer = a.get_id();
+               a.membership_expiration_date = time_point_sec::maximum();
+               a.lifetime_referrer_fee_percentage = GRAPHENE_100_PERCENT - a.network_fee_percentage;
+            }
+            else
+            {
+               a.registrar = cop.registrar;
+               a.referrer = cop.referrer;
+               a.lifetime_referrer = referrer.lifetime_referrer;
+               a.lifetime_referrer_fee_percentage = params.lifetime_referrer_percent_of_fee;
+            }
+         });
+         set_applied_operation_result( create_op_id, object_id_type( new_account.id ) );
+
+         // same as account_create_evaluator, which scales the fee on every accounts_per_fee_scale registrations
+         if( ++registered % params.accounts_per_fee_scale == 0 )
+            modify( get_global_properties(), []( global_property_object& p ) {
+               p.parameters.current_fees->get<account_create_operation>().basic_fee <<= p.parameters.account_fee_scale_bitshifts;
+            });
+
+         if( account.is_lifetime_member )
+         {
+            uop.account_to_upgrade = new_account.id;
+            uop.validate();
+            set_applied_operation_result( push_applied_operation( uop ), void_result() );
+         }
       }
+
+      modify( get_dynamic_global_properties(), [&]( dynamic_global_property_object& p ) {
+         p.accounts_registered_this_interval = registered;
+      });
    }
 
    // Helper function to get account ID by name
@@ -530,9 +621,17 @@ void database::init_genesis(const genesis_state_type& genesis_state)
 
    // Create initial balances
    share_type total_allocation;
+   // handouts are nearly always of the same asset, so remember the last lookup
+   const string* last_symbol = nullptr;
+   asset_id_type last_asset_id;
    for( const auto& handout : genesis_state.initial_balances )
    {
-      const auto asset_id = get_asset_id(handout.asset_symbol);
+      if( last_symbol == nullptr || *last_symbol != handout.asset_symbol )
+      {
+         last_asset_id = get_asset_id(handout.asset_symbol);
+         last_symbol = &handout.asset_symbol;
+      }
+      const auto asset_id = last_asset_id;
       create<balance_object>([&handout,&get_asset_id,total_allocation,asset_id](balance_object& b) {
          b.balance = asset(handout.amount, asset_id);
          b.owner = handout.owner;
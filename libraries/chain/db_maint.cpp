@@ -485,6 +485,10 @@ void visit_special_authorities( const database& db, Visitor visit )
 
 void update_top_n_authorities( database& db )
 {
+   const auto& bal_index = dynamic_cast<const primary_index<account_balance_index>&>( db.get_index_type<account_balance_index>() );
+   const top_holders_index& tracker = bal_index.get_secondary_index<top_holders_index>();
+   map< std::pair< account_id_type, bool >, top_holders_index::computed_authority > computed;
+
    visit_special_authorities( db,
    [&]( const account_object& acct, bool is_owner, const special_authority& auth )
    {
@@ -493,33 +497,64 @@ void update_top_n_authorities( database& db )
          // use index to grab the top N holders of the asset and vote_counter to obtain the weights
 
          const top_holders_special_authority& tha = auth.get< top_holders_special_authority >();
+         if( tha.num_top_holders == 0 )
+            return;
+
+         tracker.watch( tha.asset );
+         const auto key = std::make_pair( acct.id, is_owner );
+         const uint8_t flag = is_owner ? account_object::top_n_control_owner : account_object::top_n_control_active;
+         const authority& current = is_owner ? acct.owner : acct.active;
+
+         // No balance of the asset changed since the last computation, so it would give the same result.  Only
+         // trust it while the account still holds that result, popped blocks may have rolled the account back.
+         auto last = tracker.computed.find( key );
+         if( last != tracker.computed.end()
+             && last->second.asset == tha.asset
+             && last->second.num_top_holders == tha.num_top_holders
+             && last->second.change_count == tracker.get_change_count( tha.asset )
+             && ( last->second.is_empty || ( last->second.auth == current && (acct.top_n_control_flags & flag) ) ) )
+         {
+            computed.insert( *last );
+            return;
+         }
+
          vote_counter vc;
-         const auto& bal_idx = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
          uint8_t num_needed = tha.num_top_holders;
-         if( num_needed == 0 )
-            return;
 
          // find accounts
-         const auto range = bal_idx.equal_range( boost::make_tuple( tha.asset ) );
-         for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+         for( const account_balance_object* bal : bal_index.get_ranked_balances( tha.asset ) )
          {
-             assert( bal.asset_type == tha.asset );
-             if( bal.owner == acct.id )
+             assert( bal->asset_type == tha.asset );
+             if( bal->owner == acct.id )
                 continue;
-             vc.add( bal.owner, bal.balance.value );
+             vc.add( bal->owner, bal->balance.value );
              --num_needed;
              if( num_needed == 0 )
                 break;
          }
 
+         top_holders_index::computed_authority& result = computed[ key ];
+         result.asset = tha.asset;
+         result.num_top_holders = tha.num_top_holders;
+         result.change_count = tracker.get_change_count( tha.asset );
+         result.is_empty = vc.is_empty();
+         if( result.is_empty )
+            return;
+
+         vc.finish( result.auth );
+         if( result.auth == current && (acct.top_n_control_flags & flag) )
+            return;
+
          db.modify( acct, [&]( account_object& a )
          {
             vc.finish( is_owner ? a.owner : a.active );
-            if( !vc.is_empty() )
-               a.top_n_control_flags |= (is_owner ? account_object::top_n_control_owner : account_object::top_n_control_active);
+            a.top_n_control_flags |= flag;
          } );
       }
    } );
+
+   // drop the authorities which are no longer top holders authorities
+   tracker.computed.swap( computed );
 }
 
 void split_fba_balance(
@@ -612,7 +647,7 @@ void distribute_fba_balances( database& db )
 void create_buyback_orders( database& db )
 {
    const auto& bbo_idx = db.get_index_type< buyback_index >().indices().get<by_id>();
-   const auto& bal_idx = db.get_index_type< account_balance_index >().indices().get< by_account_asset >();
+   const auto& bal_idx = db.get_index_type< account_balance_index >();
 
    for( const buyback_object& bbo : bbo_idx )
    {
@@ -630,13 +665,12 @@ void create_buyback_orders( database& db )
 
       while( true )
       {
-         auto it = bal_idx.lower_bound( boost::make_tuple( buyback_account.id, next_asset ) );
-         if( it == bal_idx.end() )
+         const auto& balances = bal_idx.get_account_balances( buyback_account.id );
+         auto it = balances.lower_bound( next_asset );
+         if( it == balances.end() )
             break;
-         if( it->owner != buyback_account.id )
-            break;
-         asset_id_type asset_to_sell = it->asset_type;
-         share_type amount_to_sell = it->balance;
+         asset_id_type asset_to_sell = it->second->asset_type;
+         share_type amount_to_sell = it->second->balance;
          next_asset = asset_to_sell + 1;
          if( asset_to_sell == asset_to_buy.id )
             continue;
@@ -790,12 +824,29 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    struct process_fees_helper {
       database& d;
       const global_property_object& props;
+      vector<account_id_type> owners;
+      size_t next = 0;
 
       process_fees_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo) {}
+         : d(d), props(gpo)
+      {
+         const auto& stats_idx = dynamic_cast<const primary_index<simple_index<account_statistics_object>>&>(
+               d.get_index_type<simple_index<account_statistics_object>>() );
+         const auto& pending = stats_idx.get_secondary_index<account_pending_fee_index>().accounts_with_pending_fees;
+         owners.assign( pending.begin(), pending.end() );
+         // Fee payouts may create cashback vesting balances, and the vote tally of accounts visited later counts
+         // them, so the accounts must still be paid out in the order perform_account_maintenance visits them.
+         std::sort( owners.begin(), owners.end(), [&d]( account_id_type a, account_id_type b ) {
+            return a(d).name < b(d).name;
+         });
+      }
 
       void operator()(const account_object& a) {
-         a.statistics(d).process_fees(a, d);
+         if( next < owners.size() && owners[next] == a.id )
+         {
+            ++next;
+            a.statistics(d).process_fees(a, d);
+         }
       }
    } fee_helper(*this, gpo);
 
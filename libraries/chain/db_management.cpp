@@ -28,6 +28,8 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/thread/thread_specific.hpp>
 
 #include <fstream>
 #include <functional>
@@ -36,6 +38,7 @@
 namespace graphene { namespace chain {
 
 database::database()
+:_apply_profiler(_undo_db)
 {
    initialize_indexes();
    initialize_evaluators();
@@ -46,6 +49,41 @@ database::~database()
    clear_pending();
 }
 
+/** @return a number identifying the running task, unique across threads */
+static uint64_t current_task_token()
+{
+   static fc::task_specific_ptr<uint64_t> token;
+   static std::atomic<uint64_t> next_token{0};
+   if( !token.get() )
+      token.reset( new uint64_t( ++next_token ) );
+   return *token;
+}
+
+database::write_guard::write_guard( database& db ) : _db( db )
+{
+   const uint64_t me = current_task_token();
+   if( _db._write_owner == me )
+   {
+      ++_db._write_depth;
+      return;
+   }
+   // the owner may be a suspended task of this thread, so give it a chance to run before locking
+   while( _db._write_owner != 0 )
+      fc::usleep( fc::milliseconds(1) );
+   _db._read_write_mutex.lock();
+   _db._write_owner = me;
+   _db._write_depth = 1;
+}
+
+database::write_guard::~write_guard()
+{
+   if( --_db._write_depth == 0 )
+   {
+      _db._write_owner = 0;
+      _db._read_write_mutex.unlock();
+   }
+}
+
 void database::reindex(fc::path data_dir, const genesis_state_type& initial_allocation)
 { try {
    ilog( "reindexing blockchain" );
@@ -93,6 +131,7 @@ void database::reindex(fc::path data_dir, const genesis_state_type& initial_allo
                           skip_tapos_check |
                           skip_witness_schedule_check |
                           skip_authority_check);
+      trim_caches();
    }
    _undo_db.enable();
    auto end = fc::time_point::now();
@@ -138,6 +177,7 @@ void database::open(
 
 void database::close(bool rewind)
 {
+   write_guard guard( *this );
    // TODO:  Save pending tx's on close()
    clear_pending();
 
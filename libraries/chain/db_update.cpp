@@ -156,14 +156,35 @@ void database::update_last_irreversible_block()
    }
 }
 
+void database::forget_irreversible_revisions( uint32_t block_num )
+{
+   // blocks at or above block_num were popped before it was applied
+   while( !_block_revisions.empty() && _block_revisions.back().first >= block_num )
+      _block_revisions.pop_back();
+   _block_revisions.emplace_back( block_num, get_revision() );
+
+   // clients polling at the head hold revisions newer than the end of the last irreversible block,
+   // so older entries can go without making anything look changed to them
+   const uint32_t last_irreversible = get_dynamic_global_properties().last_irreversible_block_num;
+   uint64_t revision = 0;
+   while( !_block_revisions.empty() && _block_revisions.front().first <= last_irreversible )
+   {
+      revision = _block_revisions.front().second;
+      _block_revisions.pop_front();
+   }
+   if( revision )
+      forget_revisions( revision );
+}
+
 void database::clear_expired_transactions()
 { try {
    //Look for expired transactions in the deduplication list, and remove them.
    //Transactions must have expired by at least two forking windows in order to be removed.
-   auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids, impl_transaction_object_type));
-   const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
-   while( (!dedupe_index.empty()) && (head_block_time() > dedupe_index.rbegin()->trx.expiration) )
-      transaction_idx.remove(*dedupe_index.rbegin());
+   auto& transaction_idx = get_mutable_index_type<transaction_index>();
+   vector<const transaction_object*> expired;
+   transaction_idx.get_expired( head_block_time(), expired );
+   for( const transaction_object* trx : expired )
+      remove( *trx );
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_expired_proposals()
@@ -44,6 +44,17 @@ database& generic_evaluator::db()const { return trx_state->db(); }
    { try {
       trx_state   = &eval_state;
       //check_required_authorities(op);
+      auto& profiler = db().get_apply_profiler();
+      if( apply && profiler.timing_operations() )
+      {
+         auto start = fc::time_point::now();
+         auto result = evaluate( op );
+         auto evaluated = fc::time_point::now();
+         result = this->apply( op );
+         profiler.record_operation( op.which(), evaluated - start, fc::time_point::now() - evaluated );
+         return result;
+      }
+
       auto result = evaluate( op );
 
       if( apply ) result = this->apply( op );
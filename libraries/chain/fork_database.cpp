@@ -29,11 +29,15 @@
 namespace graphene { namespace chain {
 fork_database::fork_database()
 {
+   _ring.resize( 2 * MAX_BLOCK_REORDERING );
 }
 void fork_database::reset()
 {
    _head.reset();
-   _index.clear();
+   for( auto& s : _ring )
+      s.clear();
+   _min_num = _max_num = 0;
+   _size = 0;
 }
 
 void fork_database::pop_block()
@@ -47,12 +51,12 @@ void fork_database::pop_block()
 void     fork_database::start_block(signed_block b)
 {
    auto item = std::make_shared<fork_item>(std::move(b));
-   _index.insert(item);
+   insert(item);
    _head = item;
 }
 
 /**
- * Pushes the block into the fork database and caches it if it doesn't link
+ * Pushes the block into the fork database, throws if it doesn't link
  *
  */
 shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
@@ -66,7 +70,6 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
       wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
       wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
       throw;
-      _unlinked_index.insert( item );
    }
    return _head;
 }
@@ -82,118 +85,105 @@ void  fork_database::_push_block(const item_ptr& item)
 
    if( _head && item->previous_id() != block_id_type() )
    {
-      auto& index = _index.get<block_id>();
-      auto itr = index.find(item->previous_id());
-      GRAPHENE_ASSERT(itr != index.end(), unlinkable_block_exception, "block does not link to known chain");
-      FC_ASSERT(!(*itr)->invalid);
-      item->prev = *itr;
+      auto prev = find_item(item->previous_id());
+      GRAPHENE_ASSERT(prev, unlinkable_block_exception, "block does not link to known chain");
+      FC_ASSERT(!prev->invalid);
+      item->prev = prev;
    }
 
-   _index.insert(item);
+   insert(item);
    if( !_head ) _head = item;
    else if( item->num > _head->num )
    {
       _head = item;
-      uint32_t min_num = _head->num - std::min( _max_size, _head->num );
-//      ilog( "min block in fork DB ${n}, max_size: ${m}", ("n",min_num)("m",_max_size) );
-      auto& num_idx = _index.get<block_num>();
-      while( num_idx.size() && (*num_idx.begin())->num < min_num )
-         num_idx.erase( num_idx.begin() );
-      
-      _unlinked_index.get<block_num>().erase(_head->num - _max_size);
+      prune( _head->num - std::min( _max_size, _head->num ) );
    }
-   //_push_next( item );
 }
 
-/**
- *  Iterate through the unlinked cache and insert anything that
- *  links to the newly inserted item.  This will start a recursive
- *  set of calls performing a depth-first insertion of pending blocks as
- *  _push_next(..) calls _push_block(...) which will in turn call _push_next
- */
-void fork_database::_push_next( const item_ptr& new_item )
+void fork_database::insert( const item_ptr& item )
 {
-    auto& prev_idx = _unlinked_index.get<by_previous>();
+   if( find_item( item->id ) )
+      return;
+   if( _size == 0 )
+      _min_num = _max_num = item->num;
+   else
+   {
+      // the ring spans every number in between, so a stray number (e.g. a block claiming to follow
+      // the null block long after genesis) must not widen it
+      FC_ASSERT( item->num >= _min_num && uint64_t(item->num) <= uint64_t(_min_num) + _max_size + 1,
+                 "block ${n} is outside of the blocks held",
+                 ("n",item->num)("min",_min_num)("max_size",_max_size) );
+      _max_num = std::max( _max_num, item->num );
+   }
+   reserve();
+   slot( item->num ).push_back( item );
+   ++_size;
+}
 
-    auto itr = prev_idx.find( new_item->id );
-    while( itr != prev_idx.end() )
-    {
-       auto tmp = *itr;
-       prev_idx.erase( itr );
-       _push_block( tmp );
+void fork_database::prune( uint32_t min_num )
+{
+   if( _size == 0 || min_num <= _min_num )
+      return;
+   // each number has a slot of its own, so only the slots of the numbers that fall out of the window are touched
+   const uint64_t end = std::min<uint64_t>( min_num, uint64_t(_max_num) + 1 );
+   for( uint64_t n = _min_num; n < end; ++n )
+   {
+      auto& s = slot( uint32_t(n) );
+      _size -= s.size();
+      s.clear();
+   }
+   _min_num = min_num;
+   _max_num = std::max( _max_num, _min_num );
+}
 
-       itr = prev_idx.find( new_item->id );
-    }
+void fork_database::reserve()
+{
+   const uint64_t span = uint64_t(_max_num) - _min_num + 1;
+   if( span <= _ring.size() )
+      return;
+   size_t capacity = _ring.size();
+   while( capacity < span )
+      capacity *= 2;
+   vector< vector<item_ptr> > ring( capacity );
+   for( auto& s : _ring )
+      for( auto& item : s )
+         ring[ item->num & (capacity - 1) ].push_back( std::move(item) );
+   _ring = std::move( ring );
 }
 
 void fork_database::set_max_size( uint32_t s )
 {
    _max_size = s;
    if( !_head ) return;
+   prune( _head->num - std::min( _max_size, _head->num ) );
+}
 
-   { /// index
-      auto& by_num_idx = _index.get<block_num>();
-      auto itr = by_num_idx.begin();
-      while( itr != by_num_idx.end() )
-      {
-         if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
-         else
-            break;
-         itr = by_num_idx.begin();
-      }
-   }
-   { /// unlinked_index
-      auto& by_num_idx = _unlinked_index.get<block_num>();
-      auto itr = by_num_idx.begin();
-      while( itr != by_num_idx.end() )
-      {
-         if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
-         else
-            break;
-         itr = by_num_idx.begin();
-      }
-   }
+item_ptr fork_database::find_item(const block_id_type& id)const
+{
+   const uint32_t num = block_header::num_from_id(id);
+   if( _size == 0 || num < _min_num || num > _max_num )
+      return item_ptr();
+   for( const auto& item : slot(num) )
+      if( item->id == id )
+         return item;
+   return item_ptr();
 }
 
 bool fork_database::is_known_block(const block_id_type& id)const
 {
-   auto& index = _index.get<block_id>();
-   auto itr = index.find(id);
-   if( itr != index.end() )
-      return true;
-   auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   return unlinked_itr != unlinked_index.end();
+   return bool( find_item(id) );
 }
 
 item_ptr fork_database::fetch_block(const block_id_type& id)const
 {
-   auto& index = _index.get<block_id>();
-   auto itr = index.find(id);
-   if( itr != index.end() )
-      return *itr;
-   auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   if( unlinked_itr != unlinked_index.end() )
-      return *unlinked_itr;
-   return item_ptr();
+   return find_item(id);
 }
 
 vector<item_ptr> fork_database::fetch_block_by_number(uint32_t num)const
 {
-   vector<item_ptr> result;
-   auto itr = _index.get<block_num>().find(num);
-   while( itr != _index.get<block_num>().end() )
-   {
-      if( (*itr)->num == num )
-         result.push_back( *itr );
-      else
-         break;
-      ++itr;
-   }
-   return result;
+   if( _size == 0 || num < _min_num || num > _max_num )
+      return vector<item_ptr>();
+   return slot(num);
 }
 
 pair<fork_database::branch_type,fork_database::branch_type>
@@ -202,13 +192,10 @@ pair<fork_database::branch_type,fork_database::branch_type>
    // This function gets a branch (i.e. vector<fork_item>) leading
    // back to the most recent common ancestor.
    pair<branch_type,branch_type> result;
-   auto first_branch_itr = _index.get<block_id>().find(first);
-   FC_ASSERT(first_branch_itr != _index.get<block_id>().end());
-   auto first_branch = *first_branch_itr;
-
-   auto second_branch_itr = _index.get<block_id>().find(second);
-   FC_ASSERT(second_branch_itr != _index.get<block_id>().end());
-   auto second_branch = *second_branch_itr;
+   auto first_branch = find_item(first);
+   FC_ASSERT(first_branch);
+   auto second_branch = find_item(second);
+   FC_ASSERT(second_branch);
 
 
    while( first_branch->data.block_num() > second_branch->data.block_num() )
@@ -247,7 +234,19 @@ void fork_database::set_head(shared_ptr<fork_item> h)
 
 void fork_database::remove(block_id_type id)
 {
-   _index.get<block_id>().erase(id);
+   const uint32_t num = block_header::num_from_id(id);
+   if( _size == 0 || num < _min_num || num > _max_num )
+      return;
+   auto& s = slot(num);
+   for( auto itr = s.begin(); itr != s.end(); ++itr )
+   {
+      if( (*itr)->id == id )
+      {
+         s.erase(itr);
+         --_size;
+         return;
+      }
+   }
 }
 
 } } // graphene::chain
@@ -24,8 +24,15 @@
 #pragma once
 #include <graphene/chain/protocol/operations.hpp>
 #include <graphene/db/generic_index.hpp>
+#include <graphene/db/simple_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 
+#include <array>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace graphene { namespace chain {
    class database;
 
@@ -262,34 +269,81 @@ namespace graphene { namespace chain {
          account_id_type get_id()const { return id; }
    };
 
+   /** hashes the keys of account_member_index */
+   struct account_member_hash
+   {
+      size_t operator()( const account_id_type& a )const { return std::hash<uint64_t>()( a.instance.value ); }
+      size_t operator()( const address& a )const { return std::hash<address>()( a ); }
+      /** the x coordinate of a key is already uniformly distributed */
+      size_t operator()( const public_key_type& k )const
+      {
+         uint64_t h;
+         memcpy( &h, k.key_data.data + 1, sizeof(h) );
+         return size_t(h);
+      }
+   };
+
    /**
     *  @brief This secondary index will allow a reverse lookup of all accounts that a particular key or account
     *  is an potential signing authority.
+    *
+    *  The members of each entry are kept in a flat_set as most keys and accounts are referenced by a single
+    *  account.  about_to_modify collects the members of the account into reused vectors, so a modify does not
+    *  allocate once they have grown to size.  Modifications that leave the members unchanged, which are nearly
+    *  all of them, do not touch the maps.
     */
    class account_member_index : public secondary_index
    {
       public:
+         typedef flat_set<account_id_type> account_set;
+
          virtual void object_inserted( const object& obj ) override;
          virtual void object_removed( const object& obj ) override;
          virtual void about_to_modify( const object& before ) override;
          virtual void object_modified( const object& after  ) override;
 
+         typedef std::array<address,5> legacy_address_array;
+
+         /**
+          *  Appends the accounts referencing key in an owner, active or memo key, or through one of the addresses
+          *  derived from it in an address authority, skipping accounts already in result.
+          */
+         void find_key_references( const public_key_type& key, vector<account_id_type>& result )const;
+         /** as above, with the legacy addresses of key computed by the caller, who needs them as well */
+         void find_key_references( const public_key_type& key, const legacy_address_array& legacy,
+                                   vector<account_id_type>& result )const;
+
+         /** whether any account has an address authority; if not, legacy addresses cannot match anything */
+         bool has_address_members()const { return !account_to_address_memberships.empty(); }
+
+         /** the address forms of a key which may appear in address authorities of genesis accounts */
+         static legacy_address_array legacy_addresses( const public_key_type& key );
 
          /** given an account or key, map it to the set of accounts that reference it in an active or owner authority */
-         map< account_id_type, set<account_id_type> > account_to_account_memberships;
-         map< public_key_type, set<account_id_type> > account_to_key_memberships;
+         std::unordered_map< account_id_type, account_set, account_member_hash > account_to_account_memberships;
+         std::unordered_map< public_key_type, account_set, account_member_hash > account_to_key_memberships;
          /** some accounts use address authorities in the genesis block */
-         map< address, set<account_id_type> >         account_to_address_memberships;
+         std::unordered_map< address, account_set, account_member_hash >         account_to_address_memberships;
 
 
       protected:
-         set<account_id_type>  get_account_members( const account_object& a )const;
-         set<public_key_type>  get_key_members( const account_object& a )const;
-         set<address>          get_address_members( const account_object& a )const;
-
-         set<account_id_type>  before_account_members;
-         set<public_key_type>  before_key_members;
-         set<address>          before_address_members;
+         template<typename Key>
+         static void add_members( const flat_map<Key,weight_type>& auths, vector<Key>& result );
+         template<typename Key>
+         static void update_memberships( std::unordered_map<Key, account_set, account_member_hash>& memberships,
+                                         const vector<Key>& before, const vector<Key>& after, account_id_type account );
+
+         void get_account_members( const account_object& a, vector<account_id_type>& result )const;
+         void get_key_members( const account_object& a, vector<public_key_type>& result )const;
+         void get_address_members( const account_object& a, vector<address>& result )const;
+
+         /** members captured by about_to_modify and compared in object_modified, reused across modifies */
+         vector<account_id_type>   before_account_members;
+         vector<public_key_type>   before_key_members;
+         vector<address>           before_address_members;
+         vector<account_id_type>   after_account_members;
+         vector<public_key_type>   after_key_members;
+         vector<address>           after_address_members;
    };
 
 
@@ -309,42 +363,103 @@ namespace graphene { namespace chain {
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
-   struct by_account_asset;
-   struct by_asset_balance;
    /**
-    * @ingroup object_index
+    *  @brief This secondary index of the account statistics tracks the accounts which have fees waiting to be
+    *  paid out at the next maintenance interval, so that maintenance does not need to look at every account.
     */
-   typedef multi_index_container<
-      account_balance_object,
-      indexed_by<
-         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-         ordered_unique< tag<by_account_asset>,
-            composite_key<
-               account_balance_object,
-               member<account_balance_object, account_id_type, &account_balance_object::owner>,
-               member<account_balance_object, asset_id_type, &account_balance_object::asset_type>
-            >
-         >,
-         ordered_unique< tag<by_asset_balance>,
-            composite_key<
-               account_balance_object,
-               member<account_balance_object, asset_id_type, &account_balance_object::asset_type>,
-               member<account_balance_object, share_type, &account_balance_object::balance>,
-               member<account_balance_object, account_id_type, &account_balance_object::owner>
-            >,
-            composite_key_compare<
-               std::less< asset_id_type >,
-               std::greater< share_type >,
-               std::less< account_id_type >
-            >
-         >
-      >
-   > account_balance_object_multi_index_type;
+   class account_pending_fee_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** owners of the statistics objects with non-zero pending_fees or pending_vested_fees */
+         std::unordered_set< account_id_type, account_member_hash > accounts_with_pending_fees;
+   };
 
    /**
-    * @ingroup object_index
+    *  @brief Balances are the most frequently changed objects, so rather than a multi_index with two ordered
+    *  keys they are kept by id in a vector, plus a small sorted array of the balances of each account.
+    *
+    *  The balances of an asset ranked by amount are only needed for a few assets (top holders special
+    *  authorities), so such a ranking is built the first time it is asked for and maintained from then on.
+    *
+    *  @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   class account_balance_index : public simple_index<account_balance_object>
+   {
+      public:
+         /** largest balance first, ties broken by the lower account id */
+         struct by_rank
+         {
+            bool operator()( const account_balance_object* a, const account_balance_object* b )const
+            {
+               if( a->balance != b->balance ) return a->balance > b->balance;
+               return a->owner < b->owner;
+            }
+         };
+         typedef flat_map< asset_id_type, const account_balance_object* >    account_balances;
+         typedef std::set< const account_balance_object*, by_rank >          ranked_balances;
+
+         virtual const object& create( const std::function<void(object&)>& constructor )override;
+         virtual const object& insert( object&& obj )override;
+         virtual void          modify( const object& obj, const std::function<void(object&)>& m )override;
+         virtual void          remove( const object& obj )override;
+
+         /** @return the balance object of owner in asset or nullptr if the account never held it */
+         const account_balance_object* find( account_id_type owner, asset_id_type asset )const;
+         /** @return the balances held by owner, sorted by asset */
+         const account_balances& get_account_balances( account_id_type owner )const;
+         /** @return the balances of asset, largest first */
+         const ranked_balances& get_ranked_balances( asset_id_type asset )const;
+
+         using simple_index<account_balance_object>::find;
+
+      private:
+         void add_to_lookups( const account_balance_object& b );
+         void remove_from_lookups( const account_balance_object& b );
+
+         /** indexed by account instance */
+         vector< account_balances >                          _by_account;
+         /** only for the assets somebody asked get_ranked_balances about */
+         mutable map< asset_id_type, ranked_balances >       _rankings;
+   };
+
+   /**
+    *  @brief This secondary index of the account balances counts the balance changes of the assets used by
+    *  top holders special authorities, so maintenance can tell when the holders of an asset have not changed
+    *  and skip recomputing the authorities that depend on it.  Nothing in here is part of the chain state.
+    */
+   class top_holders_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** starts counting the balance changes of asset, no-op if it is already watched */
+         void watch( asset_id_type asset )const;
+         /** @return the number of balance changes of a watched asset since it was first watched, undo included */
+         uint64_t get_change_count( asset_id_type asset )const;
+
+         /** the outcome of the last maintenance computation of one top holders authority */
+         struct computed_authority
+         {
+            asset_id_type asset;
+            uint8_t       num_top_holders = 0;
+            uint64_t      change_count = 0;
+            bool          is_empty = true;
+            authority     auth;
+         };
+         /** keyed by account and whether it is the owner (true) or active (false) authority */
+         mutable map< std::pair< account_id_type, bool >, computed_authority > computed;
+
+      private:
+         void on_change( const object& obj );
+
+         mutable flat_map< asset_id_type, uint64_t > _change_counts;
+   };
 
    struct by_name{};
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/undo_database.hpp>
+
+#include <fc/time.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  Latency distribution with power of two buckets: bucket 0 counts samples under 1us and
+    *  bucket i counts samples in [2^(i-1), 2^i) us.
+    */
+   struct latency_histogram
+   {
+      uint64_t          count    = 0;
+      uint64_t          total_us = 0;
+      uint64_t          max_us   = 0;
+      vector<uint64_t>  buckets;
+
+      void record( const fc::microseconds& elapsed );
+      uint64_t mean_us()const { return count ? total_us / count : 0; }
+   };
+
+   struct operation_profile
+   {
+      int               which = 0;
+      string            name;
+      latency_histogram evaluate;
+      latency_histogram apply;
+   };
+
+   /**
+    *  Timings collected by the apply_profiler since it was last reset
+    */
+   struct apply_profile
+   {
+      uint32_t                          first_block = 0;
+      uint32_t                          last_block  = 0;
+      latency_histogram                 block;
+      map<string, latency_histogram>    steps;
+      /** only operation types that were applied at least once */
+      vector<operation_profile>         operations;
+
+      uint64_t                          undo_sessions_started = 0;
+      uint64_t                          undo_sessions_undone  = 0;
+      uint64_t                          undo_sessions_merged  = 0;
+      uint64_t                          objects_created  = 0;
+      uint64_t                          objects_modified = 0;
+      uint64_t                          objects_removed  = 0;
+   };
+
+   /**
+    *  @class apply_profiler
+    *  @brief collects per operation evaluator and per step block apply timings
+    *
+    *  Profiling is disabled by default, in which case the only cost is a branch per
+    *  operation and per block step.  Operations are only timed while a block is applied,
+    *  so a transaction that was pushed as pending and later included in a block is counted once.
+    */
+   class apply_profiler
+   {
+      public:
+         /**
+          *  Times consecutive steps of block application, each call to step() records the
+          *  time elapsed since the previous one.  Operations are timed for the lifetime of
+          *  the step_timer.
+          */
+         class step_timer
+         {
+            public:
+               step_timer( apply_profiler& p );
+               ~step_timer();
+               void step( const char* name );
+               void finish( uint32_t block_num );
+            private:
+               apply_profiler& _profiler;
+               bool            _enabled;
+               fc::time_point  _start;
+               fc::time_point  _last;
+         };
+
+         apply_profiler( const graphene::db::undo_database& undo ):_undo(undo){}
+
+         bool enabled()const { return _enabled; }
+         /** true while a block is being applied with profiling enabled */
+         bool timing_operations()const { return _enabled && _in_block; }
+         void enable( bool e );
+         /** if non-zero, log a summary and reset after every dump_interval blocks */
+         void set_dump_interval( uint32_t dump_interval ) { _dump_interval = dump_interval; }
+         void reset();
+
+         void record_operation( int which, const fc::microseconds& evaluate, const fc::microseconds& apply );
+         void record_step( const char* step, const fc::microseconds& elapsed );
+         void record_block( uint32_t block_num, const fc::microseconds& elapsed );
+
+         apply_profile get_profile()const;
+         void          dump()const;
+
+      private:
+         const graphene::db::undo_database&    _undo;
+         bool                                  _enabled = false;
+         bool                                  _in_block = false;
+         uint32_t                              _dump_interval = 0;
+         apply_profile                         _profile;
+         vector<operation_profile>             _operations;
+         uint64_t                              _sessions_started = 0;
+         uint64_t                              _sessions_undone  = 0;
+         uint64_t                              _sessions_merged  = 0;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::latency_histogram, (count)(total_us)(max_us)(buckets) )
+FC_REFLECT( graphene::chain::operation_profile, (which)(name)(evaluate)(apply) )
+FC_REFLECT( graphene::chain::apply_profile,
+            (first_block)(last_block)(block)(steps)(operations)
+            (undo_sessions_started)(undo_sessions_undone)(undo_sessions_merged)
+            (objects_created)(objects_modified)(objects_removed) )
@@ -23,9 +23,20 @@
  */
 #pragma once
 #include <fstream>
+#include <limits>
 #include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace chain {
+   /**
+    * A block exactly as it is packed in the block log, for consumers which want to do their own deserialization.
+    */
+   struct raw_block
+   {
+      uint32_t                block_num = 0;
+      optional<block_id_type> block_id;
+      vector<char>            data;
+   };
+
    class block_database 
    {
       public:
@@ -41,6 +52,13 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /**
+          *  Reads up to count consecutive blocks starting at block_num_from with as few seeks as possible, stopping
+          *  at the first block which is not in the database or which would take the packed size of the result past
+          *  max_bytes.  The first block is always returned.  The blocks are not unpacked or verified.
+          */
+         vector<raw_block>      fetch_range_raw( uint32_t block_num_from, uint32_t count,
+                                                 uint64_t max_bytes = std::numeric_limits<uint64_t>::max() )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
       private:
@@ -48,3 +66,5 @@ namespace graphene { namespace chain {
          mutable std::fstream _block_num_to_pos;
    };
 } }
+
+FC_REFLECT( graphene::chain::raw_block, (block_num)(block_id)(data) )
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/chain/apply_profiler.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/node_property_object.hpp>
 #include <graphene/chain/account_object.hpp>
@@ -40,6 +41,11 @@
 
 #include <fc/log/logger.hpp>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <atomic>
+#include <deque>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -122,7 +128,10 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
-         const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
+         /// Blocks of the applied chain as stored in the block log, see block_database::fetch_range_raw()
+         vector<raw_block>          fetch_raw_blocks_by_number( uint32_t first, uint32_t count,
+                                                                uint64_t max_bytes = std::numeric_limits<uint64_t>::max() )const;
+         signed_transaction         get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
          /**
@@ -155,9 +164,35 @@ namespace graphene { namespace chain {
             const fc::ecc::private_key& block_signing_private_key
             );
 
+         /**
+          *  Assembles the unsigned block for the slot at @p when from the pending transactions and
+          *  rewinds the pending state, the caller signs the block and pushes it.  As long as every
+          *  pending transaction fits into the block, they are taken as they were applied when they
+          *  arrived rather than being applied again.
+          */
+         signed_block build_block(
+            const fc::time_point_sec when,
+            witness_id_type witness_id,
+            uint32_t skip
+            );
+         signed_block _build_block(
+            const fc::time_point_sec when,
+            witness_id_type witness_id
+            );
+
          void pop_block();
          void clear_pending();
 
+         /**
+          *  Lets a thread other than the one applying blocks read the object graph.  While the
+          *  returned lock is held, pushing, generating and popping blocks and transactions waits
+          *  for it to be released, so keep it no longer than a single read.
+          */
+         boost::shared_lock<boost::shared_mutex> read_lock()const
+         {
+            return boost::shared_lock<boost::shared_mutex>( _read_write_mutex );
+         }
+
          /**
           *  This method is used to track appied operations during the evaluation of a block, these
           *  operations should include any operation actually included in a transaction as well
@@ -259,6 +294,10 @@ namespace graphene { namespace chain {
 
          node_property_object& node_properties();
 
+         /** evaluator and block apply timings, see apply_profiler */
+         apply_profiler&       get_apply_profiler()      { return _apply_profiler; }
+         const apply_profiler& get_apply_profiler()const { return _apply_profiler; }
+
 
          uint32_t last_non_undoable_block_num() const;
          //////////////////// db_init.cpp ////////////////////
@@ -267,6 +306,8 @@ namespace graphene { namespace chain {
          /// Reset the object graph in-memory
          void initialize_indexes();
          void init_genesis(const genesis_state_type& genesis_state = genesis_state_type());
+         /// create the genesis accounts by applying operations rather than in bulk, for testing the bulk path only
+         bool _genesis_accounts_through_evaluators = false;
 
          template<typename EvaluatorType>
          void register_evaluator()
@@ -428,6 +469,7 @@ namespace graphene { namespace chain {
          void update_global_dynamic_data( const signed_block& b );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
+         void forget_irreversible_revisions( uint32_t block_num );
          void clear_expired_transactions();
          void clear_expired_proposals();
          void clear_expired_orders();
@@ -455,6 +497,9 @@ namespace graphene { namespace chain {
          ///@}
 
          vector< processed_transaction >        _pending_tx;
+         /** merkle digests and total packed size of _pending_tx, kept up to date as transactions arrive */
+         vector< digest_type >                  _pending_tx_digests;
+         size_t                                 _pending_tx_size = 0;
          fork_database                          _fork_db;
 
          /**
@@ -489,6 +534,27 @@ namespace graphene { namespace chain {
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
          node_property_object              _node_property_object;
+         apply_profiler                    _apply_profiler;
+
+         /** object revision reached at the end of each applied block that is not yet irreversible */
+         std::deque< std::pair<uint32_t,uint64_t> > _block_revisions;
+
+         /**
+          *  Excludes read_lock() holders while the object graph changes.  Only the outermost guard of
+          *  a task locks, which lets push_block() pop and apply blocks through the other guarded
+          *  methods.  A writer may yield while it holds the lock (e.g. in an applied_block handler),
+          *  so a guard of any other task waits for it to finish instead of re-entering.
+          */
+         struct write_guard
+         {
+            write_guard( database& db );
+            ~write_guard();
+            database& _db;
+         };
+
+         mutable boost::shared_mutex       _read_write_mutex;
+         std::atomic<uint64_t>             _write_owner{0};
+         uint32_t                          _write_depth = 0;
    };
 
    namespace detail
@@ -64,6 +64,11 @@ namespace graphene { namespace chain {
     *
     *  Every time a block is pushed into the fork DB the
     *  block with the highest block_num will be returned.
+    *
+    *  Blocks are kept in a ring of slots indexed by block number, each holding the
+    *  (usually single) block of every fork at that height.  A block id encodes its
+    *  number, so lookups by id only compare the ids within one slot, and pruning
+    *  old blocks clears the slots that fell out of the window.
     */
    class fork_database
    {
@@ -96,29 +101,31 @@ namespace graphene { namespace chain {
          pair< branch_type, branch_type >  fetch_branch_from(block_id_type first,
                                                              block_id_type second)const;
 
-         struct block_id;
-         struct block_num;
-         struct by_previous;
-         typedef multi_index_container<
-            item_ptr,
-            indexed_by<
-               hashed_unique<tag<block_id>, member<fork_item, block_id_type, &fork_item::id>, std::hash<fc::ripemd160>>,
-               hashed_non_unique<tag<by_previous>, const_mem_fun<fork_item, block_id_type, &fork_item::previous_id>, std::hash<fc::ripemd160>>,
-               ordered_non_unique<tag<block_num>, member<fork_item,uint32_t,&fork_item::num>>
-            >
-         > fork_multi_index_type;
-
          void set_max_size( uint32_t s );
 
+         /** @return the number of blocks held, including those on forks */
+         size_t size()const { return _size; }
+
       private:
-         /** @return a pointer to the newly pushed item */
          void _push_block(const item_ptr& b );
-         void _push_next(const item_ptr& newly_inserted);
+
+         const vector<item_ptr>&  slot( uint32_t num )const { return _ring[ num & (_ring.size() - 1) ]; }
+         vector<item_ptr>&        slot( uint32_t num )      { return _ring[ num & (_ring.size() - 1) ]; }
+         item_ptr                 find_item( const block_id_type& id )const;
+         void                     insert( const item_ptr& item );
+         /** drops every block below min_num */
+         void                     prune( uint32_t min_num );
+         /** grows the ring until every number in [_min_num, _max_num] has a slot of its own */
+         void                     reserve();
 
          uint32_t                 _max_size = 1024;
 
-         fork_multi_index_type    _unlinked_index;
-         fork_multi_index_type    _index;
+         /** slots by block number modulo the ring size, which is a power of two */
+         vector< vector<item_ptr> > _ring;
+         /** every block held has a number in [_min_num, _max_num] */
+         uint32_t                 _min_num = 0;
+         uint32_t                 _max_num = 0;
+         size_t                   _size = 0;
          shared_ptr<fork_item>    _head;
    };
 } } // graphene::chain
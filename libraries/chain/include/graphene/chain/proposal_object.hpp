@@ -28,6 +28,8 @@
 
 #include <graphene/db/generic_index.hpp>
 
+#include <deque>
+
 namespace graphene { namespace chain {
 
 
@@ -78,6 +80,61 @@ class required_approval_index : public secondary_index
       map<account_id_type, set<proposal_id_type> > _account_to_proposals;
 };
 
+/**
+ *  @brief tracks which of the authorities required by each proposal its approvals can satisfy
+ *
+ *  This is a secondary index on the proposal_index.  For every proposal it keeps the accounts
+ *  reachable from the required authorities through account authorities, and which of them are
+ *  satisfied by the approvals, ignoring the recursion depth limit and the requirement that every
+ *  approving key is used.  That makes it an upper bound of the full check: when the bound already
+ *  fails, is_authorized_to_execute can return false without running verify_authority.
+ *
+ *  Approvals which were only added are propagated from the accounts they affect.  The tracking is
+ *  built again from scratch only when an approval was removed or one of the accounts it looked at
+ *  was modified since.
+ */
+class proposal_authority_index : public secondary_index
+{
+   public:
+      virtual void object_removed( const object& obj ) override;
+
+      /**
+       *  @return false if the approvals of p cannot satisfy the authorities it requires, true if they
+       *  may, in which case the full check has to decide
+       */
+      bool may_be_authorized( const database& db, const proposal_object& p )const;
+
+      /** number of times the tracking of a proposal was built from scratch */
+      uint64_t rebuilds()const { return _rebuilds; }
+
+      struct tracked_proposal
+      {
+         flat_set<account_id_type>                              required_active;
+         flat_set<account_id_type>                              required_owner;
+         vector<authority>                                      required_other;
+
+         flat_set<account_id_type>                              active_approvals;
+         flat_set<account_id_type>                              owner_approvals;
+         flat_set<public_key_type>                              key_approvals;
+
+         /** accounts whose active authority takes part in the check */
+         flat_set<account_id_type>                              nodes;
+         /** for each node, the nodes whose active authority lists it */
+         flat_map<account_id_type, flat_set<account_id_type> > dependents;
+         /** approving accounts and nodes whose active authority the approvals satisfy */
+         flat_set<account_id_type>                              satisfied;
+         /** accounts whose authorities were looked at, with their revision at the time */
+         flat_map<account_id_type, uint64_t>                    consulted;
+      };
+
+   private:
+      void rebuild( const database& db, const proposal_object& p, tracked_proposal& t )const;
+      void propagate( const database& db, tracked_proposal& t, std::deque<account_id_type>& work )const;
+
+      mutable map<proposal_id_type, tracked_proposal> _tracked;
+      mutable uint64_t                                 _rebuilds = 0;
+};
+
 struct by_expiration{};
 typedef boost::multi_index_container<
    proposal_object,
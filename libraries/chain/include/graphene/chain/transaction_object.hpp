@@ -26,23 +26,19 @@
 
 #include <graphene/chain/protocol/transaction.hpp>
 #include <graphene/db/index.hpp>
-#include <graphene/db/generic_index.hpp>
 #include <fc/uint128.hpp>
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
+#include <deque>
 
 namespace graphene { namespace chain {
    using namespace graphene::db;
-   using boost::multi_index_container;
-   using namespace boost::multi_index;
    /**
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
     * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
     * expired can be removed from the index.
+    *
+    * Only the id and expiration are needed for that, the transaction itself is served from the block it was
+    * included in (see database::get_recent_transaction).
     */
    class transaction_object : public abstract_object<transaction_object>
    {
@@ -50,25 +46,79 @@ namespace graphene { namespace chain {
          static const uint8_t space_id = implementation_ids;
          static const uint8_t type_id  = impl_transaction_object_type;
 
-         signed_transaction  trx;
          transaction_id_type trx_id;
+         time_point_sec      expiration;
+         /** the block that included the transaction, 0 while the transaction is pending */
+         uint32_t            block_num = 0;
 
-         time_point_sec get_expiration()const { return trx.expiration; }
+         time_point_sec get_expiration()const { return expiration; }
    };
 
-   struct by_expiration;
-   struct by_id;
-   struct by_trx_id;
-   typedef multi_index_container<
-      transaction_object,
-      indexed_by<
-         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-         hashed_unique< tag<by_trx_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_id_type, trx_id), std::hash<transaction_id_type> >,
-         ordered_non_unique< tag<by_expiration>, const_mem_fun<transaction_object, time_point_sec, &transaction_object::get_expiration > >
-      >
-   > transaction_multi_index_type;
-
-   typedef generic_index<transaction_object, transaction_multi_index_type> transaction_index;
+   /**
+    *  @class transaction_index
+    *  @brief a compact index of transaction_objects for duplicate detection
+    *
+    *  Transaction objects are created with ascending instances and all expire within
+    *  maximum_time_until_expiration, so they are kept in a window of instances rather
+    *  than in node based containers.  Ids are found through an open addressing hash table
+    *  of instances and expired objects through a wheel of expiration time buckets.  The
+    *  index takes part in undo like any other through primary_index.
+    *
+    *  References returned by find() and create() stay valid until the object is removed.
+    */
+   class transaction_index : public index
+   {
+      public:
+         typedef transaction_object object_type;
+
+         /** seconds of expiration time covered by each bucket of the wheel */
+         static const uint32_t wheel_granularity = 32;
+         /** buckets in the wheel, together covering more than the default maximum expiration */
+         static const uint32_t wheel_buckets = 4096;
+
+         virtual const object&  create( const std::function<void(object&)>& constructor ) override;
+         virtual const object&  insert( object&& obj ) override;
+         virtual void           modify( const object& obj, const std::function<void(object&)>& m ) override;
+         virtual void           remove( const object& obj ) override;
+         virtual const object*  find( object_id_type id )const override;
+         virtual void           inspect_all_objects( std::function<void(const object&)> inspector )const override;
+         virtual fc::uint128    hash()const override;
+
+         /** @return the object for trx_id or nullptr if the transaction is not known */
+         const transaction_object* find_trx( const transaction_id_type& trx_id )const;
+
+         /**
+          *  Collects every object that expired before now.  The caller is expected to remove
+          *  them from the database, removals that are later undone put them back in the wheel.
+          */
+         void get_expired( time_point_sec now, vector<const transaction_object*>& result );
+
+         size_t size()const { return _count; }
+
+      private:
+         static const uint64_t empty_slot = 0;
+
+         transaction_object*  entry( uint64_t instance );
+         const transaction_object* entry( uint64_t instance )const;
+         transaction_object&  emplace( transaction_object&& obj );
+         void                 add_to_wheel( const transaction_object& obj );
+
+         size_t               home_slot( const transaction_id_type& trx_id )const;
+         void                 hash_insert( const transaction_object& obj );
+         void                 hash_erase( const transaction_object& obj );
+         void                 rehash( size_t capacity );
+
+         /** objects by instance starting at _first_instance, removed objects have a null id */
+         std::deque<transaction_object>  _window;
+         uint64_t                        _first_instance = 0;
+         size_t                          _count = 0;
+
+         /** open addressing with linear probing, slots hold instance + 1 */
+         vector<uint64_t>                _slots;
+
+         vector< vector<uint64_t> >      _wheel;
+         uint64_t                        _sweep_from = 0;
+   };
 } }
 
-FC_REFLECT_DERIVED( graphene::chain::transaction_object, (graphene::db::object), (trx)(trx_id) )
+FC_REFLECT_DERIVED( graphene::chain::transaction_object, (graphene::db::object), (trx_id)(expiration)(block_num) )
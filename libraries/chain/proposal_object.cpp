@@ -25,10 +25,16 @@
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace chain {
 
 bool proposal_object::is_authorized_to_execute(database& db) const
 {
+   const auto& proposals = dynamic_cast<const primary_index<proposal_index>&>( db.get_index_type<proposal_index>() );
+   if( !proposals.get_secondary_index<proposal_authority_index>().may_be_authorized( db, *this ) )
+      return false;
+
    transaction_evaluation_state dry_run_eval(&db);
 
    try {
@@ -92,4 +98,157 @@ void required_approval_index::object_removed( const object& obj )
        remove( a, p.id );
 }
 
+namespace {
+   /**
+    *  Whether auth could be satisfied by the tracked approvals.  Address authorities are counted as
+    *  given since the approvals are keys, which keeps this an upper bound of sign_state::check_authority.
+    */
+   bool could_satisfy( const authority& auth, const proposal_authority_index::tracked_proposal& t )
+   {
+      uint64_t total_weight = 0;
+      for( const auto& k : auth.key_auths )
+         if( t.key_approvals.find( k.first ) != t.key_approvals.end() )
+            total_weight += k.second;
+      for( const auto& a : auth.address_auths )
+         total_weight += a.second;
+      for( const auto& a : auth.account_auths )
+         if( t.satisfied.find( a.first ) != t.satisfied.end() )
+            total_weight += a.second;
+      return total_weight >= auth.weight_threshold;
+   }
+}
+
+void proposal_authority_index::object_removed( const object& obj )
+{
+   _tracked.erase( obj.id );
+}
+
+bool proposal_authority_index::may_be_authorized( const database& db, const proposal_object& p )const
+{
+   try {
+      auto tracked = _tracked.find( p.id );
+      bool valid = tracked != _tracked.end();
+      tracked_proposal& t = valid ? tracked->second : _tracked[p.id];
+      for( auto itr = t.consulted.begin(); valid && itr != t.consulted.end(); ++itr )
+         valid = db.get_object_revision( itr->first ) == itr->second;
+      // approvals can only be added incrementally, a removal may unsatisfy any account
+      valid = valid && std::includes( p.available_active_approvals.begin(), p.available_active_approvals.end(),
+                                      t.active_approvals.begin(), t.active_approvals.end() )
+                    && std::includes( p.available_owner_approvals.begin(), p.available_owner_approvals.end(),
+                                      t.owner_approvals.begin(), t.owner_approvals.end() )
+                    && std::includes( p.available_key_approvals.begin(), p.available_key_approvals.end(),
+                                      t.key_approvals.begin(), t.key_approvals.end() );
+
+      if( !valid )
+         rebuild( db, p, t );
+      else
+      {
+         std::deque<account_id_type> work;
+         auto add_approvals = [&]( const flat_set<account_id_type>& approvals ) {
+            for( const auto& a : approvals )
+               if( t.satisfied.insert( a ).second )
+               {
+                  auto itr = t.dependents.find( a );
+                  if( itr != t.dependents.end() )
+                     work.insert( work.end(), itr->second.begin(), itr->second.end() );
+               }
+         };
+         add_approvals( p.available_active_approvals );
+         add_approvals( p.available_owner_approvals );
+         if( p.available_key_approvals.size() != t.key_approvals.size() )
+            work.insert( work.end(), t.nodes.begin(), t.nodes.end() );
+
+         t.active_approvals = p.available_active_approvals;
+         t.owner_approvals = p.available_owner_approvals;
+         t.key_approvals = p.available_key_approvals;
+         propagate( db, t, work );
+      }
+
+      for( const auto& id : t.required_active )
+         if( t.satisfied.find( id ) == t.satisfied.end() && !could_satisfy( id(db).owner, t ) )
+            return false;
+      for( const auto& id : t.required_owner )
+         if( t.owner_approvals.find( id ) == t.owner_approvals.end() && !could_satisfy( id(db).owner, t ) )
+            return false;
+      for( const auto& auth : t.required_other )
+         if( !could_satisfy( auth, t ) )
+            return false;
+      return true;
+   }
+   catch( const fc::exception& )
+   {
+      // e.g. an account the proposal refers to does not exist, leave it to the full check
+      _tracked.erase( p.id );
+      return true;
+   }
+}
+
+void proposal_authority_index::rebuild( const database& db, const proposal_object& p, tracked_proposal& t )const
+{
+   ++_rebuilds;
+   t = tracked_proposal();
+   for( const auto& op : p.proposed_transaction.operations )
+      operation_get_required_authorities( op, t.required_active, t.required_owner, t.required_other );
+   t.active_approvals = p.available_active_approvals;
+   t.owner_approvals = p.available_owner_approvals;
+   t.key_approvals = p.available_key_approvals;
+
+   std::deque<account_id_type> work;
+   auto consult = [&]( account_id_type id ) -> const account_object& {
+      const account_object& account = id(db);
+      t.consulted[id] = db.get_object_revision( id );
+      return account;
+   };
+   auto add_node = [&]( account_id_type id ) {
+      if( t.nodes.insert( id ).second )
+         work.push_back( id );
+   };
+   auto add_nodes = [&]( const authority& auth ) {
+      for( const auto& a : auth.account_auths )
+         add_node( a.first );
+   };
+
+   for( const auto& id : t.required_active )
+   {
+      add_node( id );
+      add_nodes( consult( id ).owner );
+   }
+   for( const auto& id : t.required_owner )
+      add_nodes( consult( id ).owner );
+   for( const auto& auth : t.required_other )
+      add_nodes( auth );
+   while( !work.empty() )
+   {
+      account_id_type id = work.front();
+      work.pop_front();
+      for( const auto& a : consult( id ).active.account_auths )
+      {
+         t.dependents[a.first].insert( id );
+         add_node( a.first );
+      }
+   }
+
+   // mirrors the accounts sign_state considers approved before looking at any authority
+   t.satisfied.insert( GRAPHENE_TEMP_ACCOUNT );
+   t.satisfied.insert( t.active_approvals.begin(), t.active_approvals.end() );
+   t.satisfied.insert( t.owner_approvals.begin(), t.owner_approvals.end() );
+   work.assign( t.nodes.begin(), t.nodes.end() );
+   propagate( db, t, work );
+}
+
+void proposal_authority_index::propagate( const database& db, tracked_proposal& t, std::deque<account_id_type>& work )const
+{
+   while( !work.empty() )
+   {
+      account_id_type id = work.front();
+      work.pop_front();
+      if( t.satisfied.find( id ) != t.satisfied.end() || !could_satisfy( id(db).active, t ) )
+         continue;
+      t.satisfied.insert( id );
+      auto itr = t.dependents.find( id );
+      if( itr != t.dependents.end() )
+         work.insert( work.end(), itr->second.begin(), itr->second.end() );
+   }
+}
+
 } } // graphene::chain
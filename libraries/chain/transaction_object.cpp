@@ -23,73 +23,240 @@
  */
 #include <graphene/chain/transaction_object.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace graphene { namespace chain {
 
-const object* transaction_index::create(const std::function<void (object*)>& constructor, object_id_type)
+const uint32_t transaction_index::wheel_granularity;
+const uint32_t transaction_index::wheel_buckets;
+const uint64_t transaction_index::empty_slot;
+
+const object& transaction_index::create( const std::function<void(object&)>& constructor )
 {
    transaction_object obj;
+   obj.id = get_next_id();
+   constructor( obj );
+   obj.id = get_next_id();
+   const object& result = emplace( std::move(obj) );
+   use_next_id();
+   return result;
+}
 
-   obj.id = get_next_available_id();
-   constructor(&obj);
+const object& transaction_index::insert( object&& obj )
+{
+   FC_ASSERT( nullptr != dynamic_cast<transaction_object*>(&obj) );
+   return emplace( std::move( static_cast<transaction_object&>(obj) ) );
+}
 
-   auto result = _index.insert(std::move(obj));
-   FC_ASSERT(result.second, "Could not create transaction_object! Most likely a uniqueness constraint is violated.");
-   return &*result.first;
+void transaction_index::modify( const object& obj, const std::function<void(object&)>& m )
+{
+   transaction_object* e = entry( obj.id.instance() );
+   assert( e == &obj );
+   const time_point_sec old_expiration = e->expiration;
+   hash_erase( *e );
+   try {
+      m( *e );
+   } catch( ... ) {
+      hash_insert( *e );
+      throw;
+   }
+   hash_insert( *e );
+   if( e->expiration != old_expiration )
+      add_to_wheel( *e );
 }
 
-void transaction_index::modify(const object* obj,
-                               const std::function<void (object*)>& m)
+void transaction_index::remove( const object& obj )
 {
-   assert(obj != nullptr);
-   FC_ASSERT(obj->id < _index.size());
+   transaction_object* e = entry( obj.id.instance() );
+   if( e == nullptr )
+      return;
+   hash_erase( *e );
+   *e = transaction_object();
+   --_count;
 
-   const transaction_object* t = dynamic_cast<const transaction_object*>(obj);
-   assert(t != nullptr);
+   while( !_window.empty() && _window.front().id.space() != transaction_object::space_id )
+   {
+      _window.pop_front();
+      ++_first_instance;
+   }
+   while( !_window.empty() && _window.back().id.space() != transaction_object::space_id )
+      _window.pop_back();
 
-   auto itr = _index.find(obj->id.instance());
-   assert(itr != _index.end());
-   _index.modify(itr, [&m](transaction_object& o) { m(&o); });
+   if( _slots.size() > 1024 && _count * 8 < _slots.size() )
+      rehash( _slots.size() / 2 );
 }
 
-void transaction_index::add(unique_ptr<object> o)
+const object* transaction_index::find( object_id_type id )const
 {
-   assert(o);
-   object_id_type id = o->id;
-   assert(id.space() == transaction_object::space_id);
-   assert(id.type() == transaction_object::type_id);
-   assert(id.instance() == size());
+   if( id.space() != transaction_object::space_id || id.type() != transaction_object::type_id )
+      return nullptr;
+   return entry( id.instance() );
+}
+
+void transaction_index::inspect_all_objects( std::function<void(const object&)> inspector )const
+{ try {
+   for( const transaction_object& e : _window )
+      if( e.id.space() == transaction_object::space_id )
+         inspector( e );
+} FC_CAPTURE_AND_RETHROW() }
 
-   auto trx = dynamic_cast<transaction_object*>(o.get());
-   assert(trx != nullptr);
-   o.release();
+fc::uint128 transaction_index::hash()const
+{
+   fc::uint128 result;
+   inspect_all_objects( [&]( const object& o ) {
+      result += o.hash();
+   });
+   return result;
+}
 
-   auto result = _index.insert(std::move(*trx));
-   FC_ASSERT(result.second, "Could not insert transaction_object! Most likely a uniqueness constraint is violated.");
+const transaction_object* transaction_index::find_trx( const transaction_id_type& trx_id )const
+{
+   if( _slots.empty() )
+      return nullptr;
+   const size_t mask = _slots.size() - 1;
+   for( size_t i = home_slot( trx_id ); _slots[i] != empty_slot; i = (i + 1) & mask )
+   {
+      const transaction_object* e = entry( _slots[i] - 1 );
+      if( e->trx_id == trx_id )
+         return e;
+   }
+   return nullptr;
 }
 
-void transaction_index::remove(object_id_type id)
+void transaction_index::get_expired( time_point_sec now, vector<const transaction_object*>& result )
 {
-   auto& index = _index.get<instance>();
-   auto itr = index.find(id.instance());
-   if( itr == index.end() )
+   if( _wheel.empty() )
       return;
+   const uint64_t now_bucket = now.sec_since_epoch() / wheel_granularity;
+   uint64_t b = std::min( _sweep_from, now_bucket );
+   if( b + wheel_buckets <= now_bucket )
+      b = now_bucket - wheel_buckets + 1;
 
-   assert(id.space() == transaction_object::space_id);
-   assert(id.type() == transaction_object::type_id);
+   const size_t first_result = result.size();
+   for( ; b <= now_bucket; ++b )
+   {
+      auto& bucket = _wheel[ b % wheel_buckets ];
+      size_t kept = 0;
+      for( uint64_t instance : bucket )
+      {
+         const transaction_object* e = entry( instance );
+         // skip what was left behind by removed objects and by objects that moved to another bucket
+         if( e == nullptr || (e->expiration.sec_since_epoch() / wheel_granularity) % wheel_buckets != b % wheel_buckets )
+            continue;
+         if( e->expiration < now )
+            result.push_back( e );
+         else
+            bucket[kept++] = instance;
+      }
+      bucket.resize( kept );
+   }
+   // the current bucket may still hold objects that expire later
+   _sweep_from = now_bucket;
 
-   index.erase(itr);
+   // undo may have put an object into its bucket more than once
+   std::sort( result.begin() + first_result, result.end() );
+   result.erase( std::unique( result.begin() + first_result, result.end() ), result.end() );
 }
 
-const object*transaction_index::get(object_id_type id) const
+transaction_object* transaction_index::entry( uint64_t instance )
 {
-   if( id.type() != transaction_object::type_id ||
-       id.space() != transaction_object::space_id )
+   if( instance < _first_instance || instance - _first_instance >= _window.size() )
       return nullptr;
+   transaction_object& e = _window[ instance - _first_instance ];
+   return e.id.space() == transaction_object::space_id ? &e : nullptr;
+}
 
-   auto itr = _index.find(id.instance());
-   if( itr == _index.end() )
-      return nullptr;
-   return &*itr;
+const transaction_object* transaction_index::entry( uint64_t instance )const
+{
+   return const_cast<transaction_index*>(this)->entry( instance );
+}
+
+transaction_object& transaction_index::emplace( transaction_object&& obj )
+{
+   const uint64_t instance = obj.id.instance();
+   FC_ASSERT( entry( instance ) == nullptr, "transaction object ${id} already exists", ("id",obj.id) );
+   FC_ASSERT( find_trx( obj.trx_id ) == nullptr, "duplicate transaction ${id}", ("id",obj.trx_id) );
+
+   if( _window.empty() )
+      _first_instance = instance;
+   while( instance < _first_instance )
+   {
+      _window.emplace_front();
+      --_first_instance;
+   }
+   while( instance - _first_instance >= _window.size() )
+      _window.emplace_back();
+
+   if( (_count + 1) * 4 > _slots.size() * 3 )
+      rehash( std::max<size_t>( 1024, _slots.size() * 2 ) );
+
+   transaction_object& e = _window[ instance - _first_instance ];
+   e = std::move( obj );
+   ++_count;
+   hash_insert( e );
+   add_to_wheel( e );
+   return e;
+}
+
+void transaction_index::add_to_wheel( const transaction_object& obj )
+{
+   if( _wheel.empty() )
+      _wheel.resize( wheel_buckets );
+   const uint64_t bucket = obj.expiration.sec_since_epoch() / wheel_granularity;
+   _wheel[ bucket % wheel_buckets ].push_back( obj.id.instance() );
+   // objects put back by undo may belong to a bucket that was swept already
+   if( bucket < _sweep_from )
+      _sweep_from = bucket;
+}
+
+size_t transaction_index::home_slot( const transaction_id_type& trx_id )const
+{
+   // transaction ids are hashes, so their leading bytes are already uniformly distributed
+   uint64_t h;
+   memcpy( &h, trx_id.data(), sizeof(h) );
+   return size_t( h & (_slots.size() - 1) );
+}
+
+void transaction_index::hash_insert( const transaction_object& obj )
+{
+   const size_t mask = _slots.size() - 1;
+   size_t i = home_slot( obj.trx_id );
+   while( _slots[i] != empty_slot )
+      i = (i + 1) & mask;
+   _slots[i] = obj.id.instance() + 1;
+}
+
+void transaction_index::hash_erase( const transaction_object& obj )
+{
+   const size_t mask = _slots.size() - 1;
+   const uint64_t value = obj.id.instance() + 1;
+   size_t i = home_slot( obj.trx_id );
+   while( _slots[i] != value )
+   {
+      assert( _slots[i] != empty_slot );
+      i = (i + 1) & mask;
+   }
+
+   // backward shift deletion keeps every probe sequence intact without tombstones
+   for( size_t j = (i + 1) & mask; _slots[j] != empty_slot; j = (j + 1) & mask )
+   {
+      const size_t k = home_slot( entry( _slots[j] - 1 )->trx_id );
+      // slot j can only move into the hole if its home is not cyclically within (i, j]
+      if( i <= j ? (i < k && k <= j) : (i < k || k <= j) )
+         continue;
+      _slots[i] = _slots[j];
+      i = j;
+   }
+   _slots[i] = empty_slot;
+}
+
+void transaction_index::rehash( size_t capacity )
+{
+   _slots.assign( capacity, empty_slot );
+   for( const transaction_object& e : _window )
+      if( e.id.space() == transaction_object::space_id )
+         hash_insert( e );
 }
 
 } } // graphene::chain
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/index.hpp>
+#include <graphene/db/object_store.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace db {
+
+   /**
+    *  @class disk_index
+    *  @brief an index whose objects live in an object_store on disk with a bounded write-back cache in RAM
+    *
+    *  Intended for large indexes of cold objects that are only ever looked up by id, such
+    *  as operation history.  Objects are loaded into the cache on demand and changes are
+    *  kept in the cache until trim() evicts them, so a disk_index behaves exactly like an
+    *  in-memory index as far as primary_index, the undo_database and secondary indexes are
+    *  concerned.
+    *
+    *  @note references returned by find() and create() remain valid only until the next
+    *  call to trim(), which object_database::trim_caches() issues between blocks.
+    *
+    *  find() and inspect_all_objects() may be called from several reader threads at once
+    *  (see database::read_lock()), so the cache and the store are guarded by a mutex of
+    *  their own.  Writers, and therefore trim(), hold the database exclusively, which keeps
+    *  references handed to readers valid for as long as they hold their read lock.
+    */
+   template<typename T>
+   class disk_index : public index
+   {
+      public:
+         typedef T object_type;
+
+         virtual const object& create( const std::function<void(object&)>& constructor ) override
+         {
+            unique_ptr<T> item( new T() );
+            item->id = get_next_id();
+            constructor( *item );
+            item->id = get_next_id();
+            use_next_id();
+            return cache_insert( std::move(item) );
+         }
+
+         virtual const object& insert( object&& obj ) override
+         {
+            FC_ASSERT( nullptr != dynamic_cast<T*>(&obj) );
+            FC_ASSERT( find( obj.id ) == nullptr, "object ${id} already exists", ("id",obj.id) );
+            return cache_insert( unique_ptr<T>( new T( std::move( static_cast<T&>(obj) ) ) ) );
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& modify_callback ) override
+         {
+            auto itr = _cache.find( obj.id.instance() );
+            assert( itr != _cache.end() && itr->second.obj.get() == &obj );
+            modify_callback( *itr->second.obj );
+            itr->second.dirty = true;
+         }
+
+         virtual void remove( const object& obj ) override
+         {
+            auto& e = _cache[ obj.id.instance() ];
+            e.obj.reset();
+            e.dirty = true;
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            if( id.space() != T::space_id || id.type() != T::type_id ) return nullptr;
+            std::lock_guard<std::mutex> lock( _cache_mutex );
+            auto itr = _cache.find( id.instance() );
+            if( itr != _cache.end() )
+            {
+               itr->second.last_used = ++_clock;
+               return itr->second.obj.get();
+            }
+            if( !_store.is_open() ) return nullptr;
+
+            auto obj = fetch( id.instance() );
+            if( !obj ) return nullptr;
+            auto& e = _cache[ id.instance() ];
+            e.obj = std::move(obj);
+            e.last_used = ++_clock;
+            return e.obj.get();
+         }
+
+         virtual void inspect_all_objects( std::function<void(const object&)> inspector )const override
+         { try {
+            // read through the store without pulling everything into the cache
+            const uint64_t end = get_next_id().instance();
+            for( uint64_t i = 0; i < end; ++i )
+            {
+               // the inspector may call find(), so don't hold the mutex while it runs
+               const T* cached = nullptr;
+               unique_ptr<T> loaded;
+               {
+                  std::lock_guard<std::mutex> lock( _cache_mutex );
+                  auto itr = _cache.find( i );
+                  if( itr != _cache.end() )
+                     cached = itr->second.obj.get();
+                  else if( _store.is_open() )
+                     loaded = fetch( i );
+               }
+               if( cached )
+                  inspector( *cached );
+               else if( loaded )
+                  inspector( *loaded );
+            }
+         } FC_CAPTURE_AND_RETHROW() }
+
+         virtual fc::uint128 hash()const override
+         {
+            fc::uint128 result;
+            inspect_all_objects( [&]( const object& o ) {
+               result += o.hash();
+            });
+            return result;
+         }
+
+         virtual bool open_store( const fc::path& dir ) override
+         {
+            // objects that were cached before a reopen (e.g. after a wipe) belong in the new store
+            for( auto& item : _cache )
+               item.second.dirty = true;
+            _store.open( dir );
+            return true;
+         }
+
+         virtual bool flush_store() override
+         {
+            std::lock_guard<std::mutex> lock( _cache_mutex );
+            write_dirty();
+            _store.flush();
+            return true;
+         }
+
+         /**
+          *  Writes back dirty objects and evicts the least recently used ones once the cache is over
+          *  capacity.  Objects which could not be written back stay in the cache.
+          */
+         virtual void trim() override
+         {
+            std::lock_guard<std::mutex> lock( _cache_mutex );
+            if( _cache.size() <= _cache_size ) return;
+            write_dirty();
+
+            // evict down to 3/4 of capacity so that trimming is amortized over several blocks
+            const size_t keep = _cache_size - _cache_size / 4;
+            vector<uint64_t> ages;
+            ages.reserve( _cache.size() );
+            for( const auto& item : _cache )
+               ages.push_back( item.second.last_used );
+            std::nth_element( ages.begin(), ages.end() - keep, ages.end() );
+            const uint64_t cutoff = *(ages.end() - keep);
+            for( auto itr = _cache.begin(); itr != _cache.end(); )
+            {
+               // dirty entries are left when there is no store to write them to
+               if( itr->second.last_used < cutoff && !itr->second.dirty )
+                  itr = _cache.erase( itr );
+               else
+                  ++itr;
+            }
+         }
+
+         void     set_cache_size( size_t s ) { _cache_size = std::max<size_t>( s, 4 ); }
+         size_t   cache_size()const          { return _cache_size; }
+         size_t   cached_objects()const
+         {
+            std::lock_guard<std::mutex> lock( _cache_mutex );
+            return _cache.size();
+         }
+         const object_store& store()const    { return _store; }
+
+      private:
+         struct cache_entry
+         {
+            unique_ptr<T> obj;
+            bool          dirty = false;
+            uint64_t      last_used = 0;
+         };
+
+         const object& cache_insert( unique_ptr<T> item )
+         {
+            auto& e = _cache[ item->id.instance() ];
+            e.obj = std::move(item);
+            e.dirty = true;
+            e.last_used = ++_clock;
+            return *e.obj;
+         }
+
+         unique_ptr<T> fetch( uint64_t instance )const
+         {
+            if( !_store.fetch( instance, _buffer ) ) return unique_ptr<T>();
+            unique_ptr<T> obj( new T() );
+            fc::raw::unpack( _buffer, *obj );
+            return obj;
+         }
+
+         void write_dirty()
+         {
+            if( !_store.is_open() ) return;
+            for( auto& item : _cache )
+            {
+               if( !item.second.dirty ) continue;
+               if( item.second.obj )
+                  _store.store( item.first, fc::raw::pack( *item.second.obj ) );
+               else
+                  _store.remove( item.first );
+               item.second.dirty = false;
+            }
+         }
+
+         mutable std::unordered_map< uint64_t, cache_entry > _cache;
+         mutable std::mutex                                  _cache_mutex;
+         mutable uint64_t                                    _clock = 0;
+         mutable vector<char>                                _buffer;
+         object_store                                        _store;
+         size_t                                              _cache_size = 100000;
+   };
+
+} } // graphene::db
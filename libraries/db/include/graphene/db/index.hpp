@@ -96,6 +96,20 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Indexes that keep their objects in a store of their own (see disk_index) open and
+          *  flush it here; primary_index then only persists the next id rather than writing a
+          *  snapshot of every object.
+          *  @return false if the index is kept entirely in memory
+          */
+         virtual bool open_store( const fc::path& dir ) { return false; }
+         virtual bool flush_store() { return false; }
+
+         /**
+          *  Called between blocks when no references into the index are held, allowing
+          *  indexes that cache objects to release memory.
+          */
+         virtual void trim(){}
 
 
          /** @return the object with id or nullptr if not found */
@@ -224,6 +238,24 @@ namespace graphene { namespace db {
 
          virtual void open( const path& db )override
          { 
+            if( this->open_store( fc::path( db.generic_string() + "_store" ) ) )
+            {
+               if( fc::exists( db ) )
+               {
+                  std::ifstream in( db.generic_string(), std::ifstream::binary );
+                  fc::sha256 open_ver;
+                  fc::raw::unpack( in, _next_id );
+                  fc::raw::unpack( in, open_ver );
+                  FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
+               }
+               if( _sindex.size() )
+                  this->inspect_all_objects( [&]( const object& o ) {
+                     for( const auto& item : _sindex )
+                        item->object_inserted( o );
+                  });
+               return;
+            }
+
             if( !fc::exists( db ) ) return;
             fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
             fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
@@ -251,6 +283,8 @@ namespace graphene { namespace db {
             auto ver  = get_object_version();
             fc::raw::pack( out, _next_id );
             fc::raw::pack( out, ver );
+            if( this->flush_store() )
+               return;
             this->inspect_all_objects( [&]( const object& o ) {
                 auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
                 auto packed_vec = fc::raw::pack( vec );
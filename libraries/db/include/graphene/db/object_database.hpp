@@ -29,6 +29,7 @@
 #include <fc/log/logger.hpp>
 
 #include <map>
+#include <unordered_map>
 
 namespace graphene { namespace db {
 
@@ -53,6 +54,12 @@ namespace graphene { namespace db {
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
+         /**
+          * Lets indexes that cache objects (such as disk_index) write back and release memory.
+          * Only call this when no references to objects are held, e.g. between blocks.
+          */
+         void trim_caches();
+
          template<typename T, typename F>
          const T& create( F&& constructor )
          {
@@ -139,10 +146,37 @@ namespace graphene { namespace db {
             return static_cast<IndexType*>(_index[ObjectType::space_id][ObjectType::type_id].get());
          }
 
+         /** registers o to be notified of every object added to, modified in or removed from the index of ObjectType */
+         template<typename ObjectType>
+         void add_index_observer( const shared_ptr<index_observer>& o )
+         {
+            get_mutable_index<ObjectType>().add_observer( o );
+         }
+
          void pop_undo();
 
          fc::path get_data_dir()const { return _data_dir; }
 
+         /**
+          *  Every create, modify and remove (including those done by undo) moves the database to a new
+          *  revision and tags the object with it, so API clients can ask whether anything changed since
+          *  a revision they have seen.  Revisions never go backwards, not even when blocks are popped,
+          *  and each process starts above any revision handed out by an earlier one.
+          */
+         /// @{
+         uint64_t get_revision()const { return _revision; }
+         /** @return the revision of the last change to id, objects without a recorded change report the base revision */
+         uint64_t get_object_revision( object_id_type id )const;
+         /** @return the revision at which an object of the given type was last removed */
+         uint64_t get_removal_revision( uint8_t space_id, uint8_t type_id )const;
+         /**
+          *  Drops the recorded revisions at or below revision and raises the base revision to it, which
+          *  keeps the bookkeeping bounded.  Affected objects then report revision, so a client that
+          *  passes an older one sees them as changed once more, but no change is ever missed.
+          */
+         void forget_revisions( uint64_t revision );
+         /// @}
+
          /** public for testing purposes only... should be private in practice. */
          undo_database                          _undo_db;
      protected:
@@ -164,8 +198,16 @@ namespace graphene { namespace db {
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
 
+         void record_change( const object& obj );
+         void record_removal( const object& obj );
+
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+
+         uint64_t                                                  _base_revision = 0;
+         uint64_t                                                  _revision = 0;
+         std::unordered_map<object_id_type,uint64_t>               _object_revisions;
+         std::map<std::pair<uint8_t,uint8_t>,uint64_t>             _removal_revisions;
    };
 
 } } // graphene::db
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <fc/filesystem.hpp>
+#include <fstream>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class object_store
+    * @brief an on-disk key/value store of packed objects keyed by object instance
+    *
+    * Packed objects are appended to an "objects" log and located through an "index"
+    * file holding one fixed size entry per instance, so the store is ordered by
+    * instance and any lookup costs a single seek.  Overwritten and removed records
+    * leave garbage in the log which is reclaimed by compact(); open() compacts
+    * automatically once garbage outweighs live data.
+    */
+   class object_store
+   {
+      public:
+         void open( const fc::path& dir );
+         bool is_open()const;
+         void flush();
+         void close();
+
+         void store( uint64_t instance, const std::vector<char>& packed );
+         void remove( uint64_t instance );
+
+         bool contains( uint64_t instance )const;
+         /** @return false if there is no record for instance */
+         bool fetch( uint64_t instance, std::vector<char>& packed )const;
+
+         /** @return one past the highest instance that may have a record */
+         uint64_t end_instance()const;
+
+         uint64_t live_bytes()const  { return _live_bytes; }
+         uint64_t total_bytes()const;
+
+         /** rewrites the log so that it contains only live records */
+         void compact();
+
+      private:
+         struct entry
+         {
+            uint64_t pos  = 0;
+            uint32_t size = 0;
+         };
+
+         /** size of an entry in the index file, which holds pos and size packed without padding */
+         static const uint64_t entry_size = sizeof(uint64_t) + sizeof(uint32_t);
+
+         bool read_entry( uint64_t instance, entry& e )const;
+         void write_entry( uint64_t instance, const entry& e );
+         static void write_entry( std::fstream& index, uint64_t instance, const entry& e );
+         void read_sizes();
+
+         fc::path             _dir;
+         mutable std::fstream _objects;
+         mutable std::fstream _index;
+         uint64_t             _live_bytes = 0;
+         /** file sizes are tracked here rather than asking the streams, which costs a seek */
+         uint64_t             _end_instance = 0;
+         uint64_t             _objects_bytes = 0;
+   };
+
+} } // graphene::db
@@ -132,6 +132,13 @@ namespace graphene { namespace db {
 
          const undo_state& head()const;
 
+         /** lifetime counters of undo sessions, used for profiling */
+         /// @{
+         uint64_t sessions_started()const { return _sessions_started; }
+         uint64_t sessions_undone()const  { return _sessions_undone;  }
+         uint64_t sessions_merged()const  { return _sessions_merged;  }
+         /// @}
+
       private:
          void undo();
          void merge();
@@ -142,6 +149,9 @@ namespace graphene { namespace db {
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
+         uint64_t                _sessions_started = 0;
+         uint64_t                _sessions_undone = 0;
+         uint64_t                _sessions_merged = 0;
    };
 
 } } // graphene::db
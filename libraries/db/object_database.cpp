@@ -26,6 +26,7 @@
 #include <fc/io/raw.hpp>
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
+#include <fc/time.hpp>
 
 namespace graphene { namespace db {
 
@@ -34,6 +35,10 @@ object_database::object_database()
 {
    _index.resize(255);
    _undo_db.enable();
+
+   // far fewer than one change per microsecond, so this stays above the last revision of a previous run
+   _base_revision = fc::time_point::now().time_since_epoch().count();
+   _revision = _base_revision;
 }
 
 object_database::~object_database(){}
@@ -51,6 +56,54 @@ const object& object_database::get_object( object_id_type id )const
    return get_index(id.space(),id.type()).get( id );
 }
 
+uint64_t object_database::get_object_revision( object_id_type id )const
+{
+   auto itr = _object_revisions.find( id );
+   if( itr != _object_revisions.end() )
+      return itr->second;
+   return _base_revision;
+}
+
+uint64_t object_database::get_removal_revision( uint8_t space_id, uint8_t type_id )const
+{
+   auto itr = _removal_revisions.find( std::make_pair( space_id, type_id ) );
+   if( itr != _removal_revisions.end() )
+      return itr->second;
+   return _base_revision;
+}
+
+void object_database::record_change( const object& obj )
+{
+   _object_revisions[obj.id] = ++_revision;
+}
+
+void object_database::record_removal( const object& obj )
+{
+   _object_revisions.erase( obj.id );
+   _removal_revisions[std::make_pair( obj.id.space(), obj.id.type() )] = ++_revision;
+}
+
+void object_database::forget_revisions( uint64_t revision )
+{
+   if( revision <= _base_revision )
+      return;
+   _base_revision = std::min( revision, _revision );
+   for( auto itr = _object_revisions.begin(); itr != _object_revisions.end(); )
+   {
+      if( itr->second <= _base_revision )
+         itr = _object_revisions.erase( itr );
+      else
+         ++itr;
+   }
+   for( auto itr = _removal_revisions.begin(); itr != _removal_revisions.end(); )
+   {
+      if( itr->second <= _base_revision )
+         itr = _removal_revisions.erase( itr );
+      else
+         ++itr;
+   }
+}
+
 const index& object_database::get_index(uint8_t space_id, uint8_t type_id)const
 {
    FC_ASSERT( _index.size() > space_id, "", ("space_id",space_id)("type_id",type_id)("index.size",_index.size()) );
@@ -81,6 +134,14 @@ void object_database::flush()
    }
 }
 
+void object_database::trim_caches()
+{
+   for( auto& space : _index )
+      for( auto& idx : space )
+         if( idx )
+            idx->trim();
+}
+
 void object_database::wipe(const fc::path& data_dir)
 {
    close();
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/db/object_store.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+static void open_file( std::fstream& f, const fc::path& p, bool create )
+{
+   f.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   auto mode = std::fstream::binary | std::fstream::in | std::fstream::out;
+   if( create )
+      mode |= std::fstream::trunc;
+   f.open( p.generic_string().c_str(), mode );
+}
+
+void object_store::open( const fc::path& dir )
+{ try {
+   if( is_open() )
+      close();
+
+   _dir = dir;
+   fc::create_directories( dir );
+   bool create = !fc::exists( dir/"index" ) || !fc::exists( dir/"objects" );
+   open_file( _index,   dir/"index",   create );
+   open_file( _objects, dir/"objects", create );
+   read_sizes();
+
+   _live_bytes = 0;
+   const auto end = end_instance();
+   entry e;
+   for( uint64_t i = 0; i < end; ++i )
+      if( read_entry( i, e ) )
+         _live_bytes += e.size;
+
+   // don't bother compacting small stores, they are cheap to carry
+   if( total_bytes() > 2 * _live_bytes + (1<<20) )
+      compact();
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+bool object_store::is_open()const
+{
+   return _objects.is_open();
+}
+
+void object_store::flush()
+{
+   _objects.flush();
+   _index.flush();
+}
+
+void object_store::close()
+{
+   _objects.close();
+   _index.close();
+   _end_instance = 0;
+   _objects_bytes = 0;
+}
+
+void object_store::read_sizes()
+{
+   _index.seekg( 0, _index.end );
+   _end_instance = uint64_t( _index.tellg() ) / entry_size;
+   _objects.seekg( 0, _objects.end );
+   _objects_bytes = uint64_t( _objects.tellg() );
+}
+
+bool object_store::read_entry( uint64_t instance, entry& e )const
+{
+   if( instance >= _end_instance )
+      return false;
+   char buffer[entry_size];
+   _index.seekg( entry_size * instance );
+   _index.read( buffer, entry_size );
+   fc::datastream<const char*> ds( buffer, entry_size );
+   fc::raw::unpack( ds, e.pos );
+   fc::raw::unpack( ds, e.size );
+   return e.size > 0;
+}
+
+void object_store::write_entry( std::fstream& index, uint64_t instance, const entry& e )
+{
+   char buffer[entry_size];
+   fc::datastream<char*> ds( buffer, entry_size );
+   fc::raw::pack( ds, e.pos );
+   fc::raw::pack( ds, e.size );
+   index.seekp( entry_size * instance );
+   index.write( buffer, entry_size );
+}
+
+void object_store::write_entry( uint64_t instance, const entry& e )
+{
+   write_entry( _index, instance, e );
+   _end_instance = std::max( _end_instance, instance + 1 );
+}
+
+uint64_t object_store::end_instance()const
+{
+   return _end_instance;
+}
+
+uint64_t object_store::total_bytes()const
+{
+   return _objects_bytes;
+}
+
+void object_store::store( uint64_t instance, const std::vector<char>& packed )
+{ try {
+   FC_ASSERT( packed.size() > 0 );
+   entry old;
+   if( read_entry( instance, old ) )
+      _live_bytes -= old.size;
+
+   entry e;
+   e.pos  = _objects_bytes;
+   e.size = packed.size();
+   _objects.seekp( e.pos );
+   _objects.write( packed.data(), packed.size() );
+   _objects_bytes += e.size;
+   write_entry( instance, e );
+   _live_bytes += e.size;
+} FC_CAPTURE_AND_RETHROW( (instance) ) }
+
+void object_store::remove( uint64_t instance )
+{ try {
+   entry e;
+   if( !read_entry( instance, e ) )
+      return;
+   _live_bytes -= e.size;
+   e.size = 0;
+   write_entry( instance, e );
+} FC_CAPTURE_AND_RETHROW( (instance) ) }
+
+bool object_store::contains( uint64_t instance )const
+{
+   entry e;
+   return read_entry( instance, e );
+}
+
+bool object_store::fetch( uint64_t instance, std::vector<char>& packed )const
+{ try {
+   entry e;
+   if( !read_entry( instance, e ) )
+      return false;
+   packed.resize( e.size );
+   _objects.seekg( e.pos );
+   _objects.read( packed.data(), e.size );
+   return true;
+} FC_CAPTURE_AND_RETHROW( (instance) ) }
+
+void object_store::compact()
+{ try {
+   ilog( "Compacting object store ${d}: ${l} live of ${t} bytes",
+         ("d",_dir)("l",_live_bytes)("t",total_bytes()) );
+
+   const auto end = end_instance();
+   {
+      std::fstream objects;
+      std::fstream idx;
+      open_file( objects, _dir/"objects.tmp", true );
+      open_file( idx,     _dir/"index.tmp",   true );
+
+      std::vector<char> data;
+      entry e;
+      for( uint64_t i = 0; i < end; ++i )
+      {
+         if( !read_entry( i, e ) )
+            continue;
+         data.resize( e.size );
+         _objects.seekg( e.pos );
+         _objects.read( data.data(), e.size );
+
+         e.pos = objects.tellp();
+         objects.write( data.data(), data.size() );
+         write_entry( idx, i, e );
+      }
+   }
+
+   close();
+   fc::rename( _dir/"objects.tmp", _dir/"objects" );
+   fc::rename( _dir/"index.tmp",   _dir/"index" );
+   open_file( _index,   _dir/"index",   false );
+   open_file( _objects, _dir/"objects", false );
+   read_sizes();
+} FC_CAPTURE_AND_RETHROW( (_dir) ) }
+
+} } // graphene::db
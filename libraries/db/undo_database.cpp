@@ -42,6 +42,7 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
 
    _stack.emplace_back();
    ++_active_sessions;
+   ++_sessions_started;
    return session(*this, disable_on_exit );
 }
 void undo_database::on_create( const object& obj )
@@ -97,6 +98,7 @@ void undo_database::undo()
    FC_ASSERT( !_disabled );
    FC_ASSERT( _active_sessions > 0 );
    disable();
+   ++_sessions_undone;
 
    auto& state = _stack.back();
    for( auto& item : state.old_values )
@@ -114,8 +116,9 @@ void undo_database::undo()
       _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
    }
 
+   // restored objects bypass the index hooks, they still count as changed for revision readers
    for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+      _db.record_change( _db.insert( std::move(*item.second) ) );
 
    _stack.pop_back();
    if( _stack.empty() )
@@ -128,6 +131,7 @@ void undo_database::merge()
 {
    FC_ASSERT( _active_sessions > 0 );
    FC_ASSERT( _stack.size() >=2 );
+   ++_sessions_merged;
    auto& state = _stack.back();
    auto& prev_state = _stack[_stack.size()-2];
 
@@ -269,7 +273,7 @@ void undo_database::pop_commit()
       }
 
       for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
+         _db.record_change( _db.insert( std::move(*item.second) ) );
 
       _stack.pop_back();
    }
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -34,6 +35,7 @@
 #include <fc/string.hpp>
 #include <fc/io/fstream.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/protocol/types.hpp>
 
@@ -125,15 +127,20 @@ void convert_to_c_array(
                dest.append(&c, 1);
                break;
 
-            // use shortest octal escape for everything else
+            // use shortest octal escape for everything else, unless the next
+            // character is an octal digit which would extend the escape
             default:
+            {
                dest.append("\\");
                char dg[3];
                dg[0] = '0' + ((c >> 6) & 3);
                dg[1] = '0' + ((c >> 3) & 7);
                dg[2] = '0' + ((c     ) & 7);
                int start = (dg[0] == '0' ? (dg[1] == '0' ? 2 : 1) : 0);
+               if( k+1 < j && src[k+1] >= '0' && src[k+1] <= '7' )
+                  start = 0;
                dest.append( dg+start, 3-start );
+            }
          }
       }
       dest.append("\"");
@@ -153,6 +160,13 @@ struct egenesis_info
    fc::optional< std::string > genesis_json_array;
    int genesis_json_array_width,
        genesis_json_array_height;
+   /** when set only the fc::raw packed genesis is embedded */
+   bool binary = false;
+   std::string genesis_packed;
+   fc::sha256 genesis_packed_hash;
+   std::string genesis_packed_array;
+   int genesis_packed_array_width,
+       genesis_packed_array_height;
 
    void fillin()
    {
@@ -186,11 +200,26 @@ struct egenesis_info
          genesis_json_array = std::string();
          // TODO: gzip
          int width = 40;
-         convert_to_c_array( *genesis_json, *genesis_json_array, width );
-         int height = (genesis_json->length() + width-1) / width;
+         convert_to_c_array( binary ? std::string() : *genesis_json, *genesis_json_array, width );
+         int height = binary ? 1 : (genesis_json->length() + width-1) / width;
+         if( binary )
+            *genesis_json_array = "\"\"";
          genesis_json_array_width = width;
          genesis_json_array_height = height;
       }
+      // the packed genesis is empty unless binary is set
+      if( binary )
+      {
+         std::vector<char> packed = fc::raw::pack( *genesis );
+         genesis_packed.assign( packed.begin(), packed.end() );
+      }
+      genesis_packed_hash = fc::sha256::hash( genesis_packed.data(), genesis_packed.size() );
+      int width = 40;
+      convert_to_c_array( genesis_packed, genesis_packed_array, width );
+      if( genesis_packed.empty() )
+         genesis_packed_array = "\"\"";
+      genesis_packed_array_width = width;
+      genesis_packed_array_height = std::max<int>( 1, (genesis_packed.length() + width-1) / width );
    }
 };
 
@@ -227,6 +256,7 @@ int main( int argc, char** argv )
       ("genesis-json,g", boost::program_options::value<boost::filesystem::path>(), "File to read genesis state from")
       ("tmplsub,t", boost::program_options::value<std::vector< std::string > >()->composing(),
        "Given argument of form src.cpp.tmpl---dest.cpp, write dest.cpp expanding template invocations in src")
+      ("binary,b", "Embed the genesis packed in binary form instead of as JSON, which avoids parsing it at startup")
       ;
 
    boost::program_options::variables_map options;
@@ -249,6 +279,7 @@ int main( int argc, char** argv )
    egenesis_info info;
 
    load_genesis( options, info );
+   info.binary = options.count("binary") > 0;
    info.fillin();
 
    fc::mutable_variant_object template_context = fc::mutable_variant_object()
@@ -257,12 +288,17 @@ int main( int argc, char** argv )
       ;
    if( info.genesis_json.valid() )
    {
-      template_context["genesis_json_length"] = info.genesis_json->length();
+      template_context["genesis_json_length"] = info.binary ? 0 : info.genesis_json->length();
       template_context["genesis_json_array"] = (*info.genesis_json_array);
       template_context["genesis_json_hash"] = (*info.genesis_json_hash).str();
       template_context["genesis_json_array_width"] = info.genesis_json_array_width;
       template_context["genesis_json_array_height"] = info.genesis_json_array_height;
    }
+   template_context["genesis_packed_length"] = info.genesis_packed.length();
+   template_context["genesis_packed_array"] = info.genesis_packed_array;
+   template_context["genesis_packed_hash"] = info.genesis_packed_hash.str();
+   template_context["genesis_packed_array_width"] = info.genesis_packed_array_width;
+   template_context["genesis_packed_array_height"] = info.genesis_packed_array_height;
 
    for( const std::string& src_dest : options["tmplsub"].as< std::vector< std::string > >() )
    {
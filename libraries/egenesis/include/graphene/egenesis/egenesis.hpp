@@ -25,6 +25,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <fc/crypto/sha256.hpp>
 #include <graphene/chain/protocol/types.hpp>
@@ -48,4 +49,17 @@ void compute_egenesis_json( std::string& result );
  */
 fc::sha256 get_egenesis_json_hash();
 
+/**
+ * Get the egenesis packed with fc::raw, or an empty vector if it was not
+ * compiled in that form.  A genesis embedded with GRAPHENE_EGENESIS_BINARY
+ * is only available this way, compute_egenesis_json() then returns the
+ * empty string while the chain ID is still that of the JSON.
+ */
+void compute_egenesis_packed( std::vector<char>& result );
+
+/**
+ * The data returned by compute_egenesis_packed() should have this hash.
+ */
+fc::sha256 get_egenesis_packed_hash();
+
 } } // graphene::egenesis
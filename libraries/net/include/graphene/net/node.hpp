@@ -196,9 +196,9 @@ namespace graphene { namespace net {
    {
       public:
         node(const std::string& user_agent);
-        ~node();
+        virtual ~node();
 
-        void close();
+        virtual void close();
 
         void      set_node_delegate( node_delegate* del );
 
@@ -212,7 +212,7 @@ namespace graphene { namespace net {
          *  to attempt to connect to.  This database is consulted any time
          *  the number connected peers falls below the target.
          */
-        void      add_node( const fc::ip::endpoint& ep );
+        virtual void add_node( const fc::ip::endpoint& ep );
 
         /**
          *  Attempt to connect to the specified endpoint immediately.
@@ -223,7 +223,7 @@ namespace graphene { namespace net {
          *  Specifies the network interface and port upon which incoming
          *  connections should be accepted.
          */
-        void      listen_on_endpoint( const fc::ip::endpoint& ep, bool wait_if_not_available );
+        virtual void listen_on_endpoint( const fc::ip::endpoint& ep, bool wait_if_not_available );
 
         /**
          *  Call with true to enable listening for incoming connections
@@ -238,7 +238,7 @@ namespace graphene { namespace net {
          *                               available.  If false and the port is not available,
          *                               just choose a random available port
          */
-        void      listen_on_port(uint16_t port, bool wait_if_not_available);
+        virtual void listen_on_port(uint16_t port, bool wait_if_not_available);
 
         /**
          * Returns the endpoint the node is listening on.  This is usually the same
@@ -250,7 +250,7 @@ namespace graphene { namespace net {
         /**
          *  @return a list of peers that are currently connected.
          */
-        std::vector<peer_status> get_connected_peers() const;
+        virtual std::vector<peer_status> get_connected_peers() const;
 
         /** return the number of peers we're actively connected to */
         virtual uint32_t get_connection_count() const;
@@ -288,7 +288,7 @@ namespace graphene { namespace net {
 
         void set_total_bandwidth_limit(uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second);
 
-        fc::variant_object network_get_info() const;
+        virtual fc::variant_object network_get_info() const;
         fc::variant_object network_get_usage_stats() const;
 
         std::vector<potential_peer_record> get_potential_peers() const;
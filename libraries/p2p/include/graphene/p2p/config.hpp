@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#define GRAPHENE_P2P_PROTOCOL_VERSION                  1
+
+/** the same framing limit as the announce/request/send protocol uses */
+#ifndef MAX_MESSAGE_SIZE
+#define MAX_MESSAGE_SIZE                               1024*1024*2
+#endif
+
+#define GRAPHENE_P2P_DEFAULT_DESIRED_PEERS             8
+#define GRAPHENE_P2P_DEFAULT_MAX_PEERS                 32
+
+/** peers whose hello round trip takes longer than this are dropped once we have enough peers */
+#define GRAPHENE_P2P_DEFAULT_MAX_ROUND_TRIP_MS         1000
+
+/** how often the node tries to top up its connections */
+#define GRAPHENE_P2P_UPDATE_CONNECTIONS_INTERVAL_SEC   2
+
+/** a peer whose oldest unsent message is older than this cannot keep up and is disconnected */
+#define GRAPHENE_P2P_MAX_SEND_BACKLOG_SEC              10
+
+/** transactions are kept this long to reconstruct blocks from their summaries */
+#define GRAPHENE_P2P_TRANSACTION_CACHE_SEC             120
+
+/** at most this many transactions are cached, summaries of blocks with others are completed by fetching */
+#define GRAPHENE_P2P_MAX_CACHED_TRANSACTIONS           100000
+
+/** a peer sending more rejected transactions than this per update interval is disconnected */
+#define GRAPHENE_P2P_MAX_REJECTED_TRANSACTIONS         200
+
+/** a fetched block that hasn't arrived by then may be fetched from another peer */
+#define GRAPHENE_P2P_FETCH_TIMEOUT_SEC                 5
+
+/** number of item ids remembered per peer to avoid sending it what it already has */
+#define GRAPHENE_P2P_PEER_KNOWN_ITEMS                  20000
+
+/** number of blocks sent to a catching up peer per call to get_block_ids */
+#define GRAPHENE_P2P_CATCH_UP_BATCH                    500
@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/chain/protocol/block.hpp>
+
 #include <fc/array.hpp>
 #include <fc/io/varint.hpp>
 #include <fc/network/ip.hpp>
@@ -104,30 +106,37 @@ namespace graphene { namespace p2p {
   };
 
   enum core_message_type_enum {
-     hello_message_type       = 1000,
-     transaction_message_type = 1001,
-     block_message_type       = 1002,
-     peer_message_type        = 1003,
-     error_message_type       = 1004
+     hello_message_type         = 1000,
+     transaction_message_type   = 1001,
+     block_summary_message_type = 1002,
+     peers_message_type         = 1003,
+     error_message_type         = 1004,
+     hello_reply_message_type   = 1005,
+     full_block_message_type    = 1006,
+     fetch_block_message_type   = 1007
   };
 
+  /**
+   *  Sent by both sides as soon as a connection is established.  The synopsis lets the receiver
+   *  work out which of its blocks the sender is missing and push them without being asked.
+   */
   struct hello_message
   {
       static const core_message_type_enum type;
 
-      std::string         user_agent;
-      uint16_t            version;
-      fc::time_point      timestamp;
-                          
-      fc::ip::address     inbound_address;
-      uint16_t            inbound_port;
-      uint16_t            outbound_port;
-      public_key_type     node_public_key;
-      fc::sha256          chain_id;
-      fc::variant_object  user_data;
-      block_id_type       head_block;
+      std::string                 user_agent;
+      uint16_t                    version = 0;
+      fc::time_point              timestamp;
+
+      uint16_t                    inbound_port = 0;
+      public_key_type             node_public_key;
+      chain_id_type               chain_id;
+      block_id_type               head_block;
+      /** see net::node_delegate::get_blockchain_synopsis() */
+      vector<block_id_type>       synopsis;
   };
 
+  /** answers a hello so that the sender can measure the round trip */
   struct hello_reply_message
   {
       static const core_message_type_enum type;
@@ -136,18 +145,28 @@ namespace graphene { namespace p2p {
       fc::time_point   reply_timestamp;
   };
 
-  struct transaction_message 
+  struct transaction_message
   {
      static const core_message_type_enum type;
      signed_transaction trx;
+     /** set by the node that first broadcast the transaction, used to measure propagation latency */
+     fc::time_point     origin_time;
   };
 
+  /**
+   *  A block without its transactions; receivers rebuild it from the transactions relayed to them
+   *  earlier and fetch the full block only if some are missing.  The operation results are part of
+   *  the merkle root but not of a relayed transaction, so they travel with the summary.
+   */
   struct block_summary_message
   {
      static const core_message_type_enum type;
 
      signed_block_header         header;
      vector<transaction_id_type> transaction_ids;
+     vector< vector<operation_result> > operation_results;
+     /** set by the producing node, used to measure propagation latency */
+     fc::time_point              origin_time;
   };
 
   struct full_block_message
@@ -156,6 +175,12 @@ namespace graphene { namespace p2p {
      signed_block  block;
   };
 
+  struct fetch_block_message
+  {
+     static const core_message_type_enum type;
+     block_id_type block_id;
+  };
+
   struct peers_message
   {
      static const core_message_type_enum type;
@@ -169,15 +194,26 @@ namespace graphene { namespace p2p {
      string message;
   };
 
-
 } } // graphene::p2p
 
 FC_REFLECT( graphene::p2p::message_header, (size)(msg_type) )
 FC_REFLECT_DERIVED( graphene::p2p::message, (graphene::p2p::message_header), (data) )
-FC_REFLECT_ENUM( graphene::p2p::core_message_type_enum, 
+FC_REFLECT_ENUM( graphene::p2p::core_message_type_enum,
        (hello_message_type)
        (transaction_message_type)
-       (block_message_type)
-       (peer_message_type)
+       (block_summary_message_type)
+       (peers_message_type)
        (error_message_type)
+       (hello_reply_message_type)
+       (full_block_message_type)
+       (fetch_block_message_type)
 )
+FC_REFLECT( graphene::p2p::hello_message,
+            (user_agent)(version)(timestamp)(inbound_port)(node_public_key)(chain_id)(head_block)(synopsis) )
+FC_REFLECT( graphene::p2p::hello_reply_message, (hello_timestamp)(reply_timestamp) )
+FC_REFLECT( graphene::p2p::transaction_message, (trx)(origin_time) )
+FC_REFLECT( graphene::p2p::block_summary_message, (header)(transaction_ids)(operation_results)(origin_time) )
+FC_REFLECT( graphene::p2p::full_block_message, (block) )
+FC_REFLECT( graphene::p2p::fetch_block_message, (block_id) )
+FC_REFLECT( graphene::p2p::peers_message, (peers) )
+FC_REFLECT( graphene::p2p::error_message, (message) )
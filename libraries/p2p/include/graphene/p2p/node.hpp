@@ -21,76 +21,168 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
-
 #pragma once
-#include <graphene/chain/database.hpp>
+#include <graphene/net/node.hpp>
 #include <graphene/p2p/peer_connection.hpp>
 
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <map>
+#include <set>
+#include <unordered_map>
 
 namespace graphene { namespace p2p {
    using namespace graphene::chain;
 
    struct node_config
    {
-      fc::ip::endpoint         server_endpoint;
-      bool                     wait_if_not_available = true;
-      uint32_t                 desired_peers;
-      uint32_t                 max_peers;
+      uint32_t                 desired_peers        = GRAPHENE_P2P_DEFAULT_DESIRED_PEERS;
+      uint32_t                 max_peers            = GRAPHENE_P2P_DEFAULT_MAX_PEERS;
+      uint32_t                 max_round_trip_ms    = GRAPHENE_P2P_DEFAULT_MAX_ROUND_TRIP_MS;
       /** receive, but don't rebroadcast data */
-      bool                     subscribe_only = false;
-      public_key_type          node_id;
-      vector<fc::ip::endpoint> seed_nodes;
+      bool                     subscribe_only       = false;
    };
 
-   struct by_remote_endpoint;
-   struct by_peer_id;
- 
-   /**
-    * @ingroup object_index
-    */
-   typedef multi_index_container<
-      peer_connection_ptr,
-      indexed_by<
-         ordered_unique< tag<by_remote_endpoint>, 
-                         const_mem_fun< peer_connection, fc::ip::endpoint, &peer_connection::get_remote_endpoint > >,
-         ordered_unique< tag<by_peer_id>, member< peer_connection, public_key_type, &peer_connection::node_id > >
-      >
-   > peer_connection_index;
+   /** running propagation latency figures for one kind of item */
+   struct latency_stats
+   {
+      uint64_t         count = 0;
+      fc::microseconds total;
+      fc::microseconds max;
 
+      void record( fc::microseconds latency );
+   };
 
-   class node : public std::enable_shared_from_this<node>
+   /**
+    *  @brief network engine implementing the push protocol described in design.md
+    *
+    *  Validated transactions and blocks are pushed to every peer immediately instead of being
+    *  announced and requested, blocks travel as summaries that the receiver rebuilds from the
+    *  transactions it has already seen, and a new peer is caught up by the side that has more
+    *  blocks as soon as the hellos are exchanged.
+    *
+    *  The node derives from graphene::net::node so that application can select it in place of
+    *  the announce/request/send engine; it reuses the same node_delegate.  All of its state is
+    *  owned by the thread that created it, which is the thread the delegate expects to be
+    *  called on.
+    */
+   class node : public graphene::net::node, public peer_connection_delegate
    {
       public:
-         server( chain_database& db );
+         node( const std::string& user_agent, graphene::net::node_delegate* delegate );
+         ~node();
 
-         void add_peer( const fc::ip::endpoint& ep );
          void configure( const node_config& cfg );
 
-         void on_incomming_connection( peer_connection_ptr new_peer );
-         void on_hello( peer_connection_ptr new_peer, hello_message m );
-         void on_transaction( peer_connection_ptr from_peer, transaction_message m );
-         void on_block( peer_connection_ptr from_peer, block_message m );
-         void on_peers( peer_connection_ptr from_peer, peers_message  m );
-         void on_error( peer_connection_ptr from_peer, error_message  m );
-         void on_full_block( peer_connection_ptr from_peer, full_block_message m );
-         void on_update_connections();
+         void      close() override;
+
+         void      add_node( const fc::ip::endpoint& ep ) override;
+         void      connect_to_endpoint( const fc::ip::endpoint& ep ) override;
+         void      listen_on_endpoint( const fc::ip::endpoint& ep, bool wait_if_not_available ) override;
+         void      listen_on_port( uint16_t port, bool wait_if_not_available ) override;
+         void      listen_to_p2p_network() override;
+         void      connect_to_p2p_network() override;
+         fc::ip::endpoint get_actual_listening_endpoint()const override;
+
+         std::vector<graphene::net::peer_status> get_connected_peers()const override;
+         uint32_t  get_connection_count()const override;
+
+         void      broadcast( const graphene::net::message& item_to_broadcast ) override;
+         void      broadcast_transaction( const signed_transaction& trx ) override;
+         /** catch-up is driven by the hello exchange, there is nothing to start here */
+         void      sync_from( const graphene::net::item_id& current_head_block,
+                              const std::vector<uint32_t>& hard_fork_block_numbers ) override {}
+
+         fc::variant_object network_get_info()const override;
+
+         const latency_stats& get_block_latency()const       { return _block_latency; }
+         const latency_stats& get_transaction_latency()const { return _transaction_latency; }
+
+         /// peer_connection_delegate
+         /// @{
+         void on_message( peer_connection* originating_peer, const message& received_message ) override;
+         void on_connection_closed( peer_connection* originating_peer ) override;
+         /// @}
 
       private:
+         void on_hello( const peer_connection_ptr& from_peer, const hello_message& m );
+         void on_hello_reply( const peer_connection_ptr& from_peer, const hello_reply_message& m );
+         void on_transaction( const peer_connection_ptr& from_peer, const transaction_message& m );
+         void on_block_summary( const peer_connection_ptr& from_peer, const block_summary_message& m );
+         void on_full_block( const peer_connection_ptr& from_peer, const full_block_message& m );
+         void on_fetch_block( const peer_connection_ptr& from_peer, const fetch_block_message& m );
+         void on_peers( const peer_connection_ptr& from_peer, const peers_message& m );
+         void on_error( const peer_connection_ptr& from_peer, const error_message& m );
+
+         void accept_loop();
+         void connect_loop( const fc::ip::endpoint& ep );
+         void add_peer( const peer_connection_ptr& new_peer );
+         void send_hello( const peer_connection_ptr& to_peer );
+         void catch_up( peer_connection_ptr new_peer, vector<block_id_type> synopsis );
+         void update_connections_loop();
+         void update_connections();
+
          /**
-          *  Specifies the network interface and port upon which incoming
-          *  connections should be accepted.
+          *  @param rebuilt the block was rebuilt from a summary, if it is rejected it is fetched
+          *  from the peer instead of holding the peer responsible
+          *  @return false if the block was rejected
           */
-         void      listen_on_endpoint( fc::ip::endpoint ep, bool wait_if_not_available );
-         void      accept_loop();
-     
-         graphene::chain::database& _db;
-     
-         fc::tcp_server         _tcp_server;
-         fc::ip::endpoint       _actual_listening_endpoint;
-         fc::future<void>       _accept_loop_complete;
-         peer_connection_index  _peers;
+         bool push_block( const peer_connection_ptr& from_peer, const signed_block& block,
+                          fc::time_point origin_time, bool sync_mode, bool rebuilt = false );
+         void fetch_block( const peer_connection_ptr& from_peer, const block_id_type& id, fc::time_point origin_time );
+         /** only transactions that were accepted or included in a block are cached */
+         void cache_transaction( const signed_transaction& trx, fc::time_point expiration );
+         void relay_block( const signed_block& block, fc::time_point origin_time, peer_connection* except );
+         void relay_transaction( const transaction_message& m, peer_connection* except );
+
+         bool is_connected_to( const fc::ip::endpoint& ep )const;
+
+         struct cached_transaction
+         {
+            signed_transaction  trx;
+            fc::time_point      expiration;
+         };
+
+         struct pending_fetch
+         {
+            fc::time_point      origin_time;
+            fc::time_point      expiration;
+            peer_connection*    peer;
+         };
 
+         fc::thread*                                   _thread;
+         graphene::net::node_delegate*                 _delegate;
+         std::string                                   _user_agent;
+         node_config                                   _config;
+         fc::ecc::private_key                          _node_key;
+
+         fc::tcp_server                                _tcp_server;
+         fc::ip::endpoint                              _listen_endpoint;
+         bool                                          _wait_if_not_available = true;
+         fc::ip::endpoint                              _actual_listening_endpoint;
+         fc::future<void>                              _accept_loop_complete;
+         fc::future<void>                              _update_connections_loop;
+
+         std::set<peer_connection_ptr>                 _peers;
+         std::map<fc::ip::endpoint,fc::future<void>>   _connect_tasks;
+         std::map<peer_connection*,fc::future<void>>   _catch_up_tasks;
+         std::set<fc::ip::endpoint>                    _potential_peers;
+         /** endpoints that failed recently and when to try them again */
+         std::map<fc::ip::endpoint,fc::time_point>     _retry_after;
+
+         std::unordered_map<transaction_id_type,cached_transaction> _transactions;
+         /** blocks requested with fetch_block_message, until they arrive or the request times out */
+         std::map<block_id_type,pending_fetch>         _pending_fetches;
+
+         latency_stats                                 _block_latency;
+         latency_stats                                 _transaction_latency;
+         uint64_t                                      _last_logged_transaction_count = 0;
    };
 
+   typedef std::shared_ptr<node> node_ptr;
+
 } } /// graphene::p2p
+
+FC_REFLECT( graphene::p2p::node_config, (desired_peers)(max_peers)(max_round_trip_ms)(subscribe_only) )
+FC_REFLECT( graphene::p2p::latency_stats, (count)(total)(max) )
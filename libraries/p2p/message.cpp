@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/p2p/message.hpp>
+
+namespace graphene { namespace p2p {
+
+  const core_message_type_enum hello_message::type          = core_message_type_enum::hello_message_type;
+  const core_message_type_enum hello_reply_message::type    = core_message_type_enum::hello_reply_message_type;
+  const core_message_type_enum transaction_message::type    = core_message_type_enum::transaction_message_type;
+  const core_message_type_enum block_summary_message::type  = core_message_type_enum::block_summary_message_type;
+  const core_message_type_enum full_block_message::type     = core_message_type_enum::full_block_message_type;
+  const core_message_type_enum fetch_block_message::type    = core_message_type_enum::fetch_block_message_type;
+  const core_message_type_enum peers_message::type          = core_message_type_enum::peers_message_type;
+  const core_message_type_enum error_message::type          = core_message_type_enum::error_message_type;
+
+} } // graphene::p2p
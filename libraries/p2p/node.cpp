@@ -22,60 +22,121 @@
  * THE SOFTWARE.
  */
 #include <graphene/p2p/node.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/exceptions.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
 
 namespace graphene { namespace p2p {
 
-   node::node( chain_database& db )
-   :_db(db)
+   void latency_stats::record( fc::microseconds latency )
    {
-
+      ++count;
+      total += latency;
+      if( latency > max )
+         max = latency;
    }
 
-   node::~node()
+   node::node( const std::string& user_agent, graphene::net::node_delegate* delegate )
+   :graphene::net::node( user_agent ),
+    _thread( &fc::thread::current() ),
+    _delegate( delegate ),
+    _user_agent( user_agent ),
+    _node_key( fc::ecc::private_key::generate() )
    {
-
+      FC_ASSERT( _delegate != nullptr );
    }
 
-   void node::add_peer( const fc::ip::endpoint& ep )
+   node::~node()
    {
-
+      close();
    }
 
    void node::configure( const node_config& cfg )
    {
-      listen_on_endpoint( cfg.server_endpoint, wait_if_not_available );
-
-      /** don't allow node to go out of scope until accept loop exits */
-      auto self = shared_from_this();
-      _accept_loop_complete = fc::async( [self](){ self->accept_loop(); } )
+      FC_ASSERT( cfg.desired_peers <= cfg.max_peers );
+      _config = cfg;
    }
 
-   void node::accept_loop()
+   void node::close()
    {
-      auto self = shared_from_this();
-      while( !_accept_loop_complete.canceled() )
+      if( !_thread->is_current() )
       {
-         try {
-            auto new_peer = std::make_shared<peer_connection>(self);
-            _tcp_server.accept( new_peer.get_socket() );
-
-            if( _accept_loop_complete.canceled() )
-               return;
+         _thread->async( [=](){ close(); }, "p2p close" ).wait();
+         return;
+      }
 
-            _peers.insert( new_peer );
+      try
+      {
+         _tcp_server.close();
+         if( _accept_loop_complete.valid() )
+            _accept_loop_complete.cancel_and_wait( __FUNCTION__ );
+         if( _update_connections_loop.valid() )
+            _update_connections_loop.cancel_and_wait( __FUNCTION__ );
+         for( auto& task : _connect_tasks )
+            task.second.cancel_and_wait( __FUNCTION__ );
+         for( auto& task : _catch_up_tasks )
+            task.second.cancel_and_wait( __FUNCTION__ );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Exception thrown while shutting down the p2p node, ignoring: ${e}", ("e",e) );
+      }
+      _connect_tasks.clear();
+      _catch_up_tasks.clear();
 
+      for( const peer_connection_ptr& peer : _peers )
+         peer->destroy();
+      _peers.clear();
+   }
 
+   void node::add_node( const fc::ip::endpoint& ep )
+   {
+      if( !_thread->is_current() )
+      {
+         _thread->async( [=](){ add_node( ep ); }, "p2p add_node" ).wait();
+         return;
+      }
+      if( ep != _actual_listening_endpoint )
+         _potential_peers.insert( ep );
+   }
 
-            // limit the rate at which we accept connections to mitigate DOS attacks
-            fc::usleep( fc::milliseconds(10) );
-         } FC_CAPTURE_AND_RETHROW() 
+   void node::connect_to_endpoint( const fc::ip::endpoint& ep )
+   {
+      if( !_thread->is_current() )
+      {
+         _thread->async( [=](){ connect_to_endpoint( ep ); }, "p2p connect_to_endpoint" ).wait();
+         return;
       }
-   } // accept_loop()
+      if( is_connected_to( ep ) )
+         return;
+      _connect_tasks[ep] = fc::async( [=](){ connect_loop( ep ); }, "p2p connect" );
+   }
 
+   void node::listen_on_endpoint( const fc::ip::endpoint& ep, bool wait_if_not_available )
+   {
+      _listen_endpoint = ep;
+      _wait_if_not_available = wait_if_not_available;
+   }
+
+   void node::listen_on_port( uint16_t port, bool wait_if_not_available )
+   {
+      listen_on_endpoint( fc::ip::endpoint( fc::ip::address(), port ), wait_if_not_available );
+   }
 
+   fc::ip::endpoint node::get_actual_listening_endpoint()const
+   {
+      return _actual_listening_endpoint;
+   }
 
-   void node::listen_on_endpoint( fc::ip::endpoint ep, bool wait_if_not_available )
+   void node::listen_to_p2p_network()
    {
+      fc::ip::endpoint ep = _listen_endpoint;
       if( ep.port() != 0 )
       {
         // if the user specified a port, we only want to bind to it if it's not already
@@ -93,7 +154,7 @@ namespace graphene { namespace p2p {
           try
           {
             fc::tcp_server temporary_server;
-            if( listen_endpoint.get_address() != fc::ip::address() )
+            if( ep.get_address() != fc::ip::address() )
               temporary_server.listen( ep );
             else
               temporary_server.listen( ep.port() );
@@ -106,12 +167,12 @@ namespace graphene { namespace p2p {
 
           if (listen_failed)
           {
-            if( wait_if_endpoint_is_busy )
+            if( _wait_if_not_available )
             {
               std::ostringstream error_message_stream;
               if( first )
               {
-                error_message_stream << "Unable to listen for connections on port " 
+                error_message_stream << "Unable to listen for connections on port "
                                      << ep.port()
                                      << ", retrying in a few seconds\n";
                 error_message_stream << "You can wait for it to become available, or restart "
@@ -121,7 +182,7 @@ namespace graphene { namespace p2p {
               }
               else
               {
-                error_message_stream << "\nStill waiting for port " << listen_endpoint.port() << " to become available\n";
+                error_message_stream << "\nStill waiting for port " << ep.port() << " to become available\n";
               }
 
               std::string error_message = error_message_stream.str();
@@ -137,8 +198,7 @@ namespace graphene { namespace p2p {
             }
           } // if (listen_failed)
         } // for(;;)
-      } // if (listen_endpoint.port() != 0)
-
+      } // if (ep.port() != 0)
 
       _tcp_server.set_reuse_address();
       try
@@ -149,16 +209,741 @@ namespace graphene { namespace p2p {
           _tcp_server.listen( ep.port() );
 
         _actual_listening_endpoint = _tcp_server.get_local_endpoint();
-        ilog( "listening for connections on endpoint ${endpoint} (our first choice)",
+        ilog( "listening for connections on endpoint ${endpoint}",
               ( "endpoint", _actual_listening_endpoint ) );
       }
       catch ( fc::exception& e )
       {
-        FC_RETHROW_EXCEPTION( e, error, 
-             "unable to listen on ${endpoint}", ("endpoint",listen_endpoint ) );
+        FC_RETHROW_EXCEPTION( e, error, "unable to listen on ${endpoint}", ("endpoint",ep ) );
+      }
+
+      _accept_loop_complete = fc::async( [=](){ accept_loop(); }, "p2p accept_loop" );
+   }
+
+   void node::connect_to_p2p_network()
+   {
+      update_connections();
+      _update_connections_loop = fc::async( [=](){ update_connections_loop(); }, "p2p update_connections" );
+   }
+
+   void node::accept_loop()
+   {
+      while( !_accept_loop_complete.canceled() )
+      {
+         peer_connection_ptr new_peer = std::make_shared<peer_connection>( this );
+         try
+         {
+            _tcp_server.accept( new_peer->get_socket() );
+         }
+         catch( const fc::canceled_exception& )
+         {
+            throw;
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "p2p accept loop exiting: ${e}", ("e",e.to_string()) );
+            return;
+         }
+
+         try
+         {
+            new_peer->accept();
+            add_peer( new_peer );
+         }
+         catch( const fc::canceled_exception& )
+         {
+            throw;
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "error accepting connection: ${e}", ("e",e.to_string()) );
+         }
+
+         // limit the rate at which we accept connections to mitigate DOS attacks
+         fc::usleep( fc::milliseconds(10) );
+      }
+   } // accept_loop()
+
+   void node::connect_loop( const fc::ip::endpoint& ep )
+   {
+      peer_connection_ptr new_peer = std::make_shared<peer_connection>( this );
+      try
+      {
+         new_peer->connect_to( ep );
+         _retry_after.erase( ep );
+         _potential_peers.insert( ep );
+         add_peer( new_peer );
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const fc::exception& e )
+      {
+         dlog( "unable to connect to ${ep}: ${e}", ("ep",ep)("e",e.to_string()) );
+         _retry_after[ep] = fc::time_point::now() + fc::seconds(30);
+      }
+   }
+
+   void node::add_peer( const peer_connection_ptr& new_peer )
+   {
+      _peers.insert( new_peer );
+      send_hello( new_peer );
+      _delegate->connection_count_changed( get_connection_count() );
+   }
+
+   bool node::is_connected_to( const fc::ip::endpoint& ep )const
+   {
+      auto task = _connect_tasks.find( ep );
+      if( task != _connect_tasks.end() && !task->second.ready() )
+         return true;
+      for( const peer_connection_ptr& peer : _peers )
+      {
+         if( peer->get_remote_endpoint() == ep )
+            return true;
+         fc::optional<fc::ip::endpoint> listening = peer->get_listening_endpoint();
+         if( listening && *listening == ep )
+            return true;
+      }
+      return false;
+   }
+
+   void node::update_connections_loop()
+   {
+      while( !_update_connections_loop.canceled() )
+      {
+         fc::usleep( fc::seconds(GRAPHENE_P2P_UPDATE_CONNECTIONS_INTERVAL_SEC) );
+         update_connections();
+      }
+   }
+
+   void node::update_connections()
+   {
+      auto now = fc::time_point::now();
+
+      for( auto itr = _connect_tasks.begin(); itr != _connect_tasks.end(); )
+      {
+         if( itr->second.ready() )
+            itr = _connect_tasks.erase( itr );
+         else
+            ++itr;
+      }
+
+      for( auto itr = _transactions.begin(); itr != _transactions.end(); )
+      {
+         if( itr->second.expiration < now )
+            itr = _transactions.erase( itr );
+         else
+            ++itr;
+      }
+
+      for( auto itr = _pending_fetches.begin(); itr != _pending_fetches.end(); )
+      {
+         if( itr->second.expiration < now )
+            itr = _pending_fetches.erase( itr );
+         else
+            ++itr;
+      }
+
+      for( const peer_connection_ptr& peer : _peers )
+         peer->rejected_transactions = 0;
+
+      if( _transaction_latency.count != _last_logged_transaction_count )
+      {
+         _last_logged_transaction_count = _transaction_latency.count;
+         ilog( "Transaction propagation latency: ${c} received, average ${a} ms, max ${m} ms",
+               ("c",_transaction_latency.count)
+               ("a",_transaction_latency.total.count() / int64_t(_transaction_latency.count) / 1000)
+               ("m",_transaction_latency.max.count() / 1000) );
+      }
+
+      if( _peers.size() + _connect_tasks.size() >= _config.desired_peers )
+         return;
+
+      vector<fc::ip::endpoint> candidates;
+      for( const fc::ip::endpoint& ep : _potential_peers )
+      {
+         auto retry = _retry_after.find( ep );
+         if( retry != _retry_after.end() && retry->second > now )
+            continue;
+         if( !is_connected_to( ep ) )
+            candidates.push_back( ep );
+      }
+      if( candidates.empty() )
+         return;
+
+      connect_to_endpoint( candidates[ rand() % candidates.size() ] );
+   }
+
+   std::vector<graphene::net::peer_status> node::get_connected_peers()const
+   {
+      if( !_thread->is_current() )
+         return _thread->async( [=](){ return get_connected_peers(); }, "p2p get_connected_peers" ).wait();
+
+      std::vector<graphene::net::peer_status> result;
+      result.reserve( _peers.size() );
+      for( const peer_connection_ptr& peer : _peers )
+      {
+         graphene::net::peer_status status;
+         status.version = peer->core_protocol_version;
+         status.host = peer->get_remote_endpoint();
+         status.info = fc::mutable_variant_object()
+               ("addr", std::string(peer->get_remote_endpoint()))
+               ("inbound", peer->direction == peer_connection::inbound)
+               ("state", peer->state)
+               ("subver", peer->user_agent)
+               ("node_id", peer->node_id)
+               ("round_trip_ms", peer->round_trip_delay.count() / 1000)
+               ("clock_offset_ms", peer->clock_offset.count() / 1000)
+               ("bytessent", peer->get_total_bytes_sent())
+               ("bytesrecv", peer->get_total_bytes_received())
+               ("send_queue", peer->get_send_queue_size());
+         result.push_back( status );
+      }
+      return result;
+   }
+
+   uint32_t node::get_connection_count()const
+   {
+      if( !_thread->is_current() )
+         return _thread->async( [=](){ return get_connection_count(); }, "p2p get_connection_count" ).wait();
+      return _peers.size();
+   }
+
+   fc::variant_object node::network_get_info()const
+   {
+      if( !_thread->is_current() )
+         return _thread->async( [=](){ return network_get_info(); }, "p2p network_get_info" ).wait();
+
+      return fc::mutable_variant_object()
+            ("engine", "push")
+            ("listening_on", _actual_listening_endpoint)
+            ("node_public_key", public_key_type( _node_key.get_public_key() ))
+            ("connection_count", _peers.size())
+            ("potential_peer_count", _potential_peers.size())
+            ("cached_transactions", _transactions.size())
+            ("block_latency", _block_latency)
+            ("transaction_latency", _transaction_latency);
+   }
+
+   void node::broadcast( const graphene::net::message& item_to_broadcast )
+   {
+      if( !_thread->is_current() )
+      {
+         _thread->async( [=](){ broadcast( item_to_broadcast ); }, "p2p broadcast" ).wait();
+         return;
+      }
+
+      if( item_to_broadcast.msg_type == graphene::net::trx_message_type )
+      {
+         broadcast_transaction( item_to_broadcast.as<graphene::net::trx_message>().trx );
+      }
+      else if( item_to_broadcast.msg_type == graphene::net::block_message_type )
+      {
+         signed_block block = item_to_broadcast.as<graphene::net::block_message>().block;
+         auto expiration = fc::time_point::now() + fc::seconds(GRAPHENE_P2P_TRANSACTION_CACHE_SEC);
+         for( const processed_transaction& trx : block.transactions )
+            cache_transaction( trx, expiration );
+         relay_block( block, fc::time_point::now(), nullptr );
+      }
+      else
+         wlog( "the push protocol does not relay messages of type ${t}", ("t",item_to_broadcast.msg_type) );
+   }
+
+   void node::broadcast_transaction( const signed_transaction& trx )
+   {
+      if( !_thread->is_current() )
+      {
+         _thread->async( [=](){ broadcast_transaction( trx ); }, "p2p broadcast_transaction" ).wait();
+         return;
+      }
+
+      transaction_message m;
+      m.trx = trx;
+      m.origin_time = fc::time_point::now();
+      cache_transaction( trx, m.origin_time + fc::seconds(GRAPHENE_P2P_TRANSACTION_CACHE_SEC) );
+      relay_transaction( m, nullptr );
+   }
+
+   void node::cache_transaction( const signed_transaction& trx, fc::time_point expiration )
+   {
+      // the id doesn't cover the signatures, so what we have cached may differ from what a block holds
+      transaction_id_type id = trx.id();
+      auto itr = _transactions.find( id );
+      if( itr != _transactions.end() )
+      {
+         itr->second = cached_transaction{ trx, expiration };
+         return;
+      }
+      if( _transactions.size() >= GRAPHENE_P2P_MAX_CACHED_TRANSACTIONS )
+         return;
+      _transactions.emplace( id, cached_transaction{ trx, expiration } );
+   }
+
+   void node::on_message( peer_connection* originating_peer, const message& received_message )
+   {
+      peer_connection_ptr from_peer = originating_peer->shared_from_this();
+      try
+      {
+         switch( core_message_type_enum( received_message.msg_type ) )
+         {
+            case hello_message_type:
+               on_hello( from_peer, received_message.as<hello_message>() );
+               break;
+            case hello_reply_message_type:
+               on_hello_reply( from_peer, received_message.as<hello_reply_message>() );
+               break;
+            case transaction_message_type:
+               on_transaction( from_peer, received_message.as<transaction_message>() );
+               break;
+            case block_summary_message_type:
+               on_block_summary( from_peer, received_message.as<block_summary_message>() );
+               break;
+            case full_block_message_type:
+               on_full_block( from_peer, received_message.as<full_block_message>() );
+               break;
+            case fetch_block_message_type:
+               on_fetch_block( from_peer, received_message.as<fetch_block_message>() );
+               break;
+            case peers_message_type:
+               on_peers( from_peer, received_message.as<peers_message>() );
+               break;
+            case error_message_type:
+               on_error( from_peer, received_message.as<error_message>() );
+               break;
+            default:
+               FC_THROW( "unknown message type ${t}", ("t",received_message.msg_type) );
+         }
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
       }
+      catch( const fc::exception& e )
+      {
+         wlog( "disconnecting ${ep} after error handling its message: ${e}",
+               ("ep",from_peer->get_remote_endpoint())("e",e.to_detail_string()) );
+         from_peer->close();
+      }
+   }
+
+   void node::on_connection_closed( peer_connection* originating_peer )
+   {
+      peer_connection_ptr closed_peer = originating_peer->shared_from_this();
+      auto task = _catch_up_tasks.find( originating_peer );
+      if( task != _catch_up_tasks.end() )
+      {
+         task->second.cancel( __FUNCTION__ );
+         _catch_up_tasks.erase( task );
+      }
+      if( _peers.erase( closed_peer ) )
+         _delegate->connection_count_changed( get_connection_count() );
+
+      // blocks we were fetching from the peer may be fetched from the next one that announces them
+      for( auto itr = _pending_fetches.begin(); itr != _pending_fetches.end(); )
+      {
+         if( itr->second.peer == originating_peer )
+            itr = _pending_fetches.erase( itr );
+         else
+            ++itr;
+      }
+
+      // the read loop that called us belongs to the peer, release it once that loop has exited
+      fc::async( [closed_peer](){}, "p2p delayed peer deletion" );
+   }
+
+   void node::send_hello( const peer_connection_ptr& to_peer )
+   {
+      hello_message m;
+      m.user_agent      = _user_agent;
+      m.version         = GRAPHENE_P2P_PROTOCOL_VERSION;
+      m.timestamp       = fc::time_point::now();
+      m.inbound_port    = _actual_listening_endpoint.port();
+      m.node_public_key = _node_key.get_public_key();
+      m.chain_id        = _delegate->get_chain_id();
+      m.head_block      = _delegate->get_head_block_id();
+      m.synopsis        = _delegate->get_blockchain_synopsis( graphene::net::item_hash_t(), 0 );
+      to_peer->send( m );
+   }
+
+   void node::on_hello( const peer_connection_ptr& from_peer, const hello_message& m )
+   {
+      FC_ASSERT( from_peer->state == peer_connection::connecting, "duplicate hello" );
+
+      hello_reply_message reply;
+      reply.hello_timestamp = m.timestamp;
+      reply.reply_timestamp = fc::time_point::now();
+      from_peer->send( reply );
+
+      if( m.version != GRAPHENE_P2P_PROTOCOL_VERSION || m.chain_id != _delegate->get_chain_id() )
+      {
+         error_message err;
+         err.message = "incompatible protocol version or chain id";
+         from_peer->send( err );
+         from_peer->close_after_send();
+         return;
+      }
+
+      if( m.node_public_key == public_key_type( _node_key.get_public_key() ) )
+      {
+         dlog( "closing connection to ourselves" );
+         _potential_peers.erase( from_peer->get_remote_endpoint() );
+         from_peer->close();
+         return;
+      }
+      for( const peer_connection_ptr& peer : _peers )
+         if( peer != from_peer && peer->node_id == m.node_public_key )
+         {
+            dlog( "already connected to node ${id}", ("id",m.node_public_key) );
+            from_peer->close();
+            return;
+         }
+
+      from_peer->node_id               = m.node_public_key;
+      from_peer->core_protocol_version = m.version;
+      from_peer->user_agent            = m.user_agent;
+      from_peer->inbound_port          = m.inbound_port;
+
+      if( _peers.size() > _config.max_peers )
+      {
+         peers_message others;
+         for( const peer_connection_ptr& peer : _peers )
+         {
+            fc::optional<fc::ip::endpoint> ep = peer->get_listening_endpoint();
+            if( peer != from_peer && ep )
+               others.peers.push_back( *ep );
+         }
+         from_peer->send( others );
+         from_peer->close_after_send();
+         return;
+      }
+
+      fc::optional<fc::ip::endpoint> listening = from_peer->get_listening_endpoint();
+      if( listening )
+         add_node( *listening );
+
+      from_peer->state = peer_connection::syncing;
+      peer_connection* key = from_peer.get();
+      peer_connection_ptr new_peer = from_peer;
+      vector<block_id_type> synopsis = m.synopsis;
+      _catch_up_tasks[key] = fc::async( [=](){ catch_up( new_peer, synopsis ); }, "p2p catch_up" );
    }
 
+   /**
+    *  Pushes every block the peer is missing according to its synopsis, in batches so that the send
+    *  queue never holds more than a few blocks, then starts relaying live items to it.
+    */
+   void node::catch_up( peer_connection_ptr new_peer, vector<block_id_type> synopsis )
+   {
+      try
+      {
+         uint32_t remaining = 0;
+         do
+         {
+            vector<block_id_type> ids = _delegate->get_block_ids( synopsis, remaining, GRAPHENE_P2P_CATCH_UP_BATCH );
+            // the first id returned is the last block we have in common
+            bool skip_first = !ids.empty() && std::find( synopsis.begin(), synopsis.end(), ids.front() ) != synopsis.end();
+            for( size_t i = skip_first ? 1 : 0; i < ids.size(); ++i )
+            {
+               while( new_peer->get_send_queue_size() > 16 )
+                  fc::usleep( fc::milliseconds(10) );
+               if( !_peers.count( new_peer ) )
+                  return;
+
+               graphene::net::message item = _delegate->get_item( graphene::net::item_id( graphene::net::block_message_type, ids[i] ) );
+               full_block_message full;
+               full.block = item.as<graphene::net::block_message>().block;
+               new_peer->mark_item_known( ids[i] );
+               new_peer->send( full );
+            }
+            if( ids.empty() )
+               break;
+            synopsis = vector<block_id_type>{ ids.back() };
+         } while( remaining > 0 );
+      }
+      catch( const graphene::net::peer_is_on_an_unreachable_fork& )
+      {
+         wlog( "peer ${ep} is on a fork we cannot provide blocks for", ("ep",new_peer->get_remote_endpoint()) );
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "unable to catch up ${ep}: ${e}", ("ep",new_peer->get_remote_endpoint())("e",e.to_string()) );
+         new_peer->close();
+         return;
+      }
+
+      new_peer->state = peer_connection::synced;
+
+      fc::optional<fc::ip::endpoint> listening = new_peer->get_listening_endpoint();
+      if( listening && !_config.subscribe_only )
+      {
+         peers_message announce;
+         announce.peers.push_back( *listening );
+         for( const peer_connection_ptr& peer : _peers )
+            if( peer != new_peer && peer->state == peer_connection::synced )
+               peer->send( announce );
+      }
+   }
+
+   void node::on_hello_reply( const peer_connection_ptr& from_peer, const hello_reply_message& m )
+   {
+      auto now = fc::time_point::now();
+      from_peer->round_trip_delay = now - m.hello_timestamp;
+      from_peer->clock_offset     = m.reply_timestamp - (m.hello_timestamp + fc::microseconds(from_peer->round_trip_delay.count() / 2));
+      from_peer->latency_measured = true;
+
+      if( from_peer->round_trip_delay > fc::milliseconds(_config.max_round_trip_ms) &&
+          _peers.size() > _config.desired_peers )
+      {
+         wlog( "disconnecting ${ep}, round trip of ${rt} ms is too slow",
+               ("ep",from_peer->get_remote_endpoint())("rt",from_peer->round_trip_delay.count() / 1000) );
+         from_peer->close();
+      }
+   }
+
+   void node::on_transaction( const peer_connection_ptr& from_peer, const transaction_message& m )
+   {
+      transaction_id_type id = m.trx.id();
+      from_peer->mark_item_known( id );
+
+      if( _transactions.count( id ) ||
+          _delegate->has_item( graphene::net::item_id( graphene::net::trx_message_type, id ) ) )
+         return;
+
+      try
+      {
+         _delegate->handle_transaction( graphene::net::trx_message( m.trx ) );
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const fc::exception& e )
+      {
+         // not cached, a block that includes it anyway is fetched in full
+         dlog( "rejected transaction ${id}: ${e}", ("id",id)("e",e.to_string()) );
+         if( ++from_peer->rejected_transactions > GRAPHENE_P2P_MAX_REJECTED_TRANSACTIONS )
+         {
+            wlog( "disconnecting ${ep}, it sent more than ${n} rejected transactions",
+                  ("ep",from_peer->get_remote_endpoint())("n",GRAPHENE_P2P_MAX_REJECTED_TRANSACTIONS) );
+            auto ep = from_peer->get_listening_endpoint();
+            if( ep )
+               _retry_after[*ep] = fc::time_point::now() + fc::seconds(GRAPHENE_P2P_TRANSACTION_CACHE_SEC);
+            from_peer->close();
+         }
+         return;
+      }
+
+      cache_transaction( m.trx, fc::time_point::now() + fc::seconds(GRAPHENE_P2P_TRANSACTION_CACHE_SEC) );
+
+      if( m.origin_time != fc::time_point() )
+         _transaction_latency.record( fc::time_point::now() - m.origin_time );
 
+      relay_transaction( m, from_peer.get() );
+   }
+
+   void node::relay_transaction( const transaction_message& m, peer_connection* except )
+   {
+      if( _config.subscribe_only && except != nullptr )
+         return;
+
+      transaction_id_type id = m.trx.id();
+      message packed( m );
+      for( const peer_connection_ptr& peer : _peers )
+      {
+         if( peer.get() == except || peer->state != peer_connection::synced || peer->knows_item( id ) )
+            continue;
+         peer->mark_item_known( id );
+         peer->send( packed );
+      }
+   }
+
+   void node::on_block_summary( const peer_connection_ptr& from_peer, const block_summary_message& m )
+   {
+      block_id_type id = m.header.id();
+      from_peer->mark_item_known( id );
+      for( const transaction_id_type& trx_id : m.transaction_ids )
+         from_peer->mark_item_known( trx_id );
+
+      if( _delegate->has_item( graphene::net::item_id( graphene::net::block_message_type, id ) ) )
+         return;
+
+      FC_ASSERT( m.transaction_ids.size() == m.operation_results.size() );
+
+      signed_block block;
+      static_cast<signed_block_header&>( block ) = m.header;
+      block.transactions.reserve( m.transaction_ids.size() );
+      for( size_t i = 0; i < m.transaction_ids.size(); ++i )
+      {
+         auto cached = _transactions.find( m.transaction_ids[i] );
+         if( cached == _transactions.end() )
+         {
+            // we haven't seen every transaction, fall back to fetching the whole block
+            fetch_block( from_peer, id, m.origin_time );
+            return;
+         }
+         block.transactions.emplace_back( cached->second.trx );
+         block.transactions.back().operation_results = m.operation_results[i];
+      }
+
+      if( push_block( from_peer, block, m.origin_time, false, true ) )
+         relay_block( block, m.origin_time, from_peer.get() );
+   }
+
+   void node::fetch_block( const peer_connection_ptr& from_peer, const block_id_type& id, fc::time_point origin_time )
+   {
+      pending_fetch fetch{ origin_time, fc::time_point::now() + fc::seconds(GRAPHENE_P2P_FETCH_TIMEOUT_SEC), from_peer.get() };
+      if( !_pending_fetches.emplace( id, fetch ).second )
+         return;
+      fetch_block_message m;
+      m.block_id = id;
+      from_peer->send( m );
+   }
+
+   void node::on_full_block( const peer_connection_ptr& from_peer, const full_block_message& m )
+   {
+      block_id_type id = m.block.id();
+      from_peer->mark_item_known( id );
+      for( const processed_transaction& trx : m.block.transactions )
+         from_peer->mark_item_known( trx.id() );
+
+      fc::time_point origin_time;
+      auto pending = _pending_fetches.find( id );
+      if( pending != _pending_fetches.end() )
+      {
+         origin_time = pending->second.origin_time;
+         _pending_fetches.erase( pending );
+      }
+
+      if( _delegate->has_item( graphene::net::item_id( graphene::net::block_message_type, id ) ) )
+         return;
+
+      // blocks sent during catch up are old, the ones we fetched to complete a summary are live
+      bool sync_mode = origin_time == fc::time_point() &&
+                       fc::time_point::now() - fc::time_point( m.block.timestamp )
+                          > fc::seconds( 2 * _delegate->get_current_block_interval_in_seconds() );
+
+      if( !push_block( from_peer, m.block, origin_time, sync_mode ) )
+         return;
+
+      // replaces cached copies with other signatures that a summary of this block can't be rebuilt from
+      auto expiration = fc::time_point::now() + fc::seconds(GRAPHENE_P2P_TRANSACTION_CACHE_SEC);
+      for( const processed_transaction& trx : m.block.transactions )
+         cache_transaction( trx, expiration );
+
+      if( !sync_mode )
+         relay_block( m.block, origin_time, from_peer.get() );
+   }
+
+   void node::on_fetch_block( const peer_connection_ptr& from_peer, const fetch_block_message& m )
+   {
+      graphene::net::item_id item( graphene::net::block_message_type, m.block_id );
+      if( !_delegate->has_item( item ) )
+      {
+         error_message err;
+         err.message = "unknown block";
+         from_peer->send( err );
+         return;
+      }
+      full_block_message full;
+      full.block = _delegate->get_item( item ).as<graphene::net::block_message>().block;
+      from_peer->send( full );
+   }
+
+   bool node::push_block( const peer_connection_ptr& from_peer, const signed_block& block,
+                          fc::time_point origin_time, bool sync_mode, bool rebuilt )
+   {
+      try
+      {
+         std::vector<fc::uint160_t> contained_transaction_message_ids;
+         _delegate->handle_block( graphene::net::block_message( block ), sync_mode, contained_transaction_message_ids );
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const graphene::net::unlinkable_block_exception& e )
+      {
+         // we are missing its parent, the peer will catch us up on reconnect; not its fault
+         wlog( "unable to link block ${n} from ${ep}", ("n",block.block_num())("ep",from_peer->get_remote_endpoint()) );
+         return false;
+      }
+      catch( const fc::exception& e )
+      {
+         if( rebuilt )
+         {
+            // our cached copy of one of its transactions may carry other signatures than the block's
+            dlog( "block ${n} rebuilt from the summary of ${ep} was rejected, fetching it: ${e}",
+                  ("n",block.block_num())("ep",from_peer->get_remote_endpoint())("e",e.to_string()) );
+            fetch_block( from_peer, block.id(), origin_time );
+            return false;
+         }
+         wlog( "disconnecting ${ep} after it sent an invalid block: ${e}",
+               ("ep",from_peer->get_remote_endpoint())("e",e.to_string()) );
+         from_peer->close();
+         return false;
+      }
+
+      if( !sync_mode && origin_time != fc::time_point() )
+      {
+         fc::microseconds latency = fc::time_point::now() - origin_time;
+         _block_latency.record( latency );
+         ilog( "Pushed block #${n} propagation latency: ${l} ms", ("n",block.block_num())("l",latency.count() / 1000) );
+      }
+      return true;
+   }
+
+   void node::relay_block( const signed_block& block, fc::time_point origin_time, peer_connection* except )
+   {
+      if( _config.subscribe_only && except != nullptr )
+         return;
+
+      block_id_type id = block.id();
+      block_summary_message summary;
+      summary.header = block;
+      summary.origin_time = origin_time;
+      summary.transaction_ids.reserve( block.transactions.size() );
+      summary.operation_results.reserve( block.transactions.size() );
+      for( const processed_transaction& trx : block.transactions )
+      {
+         summary.transaction_ids.push_back( trx.id() );
+         summary.operation_results.push_back( trx.operation_results );
+      }
+      message packed( summary );
+
+      for( const peer_connection_ptr& peer : _peers )
+      {
+         if( peer.get() == except || peer->state != peer_connection::synced || peer->knows_item( id ) )
+            continue;
+
+         // push the transactions the peer hasn't seen first so that it never has to fetch the block
+         for( size_t i = 0; i < block.transactions.size(); ++i )
+         {
+            if( peer->knows_item( summary.transaction_ids[i] ) )
+               continue;
+            transaction_message trx;
+            trx.trx = block.transactions[i];
+            peer->mark_item_known( summary.transaction_ids[i] );
+            peer->send( trx );
+         }
+         peer->mark_item_known( id );
+         peer->send( packed );
+      }
+   }
+
+   void node::on_peers( const peer_connection_ptr& from_peer, const peers_message& m )
+   {
+      for( const fc::ip::endpoint& ep : m.peers )
+         add_node( ep );
+   }
+
+   void node::on_error( const peer_connection_ptr& from_peer, const error_message& m )
+   {
+      wlog( "peer ${ep} reported an error: ${e}", ("ep",from_peer->get_remote_endpoint())("e",m.message) );
+   }
 
-} }
+} } // graphene::p2p
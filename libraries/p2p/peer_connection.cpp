@@ -23,8 +23,171 @@
  */
 #include <graphene/p2p/peer_connection.hpp>
 
+#include <fc/thread/thread.hpp>
+#include <fc/log/logger.hpp>
+
 namespace graphene { namespace p2p {
 
-} } //graphene::p2p
+   peer_connection::peer_connection( peer_connection_delegate* delegate )
+   :connection_initiation_time( fc::time_point::now() ),
+    _node( delegate ),
+    _message_connection( this )
+   {
+   }
+
+   peer_connection::~peer_connection()
+   {
+      destroy();
+   }
+
+   void peer_connection::destroy()
+   {
+      _node = nullptr;
+      _closed = true;
+      _send_queue.clear();
+      try
+      {
+         _send_queue_complete.cancel_and_wait( __FUNCTION__ );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Exception thrown while canceling the send queue, ignoring: ${e}", ("e",e) );
+      }
+      catch( ... )
+      {
+         wlog( "Exception thrown while canceling the send queue, ignoring" );
+      }
+      _message_connection.destroy_connection();
+   }
+
+   void peer_connection::accept()
+   {
+      direction = inbound;
+      _message_connection.accept();
+      _remote_endpoint = get_socket().remote_endpoint();
+   }
+
+   void peer_connection::connect_to( const fc::ip::endpoint& remote_endpoint )
+   {
+      direction = outbound;
+      _remote_endpoint = remote_endpoint;
+      _message_connection.connect_to( remote_endpoint );
+   }
+
+   void peer_connection::send( const message& message_to_send )
+   {
+      if( _closed || _close_after_send )
+         return;
+
+      queued_message queued;
+      queued.msg = message_to_send;
+      queued.enqueue_time = fc::time_point::now();
+      _send_queue.push_back( std::move(queued) );
+
+      if( get_send_backlog() > fc::seconds(GRAPHENE_P2P_MAX_SEND_BACKLOG_SEC) )
+      {
+         wlog( "peer ${ep} is ${n} messages behind, disconnecting", ("ep",_remote_endpoint)("n",_send_queue.size()) );
+         close();
+         return;
+      }
+
+      if( !_send_queue_complete.valid() || _send_queue_complete.ready() )
+      {
+         auto self = shared_from_this();
+         _send_queue_complete = fc::async( [self](){ self->process_send_queue(); }, "peer send queue" );
+      }
+   }
 
+   void peer_connection::process_send_queue()
+   {
+      try
+      {
+         while( !_send_queue.empty() )
+         {
+            _message_connection.send_message( _send_queue.front().msg );
+            _send_queue.pop_front();
+         }
+         if( _close_after_send )
+            close();
+      }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "error sending to peer ${ep}: ${e}", ("ep",_remote_endpoint)("e",e.to_string()) );
+         close();
+      }
+   }
 
+   void peer_connection::close_after_send()
+   {
+      _close_after_send = true;
+      if( !_send_queue_complete.valid() || _send_queue_complete.ready() )
+         close();
+   }
+
+   void peer_connection::close()
+   {
+      if( _closed )
+         return;
+      _closed = true;
+      _send_queue.clear();
+      _message_connection.close_connection();
+   }
+
+   fc::microseconds peer_connection::get_send_backlog()const
+   {
+      if( _send_queue.empty() )
+         return fc::microseconds();
+      return fc::time_point::now() - _send_queue.front().enqueue_time;
+   }
+
+   bool peer_connection::knows_item( const fc::ripemd160& id )const
+   {
+      return _known_items.find( id ) != _known_items.end();
+   }
+
+   void peer_connection::mark_item_known( const fc::ripemd160& id )
+   {
+      if( !_known_items.insert( id ).second )
+         return;
+      _known_items_order.push_back( id );
+      while( _known_items_order.size() > GRAPHENE_P2P_PEER_KNOWN_ITEMS )
+      {
+         _known_items.erase( _known_items_order.front() );
+         _known_items_order.pop_front();
+      }
+   }
+
+   fc::ip::endpoint peer_connection::get_remote_endpoint()const
+   {
+      return _remote_endpoint ? *_remote_endpoint : fc::ip::endpoint();
+   }
+
+   fc::optional<fc::ip::endpoint> peer_connection::get_listening_endpoint()const
+   {
+      fc::optional<fc::ip::endpoint> result;
+      if( direction == outbound )
+         result = _remote_endpoint;
+      else if( inbound_port != 0 && _remote_endpoint )
+         result = fc::ip::endpoint( _remote_endpoint->get_address(), inbound_port );
+      return result;
+   }
+
+   void peer_connection::on_message( message_oriented_connection* originating_connection,
+                                     const message& received_message )
+   {
+      if( _node )
+         _node->on_message( this, received_message );
+   }
+
+   void peer_connection::on_connection_closed( message_oriented_connection* originating_connection )
+   {
+      _closed = true;
+      if( _node )
+         _node->on_connection_closed( this );
+   }
+
+} } //graphene::p2p
@@ -34,6 +34,8 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/transaction_evaluation_state.hpp>
 
+#include <graphene/db/disk_index.hpp>
+
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/thread.hpp>
 
@@ -177,6 +179,8 @@ void account_history_plugin::plugin_set_program_options(
 {
    cli.add_options()
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
+         ("operation-history-store", boost::program_options::value<std::string>()->default_value("memory"), "Where to keep operation history objects: memory or disk")
+         ("operation-history-cache-size", boost::program_options::value<uint32_t>()->default_value(100000), "Number of operation history objects cached in RAM when operation-history-store is disk")
          ;
    cfg.add(cli);
 }
@@ -184,7 +188,16 @@ void account_history_plugin::plugin_set_program_options(
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
-   database().add_index< primary_index< simple_index< operation_history_object > > >();
+   const std::string store = options.count("operation-history-store") ? options["operation-history-store"].as<std::string>() : std::string("memory");
+   FC_ASSERT( store == "memory" || store == "disk", "operation-history-store must be memory or disk", ("store",store) );
+   if( store == "disk" )
+   {
+      auto idx = database().add_index< primary_index< disk_index< operation_history_object > > >();
+      if( options.count("operation-history-cache-size") )
+         idx->set_cache_size( options["operation-history-cache-size"].as<uint32_t>() );
+   }
+   else
+      database().add_index< primary_index< simple_index< operation_history_object > > >();
    database().add_index< primary_index< account_transaction_history_index > >();
 
    LOAD_VALUE_SET(options, "tracked-accounts", my->_tracked_accounts, graphene::chain::account_id_type);
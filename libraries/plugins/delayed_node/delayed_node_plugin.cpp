@@ -25,29 +25,85 @@
 #include <graphene/delayed_node/delayed_node_plugin.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/witness_object.hpp>
 #include <graphene/app/api.hpp>
 
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <deque>
+#include <thread>
 
 
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
 
 namespace detail {
+
+/// Number of blocks requested from the trusted node per get_blocks call
+static const uint32_t sync_batch_size = 50;
+/// Number of get_blocks calls kept outstanding while catching up
+static const uint32_t sync_batches_in_flight = 8;
+
+/**
+ * A range of blocks fetched from the trusted node.  Each block's merkle root and signature are checked on one of the
+ * validation threads as soon as the batch arrives; the recovered signing keys are compared against the witness
+ * schedule when the block is applied.
+ */
+struct fetched_batch
+{
+   std::shared_ptr<const std::vector<graphene::chain::signed_block>> blocks;
+   std::vector<fc::future<graphene::chain::public_key_type>>        signees;
+};
+
 struct delayed_node_plugin_impl {
    std::string remote_endpoint;
    fc::http::websocket_client client;
    std::shared_ptr<fc::rpc::websocket_api_connection> client_connection;
    fc::api<graphene::app::database_api> database_api;
    boost::signals2::scoped_connection client_connection_closed;
-   graphene::chain::block_id_type last_received_remote_head;
-   graphene::chain::block_id_type last_processed_remote_head;
+
+   std::vector<std::shared_ptr<fc::thread>> validation_threads;
+   uint32_t next_validation_thread = 0;
+
+   fc::future<void> sync_task;
+   bool sync_requested = false;
+
+   fc::future<fetched_batch> fetch_batch( uint32_t block_num_from, uint32_t count );
 };
+
+fc::future<fetched_batch> delayed_node_plugin_impl::fetch_batch( uint32_t block_num_from, uint32_t count )
+{
+   auto api = database_api;
+   return fc::async( [this, api, block_num_from, count]() -> fetched_batch
+   {
+      fetched_batch batch;
+      batch.blocks = std::make_shared<const std::vector<graphene::chain::signed_block>>( api->get_blocks( block_num_from, count ) );
+      FC_ASSERT( batch.blocks->size() == count, "Trusted node claims it has blocks it doesn't actually have.",
+                 ("from", block_num_from)("requested", count)("received", batch.blocks->size()) );
+
+      auto blocks = batch.blocks;
+      batch.signees.reserve( count );
+      for( size_t i = 0; i < blocks->size(); ++i )
+      {
+         auto& thread = validation_threads[ next_validation_thread++ % validation_threads.size() ];
+         batch.signees.emplace_back( thread->async( [blocks, i]() -> graphene::chain::public_key_type
+         {
+            const graphene::chain::signed_block& block = (*blocks)[i];
+            FC_ASSERT( block.transaction_merkle_root == block.calculate_merkle_root(), "Invalid merkle root",
+                       ("block_num", block.block_num()) );
+            return block.signee();
+         }, "delayed_node validate block" ) );
+      }
+      return batch;
+   }, "delayed_node fetch blocks" );
 }
 
+} // detail
+
 delayed_node_plugin::delayed_node_plugin()
    : my(new detail::delayed_node_plugin_impl)
 {}
@@ -70,6 +126,12 @@ void delayed_node_plugin::connect()
    my->client_connection_closed = my->client_connection->closed.connect([this] {
       connection_failed();
    });
+   my->database_api->set_block_applied_callback([this]( const fc::variant& block_id )
+   {
+      schedule_sync();
+   } );
+   // catch up with whatever the trusted node already has rather than waiting for its next block
+   schedule_sync();
 }
 
 void delayed_node_plugin::plugin_initialize(const boost::program_options::variables_map& options)
@@ -79,15 +141,18 @@ void delayed_node_plugin::plugin_initialize(const boost::program_options::variab
 
 void delayed_node_plugin::sync_with_trusted_node()
 {
+   using graphene::chain::database;
+
    auto& db = database();
    uint32_t synced_blocks = 0;
    uint32_t pass_count = 0;
    while( true )
    {
       graphene::chain::dynamic_global_property_object remote_dpo = my->database_api->get_dynamic_global_properties();
-      if( remote_dpo.last_irreversible_block_num <= db.head_block_num() )
+      const uint32_t remote_lib = remote_dpo.last_irreversible_block_num;
+      if( remote_lib <= db.head_block_num() )
       {
-         if( remote_dpo.last_irreversible_block_num < db.head_block_num() )
+         if( remote_lib < db.head_block_num() )
          {
             wlog( "Trusted node seems to be behind delayed node" );
          }
@@ -98,52 +163,79 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
-      while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
+
+      // Keep several batches outstanding so that the round trips to the trusted node overlap with validation and
+      // with applying the blocks we already have.  Batches are consumed strictly in order.
+      std::deque<fc::future<detail::fetched_batch>> in_flight;
+      uint32_t next_to_request = db.head_block_num() + 1;
+      auto fill_pipeline = [&]()
+      {
+         while( in_flight.size() < detail::sync_batches_in_flight && next_to_request <= remote_lib )
+         {
+            uint32_t count = std::min( detail::sync_batch_size, remote_lib - next_to_request + 1 );
+            in_flight.push_back( my->fetch_batch( next_to_request, count ) );
+            next_to_request += count;
+         }
+      };
+
+      fill_pipeline();
+      while( !in_flight.empty() )
       {
-         fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
-         FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
-         ilog("Pushing block #${n}", ("n", block->block_num()));
-         db.push_block(*block);
-         synced_blocks++;
+         detail::fetched_batch batch = in_flight.front().wait();
+         in_flight.pop_front();
+         fill_pipeline();
+
+         for( size_t i = 0; i < batch.blocks->size(); ++i )
+         {
+            const graphene::chain::signed_block& block = (*batch.blocks)[i];
+            FC_ASSERT( block.block_num() == db.head_block_num() + 1, "Trusted node returned an unexpected block",
+                       ("expected", db.head_block_num() + 1)("got", block.block_num()) );
+            // signature recovery has already been done on a validation thread, only the key comparison is left
+            graphene::chain::public_key_type signee = batch.signees[i].wait();
+            FC_ASSERT( block.witness(db).signing_key == signee, "Block is not signed by the scheduled witness",
+                       ("block_num", block.block_num())("signee", signee) );
+            db.push_block( block, database::skip_witness_signature | database::skip_merkle_check );
+            synced_blocks++;
+         }
+         ilog( "Pushed blocks #${a} through #${b}", ("a", batch.blocks->front().block_num())("b", db.head_block_num()) );
       }
    }
 }
 
-void delayed_node_plugin::mainloop()
+void delayed_node_plugin::schedule_sync()
 {
-   while( true )
+   if( my->sync_task.valid() && !my->sync_task.ready() )
    {
-      try
-      {
-         fc::usleep( fc::microseconds( 296645 ) );  // wake up a little over 3Hz
-
-         if( my->last_received_remote_head == my->last_processed_remote_head )
-            continue;
-
-         sync_with_trusted_node();
-         my->last_processed_remote_head = my->last_received_remote_head;
-      }
-      catch( const fc::exception& e )
-      {
-         elog("Error during connection: ${e}", ("e", e.to_detail_string()));
-      }
+      // the running sync re-checks the trusted node once it is done with the current range
+      my->sync_requested = true;
+      return;
    }
+   my->sync_task = fc::async( [this]()
+   {
+      do
+      {
+         my->sync_requested = false;
+         try
+         {
+            sync_with_trusted_node();
+         }
+         catch( const fc::exception& e )
+         {
+            elog("Error during connection: ${e}", ("e", e.to_detail_string()));
+         }
+      } while( my->sync_requested );
+   }, "delayed_node sync" );
 }
 
 void delayed_node_plugin::plugin_startup()
 {
-   fc::async([this]()
-   {
-      mainloop();
-   });
+   uint32_t thread_count = std::max( 1u, std::min( 4u, std::thread::hardware_concurrency() ) );
+   for( uint32_t i = 0; i < thread_count; ++i )
+      my->validation_threads.push_back( std::make_shared<fc::thread>( "delayed_node_validation" ) );
 
    try
    {
       connect();
-      my->database_api->set_block_applied_callback([this]( const fc::variant& block_id )
-      {
-         fc::from_variant( block_id, my->last_received_remote_head );
-      } );
       return;
    }
    catch (const fc::exception& e)
@@ -40,12 +40,13 @@ public:
                                            boost::program_options::options_description& cfg) override;
    virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
    virtual void plugin_startup() override;
-   void mainloop();
 
 protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// Start a sync pass, or ask the running one to look again once it is done
+   void schedule_sync();
 };
 
 } } //graphene::account_history
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/history_export/history_export_plugin.hpp>
+
+#include <graphene/app/block_event_stream.hpp>
+#include <graphene/app/impacted.hpp>
+
+#include <graphene/chain/account_evaluator.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace graphene { namespace history_export {
+
+namespace detail
+{
+
+/// The unqualified name of an operation type, used as the table name
+struct operation_name_visitor
+{
+   typedef std::string result_type;
+
+   template<typename Op>
+   std::string operator()( const Op& )const
+   {
+      std::string name = fc::get_typename<Op>::name();
+      auto pos = name.rfind( "::" );
+      return pos == std::string::npos ? name : name.substr( pos + 2 );
+   }
+};
+
+struct operation_fee_visitor
+{
+   typedef asset result_type;
+
+   template<typename Op>
+   asset operator()( const Op& op )const { return op.fee; }
+};
+
+/// The amount field of operations which have one, such as transfers; a null asset for the others
+struct operation_amount_visitor
+{
+   typedef asset result_type;
+
+   template<typename Op>
+   asset operator()( const Op& op )const { return get( op, 0 ); }
+
+private:
+   template<typename Op>
+   static typename std::enable_if< std::is_same< decltype( Op::amount ), asset >::value, asset >::type
+   get( const Op& op, int ) { return op.amount; }
+
+   template<typename Op>
+   static asset get( const Op&, long ) { return asset(); }
+};
+
+/// State of one table, only ever touched on the event stream thread
+struct export_table
+{
+   std::string name;
+   uint32_t    segment = 0;
+   row_group   rows;
+};
+
+class history_export_plugin_impl
+{
+   public:
+      history_export_plugin_impl(history_export_plugin& _plugin)
+         : _self( _plugin )
+      { }
+      virtual ~history_export_plugin_impl();
+
+      /** called on the event stream thread for every irreversible block, appends its operations to the tables */
+      void on_irreversible_block( const graphene::app::applied_block_event& e );
+      void append_row( const graphene::app::applied_block_event& e, const operation_history_object& oho );
+      void flush_table( export_table& table );
+      void flush_all();
+
+      /** flushes every table and records _last_block as exported */
+      void write_checkpoint();
+      void store_checkpoint( uint32_t block_num );
+      /** reads the checkpoint and drops row groups written after it, so that a restart neither repeats nor loses rows */
+      void recover();
+      void truncate_segment( const fc::path& file );
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      history_export_plugin&     _self;
+      fc::path                   _export_dir;
+      uint32_t                   _segment_blocks = 100000;
+      uint32_t                   _row_group_size = 10000;
+      /** the last block whose operations are all on disk, as recorded in the checkpoint */
+      uint32_t                   _exported_block = 0;
+      /** the last block appended to the tables */
+      uint32_t                   _last_block = 0;
+
+      std::shared_ptr<graphene::app::event_subscription> _subscription;
+
+      std::map<int, export_table> _tables;
+};
+
+history_export_plugin_impl::~history_export_plugin_impl()
+{
+   // the queued blocks still append to the tables, so they must be processed before the tables go away
+   _subscription.reset();
+}
+
+void history_export_plugin_impl::on_irreversible_block( const graphene::app::applied_block_event& e )
+{ try {
+   const uint32_t block_num = e.block_num();
+   // blocks delivered again by a replay are already in the tables
+   if( block_num <= _exported_block )
+      return;
+   if( _last_block == 0 && _exported_block > 0 && block_num > _exported_block + 1 )
+      elog( "Operations of blocks ${f} to ${t} were not exported before the last restart, replay the blockchain to export them",
+            ("f", _exported_block + 1)("t", block_num - 1) );
+
+   for( const operation_history_object& oho : e.operations )
+      append_row( e, oho );
+   _last_block = block_num;
+
+   if( block_num % _segment_blocks == 0 )
+      write_checkpoint();
+} FC_CAPTURE_AND_RETHROW( (e.block_num()) ) }
+
+void history_export_plugin_impl::append_row( const graphene::app::applied_block_event& e, const operation_history_object& oho )
+{
+   const uint32_t block_num = e.block_num();
+   auto itr = _tables.find( oho.op.which() );
+   if( itr == _tables.end() )
+   {
+      itr = _tables.emplace( oho.op.which(), export_table() ).first;
+      itr->second.name = oho.op.visit( operation_name_visitor() );
+   }
+   export_table& table = itr->second;
+
+   const uint32_t segment = ( block_num - 1 ) / _segment_blocks;
+   if( table.rows.size() > 0 && segment != table.segment )
+      flush_table( table );
+   table.segment = segment;
+
+   flat_set<account_id_type> accounts;
+   vector<authority> other;
+   operation_get_required_authorities( oho.op, accounts, accounts, other );
+   if( oho.op.which() == operation::tag< account_create_operation >::value )
+      accounts.insert( oho.result.get<object_id_type>() );
+   else
+      graphene::app::operation_get_impacted_accounts( oho.op, accounts );
+   for( auto& a : other )
+      for( auto& item : a.account_auths )
+         accounts.insert( item.first );
+
+   const asset fee = oho.op.visit( operation_fee_visitor() );
+   const asset amount = oho.op.visit( operation_amount_visitor() );
+   row_group& g = table.rows;
+   g.block_num.push_back( block_num );
+   g.trx_in_block.push_back( oho.trx_in_block );
+   g.op_in_trx.push_back( oho.op_in_trx );
+   g.virtual_op.push_back( oho.virtual_op );
+   g.timestamp.push_back( e.block->timestamp.sec_since_epoch() );
+   g.accounts.push_back( std::move( accounts ) );
+   g.fee_asset.push_back( fee.asset_id );
+   g.fee_amount.push_back( fee.amount );
+   g.amount_asset.push_back( amount.asset_id );
+   g.amount.push_back( amount.amount );
+   g.op.push_back( fc::raw::pack( oho.op ) );
+
+   if( g.size() >= _row_group_size )
+      flush_table( table );
+}
+
+void history_export_plugin_impl::flush_table( export_table& table )
+{
+   if( table.rows.size() == 0 )
+      return;
+
+   fc::path dir = _export_dir / table.name;
+   fc::create_directories( dir );
+   std::ostringstream file_name;
+   file_name << std::setw(10) << std::setfill('0') << ( table.segment * _segment_blocks + 1 ) << ".cols";
+
+   const vector<char> data = fc::raw::pack( table.rows );
+   const uint32_t length = data.size();
+   std::ofstream out( ( dir / file_name.str() ).generic_string().c_str(), std::ios::binary | std::ios::app );
+   out.write( (const char*)&length, sizeof(length) );
+   out.write( data.data(), data.size() );
+   FC_ASSERT( out.good(), "Unable to write to ${f}", ("f", ( dir / file_name.str() ).generic_string()) );
+
+   table.rows = row_group();
+}
+
+void history_export_plugin_impl::flush_all()
+{
+   for( auto& item : _tables )
+      flush_table( item.second );
+}
+
+void history_export_plugin_impl::write_checkpoint()
+{
+   flush_all();
+   if( _last_block > _exported_block )
+      store_checkpoint( _last_block );
+}
+
+void history_export_plugin_impl::store_checkpoint( uint32_t block_num )
+{
+   fc::create_directories( _export_dir );
+   const fc::path tmp = _export_dir / "last_block.tmp";
+   {
+      std::ofstream out( tmp.generic_string().c_str(), std::ios::binary | std::ios::trunc );
+      out.write( (const char*)&block_num, sizeof(block_num) );
+      FC_ASSERT( out.good(), "Unable to write to ${f}", ("f", tmp.generic_string()) );
+   }
+   fc::rename( tmp, _export_dir / "last_block" );
+   _exported_block = block_num;
+}
+
+void history_export_plugin_impl::recover()
+{
+   const fc::path checkpoint = _export_dir / "last_block";
+   if( !fc::exists( checkpoint ) )
+   {
+      if( fc::exists( _export_dir ) && fc::directory_iterator( _export_dir ) != fc::directory_iterator() )
+      {
+         wlog( "${d} has no checkpoint, its tables are appended to as they are", ("d", _export_dir.generic_string()) );
+         return;
+      }
+      // a new export, from here on a crash before the first checkpoint is undone like any other
+      store_checkpoint( 0 );
+      return;
+   }
+
+   std::ifstream in( checkpoint.generic_string().c_str(), std::ios::binary );
+   in.read( (char*)&_exported_block, sizeof(_exported_block) );
+   FC_ASSERT( in.good(), "Unable to read ${f}", ("f", checkpoint.generic_string()) );
+
+   for( fc::directory_iterator table( _export_dir ); table != fc::directory_iterator(); ++table )
+   {
+      if( !fc::is_directory( *table ) )
+         continue;
+
+      // segment files are named after their first block, zero padded, so name order is block order
+      vector<std::string> names;
+      for( fc::directory_iterator file( *table ); file != fc::directory_iterator(); ++file )
+         if( (*file).extension() == ".cols" )
+            names.push_back( (*file).filename().generic_string() );
+      std::sort( names.begin(), names.end() );
+
+      // rows are appended in block order, so only the last segment starting at or before the checkpoint can
+      // hold rows on both sides of it; the segments after it were written entirely after the checkpoint
+      bool scanned = false;
+      for( auto itr = names.rbegin(); itr != names.rend(); ++itr )
+      {
+         const fc::path file = *table / *itr;
+         if( std::stoul( *itr ) > _exported_block )
+            fc::remove( file );
+         else if( !scanned )
+         {
+            truncate_segment( file );
+            scanned = true;
+         }
+      }
+   }
+}
+
+void history_export_plugin_impl::truncate_segment( const fc::path& file )
+{
+   std::ifstream in( file.generic_string().c_str(), std::ios::binary );
+   uint64_t keep = 0;
+   uint32_t length = 0;
+   while( in.read( (char*)&length, sizeof(length) ) )
+   {
+      vector<char> data( length );
+      // a row group cut short by a crash is dropped along with everything after it
+      if( !in.read( data.data(), length ) )
+         break;
+      const row_group g = fc::raw::unpack<row_group>( data );
+      if( g.size() > 0 && g.block_num.front() > _exported_block )
+         break;
+      keep += sizeof(length) + length;
+   }
+   in.close();
+
+   if( keep < fc::file_size( file ) )
+   {
+      wlog( "Dropping rows of ${f} written after block ${n}", ("f", file.generic_string())("n", _exported_block) );
+      fc::resize_file( file, keep );
+   }
+}
+
+} // end namespace detail
+
+history_export_plugin::history_export_plugin() :
+   my( new detail::history_export_plugin_impl(*this) )
+{
+}
+
+history_export_plugin::~history_export_plugin()
+{
+}
+
+std::string history_export_plugin::plugin_name()const
+{
+   return "history_export";
+}
+
+void history_export_plugin::plugin_set_program_options(
+   boost::program_options::options_description& cli,
+   boost::program_options::options_description& cfg
+   )
+{
+   cli.add_options()
+         ("export-dir", boost::program_options::value<boost::filesystem::path>(), "Directory to export irreversible operation history to, as one columnar table per operation type (disabled if not set)")
+         ("export-segment-blocks", boost::program_options::value<uint32_t>()->default_value(100000), "Number of blocks covered by each segment file of an export table")
+         ("export-row-group-size", boost::program_options::value<uint32_t>()->default_value(10000), "Number of operations buffered per table before a row group is written")
+         ;
+   cfg.add(cli);
+}
+
+void history_export_plugin::plugin_initialize(const boost::program_options::variables_map& options)
+{
+   if( !options.count("export-dir") )
+      return;
+
+   my->_export_dir = options["export-dir"].as<boost::filesystem::path>();
+   if( options.count("export-segment-blocks") )
+      my->_segment_blocks = options["export-segment-blocks"].as<uint32_t>();
+   if( options.count("export-row-group-size") )
+      my->_row_group_size = options["export-row-group-size"].as<uint32_t>();
+   FC_ASSERT( my->_segment_blocks > 0 && my->_row_group_size > 0 );
+   my->recover();
+
+   my->_subscription = app().get_block_events()->subscribe( "history_export",
+      [this]( const graphene::app::applied_block_event& e ) { my->on_irreversible_block( e ); },
+      graphene::app::block_event_stream::after_irreversible );
+}
+
+void history_export_plugin::plugin_startup()
+{
+}
+
+void history_export_plugin::plugin_shutdown()
+{
+   if( !my->_subscription )
+      return;
+
+   auto stats = my->_subscription->stats();
+   ilog( "Exported operations up to block ${n}, longest export delay ${d} us",
+         ("n", stats.last_processed_block)("d", stats.max_delay.count()) );
+   // releasing the subscription waits for the queued blocks, after that the tables are ours alone
+   my->_subscription.reset();
+   my->write_checkpoint();
+}
+
+} }
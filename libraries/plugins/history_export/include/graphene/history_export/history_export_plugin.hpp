@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/plugin.hpp>
+#include <graphene/chain/database.hpp>
+
+namespace graphene { namespace history_export {
+   using namespace chain;
+
+/**
+ * @brief A run of exported operations of a single type, stored column by column
+ *
+ * Every operation type is exported to its own table under export-dir/<operation name>/.  A table is split into
+ * segment files covering export-segment-blocks blocks each, named after the first block of the segment.  A segment
+ * file is a sequence of row groups, each written as a 32 bit little endian length followed by the packed row_group.
+ *
+ * All vectors of a row group have the same length; row i of the table is made up of element i of every column.
+ */
+struct row_group
+{
+   vector<uint32_t>                  block_num;
+   vector<uint16_t>                  trx_in_block;
+   vector<uint16_t>                  op_in_trx;
+   vector<uint16_t>                  virtual_op;
+   vector<uint32_t>                  timestamp;     ///< block time, seconds since the epoch
+   vector<flat_set<account_id_type>> accounts;      ///< accounts impacted by the operation
+   vector<asset_id_type>             fee_asset;
+   vector<share_type>                fee_amount;
+   vector<asset_id_type>             amount_asset;  ///< asset of the operation's amount field, if it has one
+   vector<share_type>                amount;        ///< zero for operations without an amount field
+   vector<vector<char>>              op;            ///< the whole operation, packed
+
+   size_t size()const { return block_num.size(); }
+};
+
+namespace detail
+{
+    class history_export_plugin_impl;
+}
+
+/**
+ * @brief Exports irreversible operation history to local columnar files
+ *
+ * The plugin subscribes to the application's block event stream for irreversible blocks, so the tables are built
+ * and written on the stream's thread and block application never waits for disk.  The plugin does nothing unless
+ * export-dir is set.
+ *
+ * export-dir/last_block holds the number of the last block whose operations are all written.  It is updated at the
+ * end of every segment and on shutdown.  On startup, row groups written after it are dropped and blocks up to it are
+ * skipped, so replaying the blockchain neither repeats rows nor leaves them out.
+ */
+class history_export_plugin : public graphene::app::plugin
+{
+   public:
+      history_export_plugin();
+      virtual ~history_export_plugin();
+
+      std::string plugin_name()const override;
+      virtual void plugin_set_program_options(
+         boost::program_options::options_description& cli,
+         boost::program_options::options_description& cfg) override;
+      virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
+      virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      friend class detail::history_export_plugin_impl;
+      std::unique_ptr<detail::history_export_plugin_impl> my;
+};
+
+} } //graphene::history_export
+
+FC_REFLECT( graphene::history_export::row_group,
+            (block_num)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(accounts)
+            (fee_asset)(fee_amount)(amount_asset)(amount)(op) )
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/market_history/bucket_store.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+namespace graphene { namespace market_history {
+
+namespace {
+
+   share_type bucket_row::* const value_columns[] = {
+      &bucket_row::high_base,  &bucket_row::high_quote,
+      &bucket_row::low_base,   &bucket_row::low_quote,
+      &bucket_row::open_base,  &bucket_row::open_quote,
+      &bucket_row::close_base, &bucket_row::close_quote,
+      &bucket_row::base_volume, &bucket_row::quote_volume
+   };
+
+   const uint32_t store_version = 2;
+
+   void write_varint( std::vector<char>& out, uint64_t v )
+   {
+      while( v >= 0x80 )
+      {
+         out.push_back( char( (v & 0x7f) | 0x80 ) );
+         v >>= 7;
+      }
+      out.push_back( char(v) );
+   }
+
+   uint64_t read_varint( const char*& pos, const char* end )
+   {
+      uint64_t v = 0;
+      for( uint32_t shift = 0; shift < 64; shift += 7 )
+      {
+         FC_ASSERT( pos < end, "truncated bucket chunk" );
+         uint8_t b = uint8_t(*pos++);
+         v |= uint64_t(b & 0x7f) << shift;
+         if( !(b & 0x80) )
+            return v;
+      }
+      FC_THROW( "invalid varint in bucket chunk" );
+   }
+
+   uint64_t zigzag( int64_t v ) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+   int64_t unzigzag( uint64_t v ) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+   price trade_price_of( const fill_order_operation& o ) { return o.pays / o.receives; }
+
+   fc::time_point_sec bucket_open( fc::time_point_sec time, uint32_t seconds )
+   {
+      return fc::time_point_sec( (time.sec_since_epoch() / seconds) * seconds );
+   }
+
+   bucket_object to_bucket_object( const bucket_key& key, const bucket_row& row )
+   {
+      bucket_object b;
+      b.id = object_id_type( bucket_object::space_id, bucket_object::type_id, row.id );
+      b.key = key;
+      b.key.open = row.open;
+      b.high_base = row.high_base;
+      b.high_quote = row.high_quote;
+      b.low_base = row.low_base;
+      b.low_quote = row.low_quote;
+      b.open_base = row.open_base;
+      b.open_quote = row.open_quote;
+      b.close_base = row.close_base;
+      b.close_quote = row.close_quote;
+      b.base_volume = row.base_volume;
+      b.quote_volume = row.quote_volume;
+      return b;
+   }
+}
+
+const uint32_t bucket_series::rows_per_chunk;
+
+void bucket_row::add_trade( const price& trade_price, bool first )
+{
+   base_volume += trade_price.base.amount;
+   quote_volume += trade_price.quote.amount;
+   close_base = trade_price.base.amount;
+   close_quote = trade_price.quote.amount;
+   if( first )
+   {
+      open_base = high_base = low_base = close_base;
+      open_quote = high_quote = low_quote = close_quote;
+      return;
+   }
+
+   const asset_id_type base_id = trade_price.base.asset_id;
+   const asset_id_type quote_id = trade_price.quote.asset_id;
+   if( asset( high_base, base_id ) / asset( high_quote, quote_id ) < trade_price )
+   {
+      high_base = close_base;
+      high_quote = close_quote;
+   }
+   if( asset( low_base, base_id ) / asset( low_quote, quote_id ) > trade_price )
+   {
+      low_base = close_base;
+      low_quote = close_quote;
+   }
+}
+
+size_t bucket_series::size()const
+{
+   size_t count = _head.size();
+   for( const auto& c : _chunks )
+      count += c.rows;
+   return count;
+}
+
+size_t bucket_series::memory_usage()const
+{
+   size_t bytes = sizeof(*this) + _head.capacity() * sizeof(bucket_row);
+   for( const auto& c : _chunks )
+      bytes += sizeof(c) + c.data.capacity();
+   return bytes;
+}
+
+void bucket_series::upsert( const bucket_row& row )
+{
+   if( !_head.empty() && _head.back().open == row.open )
+   {
+      _head.back() = row;
+      return;
+   }
+   FC_ASSERT( _head.empty() || _head.back().open < row.open, "buckets must be appended in order" );
+   _head.push_back( row );
+   if( _head.size() > rows_per_chunk )
+      seal();
+}
+
+void bucket_series::seal()
+{
+   bucket_chunk chunk;
+   chunk.first_open = _head.front().open;
+   chunk.last_open = _head[rows_per_chunk-1].open;
+   chunk.rows = rows_per_chunk;
+   chunk.data.reserve( rows_per_chunk * 12 );
+
+   uint32_t prev_open = chunk.first_open.sec_since_epoch();
+   write_varint( chunk.data, prev_open / _seconds );
+   for( uint32_t i = 1; i < rows_per_chunk; ++i )
+   {
+      const uint32_t open = _head[i].open.sec_since_epoch();
+      write_varint( chunk.data, (open - prev_open) / _seconds );
+      prev_open = open;
+   }
+   uint64_t prev_id = 0;
+   for( uint32_t i = 0; i < rows_per_chunk; ++i )
+   {
+      write_varint( chunk.data, _head[i].id - prev_id );
+      prev_id = _head[i].id;
+   }
+   for( const auto column : value_columns )
+   {
+      int64_t prev = 0;
+      for( uint32_t i = 0; i < rows_per_chunk; ++i )
+      {
+         const int64_t v = (_head[i].*column).value;
+         write_varint( chunk.data, zigzag( v - prev ) );
+         prev = v;
+      }
+   }
+   chunk.data.shrink_to_fit();
+
+   _chunks.push_back( std::move(chunk) );
+   _head.erase( _head.begin(), _head.begin() + rows_per_chunk );
+}
+
+void bucket_series::decode( const bucket_chunk& chunk, vector<bucket_row>& rows )const
+{
+   rows.resize( chunk.rows );
+   const char* pos = chunk.data.data();
+   const char* end = pos + chunk.data.size();
+
+   uint64_t open = 0;
+   for( auto& r : rows )
+   {
+      open += read_varint( pos, end ) * _seconds;
+      r.open = fc::time_point_sec( uint32_t(open) );
+   }
+   uint64_t id = 0;
+   for( auto& r : rows )
+   {
+      id += read_varint( pos, end );
+      r.id = id;
+   }
+   for( const auto column : value_columns )
+   {
+      int64_t v = 0;
+      for( auto& r : rows )
+      {
+         v += unzigzag( read_varint( pos, end ) );
+         r.*column = v;
+      }
+   }
+}
+
+void bucket_series::prune( fc::time_point_sec cutoff )
+{
+   while( !_chunks.empty() && _chunks.front().last_open < cutoff )
+      _chunks.pop_front();
+}
+
+void bucket_series::query( fc::time_point_sec start, fc::time_point_sec end, uint32_t limit,
+                           vector<bucket_row>& result )const
+{
+   const size_t stop = result.size() + limit;
+
+   auto itr = std::lower_bound( _chunks.begin(), _chunks.end(), start,
+                                []( const bucket_chunk& c, fc::time_point_sec t ) { return c.last_open < t; } );
+   vector<bucket_row> rows;
+   for( ; itr != _chunks.end() && itr->first_open <= end; ++itr )
+   {
+      decode( *itr, rows );
+      for( const auto& r : rows )
+      {
+         if( r.open < start ) continue;
+         if( r.open > end || result.size() >= stop ) return;
+         result.push_back( r );
+      }
+   }
+   for( const auto& r : _head )
+   {
+      if( r.open < start ) continue;
+      if( r.open > end || result.size() >= stop ) return;
+      result.push_back( r );
+   }
+}
+
+void bucket_store::push_fill( uint32_t block_num, fc::time_point_sec time, const fill_order_operation& o )
+{
+   /** for every matched order there are two fill order operations created, one for
+    * each side.  We can filter the duplicates by only considering the fill operations where
+    * the base < quote
+    */
+   if( o.pays.asset_id > o.receives.asset_id )
+      return;
+
+   journaled_trade t;
+   t.block_num = block_num;
+   t.time = time;
+   t.trade_price = trade_price_of( o );
+
+   if( block_num <= _last_irreversible_block )
+      apply_to_series( t );
+   else
+   {
+      _journal.push_back( t );
+      apply_to_overlay( t );
+   }
+}
+
+void bucket_store::apply_to_series( const journaled_trade& t )
+{
+   const asset_id_type base = t.trade_price.base.asset_id;
+   const asset_id_type quote = t.trade_price.quote.asset_id;
+   for( uint32_t seconds : _bucket_sizes )
+   {
+      auto itr = _series.find( series_key( base, quote, seconds ) );
+      if( itr == _series.end() )
+         itr = _series.emplace( series_key( base, quote, seconds ), bucket_series( seconds ) ).first;
+      bucket_series& series = itr->second;
+
+      const auto open = bucket_open( t.time, seconds );
+      const bool first = series.empty() || series.back().open != open;
+      bucket_row row = first ? bucket_row() : series.back();
+      if( first )
+         row.id = _next_id++;
+      row.open = open;
+      row.add_trade( t.trade_price, first );
+      series.upsert( row );
+
+      if( _max_history != 0 && open.sec_since_epoch() > uint64_t(seconds) * _max_history )
+         series.prune( fc::time_point_sec( uint32_t( open.sec_since_epoch() - uint64_t(seconds) * _max_history ) ) );
+   }
+}
+
+void bucket_store::apply_to_overlay( const journaled_trade& t )
+{
+   for( uint32_t seconds : _bucket_sizes )
+   {
+      bucket_key key( t.trade_price.base.asset_id, t.trade_price.quote.asset_id, seconds, bucket_open( t.time, seconds ) );
+      auto itr = _overlay.find( key );
+      bool first = false;
+      if( itr == _overlay.end() )
+      {
+         bucket_row row;
+         auto sitr = _series.find( series_key( key.base, key.quote, seconds ) );
+         if( sitr != _series.end() && !sitr->second.empty() && sitr->second.back().open == key.open )
+            row = sitr->second.back();
+         else
+         {
+            // trades reach the series in journal order, which opens the buckets in this same order
+            row.id = _next_id + _overlay_opened++;
+            first = true;
+         }
+         row.open = key.open;
+         itr = _overlay.emplace( key, row ).first;
+      }
+      itr->second.add_trade( t.trade_price, first );
+   }
+}
+
+void bucket_store::rebuild_overlay()
+{
+   _overlay.clear();
+   _overlay_opened = 0;
+   for( const auto& t : _journal )
+      apply_to_overlay( t );
+}
+
+void bucket_store::pop_blocks( uint32_t block_num )
+{
+   if( _journal.empty() || _journal.back().block_num < block_num )
+      return;
+   while( !_journal.empty() && _journal.back().block_num >= block_num )
+      _journal.pop_back();
+   rebuild_overlay();
+}
+
+void bucket_store::set_last_irreversible_block( uint32_t block_num )
+{
+   if( block_num <= _last_irreversible_block )
+      return;
+   _last_irreversible_block = block_num;
+   if( _journal.empty() || _journal.front().block_num > block_num )
+      return;
+   while( !_journal.empty() && _journal.front().block_num <= block_num )
+   {
+      apply_to_series( _journal.front() );
+      _journal.pop_front();
+   }
+   rebuild_overlay();
+}
+
+vector<bucket_object> bucket_store::get_buckets( asset_id_type base, asset_id_type quote, uint32_t seconds,
+                                                 fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const
+{
+   if( base > quote ) std::swap( base, quote );
+   const bucket_key key( base, quote, seconds, fc::time_point_sec() );
+
+   vector<bucket_row> rows;
+   rows.reserve( std::min<uint32_t>( limit, 1000 ) );
+   auto sitr = _series.find( series_key( base, quote, seconds ) );
+   if( sitr != _series.end() && !sitr->second.empty() )
+   {
+      // pruning keeps whole chunks, the rows it left behind are older than max_history
+      if( _max_history != 0 )
+      {
+         const uint64_t newest = sitr->second.back().open.sec_since_epoch();
+         const uint64_t span = uint64_t(seconds) * ( _max_history - 1 );
+         if( newest > span && start.sec_since_epoch() < newest - span )
+            start = fc::time_point_sec( uint32_t( newest - span ) );
+      }
+      sitr->second.query( start, end, limit, rows );
+   }
+
+   // reversible buckets are never older than the newest irreversible one
+   for( auto itr = _overlay.lower_bound( bucket_key( base, quote, seconds, start ) );
+        itr != _overlay.end() && itr->first.base == base && itr->first.quote == quote &&
+        itr->first.seconds == seconds && itr->first.open <= end; ++itr )
+   {
+      if( !rows.empty() && rows.back().open == itr->second.open )
+         rows.back() = itr->second;
+      else if( rows.size() < limit && ( rows.empty() || rows.back().open < itr->second.open ) )
+         rows.push_back( itr->second );
+   }
+
+   vector<bucket_object> result;
+   result.reserve( rows.size() );
+   for( const auto& r : rows )
+      result.push_back( to_bucket_object( key, r ) );
+   return result;
+}
+
+size_t bucket_store::memory_usage()const
+{
+   size_t bytes = sizeof(*this) + _journal.size() * sizeof(journaled_trade)
+                + _overlay.size() * ( sizeof(bucket_key) + sizeof(bucket_row) );
+   for( const auto& s : _series )
+      bytes += sizeof(s.first) + s.second.memory_usage();
+   return bytes;
+}
+
+void bucket_store::save( const fc::path& file, const block_id_type& last_irreversible_id )const
+{ try {
+   fc::create_directories( file.parent_path() );
+   const fc::path tmp = file.generic_string() + ".tmp";
+   {
+      std::ofstream out( tmp.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+      FC_ASSERT( out );
+      fc::raw::pack( out, store_version );
+      fc::raw::pack( out, _last_irreversible_block );
+      fc::raw::pack( out, last_irreversible_id );
+      fc::raw::pack( out, _next_id );
+      fc::raw::pack( out, uint64_t(_series.size()) );
+      for( const auto& s : _series )
+      {
+         fc::raw::pack( out, s.first.base );
+         fc::raw::pack( out, s.first.quote );
+         fc::raw::pack( out, s.second );
+      }
+   }
+   fc::rename( tmp, file );
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+bool bucket_store::load( const fc::path& file )
+{ try {
+   clear();
+   if( !fc::exists( file ) )
+      return false;
+
+   std::ifstream in( file.generic_string(), std::ifstream::binary );
+   uint32_t version = 0;
+   fc::raw::unpack( in, version );
+   if( version != store_version )
+   {
+      wlog( "Ignoring market history buckets with version ${v}", ("v",version) );
+      return false;
+   }
+   fc::raw::unpack( in, _last_irreversible_block );
+   fc::raw::unpack( in, _loaded_block_id );
+   fc::raw::unpack( in, _next_id );
+   uint64_t count = 0;
+   fc::raw::unpack( in, count );
+   for( uint64_t i = 0; i < count; ++i )
+   {
+      series_key key;
+      bucket_series series;
+      fc::raw::unpack( in, key.base );
+      fc::raw::unpack( in, key.quote );
+      fc::raw::unpack( in, series );
+      key.seconds = series.seconds();
+      if( _bucket_sizes.find( key.seconds ) != _bucket_sizes.end() )
+         _series.emplace( key, std::move(series) );
+   }
+   return true;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+void bucket_store::clear()
+{
+   _last_irreversible_block = 0;
+   _loaded_block_id = block_id_type();
+   _next_id = 0;
+   _overlay_opened = 0;
+   _series.clear();
+   _journal.clear();
+   _overlay.clear();
+}
+
+} } // graphene::market_history
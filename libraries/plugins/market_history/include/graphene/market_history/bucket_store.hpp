@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/market_history/market_history_plugin.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <deque>
+#include <map>
+
+namespace graphene { namespace market_history {
+
+/**
+ *  The uncompressed form of one OHLCV bucket, without the market and bucket size which are implied by the
+ *  series that holds it.
+ */
+struct bucket_row
+{
+   /** instance of the bucket's object id, numbered across all series in the order buckets are opened */
+   uint64_t            id = 0;
+   fc::time_point_sec  open;
+   share_type          high_base;
+   share_type          high_quote;
+   share_type          low_base;
+   share_type          low_quote;
+   share_type          open_base;
+   share_type          open_quote;
+   share_type          close_base;
+   share_type          close_quote;
+   share_type          base_volume;
+   share_type          quote_volume;
+
+   /** folds a trade into the bucket, the first trade of a bucket also sets its open price */
+   void add_trade( const price& trade_price, bool first );
+};
+
+/**
+ *  A run of consecutive rows whose columns are stored one after the other, each as zig-zag varint deltas from the
+ *  previous row.  Open times are stored as the number of buckets since the previous row, ids as the difference
+ *  to the previous id.
+ */
+struct bucket_chunk
+{
+   fc::time_point_sec  first_open;
+   fc::time_point_sec  last_open;
+   uint32_t            rows = 0;
+   std::vector<char>   data;
+};
+
+/**
+ *  The append-only history of one market at one bucket size.  The newest rows are kept uncompressed so that the
+ *  current bucket can still be updated; once there are more than rows_per_chunk of them the oldest are sealed
+ *  into a bucket_chunk.  Pruning drops whole chunks, so up to rows_per_chunk rows older than the cutoff may be
+ *  kept; bucket_store hides them from queries.
+ */
+class bucket_series
+{
+   public:
+      static const uint32_t rows_per_chunk = 64;
+
+      bucket_series( uint32_t seconds = 0 ):_seconds(seconds){}
+
+      uint32_t seconds()const { return _seconds; }
+      bool     empty()const { return _head.empty(); }
+      size_t   size()const;
+      size_t   memory_usage()const;
+
+      /** the newest bucket, the series must not be empty */
+      const bucket_row& back()const { return _head.back(); }
+
+      /** appends a bucket newer than back() or replaces back() if it has the same open time */
+      void upsert( const bucket_row& row );
+
+      /** drops chunks whose buckets all open before cutoff */
+      void prune( fc::time_point_sec cutoff );
+
+      /** appends up to limit rows with start <= open <= end to result, oldest first */
+      void query( fc::time_point_sec start, fc::time_point_sec end, uint32_t limit, vector<bucket_row>& result )const;
+
+   private:
+      friend struct fc::reflector<bucket_series>;
+
+      void seal();
+      void decode( const bucket_chunk& chunk, vector<bucket_row>& rows )const;
+
+      uint32_t                 _seconds = 0;
+      std::deque<bucket_chunk> _chunks;
+      vector<bucket_row>       _head;
+};
+
+/**
+ *  Holds the market history buckets outside of the object database so that tracking a trade costs neither
+ *  undo state nor an object per bucket.
+ *
+ *  Only trades from irreversible blocks are written into the series.  Trades from blocks past the last
+ *  irreversible block are kept in a journal and folded into a small overlay of the buckets they touch.  When a
+ *  block is replaced by a fork the journal is cut back and the overlay rebuilt from what is left of it; when the
+ *  last irreversible block advances the journaled trades up to it are moved into the series.
+ *
+ *  Each bucket gets an id when it is opened.  Ids of irreversible buckets never change; a reversible bucket is
+ *  given the id it will have once irreversible, unless a fork replaces the trades before it.
+ *
+ *  With a max_history of n, a series keeps the buckets opened within n bucket lengths of its newest irreversible
+ *  bucket, that is the newest bucket and the n - 1 bucket slots before it, whether they had trades or not.
+ */
+class bucket_store
+{
+   public:
+      void set_bucket_sizes( const flat_set<uint32_t>& sizes ) { _bucket_sizes = sizes; }
+      void set_max_history( uint32_t max_history ) { _max_history = max_history; }
+
+      /** records the trade of a fill_order_operation, fills with base > quote are the other side of a trade */
+      void push_fill( uint32_t block_num, fc::time_point_sec time, const fill_order_operation& o );
+
+      /** forgets all trades from blocks with a number >= block_num */
+      void pop_blocks( uint32_t block_num );
+
+      void     set_last_irreversible_block( uint32_t block_num );
+      uint32_t last_irreversible_block()const { return _last_irreversible_block; }
+
+      vector<bucket_object> get_buckets( asset_id_type base, asset_id_type quote, uint32_t seconds,
+                                         fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const;
+
+      size_t journal_size()const { return _journal.size(); }
+      size_t memory_usage()const;
+
+      /** writes the irreversible part of the store, last_irreversible_id identifies the chain it was built from */
+      void save( const fc::path& file, const block_id_type& last_irreversible_id )const;
+      /** replaces the store with the one written by save(), returns false if there is none */
+      bool load( const fc::path& file );
+      /** the id passed to save() when the loaded store was written */
+      const block_id_type& loaded_block_id()const { return _loaded_block_id; }
+      void clear();
+
+   private:
+      struct series_key
+      {
+         series_key( asset_id_type b = asset_id_type(), asset_id_type q = asset_id_type(), uint32_t s = 0 )
+         :base(b),quote(q),seconds(s){}
+
+         asset_id_type base;
+         asset_id_type quote;
+         uint32_t      seconds = 0;
+
+         friend bool operator < ( const series_key& a, const series_key& b )
+         {
+            return std::tie( a.base, a.quote, a.seconds ) < std::tie( b.base, b.quote, b.seconds );
+         }
+      };
+
+      struct journaled_trade
+      {
+         uint32_t           block_num = 0;
+         fc::time_point_sec time;
+         price              trade_price;
+      };
+
+      void apply_to_series( const journaled_trade& t );
+      void apply_to_overlay( const journaled_trade& t );
+      void rebuild_overlay();
+
+      flat_set<uint32_t>                   _bucket_sizes;
+      uint32_t                             _max_history = 0;
+      uint32_t                             _last_irreversible_block = 0;
+      block_id_type                        _loaded_block_id;
+      /** the id of the next bucket opened in a series */
+      uint64_t                             _next_id = 0;
+      /** buckets opened in the overlay, which take the ids after _next_id */
+      uint64_t                             _overlay_opened = 0;
+      std::map<series_key, bucket_series>  _series;
+      std::deque<journaled_trade>          _journal;
+      std::map<bucket_key, bucket_row>     _overlay;
+};
+
+} } // graphene::market_history
+
+FC_REFLECT( graphene::market_history::bucket_row,
+            (id)(open)
+            (high_base)(high_quote)
+            (low_base)(low_quote)
+            (open_base)(open_quote)
+            (close_base)(close_quote)
+            (base_volume)(quote_volume) )
+FC_REFLECT( graphene::market_history::bucket_chunk, (first_open)(last_open)(rows)(data) )
+FC_REFLECT( graphene::market_history::bucket_series, (_seconds)(_chunks)(_head) )
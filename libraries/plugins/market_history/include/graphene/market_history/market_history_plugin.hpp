@@ -107,14 +107,6 @@ struct order_history_object : public abstract_object<order_history_object>
 };
 
 struct by_key;
-typedef multi_index_container<
-   bucket_object,
-   indexed_by<
-      hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-      ordered_unique< tag<by_key>, member< bucket_object, bucket_key, &bucket_object::key > >
-   >
-> bucket_object_multi_index_type;
-
 typedef multi_index_container<
    order_history_object,
    indexed_by<
@@ -124,7 +116,6 @@ typedef multi_index_container<
 > order_history_multi_index_type;
 
 
-typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_index;
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
 
 
@@ -135,8 +126,10 @@ namespace detail
 
 /**
  *  The market history plugin can be configured to track any number of intervals via its configuration.  Once per block it
- *  will scan the virtual operations and look for fill_order_operations and then adjust the appropriate bucket objects for
+ *  will scan the virtual operations and look for fill_order_operations and then adjust the appropriate buckets for
  *  each fill order.
+ *
+ *  Buckets are not kept in the object database, see bucket_store.  bucket_object is only used to return them.
  */
 class market_history_plugin : public graphene::app::plugin
 {
@@ -151,10 +144,16 @@ class market_history_plugin : public graphene::app::plugin
       virtual void plugin_initialize(
          const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
 
       uint32_t                    max_history()const;
       const flat_set<uint32_t>&   tracked_buckets()const;
 
+      /** @return up to limit buckets of the market with start <= open <= end, oldest first */
+      vector<bucket_object>       get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
+                                                      fc::time_point_sec start, fc::time_point_sec end,
+                                                      uint32_t limit )const;
+
    private:
       friend class detail::market_history_plugin_impl;
       std::unique_ptr<detail::market_history_plugin_impl> my;
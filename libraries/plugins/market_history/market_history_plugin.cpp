@@ -23,6 +23,7 @@
  */
 
 #include <graphene/market_history/market_history_plugin.hpp>
+#include <graphene/market_history/bucket_store.hpp>
 
 #include <graphene/chain/account_evaluator.hpp>
 #include <graphene/chain/account_object.hpp>
@@ -53,6 +54,16 @@ class market_history_plugin_impl
        */
       void update_market_histories( const signed_block& b );
 
+      /** kept beside the object database rather than in it, so that it survives the wipe of a replay */
+      fc::path buckets_file()
+      {
+         return database().get_data_dir() / "market_history_buckets";
+      }
+
+      /** loads the saved buckets once the database is open, before the first block is applied */
+      void load_buckets();
+      void save_buckets();
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -61,16 +72,24 @@ class market_history_plugin_impl
       market_history_plugin&     _self;
       flat_set<uint32_t>         _tracked_buckets;
       uint32_t                   _maximum_history_per_bucket_size = 1000;
+      bucket_store               _buckets;
+      /** the last block passed to update_market_histories, a block at or below it replaces a forked block */
+      uint32_t                   _last_block_num = 0;
+      /** number of irreversible blocks between saves of the buckets, 0 to only save on shutdown */
+      uint32_t                   _save_interval = 1000;
+      uint32_t                   _last_saved_block = 0;
+      bool                       _loaded = false;
+      /** set when the node was asked to rebuild its state, the saved buckets are then ignored */
+      bool                       _discard_saved = false;
 };
 
 
 struct operation_process_fill_order
 {
    market_history_plugin&    _plugin;
-   fc::time_point_sec        _now;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n )
-   :_plugin(mhp),_now(n) {}
+   operation_process_fill_order( market_history_plugin& mhp )
+   :_plugin(mhp) {}
 
    typedef void result_type;
 
@@ -81,9 +100,7 @@ struct operation_process_fill_order
    void operator()( const fill_order_operation& o )const 
    {
       //ilog( "processing ${o}", ("o",o) );
-      const auto& buckets = _plugin.tracked_buckets();
       auto& db         = _plugin.database();
-      const auto& bucket_idx = db.get_index_type<bucket_index>();
       const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
 
       auto time = db.head_block_time();
@@ -120,98 +137,50 @@ struct operation_process_fill_order
          }
          else break;
       }
+   }
+};
 
+market_history_plugin_impl::~market_history_plugin_impl()
+{}
 
-      auto max_history = _plugin.max_history();
-      for( auto bucket : buckets )
+void market_history_plugin_impl::load_buckets()
+{ try {
+   _loaded = true;
+   auto& db = database();
+   if( _discard_saved || db.get_data_dir().generic_string().empty() )
+      return;
+   if( !_buckets.load( buckets_file() ) )
+      return;
+
+   const uint32_t lib = _buckets.last_irreversible_block();
+   bool same_chain = ( lib == 0 );
+   if( !same_chain )
+   {
+      try
+      {
+         same_chain = ( db.get_block_id_for_num( lib ) == _buckets.loaded_block_id() );
+      }
+      catch( const fc::exception& )
       {
-          auto cutoff      = (fc::time_point() + fc::seconds( bucket * max_history));
-
-          bucket_key key;
-          key.base    = o.pays.asset_id;
-          key.quote   = o.receives.asset_id;
-
-
-          /** for every matched order there are two fill order operations created, one for
-           * each side.  We can filter the duplicates by only considering the fill operations where
-           * the base > quote
-           */
-          if( key.base > key.quote ) 
-          {
-             //ilog( "     skipping because base > quote" );
-             continue;
-          }
-
-          price trade_price = o.pays / o.receives;
-
-          key.seconds = bucket;
-          key.open    = fc::time_point() + fc::seconds((_now.sec_since_epoch() / key.seconds) * key.seconds);
-
-          const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          auto itr = by_key_idx.find( key );
-          if( itr == by_key_idx.end() )
-          { // create new bucket
-            /* const auto& obj = */
-            db.create<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.quote_volume += trade_price.quote.amount;
-                 b.base_volume += trade_price.base.amount;
-                 b.open_base = trade_price.base.amount;
-                 b.open_quote = trade_price.quote.amount;
-                 b.close_base = trade_price.base.amount;
-                 b.close_quote = trade_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
-          }
-          else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*itr) );
-             db.modify( *itr, [&]( bucket_object& b ){
-                  b.base_volume += trade_price.base.amount;
-                  b.quote_volume += trade_price.quote.amount;
-                  b.close_base = trade_price.base.amount;
-                  b.close_quote = trade_price.quote.amount;
-                  if( b.high() < trade_price ) 
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > trade_price ) 
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*itr) );
-          }
-
-          if( max_history != 0  )
-          {
-             key.open = fc::time_point_sec();
-             auto itr = by_key_idx.lower_bound( key );
-
-             while( itr != by_key_idx.end() && 
-                    itr->key.base == key.base && 
-                    itr->key.quote == key.quote && 
-                    itr->key.seconds == bucket && 
-                    itr->key.open < cutoff )
-             {
-              //  elog( "    removing old bucket ${b}", ("b", *itr) );
-                auto old_itr = itr;
-                ++itr;
-                db.remove( *old_itr );
-             }
-          }
       }
    }
-};
+   if( !same_chain )
+   {
+      wlog( "Discarding market history buckets saved for block ${n}, which is not in the block log", ("n", lib) );
+      _buckets.clear();
+   }
+   _last_saved_block = _buckets.last_irreversible_block();
+} FC_CAPTURE_AND_RETHROW() }
 
-market_history_plugin_impl::~market_history_plugin_impl()
-{}
+void market_history_plugin_impl::save_buckets()
+{ try {
+   auto& db = database();
+   if( db.get_data_dir().generic_string().empty() )
+      return;
+   const uint32_t lib = _buckets.last_irreversible_block();
+   _buckets.save( buckets_file(), lib == 0 ? block_id_type() : db.get_block_id_for_num( lib ) );
+   _last_saved_block = lib;
+} FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin_impl::update_market_histories( const signed_block& b )
 {
@@ -219,12 +188,32 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    if( _tracked_buckets.size() == 0 ) return;
 
    graphene::chain::database& db = database();
+   if( !_loaded )
+      load_buckets();
+   const uint32_t block_num = b.block_num();
+   // a replay after a crash passes the blocks the loaded buckets already hold again
+   if( block_num <= _buckets.last_irreversible_block() )
+   {
+      _last_block_num = block_num;
+      return;
+   }
+   if( block_num <= _last_block_num )
+      _buckets.pop_blocks( block_num );
+   _last_block_num = block_num;
+
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
-      if( o_op.valid() )
-         o_op->op.visit( operation_process_fill_order( _self, b.timestamp ) );
+      if( !o_op.valid() )
+         continue;
+      o_op->op.visit( operation_process_fill_order( _self ) );
+      if( o_op->op.which() == operation::tag<fill_order_operation>::value )
+         _buckets.push_fill( block_num, b.timestamp, o_op->op.get<fill_order_operation>() );
    }
+
+   _buckets.set_last_irreversible_block( db.get_dynamic_global_properties().last_irreversible_block_num );
+   if( _save_interval != 0 && _buckets.last_irreversible_block() >= _last_saved_block + _save_interval )
+      save_buckets();
 }
 
 } // end namespace detail
@@ -258,6 +247,8 @@ void market_history_plugin::plugin_set_program_options(
            "Track market history by grouping orders into buckets of equal size measured in seconds specified as a JSON array of numbers")
          ("history-per-size", boost::program_options::value<uint32_t>()->default_value(1000), 
            "How far back in time to track history for each bucket size, measured in the number of buckets (default: 1000)")
+         ("history-save-interval", boost::program_options::value<uint32_t>()->default_value(1000),
+           "Number of irreversible blocks after which the market history buckets are saved, 0 to only save them on shutdown (default: 1000)")
          ;
    cfg.add(cli);
 }
@@ -265,7 +256,6 @@ void market_history_plugin::plugin_set_program_options(
 void market_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
    database().applied_block.connect( [&]( const signed_block& b){ my->update_market_histories(b); } );
-   database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
 
    if( options.count( "bucket-size" ) )
@@ -275,11 +265,26 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    }
    if( options.count( "history-per-size" ) )
       my->_maximum_history_per_bucket_size = options["history-per-size"].as<uint32_t>();
+   if( options.count( "history-save-interval" ) )
+      my->_save_interval = options["history-save-interval"].as<uint32_t>();
+   my->_discard_saved = options.count( "replay-blockchain" ) || options.count( "resync-blockchain" );
+   my->_buckets.set_bucket_sizes( my->_tracked_buckets );
+   my->_buckets.set_max_history( my->_maximum_history_per_bucket_size );
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
-{
-}
+{ try {
+   // a replay has loaded the buckets with its first block already
+   if( !my->_loaded )
+      my->load_buckets();
+   my->_last_block_num = database().head_block_num();
+} FC_CAPTURE_AND_RETHROW() }
+
+void market_history_plugin::plugin_shutdown()
+{ try {
+   // only the irreversible buckets are saved, the chain is rewound to the last irreversible block on close
+   my->save_buckets();
+} FC_CAPTURE_AND_RETHROW() }
 
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
 {
@@ -291,4 +296,11 @@ uint32_t market_history_plugin::max_history()const
    return my->_maximum_history_per_bucket_size;
 }
 
+vector<bucket_object> market_history_plugin::get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
+                                                                 fc::time_point_sec start, fc::time_point_sec end,
+                                                                 uint32_t limit )const
+{
+   return my->_buckets.get_buckets( a, b, bucket_seconds, start, end, limit );
+}
+
 } }
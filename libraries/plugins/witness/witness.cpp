@@ -156,6 +156,18 @@ void witness_plugin::schedule_production_loop()
    if( time_to_next_second < 50000 )      // we must sleep for at least 50ms
        time_to_next_second += 1000000;
 
+   // Wake up right at the start of our next slot rather than at the next tick, so that the
+   // block is signed and broadcast without delay.  The block is assembled from the pending
+   // transactions that were applied as they arrived, so little work is left at that point.
+   if( _production_enabled )
+   {
+      const chain::database& db = database();
+      int64_t time_to_slot = (fc::time_point( db.get_slot_time(1) ) - ntp_now).count();
+      if( time_to_slot > 0 && time_to_slot < time_to_next_second
+          && _witnesses.find( db.get_scheduled_witness(1) ) != _witnesses.end() )
+         time_to_next_second = time_to_slot;
+   }
+
    fc::time_point next_wakeup( fc_now + fc::microseconds( time_to_next_second ) );
 
    //wdump( (now.time_since_epoch().count())(next_wakeup.time_since_epoch().count()) );
@@ -185,7 +197,7 @@ block_production_condition::block_production_condition_enum witness_plugin::bloc
    switch( result )
    {
       case block_production_condition::produced:
-         ilog("Generated block #${n} with timestamp ${t} at time ${c}", (capture));
+         ilog("Generated block #${n} with timestamp ${t} at time ${c}, build ${build}us sign ${sign}us apply ${apply}us", (capture));
          break;
       case block_production_condition::not_synced:
          ilog("Not producing block because production is disabled until we receive a recent block (see: --enable-stale-production)");
@@ -280,14 +292,24 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
       return block_production_condition::lag;
    }
 
-   auto block = db.generate_block(
-      scheduled_time,
-      scheduled_witness,
-      private_key_itr->second,
-      _production_skip_flags
-      );
-   capture("n", block.block_num())("t", block.timestamp)("c", now);
-   fc::async( [this,block](){ p2p_node().broadcast(net::block_message(block)); } );
+   fc::time_point build_start = fc::time_point::now();
+   auto block = db.build_block( scheduled_time, scheduled_witness, _production_skip_flags );
+   fc::time_point sign_start = fc::time_point::now();
+   if( !(_production_skip_flags & graphene::chain::database::skip_witness_signature) )
+      block.sign( private_key_itr->second );
+   fc::time_point apply_start = fc::time_point::now();
+   db.push_block( block, _production_skip_flags );
+   fc::time_point apply_end = fc::time_point::now();
+
+   capture("n", block.block_num())("t", block.timestamp)("c", now)
+          ("build", (sign_start - build_start).count())
+          ("sign", (apply_start - sign_start).count())
+          ("apply", (apply_end - apply_start).count());
+   fc::async( [this,block,apply_end](){
+      p2p_node().broadcast(net::block_message(block));
+      ilog( "Broadcast block #${n} ${us}us after it was applied",
+            ("n", block.block_num())("us", (fc::time_point::now() - apply_end).count()) );
+   } );
 
    return block_production_condition::produced;
 }
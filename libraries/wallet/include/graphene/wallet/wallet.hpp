@@ -226,6 +226,14 @@ struct worker_vote_delta
    flat_set<worker_id_type> vote_abstain;
 };
 
+struct bulk_transfer_result
+{
+   /** one transaction per recipient, empty for the recipients that could not be paid */
+   vector<signed_transaction> transactions;
+   /** the reason each failed transfer was not built or not accepted, keyed by the recipient's position */
+   map<uint32_t, string>      failed;
+};
+
 struct signed_block_with_info : public signed_block
 {
    signed_block_with_info( const signed_block& block );
@@ -602,6 +610,19 @@ class wallet_api
 
       map<string, bool> import_accounts( string filename, string password );
 
+      /** Finds the accounts controlled by keys derived from a brain key and imports those keys.
+       *
+       * Owner keys derived from the brain key, active keys derived from those and memo keys
+       * derived from the active keys are each scanned until gap_limit consecutive keys are
+       * not used by any account.  Keys are derived in parallel and checked with the node one
+       * batch at a time.
+       *
+       * @param brain_key the brain key the keys were derived from
+       * @param gap_limit the number of consecutive unused keys after which a scan stops
+       * @returns the keys imported, by the name of the account using them
+       */
+      map<string, vector<public_key_type>> recover_accounts_from_brain_key( string brain_key, uint32_t gap_limit = 20 );
+
       bool import_account_keys( string filename, string password, string src_account_name, string dest_account_name );
 
       /**
@@ -721,6 +742,35 @@ class wallet_api
       }
 
 
+      /** Transfer from one account to many, one transaction per recipient.
+       *
+       * All recipients are looked up in a single call and the transactions are signed from the
+       * wallet's cached chain state, so building them takes no further round trips.  When
+       * broadcasting, the transactions are sent without waiting for each reply in turn, and the
+       * ones rejected for a stale reference block are signed again and resent once.
+       *
+       * A transfer that fails does not stop the others, it is reported in the result instead.
+       *
+       * @param from the name or id of the account sending the funds
+       * @param recipients pairs of the name or id of a receiving account and the amount it receives
+       * @param asset_symbol the symbol or id of the asset to send
+       * @param memo a memo to attach to every transfer, empty for none
+       * @param broadcast true to broadcast the transactions on the network
+       * @returns the signed transactions in the order of recipients, and why each failed transfer failed
+       */
+      bulk_transfer_result bulk_transfer(string from,
+                                               vector< pair<string,string> > recipients,
+                                               string asset_symbol,
+                                               string memo,
+                                               bool broadcast = false);
+
+      /** Broadcast already signed transactions, keeping several broadcasts in flight at once.
+       *
+       * @param transactions the signed transactions to broadcast
+       * @returns the error of each transaction that was not accepted, keyed by its position in transactions
+       */
+      map<uint32_t, string> broadcast_transactions(vector<signed_transaction> transactions);
+
       /**
        *  This method is used to convert a JSON transaction to its transactin ID.
        */
@@ -1529,6 +1579,8 @@ FC_REFLECT( graphene::wallet::worker_vote_delta,
    (vote_abstain)
 )
 
+FC_REFLECT( graphene::wallet::bulk_transfer_result, (transactions)(failed) )
+
 FC_REFLECT_DERIVED( graphene::wallet::signed_block_with_info, (graphene::chain::signed_block),
    (block_id)(signing_key)(transaction_ids) )
 
@@ -1562,6 +1614,7 @@ FC_API( graphene::wallet::wallet_api,
         (list_assets)
         (import_key)
         (import_accounts)
+        (recover_accounts_from_brain_key)
         (import_account_keys)
         (import_balance)
         (suggest_brain_key)
@@ -1575,6 +1628,8 @@ FC_API( graphene::wallet::wallet_api,
         (cancel_order)
         (transfer)
         (transfer2)
+        (bulk_transfer)
+        (broadcast_transactions)
         (get_transaction_id)
         (create_asset)
         (update_asset)
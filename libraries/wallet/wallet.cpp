@@ -23,6 +23,8 @@
  */
 #include <algorithm>
 #include <cctype>
+#include <deque>
+#include <thread>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -59,6 +61,7 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/thread/mutex.hpp>
 #include <fc/thread/scoped_lock.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <graphene/app/api.hpp>
 #include <graphene/chain/asset_object.hpp>
@@ -408,6 +411,11 @@ public:
       {
          on_block_applied( block_id );
       } );
+      // everything fetched through get_objects or get_accounts from now on is pushed to us when it changes
+      _remote_db->set_subscribe_callback( [this](const variant& updates )
+      {
+         on_subscribed_objects_changed( updates );
+      }, false );
 
       _wallet.chain_id = _chain_id;
       _wallet.ws_server = initial_data.ws_server;
@@ -447,6 +455,75 @@ public:
       fc::async([this]{resync();}, "Resync after block");
    }
 
+   /** keeps the chain state cache up to date, updates arrive as objects and removals as bare ids */
+   void on_subscribed_objects_changed( const variant& updates )
+   {
+      if( !updates.is_array() )
+         return;
+      for( const variant& item : updates.get_array() )
+      {
+         if( item.is_object() )
+         {
+            if( !item.get_object().contains( "id" ) )
+               continue;
+            object_id_type id = item["id"].as<object_id_type>();
+            if( id == object_id_type( global_property_id_type() ) )
+               _global_props_cache = item.as<global_property_object>();
+            else if( id == object_id_type( dynamic_global_property_id_type() ) )
+               _dynamic_props_cache = item.as<dynamic_global_property_object>();
+            else if( id.is<account_id_type>() && _account_cache.count( account_id_type( id ) ) )
+               _account_cache[account_id_type( id )] = item.as<account_object>();
+         }
+         else if( item.is_string() )
+         {
+            object_id_type id = item.as<object_id_type>();
+            if( id.is<account_id_type>() )
+               _account_cache.erase( account_id_type( id ) );
+         }
+      }
+   }
+
+   /** fetches both property objects in one call, which also subscribes to their changes */
+   void refresh_chain_properties()const
+   {
+      fc::variants objects = _remote_db->get_objects( { object_id_type( global_property_id_type() ),
+                                                        object_id_type( dynamic_global_property_id_type() ) } );
+      FC_ASSERT( objects.size() == 2 && !objects[0].is_null() && !objects[1].is_null() );
+      _global_props_cache = objects[0].as<global_property_object>();
+      _dynamic_props_cache = objects[1].as<dynamic_global_property_object>();
+   }
+
+   /**
+    *  @return the accounts from the cache, the ones not cached yet are fetched in one call, which also
+    *  subscribes to their changes so they never need to be fetched again
+    */
+   vector< optional<account_object> > get_cached_accounts( const vector<account_id_type>& ids )const
+   {
+      vector<account_id_type> missing;
+      for( const account_id_type& id : ids )
+         if( !_account_cache.count( id ) )
+            missing.push_back( id );
+      if( !missing.empty() )
+      {
+         vector< optional<account_object> > fetched = _remote_db->get_accounts( missing );
+         for( const optional<account_object>& acct : fetched )
+            if( acct )
+               _account_cache[acct->id] = *acct;
+      }
+
+      vector< optional<account_object> > result;
+      result.reserve( ids.size() );
+      for( const account_id_type& id : ids )
+      {
+         auto itr = _account_cache.find( id );
+         if( itr == _account_cache.end() )
+            result.emplace_back();
+         else
+            result.emplace_back( itr->second );
+      }
+      return result;
+   }
+
    bool copy_wallet_file( string destination_filename )
    {
       fc::path src_path = get_wallet_filename();
@@ -557,17 +634,19 @@ public:
    }
    global_property_object get_global_properties() const
    {
-      return _remote_db->get_global_properties();
+      if( !_global_props_cache )
+         refresh_chain_properties();
+      return *_global_props_cache;
    }
    dynamic_global_property_object get_dynamic_global_properties() const
    {
-      return _remote_db->get_dynamic_global_properties();
+      if( !_dynamic_props_cache )
+         refresh_chain_properties();
+      return *_dynamic_props_cache;
    }
    account_object get_account(account_id_type id) const
    {
-      if( _wallet.my_accounts.get<by_id>().count(id) )
-         return *_wallet.my_accounts.get<by_id>().find(id);
-      auto rec = _remote_db->get_accounts({id}).front();
+      auto rec = get_cached_accounts({id}).front();
       FC_ASSERT(rec);
       return *rec;
    }
@@ -584,14 +663,12 @@ public:
          if( _wallet.my_accounts.get<by_name>().count(account_name_or_id) )
          {
             auto local_account = *_wallet.my_accounts.get<by_name>().find(account_name_or_id);
-            auto blockchain_account = _remote_db->lookup_account_names({account_name_or_id}).front();
+            auto blockchain_account = get_cached_accounts({local_account.id}).front();
             FC_ASSERT( blockchain_account );
-            if (local_account.id != blockchain_account->id)
-               elog("my account id ${id} different from blockchain id ${id2}", ("id", local_account.id)("id2", blockchain_account->id));
             if (local_account.name != blockchain_account->name)
                elog("my account name ${id} different from blockchain name ${id2}", ("id", local_account.name)("id2", blockchain_account->name));
 
-            return *_wallet.my_accounts.get<by_name>().find(account_name_or_id);
+            return *blockchain_account;
          }
          auto rec = _remote_db->lookup_account_names({account_name_or_id}).front();
          FC_ASSERT( rec && rec->name == account_name_or_id );
@@ -838,7 +915,7 @@ public:
       auto fee_asset_obj = get_asset(fee_asset);
       asset total_fee = fee_asset_obj.amount(0);
 
-      auto gprops = _remote_db->get_global_properties().parameters;
+      auto gprops = get_global_properties().parameters;
       if( fee_asset_obj.get_id() != asset_id_type() )
       {
          for( auto& op : _builder_transactions[handle].operations )
@@ -880,7 +957,7 @@ public:
       if( review_period_seconds )
          op.review_period_seconds = review_period_seconds;
       trx.operations = {op};
-      _remote_db->get_global_properties().parameters.current_fees->set_fee( trx.operations.front() );
+      get_global_properties().parameters.current_fees->set_fee( trx.operations.front() );
 
       return trx = sign_transaction(trx, broadcast);
    }
@@ -901,7 +978,7 @@ public:
       if( review_period_seconds )
          op.review_period_seconds = review_period_seconds;
       trx.operations = {op};
-      _remote_db->get_global_properties().parameters.current_fees->set_fee( trx.operations.front() );
+      get_global_properties().parameters.current_fees->set_fee( trx.operations.front() );
 
       return trx = sign_transaction(trx, broadcast);
    }
@@ -951,7 +1028,7 @@ public:
 
       tx.operations.push_back( account_create_op );
 
-      auto current_fees = _remote_db->get_global_properties().parameters.current_fees;
+      auto current_fees = get_global_properties().parameters.current_fees;
       set_operation_fees( tx, current_fees );
 
       vector<public_key_type> paying_keys = registrar_account_object.active.get_keys();
@@ -992,48 +1069,175 @@ public:
       op.account_to_upgrade = account_obj.get_id();
       op.upgrade_to_lifetime_member = true;
       tx.operations = {op};
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
    } FC_CAPTURE_AND_RETHROW( (name) ) }
 
 
+   /**
+    *  Derives the keys of prefix with sequence numbers [first, first+count).  Computing the public key is
+    *  the expensive part, so the range is split over one thread per core.
+    */
+   vector< pair<fc::ecc::private_key, public_key_type> > derive_keys( const string& prefix, int first, int count )
+   {
+      if( _derivation_threads.empty() )
+      {
+         const unsigned n = std::max( 1u, std::thread::hardware_concurrency() );
+         for( unsigned i = 0; i < n; ++i )
+            _derivation_threads.emplace_back( new fc::thread( "derive_keys_" + fc::to_string( uint64_t(i) ) ) );
+      }
+
+      vector< pair<fc::ecc::private_key, public_key_type> > result( count );
+      vector< fc::future<void> > done;
+      const int per_thread = ( count + int(_derivation_threads.size()) - 1 ) / int(_derivation_threads.size());
+      for( int begin = 0, t = 0; begin < count; begin += per_thread, ++t )
+      {
+         const int end = std::min( count, begin + per_thread );
+         done.push_back( _derivation_threads[t]->async( [&result,&prefix,first,begin,end]() {
+            for( int i = begin; i < end; ++i )
+            {
+               result[i].first = derive_private_key( prefix, first + i );
+               result[i].second = result[i].first.get_public_key();
+            }
+         }, "derive_keys" ) );
+      }
+      for( auto& f : done )
+         f.wait();
+      return result;
+   }
+
    // This function generates derived keys starting with index 0 and keeps incrementing
    // the index until it finds a key that isn't registered in the block chain.  To be
    // safer, it continues checking for a few more keys to make sure there wasn't a short gap
    // caused by a failed registration or the like.
    int find_first_unused_derived_key_index(const fc::ecc::private_key& parent_key)
    {
+      const int batch_size = 32;
+      const string prefix = key_to_wif(parent_key);
       int first_unused_index = 0;
       int number_of_consecutive_unused_keys = 0;
-      for (int key_index = 0; ; ++key_index)
+      for (int first = 0; ; first += batch_size)
       {
-         fc::ecc::private_key derived_private_key = derive_private_key(key_to_wif(parent_key), key_index);
-         graphene::chain::public_key_type derived_public_key = derived_private_key.get_public_key();
-         if( _keys.find(derived_public_key) == _keys.end() )
+         auto derived_keys = derive_keys( prefix, first, batch_size );
+         for (int i = 0; i < batch_size; ++i)
          {
-            if (number_of_consecutive_unused_keys)
+            const int key_index = first + i;
+            const graphene::chain::public_key_type& derived_public_key = derived_keys[i].second;
+            if( _keys.find(derived_public_key) == _keys.end() )
             {
-               ++number_of_consecutive_unused_keys;
-               if (number_of_consecutive_unused_keys > 5)
-                  return first_unused_index;
+               if (number_of_consecutive_unused_keys)
+               {
+                  ++number_of_consecutive_unused_keys;
+                  if (number_of_consecutive_unused_keys > 5)
+                     return first_unused_index;
+               }
+               else
+               {
+                  first_unused_index = key_index;
+                  number_of_consecutive_unused_keys = 1;
+               }
             }
             else
             {
-               first_unused_index = key_index;
-               number_of_consecutive_unused_keys = 1;
+               // key_index is used
+               first_unused_index = 0;
+               number_of_consecutive_unused_keys = 0;
             }
          }
-         else
+      }
+   }
+
+   struct used_derived_key
+   {
+      int                      index;
+      fc::ecc::private_key     key;
+      vector<account_id_type>  accounts;
+   };
+
+   /**
+    *  Finds the keys derived from prefix that accounts on the chain refer to, asking the node about a whole
+    *  batch of keys in one call.  Scanning stops once gap_limit consecutive keys turned out to be unused.
+    */
+   vector<used_derived_key> scan_derived_keys( const string& prefix, uint32_t gap_limit )
+   {
+      const int batch_size = std::max<int>( gap_limit, 100 );
+      vector<used_derived_key> result;
+      int last_used = -1;
+      for( int first = 0; first - last_used - 1 < int(gap_limit); first += batch_size )
+      {
+         auto derived_keys = derive_keys( prefix, first, batch_size );
+         vector<public_key_type> public_keys;
+         public_keys.reserve( derived_keys.size() );
+         for( const auto& k : derived_keys )
+            public_keys.push_back( k.second );
+
+         vector< vector<account_id_type> > references = _remote_db->get_key_references( public_keys );
+         FC_ASSERT( references.size() == public_keys.size() );
+         for( int i = 0; i < batch_size; ++i )
          {
-            // key_index is used
-            first_unused_index = 0;
-            number_of_consecutive_unused_keys = 0;
+            if( references[i].empty() )
+               continue;
+            result.push_back( used_derived_key{ first + i, derived_keys[i].first, std::move( references[i] ) } );
+            last_used = first + i;
          }
+         ilog( "Scanned ${n} derived keys, ${u} in use", ("n", first + batch_size)("u", result.size()) );
       }
+      return result;
    }
 
+   map<string, vector<public_key_type>> recover_accounts_from_brain_key( string brain_key, uint32_t gap_limit )
+   { try {
+      FC_ASSERT( !self.is_locked() );
+      FC_ASSERT( gap_limit > 0 );
+      string normalized_brain_key = normalize_brain_key( brain_key );
+
+      map< account_id_type, vector<fc::ecc::private_key> > found;
+      auto record = [&]( const used_derived_key& k ) {
+         for( const account_id_type& a : k.accounts )
+            found[a].push_back( k.key );
+      };
+
+      // owner keys are the brain key's own sequence, active keys are derived from an owner key and memo
+      // keys from an active key, see create_account_with_private_key
+      vector<fc::ecc::private_key> owner_keys;
+      bool have_first_owner_key = false;
+      for( const used_derived_key& owner : scan_derived_keys( normalized_brain_key, gap_limit ) )
+      {
+         record( owner );
+         owner_keys.push_back( owner.key );
+         have_first_owner_key |= owner.index == 0;
+      }
+      // the owner key may have been replaced since, while the active keys derived from it are still in use
+      if( !have_first_owner_key )
+         owner_keys.push_back( derive_private_key( normalized_brain_key, 0 ) );
+
+      for( const fc::ecc::private_key& owner_key : owner_keys )
+         for( const used_derived_key& active : scan_derived_keys( key_to_wif( owner_key ), gap_limit ) )
+         {
+            record( active );
+            for( const used_derived_key& memo : scan_derived_keys( key_to_wif( active.key ), gap_limit ) )
+               record( memo );
+         }
+
+      map<string, vector<public_key_type>> result;
+      for( const auto& item : found )
+      {
+         const account_object account = get_account( item.first );
+         vector<public_key_type>& imported = result[account.name];
+         for( const fc::ecc::private_key& key : item.second )
+         {
+            public_key_type pub_key = key.get_public_key();
+            if( std::find( imported.begin(), imported.end(), pub_key ) != imported.end() )
+               continue;
+            import_key( account.name, key_to_wif( key ) );
+            imported.push_back( pub_key );
+         }
+      }
+      return result;
+   } FC_CAPTURE_AND_RETHROW( (gap_limit) ) }
+
    signed_transaction create_account_with_private_key(fc::ecc::private_key owner_privkey,
                                                       string account_name,
                                                       string registrar_account,
@@ -1078,7 +1282,7 @@ public:
 
          tx.operations.push_back( account_create_op );
 
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+         set_operation_fees( tx, get_global_properties().parameters.current_fees);
 
          vector<public_key_type> paying_keys = registrar_account_object.active.get_keys();
 
@@ -1143,7 +1347,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( create_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1172,7 +1376,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1193,7 +1397,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1217,7 +1421,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1239,7 +1443,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( publish_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1263,7 +1467,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( fund_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1285,7 +1489,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( reserve_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1306,7 +1510,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( settle_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1327,7 +1531,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( settle_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1345,7 +1549,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( whitelist_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1363,7 +1567,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( committee_member_create_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1459,7 +1663,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( witness_create_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       _wallet.pending_witness_registrations[owner_account] = key_to_wif(witness_private_key);
@@ -1486,7 +1690,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( witness_update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1537,7 +1741,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1602,7 +1806,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1612,7 +1816,7 @@ public:
    { try {
       fc::optional<vesting_balance_id_type> vbid = maybe_id<vesting_balance_id_type>( account_name );
       std::vector<vesting_balance_object_with_info> result;
-      fc::time_point_sec now = _remote_db->get_dynamic_global_properties().time;
+      fc::time_point_sec now = get_dynamic_global_properties().time;
 
       if( vbid )
       {
@@ -1660,7 +1864,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( vesting_balance_withdraw_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1695,7 +1899,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( account_update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1729,7 +1933,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( account_update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1760,7 +1964,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( account_update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1786,7 +1990,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back( account_update_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1815,7 +2019,7 @@ public:
       /// TODO: fetch the accounts specified via other_auths as well.
 
       vector< optional<account_object> > approving_account_objects =
-            _remote_db->get_accounts( v_approving_account_ids );
+            get_cached_accounts( v_approving_account_ids );
 
       /// TODO: recursively check one layer deeper in the authority tree for keys
 
@@ -1949,7 +2153,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back(op);
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -1970,7 +2174,7 @@ public:
 
       signed_transaction trx;
       trx.operations = {op};
-      set_operation_fees( trx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( trx, get_global_properties().parameters.current_fees);
       trx.validate();
       idump((broadcast));
 
@@ -1987,7 +2191,7 @@ public:
          op.fee_paying_account = get_object<limit_order_object>(order_id).seller;
          op.order = order_id;
          trx.operations = {op};
-         set_operation_fees( trx, _remote_db->get_global_properties().parameters.current_fees);
+         set_operation_fees( trx, get_global_properties().parameters.current_fees);
 
          trx.validate();
          return sign_transaction(trx, broadcast);
@@ -2022,12 +2226,167 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back(xfer_op);
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees( tx, get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction(tx, broadcast);
    } FC_CAPTURE_AND_RETHROW( (from)(to)(amount)(asset_symbol)(memo)(broadcast) ) }
 
+   bulk_transfer_result bulk_transfer(string from, vector< pair<string,string> > recipients,
+                                      string asset_symbol, string memo, bool broadcast)
+   { try {
+      FC_ASSERT( !self.is_locked() );
+      fc::optional<asset_object> asset_obj = get_asset(asset_symbol);
+      FC_ASSERT(asset_obj, "Could not find asset matching ${asset}", ("asset", asset_symbol));
+
+      account_object from_account = get_account(from);
+
+      // resolve all recipients in one call instead of one lookup per transfer
+      vector<string> names;
+      for( const auto& r : recipients )
+         if( !maybe_id<account_id_type>( r.first ) )
+            names.push_back( r.first );
+      vector< optional<account_object> > named = _remote_db->lookup_account_names( names );
+      map<string, account_object> by_name;
+      for( size_t i = 0; i < names.size(); ++i )
+         if( named[i] )
+            by_name[names[i]] = *named[i];
+      vector<account_id_type> ids;
+      for( const auto& r : recipients )
+         if( auto id = maybe_id<account_id_type>( r.first ) )
+            ids.push_back( *id );
+      vector< optional<account_object> > by_id = get_cached_accounts( ids );
+      for( size_t i = 0; i < ids.size(); ++i )
+         if( by_id[i] )
+            by_name[std::string( object_id_type( ids[i] ) )] = *by_id[i];
+
+      auto fees = get_global_properties().parameters.current_fees;
+      bulk_transfer_result result;
+      result.transactions.resize( recipients.size() );
+      for( uint32_t i = 0; i < recipients.size(); ++i )
+      {
+         try
+         {
+            const auto& r = recipients[i];
+            auto to = by_name.find( r.first );
+            FC_ASSERT( to != by_name.end(), "Could not find account ${a}", ("a", r.first) );
+            const account_object& to_account = to->second;
+
+            transfer_operation xfer_op;
+            xfer_op.from = from_account.id;
+            xfer_op.to = to_account.id;
+            xfer_op.amount = asset_obj->amount_from_string( r.second );
+            if( memo.size() )
+            {
+               xfer_op.memo = memo_data();
+               xfer_op.memo->from = from_account.options.memo_key;
+               xfer_op.memo->to = to_account.options.memo_key;
+               xfer_op.memo->set_message(get_private_key(from_account.options.memo_key),
+                                         to_account.options.memo_key, memo);
+            }
+
+            signed_transaction tx;
+            tx.operations.push_back(xfer_op);
+            set_operation_fees( tx, fees );
+            tx.validate();
+            result.transactions[i] = sign_transaction( tx, false );
+         }
+         catch( const fc::exception& e )
+         {
+            result.failed[i] = e.to_string();
+         }
+      }
+
+      if( broadcast )
+      {
+         vector<uint32_t> to_send;
+         for( uint32_t i = 0; i < recipients.size(); ++i )
+            if( !result.failed.count( i ) )
+               to_send.push_back( i );
+
+         // a second round resends what was rejected for a stale reference block, signed against the new head
+         for( int round = 0; round < 2 && !to_send.empty(); ++round )
+         {
+            vector<signed_transaction> batch;
+            batch.reserve( to_send.size() );
+            for( uint32_t i : to_send )
+               batch.push_back( result.transactions[i] );
+
+            vector<uint32_t> stale;
+            for( const auto& f : broadcast_transactions( batch ) )
+            {
+               const uint32_t i = to_send[f.first];
+               if( round == 0 && is_stale_reference( f.second ) )
+                  stale.push_back( i );
+               else
+                  result.failed[i] = f.second;
+            }
+
+            to_send.clear();
+            for( uint32_t i : stale )
+            {
+               try
+               {
+                  signed_transaction tx = result.transactions[i];
+                  tx.signatures.clear();
+                  result.transactions[i] = sign_transaction( tx, false );
+                  to_send.push_back( i );
+               }
+               catch( const fc::exception& e )
+               {
+                  result.failed[i] = e.to_string();
+               }
+            }
+         }
+      }
+      return result;
+   } FC_CAPTURE_AND_RETHROW( (from)(recipients)(asset_symbol)(memo)(broadcast) ) }
+
+   /** @return true if a transaction was rejected because it refers to a block or time the node has moved past */
+   static bool is_stale_reference( const string& error )
+   {
+      return error.find( "ref_block_prefix" ) != string::npos ||
+             error.find( "trx.expiration" ) != string::npos;
+   }
+
+   map<uint32_t, string> broadcast_transactions( const vector<signed_transaction>& transactions )
+   {
+      // Keep a window of calls in flight rather than waiting for each reply before sending the next one.
+      const size_t max_in_flight = 64;
+      map<uint32_t, string> failed;
+      std::deque< std::pair< uint32_t, fc::future<void> > > in_flight;
+
+      auto wait_oldest = [&]() {
+         try
+         {
+            in_flight.front().second.wait();
+         }
+         catch( const fc::exception& e )
+         {
+            const uint32_t i = in_flight.front().first;
+            elog( "Caught exception while broadcasting tx ${id}:  ${e}", ("id", transactions[i].id().str())("e", e.to_detail_string()) );
+            failed[i] = e.to_string();
+            // our idea of the head block is out of date, fetch it again before signing anything else
+            if( is_stale_reference( failed[i] ) )
+               _dynamic_props_cache.reset();
+         }
+         in_flight.pop_front();
+      };
+
+      for( uint32_t i = 0; i < transactions.size(); ++i )
+      {
+         if( in_flight.size() >= max_in_flight )
+            wait_oldest();
+         const signed_transaction& tx = transactions[i];
+         in_flight.emplace_back( i, fc::async( [this,&tx]() { _remote_net_broadcast->broadcast_transaction( tx ); },
+                                               "broadcast_transactions" ) );
+      }
+      while( !in_flight.empty() )
+         wait_oldest();
+
+      return failed;
+   }
+
    signed_transaction issue_asset(string to_account, string amount, string symbol,
                                   string memo, bool broadcast = false)
    {
@@ -2052,7 +2411,7 @@ public:
 
       signed_transaction tx;
       tx.operations.push_back(issue_op);
-      set_operation_fees(tx,_remote_db->get_global_properties().parameters.current_fees);
+      set_operation_fees(tx,get_global_properties().parameters.current_fees);
       tx.validate();
 
       return sign_transaction(tx, broadcast);
@@ -2584,6 +2943,13 @@ public:
    optional< fc::api<network_node_api> > _remote_net_node;
    optional< fc::api<graphene::debug_witness::debug_api> > _remote_debug;
 
+   vector< std::unique_ptr<fc::thread> >              _derivation_threads;
+
+   // chain state kept current by the subscription callback, so signing needs no round trips
+   mutable optional<global_property_object>           _global_props_cache;
+   mutable optional<dynamic_global_property_object>   _dynamic_props_cache;
+   mutable map<account_id_type, account_object>       _account_cache;
+
    flat_map<string, operation> _prototype_ops;
 
    static_variant_map _operation_which_map = create_static_variant_map< operation >();
@@ -2964,6 +3330,20 @@ bool wallet_api::import_key(string account_name_or_id, string wif_key)
    return false;
 }
 
+map<string, vector<public_key_type>> wallet_api::recover_accounts_from_brain_key( string brain_key, uint32_t gap_limit )
+{
+   FC_ASSERT(!is_locked());
+   copy_wallet_file( "before-brain-key-recovery" );
+
+   auto result = my->recover_accounts_from_brain_key( brain_key, gap_limit );
+   if( !result.empty() )
+   {
+      save_wallet_file();
+      copy_wallet_file( "after-brain-key-recovery" );
+   }
+   return result;
+}
+
 map<string, bool> wallet_api::import_accounts( string filename, string password )
 {
    FC_ASSERT( !is_locked() );
@@ -3131,6 +3511,17 @@ signed_transaction wallet_api::transfer(string from, string to, string amount,
 {
    return my->transfer(from, to, amount, asset_symbol, memo, broadcast);
 }
+bulk_transfer_result wallet_api::bulk_transfer(string from, vector< pair<string,string> > recipients,
+                                               string asset_symbol, string memo, bool broadcast /* = false */)
+{
+   return my->bulk_transfer(from, recipients, asset_symbol, memo, broadcast);
+}
+
+map<uint32_t, string> wallet_api::broadcast_transactions(vector<signed_transaction> transactions)
+{
+   return my->broadcast_transactions(transactions);
+}
+
 signed_transaction wallet_api::create_asset(string issuer,
                                             string symbol,
                                             uint8_t precision,
@@ -3571,7 +3962,7 @@ namespace detail {
 vector< signed_transaction > wallet_api_impl::import_balance( string name_or_id, const vector<string>& wif_keys, bool broadcast )
 { try {
    FC_ASSERT(!is_locked());
-   const dynamic_global_property_object& dpo = _remote_db->get_dynamic_global_properties();
+   const dynamic_global_property_object& dpo = get_dynamic_global_properties();
    account_object claimer = get_account( name_or_id );
    uint32_t max_ops_per_tx = 30;
 
@@ -3664,7 +4055,7 @@ vector< signed_transaction > wallet_api_impl::import_balance( string name_or_id,
       tx.operations.reserve( ctx.ops.size() );
       for( const balance_claim_operation& op : ctx.ops )
          tx.operations.emplace_back( op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.current_fees );
+      set_operation_fees( tx, get_global_properties().parameters.current_fees );
       tx.validate();
       signed_transaction signed_tx = sign_transaction( tx, false );
       for( const address& addr : ctx.addrs )
@@ -3859,7 +4250,7 @@ blind_confirmation wallet_api::transfer_from_blind( string from_blind_account_ke
    transfer_from_blind_operation from_blind;
 
 
-   auto fees  = my->_remote_db->get_global_properties().parameters.current_fees;
+   auto fees  = my->get_global_properties().parameters.current_fees;
    fc::optional<asset_object> asset_obj = get_asset(symbol);
    FC_ASSERT(asset_obj.valid(), "Could not find asset matching ${asset}", ("asset", symbol));
    auto amount = asset_obj->amount_from_string(amount_in);
@@ -3937,7 +4328,7 @@ blind_confirmation wallet_api::blind_transfer_help( string from_key_or_label,
    blind_transfer_operation blind_tr;
    blind_tr.outputs.resize(2);
 
-   auto fees  = my->_remote_db->get_global_properties().parameters.current_fees;
+   auto fees  = my->get_global_properties().parameters.current_fees;
 
    auto amount = asset_obj->amount_from_string(amount_in);
 
@@ -4158,7 +4549,7 @@ blind_confirmation wallet_api::transfer_to_blind( string from_account_id_or_name
               [&]( const blind_output& a, const blind_output& b ){ return a.commitment < b.commitment; } );
 
    confirm.trx.operations.push_back( bop );
-   my->set_operation_fees( confirm.trx, my->_remote_db->get_global_properties().parameters.current_fees);
+   my->set_operation_fees( confirm.trx, my->get_global_properties().parameters.current_fees);
    confirm.trx.validate();
    confirm.trx = sign_transaction(confirm.trx, broadcast);
 
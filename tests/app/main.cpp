@@ -31,7 +31,10 @@
 #include <graphene/utilities/tempdir.hpp>
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/delayed_node/delayed_node_plugin.hpp>
 
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/smart_ref_impl.hpp>
 
@@ -42,7 +45,11 @@
 
 using namespace graphene;
 
-BOOST_AUTO_TEST_CASE( two_node_network )
+/**
+ *  Connects two applications running the given p2p-engine, relays a transaction from the first
+ *  and a block from the second and checks that both arrived.
+ */
+static void test_two_node_network( const string& engine, const string& endpoint1, const string& endpoint2 )
 {
    using namespace graphene::chain;
    using namespace graphene::app;
@@ -58,7 +65,8 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       graphene::app::application app1;
       app1.register_plugin<graphene::account_history::account_history_plugin>();
       boost::program_options::variables_map cfg;
-      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:3939"), false));
+      cfg.emplace("p2p-endpoint", boost::program_options::variable_value(endpoint1, false));
+      cfg.emplace("p2p-engine", boost::program_options::variable_value(engine, false));
       app1.initialize(app_dir.path(), cfg);
 
       BOOST_TEST_MESSAGE( "Creating and initializing app2" );
@@ -67,8 +75,8 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       app2.register_plugin<account_history::account_history_plugin>();
       auto cfg2 = cfg;
       cfg2.erase("p2p-endpoint");
-      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:4040"), false));
-      cfg2.emplace("seed-node", boost::program_options::variable_value(vector<string>{"127.0.0.1:3939"}, false));
+      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(endpoint2, false));
+      cfg2.emplace("seed-node", boost::program_options::variable_value(vector<string>{endpoint1}, false));
       app2.initialize(app2_dir.path(), cfg2);
 
       BOOST_TEST_MESSAGE( "Starting app1 and waiting 500 ms" );
@@ -152,3 +160,133 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( two_node_network )
+{
+   test_two_node_network( "legacy", "127.0.0.1:3939", "127.0.0.1:4040" );
+}
+
+BOOST_AUTO_TEST_CASE( two_node_push_network )
+{
+   test_two_node_network( "push", "127.0.0.1:3941", "127.0.0.1:4042" );
+}
+
+/// A genesis with every witness signing with nathan's key, as in the example genesis
+static graphene::chain::genesis_state_type make_test_genesis( const fc::ecc::private_key& key )
+{
+   using namespace graphene::chain;
+   genesis_state_type genesis;
+   genesis.initial_parameters.current_fees = fee_schedule::get_default();
+   genesis.initial_active_witnesses = GRAPHENE_DEFAULT_MIN_WITNESS_COUNT;
+   genesis.initial_timestamp = time_point_sec( fc::time_point::now().sec_since_epoch() /
+                                               genesis.initial_parameters.block_interval *
+                                               genesis.initial_parameters.block_interval );
+   for( uint64_t i = 0; i < genesis.initial_active_witnesses; ++i )
+   {
+      auto name = "init"+fc::to_string(i);
+      genesis.initial_accounts.emplace_back( name, key.get_public_key(), key.get_public_key(), true );
+      genesis.initial_committee_candidates.push_back({name});
+      genesis.initial_witness_candidates.push_back({name, key.get_public_key()});
+   }
+   return genesis;
+}
+
+/// Gives the other tasks of this thread up to 10 seconds to make done() true
+static bool wait_for( const std::function<bool()>& done )
+{
+   for( uint32_t i = 0; i < 200 && !done(); ++i )
+      fc::usleep( fc::milliseconds( 50 ) );
+   return done();
+}
+
+/**
+ *  Starts a delayed node while its trusted node is a few hundred blocks ahead, so that the sync runs several
+ *  get_blocks batches at once, and switches the trusted node to another fork in the meantime.  The delayed node
+ *  must end up with exactly the trusted node's irreversible blocks.
+ */
+BOOST_AUTO_TEST_CASE( delayed_node_sync_across_fork )
+{
+   using namespace graphene::chain;
+   using boost::program_options::variable_value;
+   try {
+      fc::temp_directory trusted_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory delayed_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory fork_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_file genesis_json;
+
+      const fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+      genesis_state_type genesis = make_test_genesis( nathan_key );
+      fc::json::save_to_file( genesis, genesis_json.path() );
+      // the chain id the applications derive from the file
+      std::string genesis_str;
+      fc::read_file_contents( genesis_json.path(), genesis_str );
+      genesis.initial_chain_id = fc::sha256::hash( genesis_str );
+      const boost::filesystem::path genesis_path( genesis_json.path().generic_string() );
+
+      auto produce = [&]( database& db, uint32_t slot ) -> signed_block
+      {
+         return db.generate_block( db.get_slot_time( slot ), db.get_scheduled_witness( slot ), nathan_key,
+                                   database::skip_nothing );
+      };
+
+      BOOST_TEST_MESSAGE( "Starting the trusted node with 300 blocks" );
+      graphene::app::application trusted;
+      boost::program_options::variables_map cfg;
+      cfg.emplace("p2p-endpoint", variable_value(string("127.0.0.1:3945"), false));
+      cfg.emplace("rpc-endpoint", variable_value(string("127.0.0.1:8095"), false));
+      cfg.emplace("genesis-json", variable_value(genesis_path, false));
+      trusted.initialize( trusted_dir.path(), cfg );
+      trusted.startup();
+      std::shared_ptr<database> db1 = trusted.chain_database();
+
+      // a second copy of the chain, to build the competing fork on
+      database fork_db;
+      fork_db.open( fork_dir.path(), [&]{ return genesis; } );
+      for( uint32_t i = 0; i < 300; ++i )
+         fork_db.push_block( produce( *db1, 1 ) );
+
+      BOOST_TEST_MESSAGE( "Starting the delayed node" );
+      graphene::app::application delayed;
+      delayed.register_plugin<graphene::delayed_node::delayed_node_plugin>();
+      boost::program_options::variables_map cfg2;
+      cfg2.emplace("p2p-endpoint", variable_value(string("127.0.0.1:3946"), false));
+      cfg2.emplace("genesis-json", variable_value(genesis_path, false));
+      cfg2.emplace("trusted-node", variable_value(string("127.0.0.1:8095"), false));
+      delayed.initialize( delayed_dir.path(), cfg2 );
+      delayed.initialize_plugins( cfg2 );
+      delayed.startup();
+      delayed.startup_plugins();
+      std::shared_ptr<database> db2 = delayed.chain_database();
+
+      BOOST_TEST_MESSAGE( "Switching the trusted node to a longer fork" );
+      // both branches start at the head, which is above the last irreversible block
+      const uint32_t fork_point = db1->head_block_num();
+      BOOST_REQUIRE( db1->get_dynamic_global_properties().last_irreversible_block_num < fork_point );
+      produce( *db1, 1 );
+      produce( *db1, 1 );
+      // skipping a slot makes the other branch differ from the first block on
+      vector<signed_block> fork;
+      fork.push_back( produce( fork_db, 2 ) );
+      for( uint32_t i = 0; i < 3; ++i )
+         fork.push_back( produce( fork_db, 1 ) );
+      for( const signed_block& b : fork )
+         db1->push_block( b );
+      BOOST_REQUIRE( db1->head_block_id() == fork.back().id() );
+
+      for( uint32_t i = 0; i < 30; ++i )
+         produce( *db1, 1 );
+      const uint32_t lib = db1->get_dynamic_global_properties().last_irreversible_block_num;
+      BOOST_REQUIRE( lib > fork_point + fork.size() );
+
+      BOOST_TEST_MESSAGE( "Waiting for the delayed node to catch up" );
+      BOOST_REQUIRE( wait_for( [&]() { return db2->head_block_num() == lib; } ) );
+      for( uint32_t n = 1; n <= lib; ++n )
+         BOOST_CHECK( db2->get_block_id_for_num( n ) == db1->get_block_id_for_num( n ) );
+      BOOST_CHECK( db2->get_block_id_for_num( fork_point + 1 ) == fork.front().id() );
+
+      fork_db.close();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <random>
+
+using namespace graphene::chain;
+
+/**
+ *  Balance updates as done by a stream of transfers: every transfer debits one account and credits another,
+ *  spread over a few assets, with an undo session per block the way block production applies them.
+ */
+BOOST_AUTO_TEST_CASE( balance_bench )
+{
+   try {
+#ifdef NDEBUG
+      const int account_count  = 100000;
+      const int transfer_count = 2000000;
+#else
+      const int account_count  = 10000;
+      const int transfer_count = 200000;
+#endif
+      const int asset_count         = 4;
+      const int transfers_per_block = 1000;
+
+      genesis_state_type genesis_state;
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "target"+fc::to_string(i),
+            public_key_type( fc::ecc::private_key::regenerate( fc::digest( i ) ).get_public_key() ) );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      database db;
+      db.open( data_dir.path(), [&]{ return genesis_state; } );
+
+      const account_id_type first_account = db.get_index_type<account_index>().indices().get<by_name>().find( "target0" )->id;
+      auto account_of = [&]( int i ) { return first_account + i; };
+      // the balances only need asset ids, no asset objects are looked at unless a transfer fails
+      for( int i = 0; i < account_count; ++i )
+         for( int a = 0; a < asset_count; ++a )
+            db.adjust_balance( account_of( i ), asset( 1000000000, asset_id_type( a ) ) );
+
+      std::mt19937 rng( 42 );
+      std::uniform_int_distribution<int> pick_account( 0, account_count - 1 );
+      std::uniform_int_distribution<int> pick_asset( 0, asset_count - 1 );
+
+      auto start = fc::time_point::now();
+      for( int done = 0; done < transfer_count; )
+      {
+         auto session = db._undo_db.start_undo_session( true );
+         for( int i = 0; i < transfers_per_block && done < transfer_count; ++i, ++done )
+         {
+            asset amount( 1 + done % 100, asset_id_type( pick_asset( rng ) ) );
+            db.adjust_balance( account_of( pick_account( rng ) ), -amount );
+            db.adjust_balance( account_of( pick_account( rng ) ), amount );
+         }
+         session.commit();
+      }
+      auto elapsed = fc::time_point::now() - start;
+
+      ilog( "Applied ${n} transfers between ${a} accounts in ${t} ms, ${r} transfers/s",
+            ("n",transfer_count)("a",account_count)("t",elapsed.count() / 1000)
+            ("r",uint64_t(transfer_count) * 1000000 / std::max<int64_t>( elapsed.count(), 1 )) );
+
+      db.close();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
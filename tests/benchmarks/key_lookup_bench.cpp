@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/database_api.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+/**
+ *  Reverse key lookups as done by a wallet recovering accounts from a brain key: a large batch
+ *  of candidate keys, most of which are not referenced by any account.
+ */
+BOOST_AUTO_TEST_CASE( key_lookup_bench )
+{
+   try {
+#ifdef NDEBUG
+      const int account_count = 200000;
+      const int lookup_count  = 200000;
+#else
+      const int account_count = 20000;
+      const int lookup_count  = 20000;
+#endif
+
+      auto key_of = []( int i ) {
+         return public_key_type( fc::ecc::private_key::regenerate( fc::digest( i ) ).get_public_key() );
+      };
+
+      genesis_state_type genesis_state;
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "target"+fc::to_string(i), key_of(i) );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      database db;
+      db.open( data_dir.path(), [&]{ return genesis_state; } );
+
+      // one in ten candidates belongs to an account
+      vector<public_key_type> keys;
+      keys.reserve( lookup_count );
+      for( int i = 0; i < lookup_count; ++i )
+         keys.push_back( key_of( i % 10 == 0 ? i / 10 : account_count + i ) );
+
+      graphene::app::database_api api( db );
+      auto start = fc::time_point::now();
+      auto refs = api.get_key_references( keys );
+      auto elapsed = fc::time_point::now() - start;
+
+      size_t found = 0;
+      for( const auto& r : refs )
+         found += r.size();
+      BOOST_CHECK_EQUAL( found, size_t( lookup_count / 10 ) );
+
+      ilog( "Looked up ${n} keys in ${t} ms, ${r} keys/s, ${f} referenced",
+            ("n",lookup_count)("t",elapsed.count() / 1000)
+            ("r",uint64_t(lookup_count) * 1000000 / std::max<int64_t>( elapsed.count(), 1 ))("f",found) );
+
+      db.close();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
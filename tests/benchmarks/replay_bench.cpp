@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <cstdlib>
+#include <random>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+/**
+ *  Replay benchmarks.
+ *
+ *  A chain directory has the layout of a node's blockchain directory (the blocks are read
+ *  from database/block_num_to_block) plus the genesis.json it was started from.  The
+ *  following environment variables control the benchmarks:
+ *
+ *  GRAPHENE_BENCH_CHAIN_DIR    chain directory replayed by block_log_replay_bench
+ *  GRAPHENE_BENCH_OUTPUT_DIR   if set, synthetic chains are kept in subdirectories of it
+ *  GRAPHENE_BENCH_SKIP         skip flags used for replay: "replay" (the flags used by
+ *                              reindex, default), "none", "all" or a number
+ *
+ *  Transactions of the synthetic chains are not signed, so they can only be replayed with
+ *  skip_transaction_signatures and skip_authority_check set.
+ */
+namespace {
+
+struct replay_report
+{
+   uint32_t       blocks = 0;
+   uint64_t       transactions = 0;
+   uint64_t       operations = 0;
+   double         seconds = 0;
+   int64_t        peak_rss_kb = 0;
+   apply_profile  profile;
+};
+
+uint32_t replay_skip_flags()
+{
+   const uint32_t reindex_flags = database::skip_witness_signature |
+                                  database::skip_transaction_signatures |
+                                  database::skip_transaction_dupe_check |
+                                  database::skip_tapos_check |
+                                  database::skip_witness_schedule_check |
+                                  database::skip_authority_check;
+   const char* skip = getenv( "GRAPHENE_BENCH_SKIP" );
+   if( skip == nullptr || string( skip ) == "replay" ) return reindex_flags;
+   if( string( skip ) == "none" ) return database::skip_nothing;
+   if( string( skip ) == "all" ) return ~0;
+   return std::strtoul( skip, nullptr, 0 );
+}
+
+int64_t peak_rss_kb()
+{
+#ifndef WIN32
+   struct rusage usage;
+   if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+#ifdef __APPLE__
+      return usage.ru_maxrss / 1024;
+#else
+      return usage.ru_maxrss;
+#endif
+#endif
+   return 0;
+}
+
+fc::path blocks_dir( const fc::path& chain_dir )
+{
+   return chain_dir / "database" / "block_num_to_block";
+}
+
+replay_report replay_chain( const fc::path& chain_dir, uint32_t skip )
+{ try {
+   replay_report report;
+   auto genesis = fc::json::from_file( chain_dir / "genesis.json" ).as<genesis_state_type>();
+
+   block_database blocks;
+   blocks.open( blocks_dir( chain_dir ) );
+   auto last = blocks.last();
+   FC_ASSERT( last.valid(), "No blocks in ${d}", ("d",chain_dir) );
+
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   database db;
+   db.open( data_dir.path(), [&]{ return genesis; } );
+   db.get_apply_profiler().enable( true );
+
+   auto start = fc::time_point::now();
+   const uint32_t last_block_num = last->block_num();
+   for( uint32_t i = 1; i <= last_block_num; ++i )
+   {
+      auto block = blocks.fetch_by_number( i );
+      FC_ASSERT( block.valid(), "Block ${i} missing from ${d}", ("i",i)("d",chain_dir) );
+      db.push_block( *block, skip );
+      ++report.blocks;
+      report.transactions += block->transactions.size();
+      for( const auto& trx : block->transactions )
+         report.operations += trx.operations.size();
+   }
+   report.seconds = double( (fc::time_point::now() - start).count() ) / 1000000.0;
+   report.peak_rss_kb = peak_rss_kb();
+   report.profile = db.get_apply_profiler().get_profile();
+
+   db.close();
+   blocks.close();
+   return report;
+} FC_CAPTURE_AND_RETHROW( (chain_dir)(skip) ) }
+
+void print_report( const string& name, const replay_report& r )
+{
+   ilog( "${name}: replayed ${b} blocks, ${t} transactions, ${o} operations in ${s} seconds",
+         ("name",name)("b",r.blocks)("t",r.transactions)("o",r.operations)("s",r.seconds) );
+   ilog( "${name}: ${bps} blocks/s, ${ops} ops/s, peak RSS ${rss} KiB",
+         ("name",name)("bps",r.seconds > 0 ? r.blocks / r.seconds : 0)
+         ("ops",r.seconds > 0 ? r.operations / r.seconds : 0)("rss",r.peak_rss_kb) );
+   for( const auto& step : r.profile.steps )
+      ilog( "${name}:    ${step}: ${total} ms total", ("name",name)("step",step.first)("total",step.second.total_us / 1000) );
+   for( const auto& op : r.profile.operations )
+      ilog( "${name}:    ${op} x${n}: ${total} ms total, ${mean} us mean",
+            ("name",name)("op",op.name)("n",op.evaluate.count)
+            ("total",(op.evaluate.total_us + op.apply.total_us) / 1000)
+            ("mean",(op.evaluate.total_us + op.apply.total_us) / op.evaluate.count) );
+}
+
+/**
+ *  Copies the fixture's chain to a chain directory, replays it and reports the results
+ */
+void save_and_replay( database_fixture& f, const string& name )
+{
+   optional<fc::temp_directory> tmp;
+   fc::path chain_dir;
+   if( const char* out = getenv( "GRAPHENE_BENCH_OUTPUT_DIR" ) )
+      chain_dir = fc::path( out ) / name;
+   else
+   {
+      tmp = fc::temp_directory( graphene::utilities::temp_directory_path() );
+      chain_dir = tmp->path();
+   }
+
+   fc::create_directories( chain_dir );
+   fc::json::save_to_file( f.genesis_state, chain_dir / "genesis.json" );
+   block_database out;
+   out.open( blocks_dir( chain_dir ) );
+   for( uint32_t i = 1; i <= f.db.head_block_num(); ++i )
+   {
+      auto block = f.db.fetch_block_by_number( i );
+      FC_ASSERT( block.valid() );
+      out.store( block->id(), *block );
+   }
+   out.close();
+   ilog( "Wrote ${n} blocks of ${name} chain to ${d}", ("n",f.db.head_block_num())("name",name)("d",chain_dir) );
+
+   auto report = replay_chain( chain_dir, replay_skip_flags() );
+   BOOST_CHECK_EQUAL( report.blocks, f.db.head_block_num() );
+   print_report( name, report );
+}
+
+#ifdef NDEBUG
+const uint32_t bench_accounts   = 1000;
+const uint32_t bench_blocks     = 2000;
+const uint32_t bench_trx        = 200;
+#else
+const uint32_t bench_accounts   = 50;
+const uint32_t bench_blocks     = 50;
+const uint32_t bench_trx        = 20;
+#endif
+const uint32_t bench_ops_per_trx = 5;
+
+vector<account_id_type> create_bench_accounts( database_fixture& f )
+{
+   vector<account_id_type> accounts;
+   for( uint32_t i = 0; i < bench_accounts; ++i )
+   {
+      const auto& a = f.create_account( "bench" + fc::to_string( i ) );
+      f.fund( a, asset( 100000000 ) );
+      accounts.push_back( a.id );
+   }
+   f.generate_block();
+   return accounts;
+}
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE( transfer_heavy_replay_bench, database_fixture )
+{
+   try {
+      auto accounts = create_bench_accounts( *this );
+      std::mt19937 rng( 1 );
+      std::uniform_int_distribution<size_t> pick( 0, accounts.size() - 1 );
+      // offset of the recipient from the sender, never zero so the two always differ
+      std::uniform_int_distribution<size_t> pick_other( 1, accounts.size() - 1 );
+      uint64_t n = 0;
+
+      for( uint32_t b = 0; b < bench_blocks; ++b )
+      {
+         for( uint32_t t = 0; t < bench_trx; ++t )
+         {
+            trx.clear();
+            set_expiration( db, trx );
+            for( uint32_t o = 0; o < bench_ops_per_trx; ++o )
+            {
+               transfer_operation op;
+               const size_t from = pick( rng );
+               op.from   = accounts[ from ];
+               op.to     = accounts[ (from + pick_other( rng )) % accounts.size() ];
+               // a distinct amount per operation keeps every transaction id unique
+               op.amount = asset( 1 + (++n % 1000) );
+               trx.operations.push_back( op );
+            }
+            db.push_transaction( trx, ~0 );
+         }
+         generate_block();
+      }
+      trx.clear();
+
+      save_and_replay( *this, "transfer_heavy" );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( market_heavy_replay_bench, database_fixture )
+{
+   try {
+      auto accounts = create_bench_accounts( *this );
+      const auto& bench_asset = create_user_issued_asset( "BENCH" );
+      const asset_id_type bench_id = bench_asset.id;
+      for( const auto& a : accounts )
+         issue_uia( a, bench_id(db).amount( 100000000 ) );
+      generate_block();
+
+      std::mt19937 rng( 2 );
+      std::uniform_int_distribution<size_t> pick( 0, accounts.size() - 1 );
+      std::uniform_int_distribution<int64_t> jitter( -50, 50 );
+      std::uniform_int_distribution<int> action( 0, 9 );
+      vector<limit_order_id_type> open_orders;
+
+      for( uint32_t b = 0; b < bench_blocks; ++b )
+      {
+         for( uint32_t t = 0; t < bench_trx; ++t )
+         {
+            trx.clear();
+            set_expiration( db, trx );
+            for( uint32_t o = 0; o < bench_ops_per_trx; ++o )
+            {
+               const auto seller = accounts[ pick( rng ) ];
+               // roughly a fifth of the activity cancels resting orders, the rest crosses the spread
+               if( action( rng ) < 2 && !open_orders.empty() )
+               {
+                  auto order_id = open_orders.back();
+                  open_orders.pop_back();
+                  const auto* order = db.find( order_id );
+                  if( order != nullptr )
+                  {
+                     limit_order_cancel_operation cancel;
+                     cancel.fee_paying_account = order->seller;
+                     cancel.order = order_id;
+                     trx.operations.push_back( cancel );
+                     continue;
+                  }
+               }
+               limit_order_create_operation op;
+               op.seller = seller;
+               const int64_t amount = 1000 + jitter( rng );
+               if( action( rng ) < 5 )
+               {
+                  op.amount_to_sell = asset( 1000 );
+                  op.min_to_receive = bench_id(db).amount( amount );
+               }
+               else
+               {
+                  op.amount_to_sell = bench_id(db).amount( 1000 );
+                  op.min_to_receive = asset( amount );
+               }
+               trx.operations.push_back( op );
+            }
+            auto ptx = db.push_transaction( trx, ~0 );
+            for( const auto& result : ptx.operation_results )
+               if( result.which() == operation_result::tag<object_id_type>::value )
+               {
+                  object_id_type id = result.get<object_id_type>();
+                  if( id.is<limit_order_id_type>() && db.find_object( id ) != nullptr )
+                     open_orders.push_back( limit_order_id_type( id ) );
+               }
+         }
+         generate_block();
+      }
+      trx.clear();
+
+      save_and_replay( *this, "market_heavy" );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_log_replay_bench )
+{
+   try {
+      const char* chain_dir = getenv( "GRAPHENE_BENCH_CHAIN_DIR" );
+      if( chain_dir == nullptr )
+      {
+         ilog( "GRAPHENE_BENCH_CHAIN_DIR not set, skipping block log replay" );
+         return;
+      }
+      print_report( "block_log", replay_chain( fc::path( chain_dir ), replay_skip_flags() ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_read_pool.hpp>
+#include <graphene/app/database_api.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace graphene::chain;
+
+namespace {
+
+   int64_t percentile( vector<int64_t>& sorted, uint32_t p )
+   {
+      if( sorted.empty() )
+         return 0;
+      return sorted[ std::min<size_t>( sorted.size() * p / 100, sorted.size() - 1 ) ];
+   }
+
+   /**
+    *  Runs client_count simulated clients issuing a mix of account, balance and object queries while
+    *  a block is generated every block_interval, and logs the latency percentiles of calls and blocks.
+    */
+   void run_load( database& db, uint32_t threads, int account_count, int client_count,
+                  fc::microseconds duration, fc::microseconds block_interval )
+   {
+      std::shared_ptr<graphene::app::api_read_pool> pool;
+      if( threads > 0 )
+         pool = std::make_shared<graphene::app::api_read_pool>( db, threads );
+      graphene::app::database_api api( db, std::shared_ptr<graphene::app::market_depth>(),
+                                       std::shared_ptr<graphene::app::notification_hub>(), pool );
+
+      const account_id_type first_account = db.get_index_type<account_index>().indices().get<by_name>().find( "target0" )->id;
+      const fc::time_point stop = fc::time_point::now() + duration;
+      vector<int64_t> call_latency;
+      vector<int64_t> block_latency;
+
+      auto witness_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "null_key" ) ) );
+      auto producer = fc::async( [&]() {
+         while( fc::time_point::now() < stop )
+         {
+            fc::usleep( block_interval );
+            auto start = fc::time_point::now();
+            db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), witness_key, ~0 );
+            block_latency.push_back( ( fc::time_point::now() - start ).count() );
+         }
+      }, "block producer" );
+
+      vector< fc::future<void> > clients;
+      for( int c = 0; c < client_count; ++c )
+      {
+         clients.push_back( fc::async( [&, c]() {
+            std::mt19937 rng( c );
+            std::uniform_int_distribution<int> pick_account( 0, account_count - 1 );
+            for( uint32_t i = 0; fc::time_point::now() < stop; ++i )
+            {
+               const account_id_type account = first_account + pick_account( rng );
+               auto start = fc::time_point::now();
+               switch( i % 4 )
+               {
+                  case 0:
+                     api.get_full_accounts( { std::string( object_id_type( account ) ) }, false );
+                     break;
+                  case 1:
+                     api.get_account_balances( account, flat_set<asset_id_type>() );
+                     break;
+                  case 2:
+                     api.get_objects( { account, account_id_type( first_account + pick_account( rng ) ) } );
+                     break;
+                  default:
+                     api.lookup_accounts( "target" + fc::to_string( uint64_t( pick_account( rng ) ) ), 10 );
+               }
+               call_latency.push_back( ( fc::time_point::now() - start ).count() );
+               // calls served on this thread never wait, let the other clients and the producer run
+               fc::yield();
+            }
+         }, "api client" ) );
+      }
+      for( auto& c : clients )
+         c.wait();
+      producer.wait();
+
+      std::sort( call_latency.begin(), call_latency.end() );
+      std::sort( block_latency.begin(), block_latency.end() );
+      ilog( "${t} API threads: ${n} calls (${r}/s), call latency p50 ${c50} us, p90 ${c90} us, p99 ${c99} us; "
+            "${b} blocks, block latency p50 ${b50} us, p99 ${b99} us",
+            ("t",threads)("n",call_latency.size())
+            ("r",uint64_t(call_latency.size()) * 1000000 / std::max<int64_t>( duration.count(), 1 ))
+            ("c50",percentile( call_latency, 50 ))("c90",percentile( call_latency, 90 ))("c99",percentile( call_latency, 99 ))
+            ("b",block_latency.size())("b50",percentile( block_latency, 50 ))("b99",percentile( block_latency, 99 )) );
+   }
+
+}
+
+/**
+ *  Mixed read-only API load from many clients while blocks keep arriving, served on the main thread
+ *  and on read pools of growing size.
+ */
+BOOST_AUTO_TEST_CASE( rpc_load_bench )
+{
+   try {
+#ifdef NDEBUG
+      const int account_count = 100000;
+      const int client_count  = 64;
+      const fc::microseconds duration = fc::seconds( 10 );
+#else
+      const int account_count = 10000;
+      const int client_count  = 16;
+      const fc::microseconds duration = fc::seconds( 3 );
+#endif
+
+      genesis_state_type genesis_state;
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back( "target"+fc::to_string(i),
+            public_key_type( fc::ecc::private_key::regenerate( fc::digest( i ) ).get_public_key() ) );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      database db;
+      db.open( data_dir.path(), [&]{ return genesis_state; } );
+
+      for( uint32_t threads : { 0u, 1u, 4u, std::max( 1u, std::thread::hardware_concurrency() ) } )
+         run_load( db, threads, account_count, client_count, duration, fc::milliseconds( 100 ) );
+
+      db.close();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -152,7 +152,7 @@ void database_fixture::verify_asset_supplies( const database& db )
    BOOST_CHECK(core_asset_data.fee_pool == 0);
 
    const simple_index<account_statistics_object>& statistics_index = db.get_index_type<simple_index<account_statistics_object>>();
-   const auto& balance_index = db.get_index_type<account_balance_index>().indices();
+   const auto& balance_index = db.get_index_type<account_balance_index>();
    const auto& settle_index = db.get_index_type<force_settlement_index>().indices();
    map<asset_id_type,share_type> total_balances;
    map<asset_id_type,share_type> total_debts;
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Starts a line of witness_node processes on localhost, lets the first one produce blocks for all
+init witnesses and measures how long blocks take to reach every hop, once per p2p engine.
+
+   node0 <-> node1 <-> node2 <-> ... <-> nodeN-1
+
+Block latency is read from the "Got block" line every node logs when a block arrives (time since
+the block's slot), so both engines are measured the same way.  The push engine additionally logs
+the propagation latency measured from the moment the producer relayed the block, and a periodic
+summary of transaction latency for transactions submitted to any node while the test runs.
+
+usage: topology.py path/to/witness_node [--nodes N] [--seconds S] [--engines legacy,push]
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+
+GOT_BLOCK = re.compile(r"Got block: #(\d+) .* latency: (-?\d+) ms")
+PUSHED_BLOCK = re.compile(r"Pushed block #(\d+) propagation latency: (-?\d+) ms")
+TRX_SUMMARY = re.compile(r"Transaction propagation latency: (\d+) received, average (-?\d+) ms, max (-?\d+) ms")
+
+def create_genesis(witness_node, workdir):
+    genesis = os.path.join(workdir, "genesis.json")
+    subprocess.check_call([witness_node, "--data-dir", os.path.join(workdir, "genesis_dir"),
+                           "--create-genesis-json", genesis],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    with open(genesis) as f:
+        state = json.load(f)
+    # every node must agree on the timestamp, it is part of the chain id
+    interval = state["initial_parameters"]["block_interval"]
+    start = int(time.time()) + 2 * interval
+    start -= start % interval
+    state["initial_timestamp"] = time.strftime("%Y-%m-%dT%H:%M:%S", time.gmtime(start))
+    with open(genesis, "w") as f:
+        json.dump(state, f, indent=2)
+    return genesis, state["initial_active_witnesses"]
+
+def start_nodes(witness_node, workdir, genesis, witness_count, engine, count, base_port):
+    procs = []
+    for i in range(count):
+        data_dir = os.path.join(workdir, engine, "node%d" % i)
+        os.makedirs(data_dir)
+        args = [witness_node, "--data-dir", data_dir, "--genesis-json", genesis,
+                "--p2p-engine", engine, "--p2p-endpoint", "127.0.0.1:%d" % (base_port + i)]
+        if i > 0:
+            args += ["--seed-node", "127.0.0.1:%d" % (base_port + i - 1)]
+        else:
+            args += ["--enable-stale-production"]
+            for w in range(1, witness_count + 1):
+                args += ["--witness-id", '"1.6.%d"' % w]
+        log = open(os.path.join(data_dir, "stderr.log"), "w")
+        procs.append((subprocess.Popen(args, stdout=log, stderr=subprocess.STDOUT), log, data_dir))
+        # give each node time to listen before its neighbour connects
+        time.sleep(1)
+    return procs
+
+def stop_nodes(procs):
+    for proc, log, data_dir in procs:
+        proc.send_signal(signal.SIGINT)
+    for proc, log, data_dir in procs:
+        try:
+            proc.wait(timeout=30)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+        log.close()
+
+def average(values):
+    return sum(values) / len(values) if values else float("nan")
+
+def report(engine, procs):
+    print("engine: %s" % engine)
+    print("  %-6s %8s %12s %12s %16s" % ("hop", "blocks", "avg ms", "max ms", "push avg ms"))
+    for hop, (proc, log, data_dir) in enumerate(procs):
+        got, pushed, trx = [], [], None
+        with open(os.path.join(data_dir, "stderr.log"), errors="replace") as f:
+            for line in f:
+                m = GOT_BLOCK.search(line)
+                if m:
+                    got.append(int(m.group(2)))
+                m = PUSHED_BLOCK.search(line)
+                if m:
+                    pushed.append(int(m.group(2)))
+                m = TRX_SUMMARY.search(line)
+                if m:
+                    trx = m.groups()
+        if hop == 0:
+            print("  %-6d %8s" % (hop, "producer"))
+            continue
+        print("  %-6d %8d %12.1f %12s %16s" % (hop, len(got), average(got), max(got) if got else "-",
+                                               "%.1f" % average(pushed) if pushed else "-"))
+        if trx:
+            print("         transactions: %s received, average %s ms, max %s ms" % trx)
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare block propagation latency of the p2p engines")
+    parser.add_argument("witness_node")
+    parser.add_argument("--nodes", type=int, default=5)
+    parser.add_argument("--seconds", type=int, default=60)
+    parser.add_argument("--engines", default="legacy,push")
+    parser.add_argument("--base-port", type=int, default=18100)
+    parser.add_argument("--keep", action="store_true", help="keep the data directories and logs")
+    opts = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix="graphene_latency_")
+    try:
+        for n, engine in enumerate(opts.engines.split(",")):
+            genesis, witness_count = create_genesis(opts.witness_node, workdir)
+            procs = start_nodes(opts.witness_node, workdir, genesis, witness_count, engine,
+                                opts.nodes, opts.base_port + 100 * n)
+            try:
+                time.sleep(opts.seconds)
+            finally:
+                stop_nodes(procs)
+            report(engine, procs)
+    finally:
+        if opts.keep:
+            print("logs kept in %s" % workdir)
+        else:
+            shutil.rmtree(workdir)
+
+if __name__ == "__main__":
+    main()
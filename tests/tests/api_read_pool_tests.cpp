@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/api_read_pool.hpp>
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::app::api_read_pool;
+
+BOOST_FIXTURE_TEST_SUITE( api_read_pool_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( calls_over_the_method_limit_are_rejected )
+{
+   try {
+      api_read_pool pool( db, 2 );
+      pool.set_method_limit( "slow", 1 );
+
+      fc::promise<void>::ptr started( new fc::promise<void>() );
+      fc::promise<void>::ptr release( new fc::promise<void>() );
+      auto first = fc::async( [&]() {
+         return pool.run( "slow", [&]() -> uint32_t {
+            started->set_value();
+            fc::future<void>( release ).wait();
+            return db.head_block_num();
+         });
+      });
+      fc::future<void>( started ).wait();
+
+      GRAPHENE_CHECK_THROW( pool.run( "slow", []() { return 0; } ), fc::exception );
+      // other methods are not affected
+      BOOST_CHECK_EQUAL( pool.run( "fast", [&]() { return db.head_block_num(); } ), db.head_block_num() );
+
+      release->set_value();
+      BOOST_CHECK_EQUAL( first.wait(), db.head_block_num() );
+      // the slot is free again once the first call returned
+      BOOST_CHECK_EQUAL( pool.run( "slow", []() { return 7; } ), 7 );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( writers_wait_for_readers )
+{
+   try {
+      api_read_pool pool( db, 1 );
+      const uint32_t head = db.head_block_num();
+
+      fc::promise<void>::ptr started( new fc::promise<void>() );
+      fc::promise<void>::ptr release( new fc::promise<void>() );
+      auto reader = fc::async( [&]() {
+         return pool.run( "read", [&]() -> uint32_t {
+            started->set_value();
+            fc::future<void>( release ).wait();
+            return db.head_block_num();
+         });
+      });
+      fc::future<void>( started ).wait();
+
+      // the writer blocks its thread on the lock, so it must not be the one that releases the reader
+      fc::thread writer_thread( "writer" );
+      auto writer = writer_thread.async( [&]() { generate_block(); } );
+      fc::usleep( fc::milliseconds( 50 ) );
+      BOOST_CHECK( !writer.ready() );
+      BOOST_CHECK_EQUAL( db.head_block_num(), head );
+
+      release->set_value();
+      // the reader saw the state from before the block
+      BOOST_CHECK_EQUAL( reader.wait(), head );
+      writer.wait();
+      BOOST_CHECK_EQUAL( db.head_block_num(), head + 1 );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( other_tasks_wait_for_a_suspended_writer )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      bool in_apply = false;
+      bool pushed_during_apply = false;
+      bool yielded = false;
+      fc::future<void> pusher;
+      db.on_pending_transaction.connect( [&]( const signed_transaction& ) {
+         pushed_during_apply = pushed_during_apply || in_apply;
+      });
+      db.applied_block.connect( [&]( const signed_block& ) {
+         if( yielded )
+            return;
+         yielded = true;
+         in_apply = true;
+         // another task of this thread pushes a transaction while the block is being applied
+         pusher = fc::async( [&]() {
+            signed_transaction tx;
+            transfer_operation op;
+            op.from = account_id_type();
+            op.to = alice_id;
+            op.amount = asset( 100 );
+            tx.operations.push_back( op );
+            for( auto& o : tx.operations )
+               db.current_fee_schedule().set_fee( o );
+            set_expiration( db, tx );
+            db.push_transaction( tx, ~0 );
+         });
+         fc::usleep( fc::milliseconds( 20 ) );
+         in_apply = false;
+      });
+
+      generate_block();
+      pusher.wait();
+      BOOST_CHECK( yielded );
+      BOOST_CHECK( !pushed_during_apply );
+      BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 100 );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -717,6 +717,77 @@ BOOST_FIXTURE_TEST_CASE( proposal_delete, database_fixture )
    }
 } FC_LOG_AND_RETHROW() }
 
+/// approvals added to a proposal are tracked incrementally until an account it depends on changes
+BOOST_FIXTURE_TEST_CASE( proposal_authority_tracking, database_fixture )
+{ try {
+   generate_block();
+   ACTORS( (alice)(bob)(cindy)(well)(mega) );
+   transfer( account_id_type()(db), alice, asset(100000) );
+   transfer( account_id_type()(db), mega, asset(100000) );
+
+   auto set_auth = [&]( account_id_type aid, const authority& auth )
+   {
+      signed_transaction tx;
+      account_update_operation op;
+      op.account = aid;
+      op.active = auth;
+      op.owner = auth;
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      PUSH_TX( db, tx, database::skip_transaction_signatures | database::skip_authority_check );
+   };
+   set_auth( well_id, authority( 60, alice_id, 50, bob_id, 50 ) );
+   set_auth( mega_id, authority( 2, well_id, 1, cindy_id, 1 ) );
+
+   proposal_id_type pid;
+   {
+      transfer_operation top;
+      top.from = mega_id;
+      top.to = alice_id;
+      top.amount = asset(500);
+
+      proposal_create_operation pop;
+      pop.proposed_ops.emplace_back( top );
+      pop.fee_paying_account = alice_id;
+      pop.expiration_time = db.head_block_time() + fc::days(1);
+      trx.operations.push_back( pop );
+      sign( trx, alice_private_key );
+      pid = PUSH_TX( db, trx ).operation_results.front().get<object_id_type>();
+      trx.clear();
+   }
+
+   const auto& proposals = dynamic_cast<const primary_index<proposal_index>&>( db.get_index_type<proposal_index>() );
+   const auto& tracker = proposals.get_secondary_index<proposal_authority_index>();
+   BOOST_CHECK( !pid(db).is_authorized_to_execute(db) );
+   const uint64_t rebuilds = tracker.rebuilds();
+
+   auto approve = [&]( account_id_type approver, const fc::ecc::private_key& key )
+   {
+      proposal_update_operation uop;
+      uop.fee_paying_account = alice_id;
+      uop.proposal = pid;
+      uop.active_approvals_to_add.insert( approver );
+      trx.operations.push_back( uop );
+      sign( trx, alice_private_key );
+      if( approver != alice_id )
+         sign( trx, key );
+      PUSH_TX( db, trx );
+      trx.clear();
+   };
+
+   // well is satisfied by alice and bob, but mega still needs cindy
+   approve( alice_id, alice_private_key );
+   BOOST_CHECK( !pid(db).is_authorized_to_execute(db) );
+   approve( bob_id, bob_private_key );
+   BOOST_CHECK( !pid(db).is_authorized_to_execute(db) );
+   BOOST_CHECK_EQUAL( tracker.rebuilds(), rebuilds );
+
+   // once alice may act for cindy the approvals suffice, which is noticed through cindy's new authority
+   set_auth( cindy_id, authority( 1, alice_id, 1 ) );
+   BOOST_CHECK( pid(db).is_authorized_to_execute(db) );
+   BOOST_CHECK_EQUAL( tracker.rebuilds(), rebuilds + 1 );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_FIXTURE_TEST_CASE( proposal_owner_authority_delete, database_fixture )
 { try {
    generate_block();
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/block_event_stream.hpp>
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::app::applied_block_event;
+using graphene::app::block_event_stream;
+
+BOOST_FIXTURE_TEST_SUITE( block_event_stream_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( events_are_delivered_in_order_off_the_chain_thread )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+      auto stream = block_event_stream::create( db );
+
+      // the handlers only touch their own vectors, which are read after wait_idle()
+      vector<uint32_t> applied, irreversible;
+      vector<size_t> operations;
+      bool saw_changes = false;
+      fc::thread* chain_thread = &fc::thread::current();
+      bool ran_on_chain_thread = false;
+
+      auto a = stream->subscribe( "applied", [&]( const applied_block_event& e ) {
+         applied.push_back( e.block_num() );
+         operations.push_back( e.operations.size() );
+         saw_changes = saw_changes || !e.changed_ids.empty();
+         ran_on_chain_thread = ran_on_chain_thread || &fc::thread::current() == chain_thread;
+      } );
+      auto i = stream->subscribe( "irreversible", [&]( const applied_block_event& e ) {
+         irreversible.push_back( e.block_num() );
+      }, block_event_stream::after_irreversible );
+      BOOST_CHECK_EQUAL( stream->subscribers(), 2u );
+
+      const uint32_t first = db.head_block_num() + 1;
+      transfer( account_id_type(), alice_id, asset( 1000 ) );
+      generate_blocks( 30 );
+      a->wait_idle();
+      i->wait_idle();
+
+      BOOST_REQUIRE_EQUAL( applied.size(), 30u );
+      for( uint32_t n = 0; n < applied.size(); ++n )
+         BOOST_CHECK_EQUAL( applied[n], first + n );
+      // the transfer is in the first block
+      BOOST_CHECK_EQUAL( operations.front(), 1u );
+      BOOST_CHECK( saw_changes );
+      BOOST_CHECK( !ran_on_chain_thread );
+
+      // only blocks which have become irreversible are delivered, again in order
+      const uint32_t lib = db.get_dynamic_global_properties().last_irreversible_block_num;
+      BOOST_REQUIRE( !irreversible.empty() );
+      BOOST_CHECK_EQUAL( irreversible.front(), first );
+      BOOST_CHECK_EQUAL( irreversible.back(), lib );
+      for( uint32_t n = 1; n < irreversible.size(); ++n )
+         BOOST_CHECK_EQUAL( irreversible[n], irreversible[n-1] + 1 );
+
+      auto stats = a->stats();
+      BOOST_CHECK_EQUAL( stats.processed, 30u );
+      BOOST_CHECK_EQUAL( stats.last_processed_block, db.head_block_num() );
+      BOOST_CHECK_EQUAL( stats.queued, 0u );
+
+      // released subscribers are dropped on the next block
+      i.reset();
+      generate_block();
+      BOOST_CHECK_EQUAL( stream->subscribers(), 1u );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( full_queue_stalls_the_next_block )
+{
+   try {
+      auto stream = block_event_stream::create( db );
+      std::atomic<uint32_t> processed{0};
+      auto slow = stream->subscribe( "slow", [&]( const applied_block_event& ) {
+         fc::usleep( fc::milliseconds( 20 ) );
+         ++processed;
+      }, block_event_stream::after_apply, 2 );
+
+      // block application itself never waits for subscribers
+      generate_blocks( 4 );
+      BOOST_CHECK_EQUAL( slow->stats().stalls, 0u );
+
+      // the block producer does, once the block is in
+      stream->wait_for_subscribers();
+      BOOST_CHECK_EQUAL( slow->stats().stalls, 1u );
+      BOOST_CHECK( slow->stats().queued <= 2 );
+      for( uint32_t i = 0; i < 2; ++i )
+      {
+         generate_block();
+         stream->wait_for_subscribers();
+         BOOST_CHECK( slow->stats().queued <= 2 );
+      }
+
+      slow->wait_idle();
+      BOOST_CHECK_EQUAL( processed.load(), 6u );
+      BOOST_CHECK( slow->stats().max_delay >= fc::milliseconds( 20 ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
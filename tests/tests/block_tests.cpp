@@ -29,13 +29,17 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/balance_object.hpp>
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/market_object.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
 
+#include <fc/bitutil.hpp>
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -293,6 +297,103 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
 }
 
 
+BOOST_AUTO_TEST_CASE( fork_db_deep_reorg )
+{
+   try {
+      fork_database fdb;
+      auto make_block = []( const signed_block& prev, uint32_t fork ) {
+         signed_block b;
+         b.previous = prev.id();
+         b.timestamp = prev.timestamp + 3 + fork;
+         return b;
+      };
+
+      // the main chain runs far past the window, old blocks are pruned
+      signed_block genesis;
+      genesis.timestamp = fc::time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+      fdb.start_block( genesis );
+      vector<signed_block> main_chain( 1, genesis );
+      for( uint32_t i = 0; i < 3000; ++i )
+      {
+         main_chain.push_back( make_block( main_chain.back(), 0 ) );
+         fdb.push_block( main_chain.back() );
+      }
+      BOOST_CHECK_EQUAL( fdb.head()->num, 3001u );
+      BOOST_CHECK_EQUAL( fdb.size(), 1025u );
+      BOOST_CHECK( !fdb.is_known_block( main_chain[1000].id() ) );
+      BOOST_CHECK( fdb.is_known_block( main_chain[2000].id() ) );
+      BOOST_CHECK( fdb.fetch_block_by_number( 1976 ).empty() );
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 1977 ).size(), 1u );
+      GRAPHENE_REQUIRE_THROW( fdb.push_block( make_block( main_chain[1975], 1 ) ), fc::exception );
+
+      // a fork from 800 blocks back overtakes the main chain
+      vector<signed_block> fork( 1, main_chain[2200] );
+      for( uint32_t i = 0; i < 801; ++i )
+      {
+         fork.push_back( make_block( fork.back(), 1 ) );
+         auto head = fdb.push_block( fork.back() );
+         BOOST_CHECK( head->id == (i < 800 ? main_chain.back().id() : fork.back().id()) );
+      }
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 2500 ).size(), 2u );
+      auto branches = fdb.fetch_branch_from( fork.back().id(), main_chain.back().id() );
+      BOOST_CHECK_EQUAL( branches.first.size(), 801u );
+      BOOST_CHECK_EQUAL( branches.second.size(), 800u );
+      BOOST_CHECK( branches.first.back()->previous_id() == main_chain[2200].id() );
+      BOOST_CHECK( branches.second.back()->previous_id() == main_chain[2200].id() );
+
+      // popping back to the fork point and removing the dead branch
+      for( uint32_t i = 0; i < 801; ++i )
+         fdb.pop_block();
+      BOOST_CHECK( fdb.head()->id == main_chain[2200].id() );
+      for( const auto& item : branches.second )
+         fdb.remove( item->id );
+      BOOST_CHECK( !fdb.is_known_block( main_chain[2500].id() ) );
+      BOOST_CHECK( fdb.is_known_block( fork[300].id() ) );
+
+      // a window larger than the ring makes it grow without losing blocks
+      fdb.set_head( fdb.fetch_block( fork.back().id() ) );
+      fdb.set_max_size( 5000 );
+      for( uint32_t i = 0; i < 4000; ++i )
+      {
+         fork.push_back( make_block( fork.back(), 1 ) );
+         fdb.push_block( fork.back() );
+      }
+      BOOST_CHECK_EQUAL( fdb.head()->num, 7002u );
+      BOOST_CHECK( fdb.is_known_block( fork[1].id() ) );
+      BOOST_CHECK_EQUAL( fdb.fetch_branch_from( fork.back().id(), fork[1].id() ).first.size(), 4801u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( fork_db_rejects_blocks_outside_the_window )
+{
+   try {
+      fork_database fdb;
+      signed_block head;
+      head.timestamp = fc::time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+      // pretend the chain was loaded from disk at block 501
+      head.previous = block_id_type();
+      head.previous._hash[0] = fc::endian_reverse_u32( 500 );
+      fdb.start_block( head );
+      BOOST_CHECK_EQUAL( fdb.head()->num, 501u );
+
+      // a block following the null block is number 1, which is within _max_size of the head but
+      // below everything held; it must neither link nor stretch the ring down to 1
+      signed_block stray;
+      stray.timestamp = head.timestamp + 3;
+      BOOST_CHECK_EQUAL( stray.block_num(), 1u );
+      GRAPHENE_REQUIRE_THROW( fdb.push_block( stray ), fc::exception );
+      BOOST_CHECK_EQUAL( fdb.size(), 1u );
+      BOOST_CHECK( fdb.fetch_block_by_number( 1 ).empty() );
+
+      // the chain carries on as before
+      signed_block next;
+      next.previous = head.id();
+      next.timestamp = head.timestamp + 3;
+      BOOST_CHECK( fdb.push_block( next )->id == next.id() );
+      BOOST_CHECK_EQUAL( fdb.size(), 2u );
+   } FC_LOG_AND_RETHROW()
+}
+
 /**
  *  These test has been disabled, out of order blocks should result in the node getting disconnected.
  *  
@@ -1237,6 +1338,183 @@ BOOST_AUTO_TEST_CASE( genesis_reserve_ids )
    }
 }
 
+BOOST_AUTO_TEST_CASE( genesis_packed_accounts )
+{
+   try
+   {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto plain_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("plain"))).get_public_key();
+
+      genesis_state_type genesis_state = make_genesis();
+      genesis_state.initial_accounts.emplace_back( "plain", plain_key );
+      genesis_state.initial_balances.push_back( { address( plain_key ), GRAPHENE_SYMBOL, 1000 } );
+      genesis_state.initial_balances.push_back( { address( plain_key ), GRAPHENE_SYMBOL, 2000 } );
+
+      // a genesis embedded in packed form must load exactly as the JSON one does
+      std::vector<char> packed = fc::raw::pack( genesis_state );
+      genesis_state_type unpacked = fc::raw::unpack<genesis_state_type>( packed );
+      BOOST_CHECK( fc::json::to_string( unpacked ) == fc::json::to_string( genesis_state ) );
+
+      database db;
+      db.open( data_dir.path(), [&]{ return unpacked; } );
+
+      const auto& acct_idx = db.get_index_type<account_index>().indices().get<by_name>();
+      auto init_itr = acct_idx.find( "init0" );
+      BOOST_REQUIRE( init_itr != acct_idx.end() );
+      BOOST_CHECK( init_itr->is_lifetime_member() );
+      BOOST_CHECK( init_itr->referrer == init_itr->id );
+      BOOST_CHECK_EQUAL( init_itr->lifetime_referrer_fee_percentage,
+                         GRAPHENE_100_PERCENT - init_itr->network_fee_percentage );
+
+      auto plain_itr = acct_idx.find( "plain" );
+      BOOST_REQUIRE( plain_itr != acct_idx.end() );
+      BOOST_CHECK( !plain_itr->is_lifetime_member() );
+      BOOST_CHECK( plain_itr->registrar == GRAPHENE_TEMP_ACCOUNT );
+      BOOST_CHECK( plain_itr->active == plain_itr->owner );
+      BOOST_CHECK( plain_itr->options.memo_key == plain_key );
+      BOOST_CHECK( plain_itr->statistics(db).owner == plain_itr->id );
+      BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().accounts_registered_this_interval,
+                         genesis_state.initial_accounts.size() );
+
+      share_type handed_out;
+      for( const balance_object& b : db.get_index_type<balance_index>().indices() )
+         if( b.owner == address( plain_key ) )
+            handed_out += b.balance.amount;
+      BOOST_CHECK_EQUAL( handed_out.value, 3000 );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( build_block_from_pending, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice) );
+      generate_block();
+
+      for( int i = 0; i < 5; ++i )
+         transfer( account_id_type(), alice_id, asset( 100 + i ) );
+      BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 510 );
+
+      // the pending transactions are taken as they are and the pending state is rewound
+      auto block = db.build_block( db.get_slot_time(1), db.get_scheduled_witness(1), database::skip_nothing );
+      BOOST_CHECK_EQUAL( block.transactions.size(), 5u );
+      BOOST_CHECK( block.transaction_merkle_root == block.calculate_merkle_root() );
+      BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 0 );
+
+      block.sign( init_account_priv_key );
+      PUSH_BLOCK( db, block, database::skip_undo_history_check );
+      BOOST_CHECK( db.head_block_id() == block.id() );
+      BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), 510 );
+
+      // with nothing pending the block is empty
+      auto empty = db.build_block( db.get_slot_time(1), db.get_scheduled_witness(1), database::skip_nothing );
+      BOOST_CHECK( empty.transactions.empty() );
+      BOOST_CHECK( empty.transaction_merkle_root == checksum_type() );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( fetch_raw_block_range, database_fixture )
+{
+   try
+   {
+      generate_blocks( 20 );
+      ACTORS( (alice) );
+      transfer( account_id_type(), alice_id, asset( 1000 ) );
+      generate_blocks( 5 );
+      const uint32_t head = db.head_block_num();
+
+      auto raw = db.fetch_raw_blocks_by_number( 3, 10 );
+      BOOST_REQUIRE_EQUAL( raw.size(), 10u );
+      for( const raw_block& b : raw )
+      {
+         auto block = db.fetch_block_by_number( b.block_num );
+         BOOST_REQUIRE( block.valid() );
+         BOOST_CHECK( b.data == fc::raw::pack( *block ) );
+         BOOST_REQUIRE( b.block_id.valid() );
+         BOOST_CHECK( *b.block_id == block->id() );
+         BOOST_CHECK( fc::raw::unpack<signed_block>( b.data ).id() == *b.block_id );
+      }
+      BOOST_CHECK_EQUAL( raw.front().block_num, 3u );
+      BOOST_CHECK_EQUAL( raw.back().block_num, 12u );
+
+      // the range is cut at the head block
+      raw = db.fetch_raw_blocks_by_number( head - 2, 10 );
+      BOOST_REQUIRE_EQUAL( raw.size(), 3u );
+      BOOST_CHECK( *raw.back().block_id == db.head_block_id() );
+      BOOST_CHECK( db.fetch_raw_blocks_by_number( head + 1, 10 ).empty() );
+      BOOST_CHECK( db.fetch_raw_blocks_by_number( 0, 10 ).empty() );
+
+      // the range is cut once it would exceed the byte limit, but never below one block
+      auto all = db.fetch_raw_blocks_by_number( 3, 10 );
+      uint64_t three = all[0].data.size() + all[1].data.size() + all[2].data.size();
+      raw = db.fetch_raw_blocks_by_number( 3, 10, three );
+      BOOST_REQUIRE_EQUAL( raw.size(), 3u );
+      BOOST_CHECK( raw[2].data == all[2].data );
+      BOOST_CHECK_EQUAL( db.fetch_raw_blocks_by_number( 3, 10, three - 1 ).size(), 2u );
+      BOOST_CHECK_EQUAL( db.fetch_raw_blocks_by_number( 3, 10, 1 ).size(), 1u );
+
+      // popped blocks are no longer returned
+      db.pop_block();
+      raw = db.fetch_raw_blocks_by_number( head - 2, 10 );
+      BOOST_CHECK_EQUAL( raw.size(), 2u );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( genesis_bulk_accounts_match_evaluators )
+{
+   try
+   {
+      genesis_state_type genesis_state = make_genesis();
+      genesis_state.initial_parameters.current_fees = fee_schedule::get_default();
+      genesis_state.initial_parameters.accounts_per_fee_scale = 4;
+      for( int i = 0; i < 13; ++i )
+      {
+         auto key = fc::ecc::private_key::regenerate( fc::digest( i ) ).get_public_key();
+         genesis_state.initial_accounts.emplace_back( "plain" + fc::to_string(i), key, key, i % 5 == 0 );
+      }
+
+      fc::temp_directory bulk_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory eval_dir( graphene::utilities::temp_directory_path() );
+      database bulk;
+      bulk.open( bulk_dir.path(), [&]{ return genesis_state; } );
+      database eval;
+      eval._genesis_accounts_through_evaluators = true;
+      eval.open( eval_dir.path(), [&]{ return genesis_state; } );
+
+      BOOST_CHECK( fc::raw::pack( bulk.get_global_properties() ) == fc::raw::pack( eval.get_global_properties() ) );
+      BOOST_CHECK( fc::raw::pack( bulk.get_dynamic_global_properties() ) == fc::raw::pack( eval.get_dynamic_global_properties() ) );
+
+      const auto& bulk_accounts = bulk.get_index_type<account_index>().indices().get<by_id>();
+      const auto& eval_accounts = eval.get_index_type<account_index>().indices().get<by_id>();
+      BOOST_REQUIRE_EQUAL( bulk_accounts.size(), eval_accounts.size() );
+      for( auto b = bulk_accounts.begin(), e = eval_accounts.begin(); b != bulk_accounts.end(); ++b, ++e )
+      {
+         BOOST_CHECK_MESSAGE( fc::raw::pack( *b ) == fc::raw::pack( *e ), b->name );
+         BOOST_CHECK( fc::raw::pack( b->statistics(bulk) ) == fc::raw::pack( e->statistics(eval) ) );
+      }
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_FIXTURE_TEST_CASE( miss_many_blocks, database_fixture )
 {
    try
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/api.hpp>
+#include <graphene/app/database_api.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::app::database_api;
+using graphene::app::history_api;
+
+BOOST_FIXTURE_TEST_SUITE( database_api_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( limit_order_paging )
+{
+   try {
+      ACTORS( (buyer) );
+      const auto& test = create_user_issued_asset( "PAGETEST" );
+      const asset_id_type test_id = test.id;
+      const asset_id_type core_id;
+      fund( buyer, asset( 100000 ) );
+
+      // two orders share the best price so the page boundary has to fall between them
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 100 ) );
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 200 ) );
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 100 ) );
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 300 ) );
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 150 ) );
+
+      database_api api( db );
+      vector<limit_order_object> all = api.get_limit_orders_page( core_id, test_id, 300,
+                                                                  optional<price>(), optional<limit_order_id_type>() );
+      BOOST_REQUIRE_EQUAL( all.size(), 5 );
+      for( size_t i = 1; i < all.size(); ++i )
+         BOOST_CHECK( all[i-1].sell_price >= all[i].sell_price );
+
+      vector<limit_order_object> paged;
+      optional<price> start_price;
+      optional<limit_order_id_type> start_id;
+      while( true )
+      {
+         vector<limit_order_object> page = api.get_limit_orders_page( core_id, test_id, 2, start_price, start_id );
+         if( page.empty() ) break;
+         BOOST_CHECK( page.size() <= 2 );
+         paged.insert( paged.end(), page.begin(), page.end() );
+         start_price = page.back().sell_price;
+         start_id = page.back().id;
+         // an order placed ahead of the cursor does not show up again on later pages
+         if( paged.size() == 2 )
+            create_sell_order( buyer_id, asset( 200 ), test.amount( 100 ) );
+      }
+      BOOST_REQUIRE_EQUAL( paged.size(), all.size() );
+      for( size_t i = 0; i < all.size(); ++i )
+         BOOST_CHECK( paged[i].id == all[i].id );
+
+      // the legacy call is capped instead of returning the whole book
+      BOOST_CHECK_EQUAL( api.get_limit_orders( core_id, test_id, 1000 ).size(), 6 );
+      BOOST_CHECK_THROW( api.get_limit_orders_page( core_id, test_id, 301, optional<price>(), optional<limit_order_id_type>() ),
+                         fc::exception );
+      BOOST_CHECK_THROW( api.get_limit_orders_page( core_id, test_id, 10, price( test.amount( 1 ), asset( 1 ) ),
+                                                    optional<limit_order_id_type>() ), fc::exception );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( legacy_order_calls_are_capped )
+{
+   try {
+      ACTORS( (buyer) );
+      const auto& test = create_user_issued_asset( "CAPTEST" );
+      const asset_id_type test_id = test.id;
+      const asset_id_type core_id;
+      fund( buyer, asset( 1000000 ) );
+
+      for( uint32_t i = 0; i < 310; ++i )
+         create_sell_order( buyer_id, asset( 100 ), test.amount( 100 + i ) );
+
+      database_api api( db );
+      // only the first 300 orders of the full side are returned, the best ones first
+      auto orders = api.get_limit_orders( core_id, test_id, 1000 );
+      BOOST_REQUIRE_EQUAL( orders.size(), 300u );
+      for( size_t i = 1; i < orders.size(); ++i )
+         BOOST_CHECK( orders[i-1].sell_price >= orders[i].sell_price );
+      BOOST_CHECK( orders.front().sell_price == price( asset( 100 ), test.amount( 100 ) ) );
+      BOOST_CHECK_EQUAL( api.get_limit_orders( core_id, test_id, 10 ).size(), 10u );
+
+      // the rest are reached by paging on
+      auto rest = api.get_limit_orders_page( core_id, test_id, 300, orders.back().sell_price, orders.back().id );
+      BOOST_CHECK_EQUAL( rest.size(), 10u );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( call_and_settle_order_paging )
+{
+   try {
+      ACTORS( (nathan)(shorter1)(shorter2)(shorter3)(shorter4) );
+      const asset_id_type bitusd_id = create_bitasset( "USDBIT", nathan_id, 100, 0 ).id;
+      const asset_id_type core_id;
+      for( const account_id_type& a : { shorter1_id, shorter2_id, shorter3_id, shorter4_id } )
+         transfer( account_id_type(), a, asset( 100000 ) );
+
+      update_feed_producers( bitusd_id, { nathan_id } );
+      price_feed feed;
+      feed.settlement_price = price( asset( 1, bitusd_id ), asset( 1, core_id ) );
+      publish_feed( bitusd_id, nathan_id, feed );
+
+      // shorter1 and shorter3 share a call price, so a page may end between them
+      borrow( shorter1_id, asset( 1000, bitusd_id ), asset( 3000 ) );
+      borrow( shorter2_id, asset( 1000, bitusd_id ), asset( 2500 ) );
+      borrow( shorter3_id, asset( 1000, bitusd_id ), asset( 3000 ) );
+      borrow( shorter4_id, asset( 1000, bitusd_id ), asset( 4000 ) );
+
+      database_api api( db );
+      auto calls = api.get_call_orders( bitusd_id, 1000 );
+      BOOST_REQUIRE_EQUAL( calls.size(), 4u );
+      vector<call_order_object> paged_calls;
+      optional<price> call_price;
+      optional<call_order_id_type> call_id;
+      while( true )
+      {
+         auto page = api.get_call_orders_page( bitusd_id, 1, call_price, call_id );
+         if( page.empty() ) break;
+         paged_calls.push_back( page.front() );
+         call_price = page.back().call_price;
+         call_id = page.back().id;
+      }
+      BOOST_REQUIRE_EQUAL( paged_calls.size(), calls.size() );
+      for( size_t i = 0; i < calls.size(); ++i )
+         BOOST_CHECK( paged_calls[i].id == calls[i].id );
+      GRAPHENE_CHECK_THROW( api.get_call_orders_page( bitusd_id, 301, optional<price>(), optional<call_order_id_type>() ),
+                            fc::exception );
+
+      // settlements requested in one block share their settlement date
+      for( const account_id_type& a : { shorter1_id, shorter2_id, shorter3_id, shorter4_id } )
+         transfer( a, nathan_id, asset( 1000, bitusd_id ) );
+      for( uint32_t i = 0; i < 5; ++i )
+         force_settle( nathan_id, asset( 10 + i, bitusd_id ) );
+      generate_block();
+      force_settle( nathan_id, asset( 20, bitusd_id ) );
+
+      auto settles = api.get_settle_orders( bitusd_id, 1000 );
+      BOOST_REQUIRE_EQUAL( settles.size(), 6u );
+      vector<force_settlement_object> paged_settles;
+      optional<time_point_sec> settle_date;
+      optional<force_settlement_id_type> settle_id;
+      while( true )
+      {
+         auto page = api.get_settle_orders_page( bitusd_id, 2, settle_date, settle_id );
+         if( page.empty() ) break;
+         BOOST_CHECK( page.size() <= 2 );
+         paged_settles.insert( paged_settles.end(), page.begin(), page.end() );
+         settle_date = page.back().settlement_date;
+         settle_id = page.back().id;
+      }
+      BOOST_REQUIRE_EQUAL( paged_settles.size(), settles.size() );
+      for( size_t i = 0; i < settles.size(); ++i )
+      {
+         BOOST_CHECK( paged_settles[i].id == settles[i].id );
+         if( i > 0 )
+            BOOST_CHECK( settles[i-1].settlement_date <= settles[i].settlement_date );
+      }
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( account_history_paging )
+{
+   try {
+      ACTORS( (alice)(bob)(carol) );
+      transfer( account_id_type(), alice_id, asset( 100000 ) );
+      // carol has history on both sides of alice's
+      transfer( account_id_type(), carol_id, asset( 1000 ) );
+      for( uint32_t i = 0; i < 10; ++i )
+         transfer( alice_id, bob_id, asset( 100 + i ) );
+      transfer( account_id_type(), carol_id, asset( 1000 ) );
+      generate_block();
+
+      history_api hist( app );
+      auto all = hist.get_account_history( alice_id, operation_history_id_type(), 100, operation_history_id_type() );
+      BOOST_REQUIRE( all.size() >= 11u );
+      for( size_t i = 1; i < all.size(); ++i )
+         BOOST_CHECK( all[i-1].id > all[i].id );
+
+      // pages of 3, each starting just below the last operation of the previous one
+      vector<operation_history_object> paged;
+      operation_history_id_type start;
+      while( true )
+      {
+         auto page = hist.get_account_history( alice_id, operation_history_id_type(), 3, start );
+         if( page.empty() ) break;
+         BOOST_CHECK( page.size() <= 3 );
+         paged.insert( paged.end(), page.begin(), page.end() );
+         if( page.back().id.instance() == 0 ) break;
+         start = operation_history_id_type( page.back().id.instance() - 1 );
+      }
+      BOOST_REQUIRE_EQUAL( paged.size(), all.size() );
+      for( size_t i = 0; i < all.size(); ++i )
+         BOOST_CHECK( paged[i].id == all[i].id );
+
+      // stop bounds the page from below, exclusively
+      auto tail = hist.get_account_history( alice_id, all[5].id, 100, operation_history_id_type() );
+      BOOST_REQUIRE_EQUAL( tail.size(), 5u );
+      BOOST_CHECK( tail.back().id == all[4].id );
+
+      // a start at or below stop is an empty range rather than a walk into other accounts' history
+      BOOST_CHECK( hist.get_account_history( alice_id, all[2].id, 100, all[5].id ).empty() );
+      BOOST_CHECK( hist.get_account_history( alice_id, all[2].id, 100, all[2].id ).empty() );
+      BOOST_CHECK( hist.get_account_history( alice_id, all.front().id, 100, operation_history_id_type(1) ).empty() );
+
+      const uint32_t total = alice_id(db).statistics(db).total_ops;
+      auto relative = hist.get_relative_account_history( alice_id, 0, 100, 0 );
+      BOOST_REQUIRE( !relative.empty() );
+      BOOST_CHECK( relative.front().id == all.front().id );
+      BOOST_CHECK( hist.get_relative_account_history( alice_id, total, 100, 2 ).empty() );
+      BOOST_CHECK( hist.get_relative_account_history( carol_id, 5, 100, 5 ).empty() );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( get_blocks_range )
+{
+   try {
+      ACTORS( (alice) );
+      generate_blocks( 10 );
+      transfer( account_id_type(), alice_id, asset( 1000 ) );
+      generate_blocks( 5 );
+      const uint32_t head = db.head_block_num();
+
+      database_api api( db );
+      auto blocks = api.get_blocks( 2, 10 );
+      BOOST_REQUIRE_EQUAL( blocks.size(), 10u );
+      for( uint32_t i = 0; i < blocks.size(); ++i )
+      {
+         BOOST_CHECK_EQUAL( blocks[i].block_num(), 2 + i );
+         BOOST_CHECK( blocks[i].id() == db.get_block_id_for_num( 2 + i ) );
+      }
+
+      // the transfer comes back with its signatures
+      blocks = api.get_blocks( head - 4, 1 );
+      BOOST_REQUIRE_EQUAL( blocks.size(), 1u );
+      BOOST_REQUIRE_EQUAL( blocks[0].transactions.size(), 1u );
+      const signed_transaction stored = db.fetch_block_by_number( head - 4 )->transactions[0];
+      BOOST_CHECK( blocks[0].transactions[0].id() == stored.id() );
+      BOOST_CHECK( blocks[0].transactions[0].signatures == stored.signatures );
+
+      blocks = api.get_blocks( 1, 100 );
+      BOOST_REQUIRE_EQUAL( blocks.size(), head );
+      BOOST_CHECK( blocks.back().id() == db.head_block_id() );
+      BOOST_CHECK_THROW( api.get_blocks( 1, 101 ), fc::exception );
+
+      // the range stops at the first block this node does not have
+      BOOST_CHECK_EQUAL( api.get_blocks( head - 1, 10 ).size(), 2u );
+      BOOST_CHECK( api.get_blocks( head + 1, 10 ).empty() );
+      BOOST_CHECK( api.get_blocks( 0, 10 ).empty() );
+      BOOST_CHECK( api.get_blocks( 1, 0 ).empty() );
+
+      db.pop_block();
+      BOOST_CHECK_EQUAL( api.get_blocks( head - 1, 10 ).size(), 1u );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
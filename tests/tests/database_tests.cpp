@@ -24,11 +24,20 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/database_api.hpp>
+
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/transaction_object.hpp>
+
+#include <graphene/db/disk_index.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/thread/thread.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -59,3 +68,463 @@ BOOST_AUTO_TEST_CASE( undo_test )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( object_revision_test )
+{
+   try {
+      database db;
+      uint64_t start = db.get_revision();
+
+      auto ses = db._undo_db.start_undo_session();
+      const auto& bal_obj = db.create<account_balance_object>( [&]( account_balance_object& obj ){} );
+      auto id = bal_obj.id;
+      uint64_t created = db.get_object_revision( id );
+      BOOST_CHECK_GT( created, start );
+      BOOST_CHECK_EQUAL( created, db.get_revision() );
+
+      db.modify( bal_obj, [&]( account_balance_object& obj ){ obj.balance = 10; } );
+      uint64_t modified = db.get_object_revision( id );
+      BOOST_CHECK_GT( modified, created );
+
+      // undoing the creation removes the object, which must look like a change to anyone who saw it
+      uint64_t before_undo = db.get_revision();
+      ses.undo();
+      BOOST_CHECK( db.find_object( id ) == nullptr );
+      BOOST_CHECK_GT( db.get_removal_revision( id.space(), id.type() ), before_undo );
+      BOOST_CHECK_GT( db.get_revision(), before_undo );
+
+      // the revision keeps growing after the undo, even though the object id is reused
+      ses = db._undo_db.start_undo_session();
+      const auto& bal_obj2 = db.create<account_balance_object>( [&]( account_balance_object& obj ){} );
+      BOOST_CHECK( bal_obj2.id == id );
+      BOOST_CHECK_GT( db.get_object_revision( id ), modified );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( balance_index_test )
+{
+   try {
+      database db;
+      const account_balance_index& idx = db.get_index_type<account_balance_index>();
+      auto make_balance = [&]( account_id_type owner, asset_id_type asset, share_type amount ) -> const account_balance_object& {
+         return db.create<account_balance_object>( [&]( account_balance_object& b ) {
+            b.owner = owner;
+            b.asset_type = asset;
+            b.balance = amount;
+         });
+      };
+      auto ranked_owners = [&]( asset_id_type asset ) {
+         vector<account_id_type> owners;
+         for( const account_balance_object* b : idx.get_ranked_balances( asset ) )
+            owners.push_back( b->owner );
+         return owners;
+      };
+
+      make_balance( account_id_type(5), asset_id_type(1), 100 );
+      make_balance( account_id_type(5), asset_id_type(0), 300 );
+      make_balance( account_id_type(2), asset_id_type(1), 100 );
+      const auto& b7 = make_balance( account_id_type(7), asset_id_type(1), 50 );
+      BOOST_CHECK_THROW( make_balance( account_id_type(5), asset_id_type(0), 1 ), fc::exception );
+
+      BOOST_REQUIRE( idx.find( account_id_type(5), asset_id_type(0) ) != nullptr );
+      BOOST_CHECK_EQUAL( idx.find( account_id_type(5), asset_id_type(0) )->balance.value, 300 );
+      BOOST_CHECK( idx.find( account_id_type(2), asset_id_type(0) ) == nullptr );
+      BOOST_CHECK( idx.find( account_id_type(100), asset_id_type(0) ) == nullptr );
+      BOOST_CHECK( idx.get_account_balances( account_id_type(100) ).empty() );
+
+      // an account's balances come sorted by asset
+      const auto& of5 = idx.get_account_balances( account_id_type(5) );
+      BOOST_REQUIRE_EQUAL( of5.size(), 2 );
+      BOOST_CHECK( of5.begin()->first == asset_id_type(0) );
+
+      // largest first, ties go to the lower account id
+      vector<account_id_type> expected = { account_id_type(2), account_id_type(5), account_id_type(7) };
+      BOOST_CHECK( ranked_owners( asset_id_type(1) ) == expected );
+
+      // the ranking follows changes, and undo puts everything back
+      {
+         auto ses = db._undo_db.start_undo_session( true );
+         db.modify( b7, []( account_balance_object& b ) { b.balance = 1000; } );
+         make_balance( account_id_type(9), asset_id_type(1), 500 );
+         expected = { account_id_type(7), account_id_type(9), account_id_type(2), account_id_type(5) };
+         BOOST_CHECK( ranked_owners( asset_id_type(1) ) == expected );
+         ses.undo();
+      }
+      expected = { account_id_type(2), account_id_type(5), account_id_type(7) };
+      BOOST_CHECK( ranked_owners( asset_id_type(1) ) == expected );
+      BOOST_CHECK( idx.find( account_id_type(9), asset_id_type(1) ) == nullptr );
+      BOOST_CHECK_EQUAL( idx.find( account_id_type(7), asset_id_type(1) )->balance.value, 50 );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( restored_object_revision_test, database_fixture )
+{
+   try {
+      ACTORS( (seller) );
+      const auto& test = create_user_issued_asset( "REVTEST" );
+      fund( seller, asset( 10000 ) );
+      const limit_order_id_type order_id = create_sell_order( seller_id, asset( 1000 ), test.amount( 100 ) )->id;
+      generate_block();
+
+      graphene::app::database_api api( db );
+      const vector<object_id_type> ids{ order_id };
+      uint64_t known = api.get_objects_since( ids, 0 ).revision;
+
+      // a pending transaction removes the order
+      cancel_limit_order( order_id(db) );
+      auto removed = api.get_objects_since( ids, known );
+      BOOST_REQUIRE_EQUAL( removed.changed.size(), 1u );
+      BOOST_CHECK( removed.changed.begin()->second.is_null() );
+      known = removed.revision;
+
+      // discarding the transaction makes undo put the order back, which clients must hear about
+      db.clear_pending();
+      BOOST_REQUIRE( db.find( order_id ) != nullptr );
+      auto restored = api.get_objects_since( ids, known );
+      BOOST_REQUIRE_EQUAL( restored.changed.size(), 1u );
+      BOOST_CHECK( restored.changed.begin()->second["id"].as<limit_order_id_type>() == order_id );
+      BOOST_CHECK_GT( db.get_object_revision( order_id ), known );
+      BOOST_CHECK( api.get_objects_since( ids, restored.revision ).changed.empty() );
+
+      // once the block after the restore is irreversible, the order's entry is dropped and it
+      // reports the raised base revision like any object without a recorded change, which is never
+      // older than what was recorded for it
+      const uint32_t restored_block = db.head_block_num() + 1;
+      for( int i = 0; i < 100 && db.get_dynamic_global_properties().last_irreversible_block_num < restored_block; ++i )
+         generate_block();
+      BOOST_REQUIRE_GE( db.get_dynamic_global_properties().last_irreversible_block_num, restored_block );
+      BOOST_CHECK_EQUAL( db.get_object_revision( order_id ), db.get_object_revision( limit_order_id_type( 1000000 ) ) );
+      BOOST_CHECK_GT( db.get_object_revision( order_id ), restored.revision );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( disk_index_test )
+{
+   try {
+      typedef primary_index< disk_index< operation_history_object > > history_index;
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      vector<operation_history_id_type> ids;
+      {
+         graphene::db::object_database db;
+         auto idx = db.add_index< history_index >();
+         idx->set_cache_size( 8 );
+         db.open( data_dir.path() );
+
+         for( uint32_t i = 0; i < 50; ++i )
+         {
+            ids.push_back( db.create<operation_history_object>( [&]( operation_history_object& o ) {
+               o.block_num = i;
+            }).id );
+            db.trim_caches();
+         }
+         BOOST_CHECK( idx->cached_objects() <= 8 );
+         BOOST_CHECK_EQUAL( ids[3](db).block_num, 3 );
+
+         {
+            auto ses = db._undo_db.start_undo_session();
+            db.modify( ids[4](db), []( operation_history_object& o ) { o.block_num = 1000; } );
+            db.remove( ids[5](db) );
+            db.create<operation_history_object>( []( operation_history_object& o ) { o.block_num = 2000; } );
+            // evicting in the middle of a session must not lose the undo state
+            db.trim_caches();
+            BOOST_CHECK_EQUAL( ids[4](db).block_num, 1000 );
+            BOOST_CHECK( db.find( ids[5] ) == nullptr );
+            ses.undo();
+         }
+         BOOST_CHECK_EQUAL( ids[4](db).block_num, 4 );
+         BOOST_CHECK_EQUAL( ids[5](db).block_num, 5 );
+         BOOST_CHECK( db.find( operation_history_id_type(50) ) == nullptr );
+
+         db.remove( ids[6](db) );
+         db.flush();
+         db.close();
+      }
+      {
+         graphene::db::object_database db;
+         db.add_index< history_index >();
+         db.open( data_dir.path() );
+         BOOST_CHECK_EQUAL( ids[49](db).block_num, 49 );
+         BOOST_CHECK( db.find( ids[6] ) == nullptr );
+         BOOST_CHECK( db.get_index_type< history_index >().get_next_id() == operation_history_id_type(50) );
+         uint32_t count = 0;
+         db.get_index_type< history_index >().inspect_all_objects( [&]( const object& ) { ++count; } );
+         BOOST_CHECK_EQUAL( count, 49 );
+
+         // readers on the API pool miss the cache concurrently
+         vector<std::unique_ptr<fc::thread>> readers;
+         vector<fc::future<uint32_t>> mismatches;
+         for( uint32_t t = 0; t < 4; ++t )
+         {
+            readers.emplace_back( new fc::thread( "disk_index_reader" ) );
+            mismatches.push_back( readers.back()->async( [&]() -> uint32_t {
+               uint32_t bad = 0;
+               for( uint32_t round = 0; round < 20; ++round )
+                  for( uint32_t i = 0; i < 50; ++i )
+                  {
+                     const auto* o = db.find( ids[i] );
+                     if( i == 6 ? o != nullptr : ( o == nullptr || o->block_num != i ) )
+                        ++bad;
+                  }
+               return bad;
+            }));
+         }
+         for( auto& m : mismatches )
+            BOOST_CHECK_EQUAL( m.wait(), 0u );
+      }
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( disk_index_keeps_unwritten_objects )
+{
+   try {
+      typedef primary_index< disk_index< operation_history_object > > history_index;
+      graphene::db::object_database db;
+      auto idx = db.add_index< history_index >();
+      idx->set_cache_size( 8 );
+
+      // without a store nothing can be written back, so trimming must not drop anything
+      vector<operation_history_id_type> ids;
+      for( uint32_t i = 0; i < 50; ++i )
+      {
+         ids.push_back( db.create<operation_history_object>( [&]( operation_history_object& o ) {
+            o.block_num = i;
+         }).id );
+         db.trim_caches();
+      }
+      BOOST_CHECK_EQUAL( idx->cached_objects(), 50u );
+      for( uint32_t i = 0; i < 50; ++i )
+         BOOST_CHECK_EQUAL( ids[i](db).block_num, i );
+
+      // once there is a store they are written back and evicted as usual
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      db.open( data_dir.path() );
+      db.trim_caches();
+      BOOST_CHECK( idx->cached_objects() <= 8 );
+      BOOST_CHECK_EQUAL( idx->store().end_instance(), 50u );
+      for( uint32_t i = 0; i < 50; ++i )
+         BOOST_CHECK_EQUAL( ids[i](db).block_num, i );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( transaction_index_test )
+{
+   try {
+      database db;
+      const auto& idx = db.get_index_type<transaction_index>();
+      auto trx_id = []( int i ) { return fc::ripemd160::hash( "trx" + std::to_string(i) ); };
+      const time_point_sec start( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+
+      // enough objects for the hash table to grow a few times
+      for( int i = 0; i < 5000; ++i )
+         db.create<transaction_object>( [&]( transaction_object& t ) {
+            t.trx_id = trx_id(i);
+            t.expiration = start + (i % 100) * 10;
+         });
+      BOOST_CHECK_EQUAL( idx.size(), 5000u );
+      for( int i = 0; i < 5000; ++i )
+      {
+         const transaction_object* t = idx.find_trx( trx_id(i) );
+         BOOST_REQUIRE( t != nullptr );
+         BOOST_CHECK( t->id == transaction_obj_id_type(i) );
+      }
+      BOOST_CHECK( idx.find_trx( trx_id(5000) ) == nullptr );
+
+      // objects expiring before start + 500 go away, the rest are all still found
+      vector<const transaction_object*> expired;
+      const_cast<transaction_index&>(idx).get_expired( start + 500, expired );
+      BOOST_CHECK_EQUAL( expired.size(), 2500u );
+      for( const transaction_object* t : expired )
+      {
+         BOOST_CHECK( t->expiration < start + 500 );
+         db.remove( *t );
+      }
+      for( int i = 0; i < 5000; ++i )
+         BOOST_CHECK( (idx.find_trx( trx_id(i) ) != nullptr) == (i % 100 >= 50) );
+
+      // removals that are undone are found and expire again
+      db._undo_db.enable();
+      {
+         auto session = db._undo_db.start_undo_session();
+         expired.clear();
+         const_cast<transaction_index&>(idx).get_expired( start + 1000, expired );
+         BOOST_CHECK_EQUAL( expired.size(), 2500u );
+         for( const transaction_object* t : expired )
+            db.remove( *t );
+         BOOST_CHECK_EQUAL( idx.size(), 0u );
+         db.create<transaction_object>( [&]( transaction_object& t ) {
+            t.trx_id = trx_id(5000);
+            t.expiration = start + 2000;
+         });
+      }
+      BOOST_CHECK_EQUAL( idx.size(), 2500u );
+      BOOST_CHECK( idx.find_trx( trx_id(5000) ) == nullptr );
+      BOOST_CHECK( idx.find_trx( trx_id(99) ) != nullptr );
+      expired.clear();
+      const_cast<transaction_index&>(idx).get_expired( start + 1000, expired );
+      BOOST_CHECK_EQUAL( expired.size(), 2500u );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( recent_transaction_test, database_fixture )
+{
+   try {
+      ACTORS( (alice) );
+      generate_block();
+
+      signed_transaction tx;
+      transfer_operation op;
+      op.from = account_id_type();
+      op.to = alice_id;
+      op.amount = asset(1000);
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      PUSH_TX( db, tx, ~0 );
+      const auto id = tx.id();
+
+      // pending transactions and those in a block are both served, pending ones without touching a block
+      const auto& trx_idx = db.get_index_type<transaction_index>();
+      BOOST_CHECK( db.is_known_transaction( id ) );
+      BOOST_CHECK_EQUAL( trx_idx.find_trx( id )->block_num, 0u );
+      BOOST_CHECK( db.get_recent_transaction( id ).id() == id );
+      generate_block();
+      BOOST_CHECK( db.is_known_transaction( id ) );
+      BOOST_CHECK_EQUAL( trx_idx.find_trx( id )->block_num, db.head_block_num() );
+      BOOST_CHECK( db.get_recent_transaction( id ).operations.front().get<transfer_operation>().amount == asset(1000) );
+
+      generate_blocks( tx.expiration + db.get_global_properties().parameters.block_interval );
+      BOOST_CHECK( !db.is_known_transaction( id ) );
+      GRAPHENE_REQUIRE_THROW( db.get_recent_transaction( id ), fc::exception );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( apply_profiler_test, database_fixture )
+{
+   try {
+      auto& profiler = db.get_apply_profiler();
+      BOOST_CHECK( !profiler.enabled() );
+      profiler.enable( true );
+
+      ACTORS( (alice)(bob) );
+      fund( alice );
+      transfer( alice, bob, asset(1000) );
+      generate_block();
+      generate_block();
+
+      auto profile = profiler.get_profile();
+      BOOST_CHECK_EQUAL( profile.block.count, 2 );
+      BOOST_CHECK_EQUAL( profile.last_block, db.head_block_num() );
+      BOOST_CHECK( profile.steps.count( "apply_transactions" ) );
+      BOOST_CHECK( profile.steps.count( "clear_expired_orders" ) );
+      BOOST_CHECK( profile.undo_sessions_started > 0 );
+
+      bool found_transfer = false;
+      for( const auto& op : profile.operations )
+         if( op.which == operation::tag<transfer_operation>::value )
+         {
+            found_transfer = true;
+            BOOST_CHECK_EQUAL( op.name, "transfer_operation" );
+            // fund() and transfer() were pushed as pending first, each is counted once when applied in the block
+            BOOST_CHECK_EQUAL( op.evaluate.count, 2u );
+            BOOST_CHECK_EQUAL( op.evaluate.count, op.apply.count );
+         }
+      BOOST_CHECK( found_transfer );
+
+      profiler.reset();
+      BOOST_CHECK_EQUAL( profiler.get_profile().block.count, 0 );
+      BOOST_CHECK( profiler.get_profile().operations.empty() );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( account_member_index_test, database_fixture )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      const auto& refs = dynamic_cast<const primary_index<account_index>&>( db.get_index_type<account_index>() )
+                            .get_secondary_index<account_member_index>();
+      auto references = [&]( const public_key_type& key ) {
+         vector<account_id_type> result;
+         refs.find_key_references( key, result );
+         return result;
+      };
+
+      const public_key_type alice_key = alice_private_key.get_public_key();
+      const public_key_type new_key = generate_private_key( "new" ).get_public_key();
+      BOOST_REQUIRE_EQUAL( references( alice_key ).size(), 1u );
+      BOOST_CHECK( references( alice_key )[0] == alice_id );
+      BOOST_CHECK( references( new_key ).empty() );
+
+      account_update_operation op;
+      op.account = alice_id;
+      op.active = authority( 1, bob_id, 1, new_key, 1 );
+      trx.operations.push_back( op );
+      PUSH_TX( db, trx, ~0 );
+      trx.operations.clear();
+
+      BOOST_REQUIRE_EQUAL( references( new_key ).size(), 1u );
+      BOOST_CHECK( references( new_key )[0] == alice_id );
+      // still the owner and memo key
+      BOOST_CHECK_EQUAL( references( alice_key ).size(), 1u );
+      BOOST_REQUIRE( refs.account_to_account_memberships.count( bob_id ) );
+      BOOST_CHECK( refs.account_to_account_memberships.at( bob_id ).count( alice_id ) );
+
+      // modifications that leave the authorities alone do not disturb the index
+      db.modify( alice_id(db), []( account_object& a ) { a.name = "alice-renamed"; } );
+      BOOST_CHECK_EQUAL( references( new_key ).size(), 1u );
+
+      db.modify( alice_id(db), [&]( account_object& a ) {
+         a.owner = authority( 1, new_key, 1 );
+         a.active = authority( 1, new_key, 1 );
+         a.options.memo_key = new_key;
+      });
+      BOOST_CHECK( references( alice_key ).empty() );
+      BOOST_CHECK( !refs.account_to_key_memberships.count( alice_key ) );
+      BOOST_CHECK( !refs.account_to_account_memberships.count( bob_id ) );
+
+      // genesis style address authorities are found through the legacy address forms of a key
+      const public_key_type legacy_key = generate_private_key( "legacy" ).get_public_key();
+      db.modify( bob_id(db), [&]( account_object& a ) {
+         a.active.address_auths[ address( pts_address( legacy_key, false, 56 ) ) ] = 1;
+      });
+      BOOST_REQUIRE_EQUAL( references( legacy_key ).size(), 1u );
+      BOOST_CHECK( references( legacy_key )[0] == bob_id );
+      vector<account_id_type> with_legacy;
+      refs.find_key_references( legacy_key, account_member_index::legacy_addresses( legacy_key ), with_legacy );
+      BOOST_CHECK( with_legacy == references( legacy_key ) );
+
+      db.modify( bob_id(db), [&]( account_object& a ) { a.active.address_auths.clear(); } );
+      BOOST_CHECK( references( legacy_key ).empty() );
+      BOOST_CHECK( !refs.has_address_members() );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
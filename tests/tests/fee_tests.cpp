@@ -943,4 +943,49 @@ BOOST_AUTO_TEST_CASE( stealth_fba_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( pending_fee_index_tracks_fee_payers )
+{
+   try
+   {
+      ACTORS((alice)(bob)(carol));
+      transfer( committee_account, alice_id, asset( 1000000 ) );
+      transfer( committee_account, bob_id, asset( 1000000 ) );
+      enable_fees();
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+
+      const auto& stats_idx = dynamic_cast<const primary_index<simple_index<account_statistics_object>>&>(
+            db.get_index_type<simple_index<account_statistics_object>>() );
+      const auto& pending = stats_idx.get_secondary_index<account_pending_fee_index>().accounts_with_pending_fees;
+      BOOST_CHECK( pending.empty() );
+
+      transfer( alice_id, carol_id, asset( 1000 ) );
+      transfer( bob_id, carol_id, asset( 1000 ) );
+      BOOST_CHECK_EQUAL( pending.size(), 2u );
+      BOOST_CHECK( pending.count( alice_id ) );
+      BOOST_CHECK( pending.count( bob_id ) );
+      BOOST_CHECK( !pending.count( carol_id ) );
+
+      // undoing the pending transactions takes the fees and the entries back
+      db.clear_pending();
+      BOOST_CHECK( pending.empty() );
+
+      transfer( alice_id, carol_id, asset( 1000 ) );
+      generate_block();
+      BOOST_CHECK_EQUAL( pending.size(), 1u );
+      const share_type paid = alice_id(db).statistics(db).pending_fees + alice_id(db).statistics(db).pending_vested_fees;
+      BOOST_CHECK( paid > 0 );
+
+      // maintenance pays out exactly the tracked accounts and leaves nothing behind
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      BOOST_CHECK( pending.empty() );
+      BOOST_CHECK_EQUAL( alice_id(db).statistics(db).lifetime_fees_paid.value, paid.value );
+      BOOST_CHECK_EQUAL( bob_id(db).statistics(db).lifetime_fees_paid.value, 0 );
+   }
+   catch( const fc::exception& e )
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
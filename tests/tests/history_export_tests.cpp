@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <boost/program_options.hpp>
+
+#include <graphene/history_export/history_export_plugin.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::history_export::history_export_plugin;
+using graphene::history_export::row_group;
+
+namespace {
+
+std::shared_ptr<history_export_plugin> start_export( database_fixture& f, const fc::path& dir, uint32_t segment_blocks )
+{
+   auto plugin = std::make_shared<history_export_plugin>();
+   plugin->plugin_set_app( &f.app );
+
+   boost::program_options::options_description cli, cfg;
+   plugin->plugin_set_program_options( cli, cfg );
+   const vector<std::string> args = { "--export-dir", dir.generic_string(),
+                                      "--export-segment-blocks", std::to_string( segment_blocks ),
+                                      "--export-row-group-size", "1" };
+   boost::program_options::variables_map options;
+   boost::program_options::store( boost::program_options::command_line_parser( args ).options( cli ).run(), options );
+   plugin->plugin_initialize( options );
+   plugin->plugin_startup();
+   return plugin;
+}
+
+/// block numbers of all exported transfers, in file order
+vector<uint32_t> exported_transfers( const fc::path& dir )
+{
+   vector<uint32_t> result;
+   const fc::path table = dir / "transfer_operation";
+   if( !fc::exists( table ) )
+      return result;
+
+   vector<std::string> names;
+   for( fc::directory_iterator file( table ); file != fc::directory_iterator(); ++file )
+      names.push_back( (*file).filename().generic_string() );
+   std::sort( names.begin(), names.end() );
+
+   for( const std::string& name : names )
+   {
+      std::ifstream in( ( table / name ).generic_string().c_str(), std::ios::binary );
+      uint32_t length = 0;
+      while( in.read( (char*)&length, sizeof(length) ) )
+      {
+         vector<char> data( length );
+         BOOST_REQUIRE( in.read( data.data(), length ) );
+         const row_group g = fc::raw::unpack<row_group>( data );
+         result.insert( result.end(), g.block_num.begin(), g.block_num.end() );
+      }
+   }
+   return result;
+}
+
+/// makes one transfer per block, returns the numbers of the blocks
+vector<uint32_t> make_transfers( database_fixture& f, uint32_t count )
+{
+   vector<uint32_t> result;
+   const account_id_type to = f.get_account( "init0" ).id;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      f.transfer( account_id_type(), to, asset( 1 ) );
+      f.generate_block();
+      result.push_back( f.db.head_block_num() );
+   }
+   return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( history_export_tests )
+
+BOOST_AUTO_TEST_CASE( replayed_blocks_are_not_exported_twice )
+{
+   try {
+      fc::temp_directory export_dir;
+      vector<uint32_t> first_run;
+      {
+         database_fixture f;
+         auto plugin = start_export( f, export_dir.path(), 1000 );
+         make_transfers( f, 5 );
+         f.generate_blocks( 20 );
+         plugin->plugin_shutdown();
+         first_run = exported_transfers( export_dir.path() );
+         BOOST_REQUIRE_EQUAL( first_run.size(), 5u );
+      }
+
+      // the same chain again, as a replay would deliver it, and then some new blocks
+      database_fixture f;
+      auto plugin = start_export( f, export_dir.path(), 1000 );
+      make_transfers( f, 5 );
+      f.generate_blocks( 20 );
+      make_transfers( f, 3 );
+      f.generate_blocks( 20 );
+      plugin->plugin_shutdown();
+
+      const vector<uint32_t> blocks = exported_transfers( export_dir.path() );
+      BOOST_REQUIRE_EQUAL( blocks.size(), 8u );
+      BOOST_CHECK( std::equal( first_run.begin(), first_run.end(), blocks.begin() ) );
+      BOOST_CHECK( std::is_sorted( blocks.begin(), blocks.end() ) );
+      BOOST_CHECK( std::adjacent_find( blocks.begin(), blocks.end() ) == blocks.end() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( rows_after_the_checkpoint_are_dropped_on_restart )
+{
+   try {
+      fc::temp_directory export_dir;
+      database_fixture f;
+
+      auto plugin = start_export( f, export_dir.path(), 1000 );
+      make_transfers( f, 4 );
+      f.generate_blocks( 20 );
+      plugin->plugin_shutdown();
+      const uint32_t checkpoint = f.db.get_dynamic_global_properties().last_irreversible_block_num;
+      const vector<uint32_t> saved = exported_transfers( export_dir.path() );
+      BOOST_REQUIRE_EQUAL( saved.size(), 4u );
+
+      // rows are written as soon as a row group is full, the crash comes before the next checkpoint
+      plugin = start_export( f, export_dir.path(), 1000 );
+      make_transfers( f, 3 );
+      f.generate_blocks( 20 );
+      plugin.reset();
+      BOOST_REQUIRE_EQUAL( exported_transfers( export_dir.path() ).size(), 7u );
+
+      plugin = start_export( f, export_dir.path(), 1000 );
+      const vector<uint32_t> blocks = exported_transfers( export_dir.path() );
+      BOOST_CHECK( blocks == saved );
+      BOOST_CHECK( blocks.back() <= checkpoint );
+      plugin->plugin_shutdown();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( segments_are_checkpointed_as_they_end )
+{
+   try {
+      fc::temp_directory export_dir;
+      database_fixture f;
+
+      // without a clean shutdown, what survives is what the last completed segment covered
+      auto plugin = start_export( f, export_dir.path(), 5 );
+      const vector<uint32_t> transfers = make_transfers( f, 30 );
+      const uint32_t last_irreversible = f.db.get_dynamic_global_properties().last_irreversible_block_num;
+      plugin.reset();
+
+      const uint32_t checkpoint = last_irreversible - last_irreversible % 5;
+      vector<uint32_t> expected;
+      for( uint32_t b : transfers )
+         if( b <= checkpoint )
+            expected.push_back( b );
+      BOOST_REQUIRE( !expected.empty() && expected.size() < transfers.size() );
+
+      plugin = start_export( f, export_dir.path(), 5 );
+      BOOST_CHECK( exported_transfers( export_dir.path() ) == expected );
+      plugin->plugin_shutdown();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
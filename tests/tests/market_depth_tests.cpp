@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/market_depth.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::app::market_depth;
+using graphene::app::market_depth_delta;
+using graphene::app::market_depth_snapshot;
+
+BOOST_FIXTURE_TEST_SUITE( market_depth_tests, database_fixture )
+
+static void check_same_levels( const vector<graphene::app::depth_level>& a, const vector<graphene::app::depth_level>& b )
+{
+   BOOST_REQUIRE_EQUAL( a.size(), b.size() );
+   for( size_t i = 0; i < a.size(); ++i )
+   {
+      BOOST_CHECK( a[i].sell_price == b[i].sell_price );
+      BOOST_CHECK_EQUAL( a[i].for_sale.value, b[i].for_sale.value );
+      BOOST_CHECK_EQUAL( a[i].orders, b[i].orders );
+   }
+}
+
+BOOST_AUTO_TEST_CASE( depth_follows_order_book )
+{
+   try {
+      ACTORS( (buyer)(seller) );
+      const auto& test = create_user_issued_asset( "DEPTHTEST" );
+      const asset_id_type test_id = test.id;
+      const asset_id_type core_id;
+      issue_uia( seller, test.amount( 100000 ) );
+      fund( buyer, asset( 100000 ) );
+
+      auto depth = market_depth::create( db );
+      depth->track( core_id, test_id );
+      BOOST_CHECK( depth->is_tracked( test_id, core_id ) );
+
+      vector<market_depth_delta> deltas;
+      boost::signals2::scoped_connection connection = depth->depth_changed.connect(
+         [&]( const map< std::pair<asset_id_type,asset_id_type>, fc::variant >& changed ) {
+            for( const auto& item : changed )
+               deltas.push_back( item.second.as<market_depth_delta>() );
+         });
+
+      auto check_consistent = [&]() {
+         auto tracked = depth->get_snapshot( core_id, test_id, 100 );
+         auto fresh = market_depth::aggregate_orders( db, core_id, test_id, 100 );
+         check_same_levels( tracked.bids, fresh.bids );
+         check_same_levels( tracked.asks, fresh.asks );
+      };
+
+      // orders at the same price share a level, the best level comes first
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 200 ) );
+      create_sell_order( buyer_id, asset( 300 ), test.amount( 600 ) );
+      create_sell_order( buyer_id, asset( 100 ), test.amount( 300 ) );
+      auto snapshot = depth->get_snapshot( core_id, test_id, 100 );
+      BOOST_REQUIRE_EQUAL( snapshot.bids.size(), 2 );
+      BOOST_CHECK_EQUAL( snapshot.bids[0].for_sale.value, 400 );
+      BOOST_CHECK_EQUAL( snapshot.bids[0].orders, 2 );
+      BOOST_CHECK_EQUAL( snapshot.bids[1].for_sale.value, 100 );
+      BOOST_CHECK( snapshot.asks.empty() );
+      BOOST_CHECK_EQUAL( depth->get_snapshot( core_id, test_id, 1 ).bids.size(), 1 );
+      BOOST_REQUIRE_EQUAL( deltas.size(), 3 );
+      BOOST_CHECK( deltas[0].sequence < deltas[1].sequence && deltas[1].sequence < deltas[2].sequence );
+      BOOST_CHECK_EQUAL( snapshot.sequence, deltas.back().sequence );
+
+      // an order that does not cross rests on the other side
+      create_sell_order( seller_id, test.amount( 100 ), asset( 100 ) );
+      BOOST_CHECK_EQUAL( depth->get_snapshot( core_id, test_id, 100 ).asks.size(), 1 );
+      check_consistent();
+
+      // a partial fill modifies the resting order
+      create_sell_order( seller_id, test.amount( 100 ), asset( 40 ) );
+      BOOST_CHECK_EQUAL( depth->get_snapshot( core_id, test_id, 100 ).bids[0].for_sale.value, 350 );
+      check_consistent();
+
+      // popping the block puts back removed and modified orders
+      generate_block();
+      auto before_pop = depth->get_snapshot( core_id, test_id, 100 );
+      create_sell_order( seller_id, test.amount( 1000 ), asset( 100 ) );
+      generate_block();
+      db.pop_block();
+      db.clear_pending();
+      check_consistent();
+      check_same_levels( depth->get_snapshot( core_id, test_id, 100 ).bids, before_pop.bids );
+      check_same_levels( depth->get_snapshot( core_id, test_id, 100 ).asks, before_pop.asks );
+
+      // removed levels are reported with nothing for sale
+      deltas.clear();
+      const auto& orders = db.get_index_type<limit_order_index>().indices().get<by_account>();
+      auto itr = orders.lower_bound( boost::make_tuple( buyer_id ) );
+      BOOST_REQUIRE( itr != orders.end() && itr->seller == buyer_id );
+      cancel_limit_order( *itr );
+      BOOST_REQUIRE( !deltas.empty() );
+      check_consistent();
+
+      depth->untrack( test_id, core_id );
+      BOOST_CHECK( !depth->is_tracked( core_id, test_id ) );
+      check_consistent();
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
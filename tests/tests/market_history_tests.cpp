@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/market_history/bucket_store.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+
+using namespace graphene::chain;
+using namespace graphene::market_history;
+
+namespace {
+
+   const asset_id_type core_id;
+   const asset_id_type test_id( 1 );
+
+   /** a trade of core for test, with the matching fill of the other side */
+   void trade( bucket_store& store, uint32_t block_num, uint32_t time, int64_t core_amount, int64_t test_amount )
+   {
+      const fc::time_point_sec t( time );
+      store.push_fill( block_num, t, fill_order_operation( object_id_type(), account_id_type(),
+                                                           asset( core_amount, core_id ), asset( test_amount, test_id ), asset() ) );
+      store.push_fill( block_num, t, fill_order_operation( object_id_type(), account_id_type(),
+                                                           asset( test_amount, test_id ), asset( core_amount, core_id ), asset() ) );
+   }
+
+   vector<bucket_object> all_buckets( const bucket_store& store, uint32_t seconds, uint32_t limit = 10000 )
+   {
+      return store.get_buckets( test_id, core_id, seconds, fc::time_point_sec(), fc::time_point_sec::maximum(), limit );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE( market_history_tests )
+
+BOOST_AUTO_TEST_CASE( bucket_series_round_trip )
+{
+   try {
+      bucket_store store;
+      store.set_bucket_sizes( { 60, 3600 } );
+
+      // one trade a minute, every trade irreversible as soon as it is pushed
+      const uint32_t start = 1500000000 / 3600 * 3600;
+      const uint32_t count = 5 * bucket_series::rows_per_chunk + 7;
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         trade( store, i + 1, start + i * 60, 100 + i, 10 + (i % 3) );
+         store.set_last_irreversible_block( i + 1 );
+      }
+      BOOST_CHECK_EQUAL( store.journal_size(), 0u );
+
+      auto minutes = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( minutes.size(), count );
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         const auto& b = minutes[i];
+         BOOST_CHECK( b.key.base == core_id );
+         BOOST_CHECK( b.key.quote == test_id );
+         BOOST_CHECK_EQUAL( b.key.seconds, 60u );
+         BOOST_CHECK_EQUAL( b.key.open.sec_since_epoch(), start + i * 60 );
+         BOOST_CHECK_EQUAL( b.open_base.value, 100 + i );
+         BOOST_CHECK_EQUAL( b.close_quote.value, 10 + (i % 3) );
+         BOOST_CHECK_EQUAL( b.base_volume.value, 100 + i );
+      }
+
+      auto hours = all_buckets( store, 3600 );
+      BOOST_REQUIRE_EQUAL( hours.size(), (count + 59) / 60 );
+      BOOST_CHECK_EQUAL( hours[0].open_base.value, 100 );
+      BOOST_CHECK_EQUAL( hours[0].close_base.value, 159 );
+      BOOST_CHECK_EQUAL( hours[0].base_volume.value, (100 + 159) * 60 / 2 );
+      // 157/10 is the highest and 102/12 the lowest price of core in test during the first hour
+      BOOST_CHECK_EQUAL( hours[0].high_base.value, 157 );
+      BOOST_CHECK_EQUAL( hours[0].high_quote.value, 10 );
+      BOOST_CHECK_EQUAL( hours[0].low_base.value, 102 );
+      BOOST_CHECK_EQUAL( hours[0].low_quote.value, 12 );
+
+      // ranges and limits cut across sealed chunks
+      auto range = store.get_buckets( core_id, test_id, 60, fc::time_point_sec( start + 60 * 60 ),
+                                      fc::time_point_sec( start + 200 * 60 ), 100 );
+      BOOST_REQUIRE_EQUAL( range.size(), 100u );
+      BOOST_CHECK_EQUAL( range.front().key.open.sec_since_epoch(), start + 60 * 60 );
+      BOOST_CHECK_EQUAL( range.back().open_base.value, 100 + 159 );
+      BOOST_CHECK_EQUAL( all_buckets( store, 60, 10 ).size(), 10u );
+      BOOST_CHECK( all_buckets( store, 300 ).empty() );
+
+      // every bucket of every series has its own id
+      flat_set<object_id_type> ids;
+      for( const auto& b : minutes )
+         ids.insert( b.id );
+      for( const auto& b : hours )
+         ids.insert( b.id );
+      BOOST_CHECK_EQUAL( ids.size(), minutes.size() + hours.size() );
+      BOOST_CHECK_EQUAL( minutes[0].id.space(), bucket_object::space_id );
+      BOOST_CHECK_EQUAL( minutes[0].id.type(), bucket_object::type_id );
+
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      const fc::path file = dir.path() / "buckets";
+      const block_id_type lib_id = fc::ripemd160::hash( std::string( "last irreversible" ) );
+      store.save( file, lib_id );
+
+      bucket_store loaded;
+      loaded.set_bucket_sizes( { 60, 3600 } );
+      BOOST_REQUIRE( loaded.load( file ) );
+      BOOST_CHECK_EQUAL( loaded.last_irreversible_block(), count );
+      BOOST_CHECK( loaded.loaded_block_id() == lib_id );
+      auto reloaded = all_buckets( loaded, 60 );
+      BOOST_REQUIRE_EQUAL( reloaded.size(), count );
+      for( uint32_t i = 0; i < count; ++i )
+         BOOST_CHECK( fc::json::to_string( reloaded[i] ) == fc::json::to_string( minutes[i] ) );
+
+      // ids continue where the saved store left off
+      trade( loaded, count + 1, start + count * 60, 100, 10 );
+      loaded.set_last_irreversible_block( count + 1 );
+      const auto next = all_buckets( loaded, 60 ).back();
+      BOOST_CHECK( !ids.count( next.id ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( bucket_store_follows_forks )
+{
+   try {
+      bucket_store store;
+      store.set_bucket_sizes( { 60 } );
+      const uint32_t start = 1500000000 / 60 * 60;
+
+      trade( store, 1, start, 100, 10 );
+      store.set_last_irreversible_block( 1 );
+      trade( store, 2, start + 3, 200, 10 );
+      trade( store, 3, start + 6, 300, 10 );
+      trade( store, 4, start + 60, 50, 10 );
+      BOOST_CHECK_EQUAL( store.journal_size(), 3u );
+
+      auto buckets = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 2u );
+      BOOST_CHECK( buckets[0].id != buckets[1].id );
+      const object_id_type forked_id = buckets[1].id;
+      BOOST_CHECK_EQUAL( buckets[0].base_volume.value, 600 );
+      BOOST_CHECK_EQUAL( buckets[0].close_base.value, 300 );
+      BOOST_CHECK_EQUAL( buckets[0].high_base.value, 300 );
+      BOOST_CHECK_EQUAL( buckets[1].base_volume.value, 50 );
+
+      // blocks 3 and 4 are replaced by a fork whose block 3 trades lower
+      store.pop_blocks( 3 );
+      trade( store, 3, start + 6, 80, 10 );
+      buckets = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( buckets.size(), 1u );
+      BOOST_CHECK_EQUAL( buckets[0].base_volume.value, 380 );
+      BOOST_CHECK_EQUAL( buckets[0].open_base.value, 100 );
+      BOOST_CHECK_EQUAL( buckets[0].close_base.value, 80 );
+      BOOST_CHECK_EQUAL( buckets[0].high_base.value, 200 );
+      BOOST_CHECK_EQUAL( buckets[0].low_base.value, 80 );
+
+      // a bucket opened after the fork takes the id the forked one had
+      trade( store, 4, start + 60, 70, 10 );
+      BOOST_CHECK( all_buckets( store, 60 )[1].id == forked_id );
+      store.pop_blocks( 4 );
+
+      // once irreversible the same buckets come from the series, under the same ids
+      store.set_last_irreversible_block( 3 );
+      BOOST_CHECK_EQUAL( store.journal_size(), 0u );
+      auto settled = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( settled.size(), 1u );
+      BOOST_CHECK( fc::json::to_string( settled[0] ) == fc::json::to_string( buckets[0] ) );
+
+      // popping irreversible blocks has no effect
+      store.pop_blocks( 2 );
+      BOOST_CHECK_EQUAL( all_buckets( store, 60 )[0].base_volume.value, 380 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( bucket_store_prunes_old_chunks )
+{
+   try {
+      bucket_store store;
+      store.set_bucket_sizes( { 60 } );
+      store.set_max_history( bucket_series::rows_per_chunk );
+      const uint32_t start = 1500000000 / 60 * 60;
+
+      const uint32_t count = 4 * bucket_series::rows_per_chunk + 10;
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         trade( store, i + 1, start + i * 60, 100 + i, 10 );
+         store.set_last_irreversible_block( i + 1 );
+      }
+
+      // exactly the last max_history buckets are returned, even though pruning keeps whole chunks
+      auto buckets = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( buckets.size(), bucket_series::rows_per_chunk );
+      BOOST_CHECK_EQUAL( buckets.front().key.open.sec_since_epoch(), start + (count - bucket_series::rows_per_chunk) * 60 );
+      BOOST_CHECK_EQUAL( buckets.back().key.open.sec_since_epoch(), start + (count - 1) * 60 );
+      BOOST_CHECK_EQUAL( buckets.back().open_base.value, 100 + count - 1 );
+
+      // the window is measured in bucket lengths, so minutes without trades use it up as well
+      const uint32_t later = start + (count - 1 + 10) * 60;
+      trade( store, count + 1, later, 100, 10 );
+      store.set_last_irreversible_block( count + 1 );
+      buckets = all_buckets( store, 60 );
+      BOOST_REQUIRE_EQUAL( buckets.size(), bucket_series::rows_per_chunk - 10 + 1 );
+      BOOST_CHECK_EQUAL( buckets.front().key.open.sec_since_epoch(), later - (bucket_series::rows_per_chunk - 1) * 60 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
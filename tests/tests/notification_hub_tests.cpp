@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/notification_hub.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using graphene::app::notification_hub;
+
+BOOST_FIXTURE_TEST_SUITE( notification_hub_tests, database_fixture )
+
+static set<object_id_type> ids_of( const vector<fc::variant>& batches )
+{
+   set<object_id_type> result;
+   for( const auto& batch : batches )
+      for( const auto& item : batch.get_array() )
+         result.insert( item.is_object() ? item["id"].as<object_id_type>() : item.as<object_id_type>() );
+   return result;
+}
+
+/// the callback sets the current promise so a test can wait for a batch instead of sleeping
+static void delivered( const fc::promise<void>::ptr& p )
+{
+   if( !p->ready() )
+      p->set_value();
+}
+
+static object_id_type core_balance_id( const database& db, account_id_type owner )
+{
+   const account_balance_object* b = db.get_index_type<account_balance_index>().find( owner, asset_id_type() );
+   FC_ASSERT( b != nullptr );
+   return b->id;
+}
+
+BOOST_AUTO_TEST_CASE( only_subscribed_objects_are_delivered )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      auto hub = notification_hub::create( db );
+
+      vector<fc::variant> alice_updates, bob_updates, idle_updates;
+      fc::promise<void>::ptr alice_delivered( new fc::promise<void>() );
+      fc::promise<void>::ptr bob_delivered( new fc::promise<void>() );
+      auto a = hub->connect();
+      a->set_callback( [&]( const fc::variant& v ) { alice_updates.push_back( v ); delivered( alice_delivered ); }, true );
+      a->subscribe( alice_id );
+      auto b = hub->connect();
+      b->set_callback( [&]( const fc::variant& v ) { bob_updates.push_back( v ); delivered( bob_delivered ); }, true );
+      b->subscribe( bob_id );
+      auto idle = hub->connect();
+      idle->set_callback( [&]( const fc::variant& v ) { idle_updates.push_back( v ); }, true );
+      BOOST_CHECK_EQUAL( hub->subscribers(), 3u );
+
+      transfer( account_id_type(), alice_id, asset( 1000 ) );
+      fc::future<void>( alice_delivered ).wait( fc::seconds( 5 ) );
+
+      // alice's balance is delivered because she owns it, the sender's is not;
+      // nothing was queued for bob or idle, so there is no delivery of theirs still to come
+      auto received = ids_of( alice_updates );
+      BOOST_CHECK( received.count( core_balance_id( db, alice_id ) ) );
+      BOOST_CHECK( !received.count( core_balance_id( db, account_id_type() ) ) );
+      BOOST_CHECK( bob_updates.empty() );
+      BOOST_CHECK( idle_updates.empty() );
+      BOOST_CHECK_EQUAL( hub->objects_serialized(), received.size() );
+
+      // released subscribers are dropped on the next change
+      idle.reset();
+      transfer( account_id_type(), bob_id, asset( 1000 ) );
+      fc::future<void>( bob_delivered ).wait( fc::seconds( 5 ) );
+      BOOST_CHECK_EQUAL( hub->subscribers(), 2u );
+      BOOST_CHECK( ids_of( bob_updates ).count( core_balance_id( db, bob_id ) ) );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( slow_subscribers_are_coalesced )
+{
+   try {
+      ACTORS( (alice) );
+      auto hub = notification_hub::create( db );
+      hub->set_max_pending( 1 );
+
+      vector<fc::variant> updates;
+      fc::promise<void>::ptr first_delivered( new fc::promise<void>() );
+      auto a = hub->connect();
+      a->set_callback( [&]( const fc::variant& v ) { updates.push_back( v ); delivered( first_delivered ); }, true );
+      a->subscribe( alice_id );
+
+      // nothing is delivered until this task yields, so the second change finds the first still queued
+      transfer( account_id_type(), alice_id, asset( 1000 ) );
+      transfer( account_id_type(), alice_id, asset( 2000 ) );
+      BOOST_CHECK_EQUAL( a->pending(), 1u );
+      fc::future<void>( first_delivered ).wait( fc::seconds( 5 ) );
+      BOOST_CHECK_EQUAL( a->pending(), 0u );
+
+      BOOST_REQUIRE_EQUAL( updates.size(), 1u );
+      const auto& items = updates[0].get_array();
+      BOOST_CHECK_EQUAL( items.size(), ids_of( updates ).size() );
+
+      const object_id_type alice_balance = core_balance_id( db, alice_id );
+      for( const auto& item : items )
+         if( item.is_object() && item["id"].as<object_id_type>() == alice_balance )
+            BOOST_CHECK_EQUAL( item["balance"].as<int64_t>(), 3000 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
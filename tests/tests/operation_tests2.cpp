@@ -1484,6 +1484,64 @@ BOOST_AUTO_TEST_CASE( top_n_special )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( top_n_special_unchanged_holders )
+{
+   ACTORS( (alice)(bob)(izzy)(stan) );
+
+   generate_blocks( HARDFORK_516_TIME );
+   generate_blocks( HARDFORK_599_TIME );
+
+   try
+   {
+      asset_id_type topn_id = create_user_issued_asset( "TOPN", izzy_id(db), 0 ).id;
+
+      {
+         top_holders_special_authority top2;
+         top2.num_top_holders = 2;
+         top2.asset = topn_id;
+
+         account_update_operation op;
+         op.account = stan_id;
+         op.extensions.value.active_special_authority = top2;
+         op.extensions.value.owner_special_authority = top2;
+
+         signed_transaction tx;
+         tx.operations.push_back( op );
+         set_expiration( db, tx );
+         sign( tx, stan_private_key );
+         PUSH_TX( db, tx );
+      }
+
+      set_expiration( db, trx );
+      issue_uia( alice_id, asset( 1000, topn_id ) );
+      generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+
+      BOOST_CHECK( stan_id(db).owner  == authority( 501, alice_id, 1000 ) );
+      BOOST_CHECK( stan_id(db).active == authority( 501, alice_id, 1000 ) );
+
+      // no balance of the asset changed, so maintenance leaves Stan alone
+      uint64_t stan_revision = db.get_object_revision( stan_id );
+      generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+      BOOST_CHECK_EQUAL( db.get_object_revision( stan_id ), stan_revision );
+      BOOST_CHECK( stan_id(db).owner  == authority( 501, alice_id, 1000 ) );
+
+      // popping the maintenance block rolls Stan back, redoing it brings Bob in again
+      set_expiration( db, trx );
+      issue_uia( bob_id, asset( 1000, topn_id ) );
+      generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+      const authority both( 1001, alice_id, 1000, bob_id, 1000 );
+      BOOST_CHECK( stan_id(db).owner  == both );
+      BOOST_CHECK( stan_id(db).active == both );
+
+      db.pop_block();
+      db.clear_pending();
+      BOOST_CHECK( stan_id(db).owner  == authority( 501, alice_id, 1000 ) );
+      generate_block();
+      BOOST_CHECK( stan_id(db).owner  == both );
+      BOOST_CHECK( stan_id(db).active == both );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( buyback )
 {
    ACTORS( (alice)(bob)(chloe)(dan)(izzy)(philbin) );